@@ -28,7 +28,6 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "CMCellCycleModel.hpp"
-#include "RandomNumberGenerator.hpp"
 #include "StemCellProliferativeType.hpp"
 #include "TransitCellProliferativeType.hpp"
 #include "DifferentiatedCellProliferativeType.hpp"
@@ -61,7 +60,8 @@ CMCellCycleModel::CMCellCycleModel(const CMCellCycleModel& rModel)
      mDiffModelParam(rModel.mDiffModelParam),
      mTDYThreshold(rModel.mTDYThreshold),
      mAverageDivisionAge(rModel.mAverageDivisionAge),
-     mStdDivisionAge(rModel.mStdDivisionAge)
+     mStdDivisionAge(rModel.mStdDivisionAge),
+     mpSimulationContext(rModel.mpSimulationContext)
 {
     /*
      * Initialize only those member variables defined in this class.
@@ -73,14 +73,14 @@ CMCellCycleModel::CMCellCycleModel(const CMCellCycleModel& rModel)
 
 void CMCellCycleModel::Initialise()
 {
-    double RandomDivisionAge = GenerateDivisionAge();
+    double RandomDivisionAge = GenerateDivisionAge(INITIAL_DIVISION_AGE_RANDOM_STREAM);
     mpCell->GetCellData()->SetItem("DivAge", RandomDivisionAge);
     mpCell->GetCellData()->SetItem("DivisionDelay", 0);
 }
 
 void CMCellCycleModel::InitialiseDaughterCell()
 {
-    double RandomDivisionAge = GenerateDivisionAge();
+    double RandomDivisionAge = GenerateDivisionAge(DAUGHTER_DIVISION_AGE_RANDOM_STREAM);
     mpCell->GetCellData()->SetItem("DivAge", RandomDivisionAge);
     mpCell->GetCellData()->SetItem("DivisionDelay", 0);
 }
@@ -88,7 +88,11 @@ void CMCellCycleModel::InitialiseDaughterCell()
 bool CMCellCycleModel::ReadyToDivide()
 {
     assert(mpCell != NULL);
-    RandomNumberGenerator* p_gen = RandomNumberGenerator::Instance();
+    if (!mpSimulationContext)
+    {
+        EXCEPTION("CMCellCycleModel needs a simulation context; add the cell to an OffLatticeSimulationUT or call SetSimulationContext().");
+    }
+    UtericBudSimulationContext* p_gen = mpSimulationContext.get();
     
     MAKE_PTR(RVCellMutationState, p_rv_state);   
     
@@ -99,7 +103,7 @@ bool CMCellCycleModel::ReadyToDivide()
         MAKE_PTR(TransitCellProliferativeType, p_transit_type);
         MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
     
-        double dt = SimulationTime::Instance()->GetTimeStep();
+        double dt = mpSimulationContext->GetTimeStep();
         
         //double conc_a = mpCell->GetCellData()->GetItem("concentrationA");
         //double conc_b = mpCell->GetCellData()->GetItem("concentrationB");
@@ -205,13 +209,13 @@ bool CMCellCycleModel::ReadyToDivide()
             double DiffYThreshold = mTDYThreshold;
             
             //if ( (p_gen->ranf() < DiffProbability) && (conc_a < DiffYThreshold) ) // conc_a < or >?
-            if (p_gen->ranf() < DiffProbability)
+            if (p_gen->ranf(DIFFERENTIATION_RANDOM_STREAM, mpCell->GetCellId()) < DiffProbability)
             {
                 mpCell->SetCellProliferativeType(p_diff_type);
             }
             else 
             {
-                double RandomDivisionAge = GenerateDivisionAge();
+                double RandomDivisionAge = GenerateDivisionAge(DIVISION_AGE_RANDOM_STREAM);
                 mpCell->GetCellData()->SetItem("DivAge", RandomDivisionAge);
             }
             
@@ -317,6 +321,18 @@ double CMCellCycleModel::GetStdDivisionAge()
 }
 
 
+void CMCellCycleModel::SetSimulationContext(boost::shared_ptr<UtericBudSimulationContext> pSimulationContext)
+{
+    assert(pSimulationContext);
+    mpSimulationContext = pSimulationContext;
+}
+
+boost::shared_ptr<UtericBudSimulationContext> CMCellCycleModel::GetSimulationContext() const
+{
+    return mpSimulationContext;
+}
+
+
 
 double CMCellCycleModel::GetAverageTransitCellCycleTime()
 {
@@ -330,11 +346,15 @@ double CMCellCycleModel::GetAverageStemCellCycleTime()
 
 
 
-double CMCellCycleModel::GenerateDivisionAge()
+double CMCellCycleModel::GenerateDivisionAge(UtericBudRandomStream stream)
 {
-    RandomNumberGenerator* p_gen = RandomNumberGenerator::Instance();
+    if (!mpSimulationContext)
+    {
+        EXCEPTION("CMCellCycleModel needs a simulation context to draw division ages; call SetSimulationContext() before the cell is initialised.");
+    }
+    UtericBudSimulationContext* p_gen = mpSimulationContext.get();
     
-    double RandomDivisionAge = p_gen->NormalRandomDeviate(mAverageDivisionAge, mStdDivisionAge);
+    double RandomDivisionAge = p_gen->NormalRandomDeviate(mAverageDivisionAge, mStdDivisionAge, stream, mpCell->GetCellId());
     // If a negative number is generated, set it to the mean.
     if (RandomDivisionAge < 0)
     {
@@ -342,6 +362,7 @@ double CMCellCycleModel::GenerateDivisionAge()
         PRINT_VARIABLE(RandomDivisionAge);
     }
     
+    return RandomDivisionAge;
 }
 
 
@@ -31,6 +31,8 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define CMCellCycleModel_HPP_
 
 #include "AbstractCellCycleModel.hpp"
+#include "UtericBudSimulationContext.hpp"
+#include "AbstractSimulationContextUser.hpp"
 
 /**
  * Simple cell-cycle model where mature non-differentiated cells have a specified probability of
@@ -40,7 +42,7 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  * of dividing per hour; the second, mAverageDivisionAge, defines a minimum age at which cells
  * may divide.
  */
-class CMCellCycleModel : public AbstractCellCycleModel
+class CMCellCycleModel : public AbstractCellCycleModel, public AbstractSimulationContextUser
 {
 private:
 
@@ -91,6 +93,13 @@ protected:
      * Defaults to 1 hour.
      */
     double mStdDivisionAge;
+    
+    /**
+     * Source of random numbers and the time step, shared with daughter cells.
+     * Must be set before the cell is initialised. Not archived; given by
+     * OffLatticeSimulationUT in SetupSolve() after loading.
+     */
+    boost::shared_ptr<UtericBudSimulationContext> mpSimulationContext;
 
     /**
      * Protected copy-constructor for use by CreateCellCycleModel.
@@ -260,6 +269,21 @@ public:
      * @return mAverageDivisionAge
      */
     double GetStdDivisionAge();
+    
+    
+    /**
+     * Set the value of mpSimulationContext.
+     *
+     * @param pSimulationContext the source of random numbers and the time step
+     */
+    void SetSimulationContext(boost::shared_ptr<UtericBudSimulationContext> pSimulationContext);
+
+    /**
+     * Get mpSimulationContext.
+     *
+     * @return mpSimulationContext
+     */
+    boost::shared_ptr<UtericBudSimulationContext> GetSimulationContext() const;
 
 
 
@@ -285,8 +309,11 @@ public:
      * Quick function for Generating a new division age for cells. to be called 
      * in Initialise(), InitialiseDaughterCell() and ReadyToDivide(). Draws from 
      * normal distribution with mean mAverageDivisionAge and std deviation mStdDivisionAge
+     *
+     * @param stream the random stream of the caller, so that a cell drawing twice in one time step gets two different ages
+     * @return the division age
      */
-    double GenerateDivisionAge();
+    double GenerateDivisionAge(UtericBudRandomStream stream);
 
     /**
      * Overridden OutputCellCycleModelParameters() method.
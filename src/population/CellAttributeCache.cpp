@@ -0,0 +1,215 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "CellAttributeCache.hpp"
+
+#include <algorithm>
+
+#include "AbstractOffLatticeCellPopulation.hpp"
+
+#include "WildTypeCellMutationState.hpp"
+#include "AttachedCellMutationState.hpp"
+#include "RVCellMutationState.hpp"
+#include "TransitCellProliferativeType.hpp"
+#include "DifferentiatedCellProliferativeType.hpp"
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+CellAttributeCache<ELEMENT_DIM,SPACE_DIM>::CellAttributeCache()
+    : mIsValid(false),
+      mTimeStepsElapsed(0),
+      mNumNodes(0),
+      mNumRebuilds(0)
+{
+    std::fill(mMutationStateCounts, mMutationStateCounts + OTHER_MUTATION_STATE + 1, 0u);
+    std::fill(mProliferativeTypeCounts, mProliferativeTypeCounts + OTHER_PROLIFERATIVE_TYPE + 1, 0u);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void CellAttributeCache<ELEMENT_DIM,SPACE_DIM>::StoreCell(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation, CellPtr pCell, unsigned nodeIndex)
+{
+    mCellIds[nodeIndex] = pCell->GetCellId();
+
+    boost::shared_ptr<AbstractCellMutationState> p_state = pCell->GetMutationState();
+    if (p_state->IsType<WildTypeCellMutationState>())
+    {
+        mMutationStates[nodeIndex] = WILD_TYPE_MUTATION_STATE;
+    }
+    else if (p_state->IsType<AttachedCellMutationState>())
+    {
+        mMutationStates[nodeIndex] = ATTACHED_MUTATION_STATE;
+    }
+    else if (p_state->IsType<RVCellMutationState>())
+    {
+        mMutationStates[nodeIndex] = RV_MUTATION_STATE;
+    }
+    else
+    {
+        mMutationStates[nodeIndex] = OTHER_MUTATION_STATE;
+    }
+
+    boost::shared_ptr<AbstractCellProliferativeType> p_type = pCell->GetCellProliferativeType();
+    if (p_type->IsType<TransitCellProliferativeType>())
+    {
+        mProliferativeTypes[nodeIndex] = TRANSIT_PROLIFERATIVE_TYPE;
+    }
+    else if (p_type->IsType<DifferentiatedCellProliferativeType>())
+    {
+        mProliferativeTypes[nodeIndex] = DIFFERENTIATED_PROLIFERATIVE_TYPE;
+    }
+    else
+    {
+        mProliferativeTypes[nodeIndex] = OTHER_PROLIFERATIVE_TYPE;
+    }
+
+    // The damping constant depends on the mutation state, so is re-read along with it
+    AbstractOffLatticeCellPopulation<ELEMENT_DIM,SPACE_DIM>* p_population = dynamic_cast<AbstractOffLatticeCellPopulation<ELEMENT_DIM,SPACE_DIM>*>(&rCellPopulation);
+    mDampingConstants[nodeIndex] = p_population ? p_population->GetDampingConstant(nodeIndex) : 0.0;
+
+    mHasCell[nodeIndex] = true;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool CellAttributeCache<ELEMENT_DIM,SPACE_DIM>::Refresh(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    if (mIsValid
+        && mpSimulationContext && mpSimulationContext->HasClock()
+        && mTimeStepsElapsed == mpSimulationContext->GetTimeStepsElapsed()
+        && mNumNodes == rCellPopulation.rGetMesh().GetNumNodes())
+    {
+        return false;
+    }
+
+    Rebuild(rCellPopulation);
+    return true;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void CellAttributeCache<ELEMENT_DIM,SPACE_DIM>::Rebuild(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    AbstractMesh<ELEMENT_DIM,SPACE_DIM>& r_mesh = rCellPopulation.rGetMesh();
+
+    // The vectors only grow, so once they have reached the size of the population rebuilding does not allocate
+    unsigned num_indices = std::max((unsigned) mHasCell.size(), r_mesh.GetMaximumNodeIndex());
+    mHasCell.assign(num_indices, false);
+    mCellIds.resize(num_indices, 0);
+    mMutationStates.resize(num_indices, OTHER_MUTATION_STATE);
+    mProliferativeTypes.resize(num_indices, OTHER_PROLIFERATIVE_TYPE);
+    mDampingConstants.resize(num_indices, 0.0);
+
+    std::fill(mMutationStateCounts, mMutationStateCounts + OTHER_MUTATION_STATE + 1, 0u);
+    std::fill(mProliferativeTypeCounts, mProliferativeTypeCounts + OTHER_PROLIFERATIVE_TYPE + 1, 0u);
+
+    for (typename AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>::Iterator cell_iter = rCellPopulation.Begin();
+         cell_iter != rCellPopulation.End();
+         ++cell_iter)
+    {
+        unsigned node_index = rCellPopulation.GetLocationIndexUsingCell(*cell_iter);
+        assert(node_index < num_indices);
+
+        StoreCell(rCellPopulation, *cell_iter, node_index);
+        mMutationStateCounts[mMutationStates[node_index]]++;
+        mProliferativeTypeCounts[mProliferativeTypes[node_index]]++;
+    }
+
+    mIsValid = true;
+    mTimeStepsElapsed = (mpSimulationContext && mpSimulationContext->HasClock()) ? mpSimulationContext->GetTimeStepsElapsed() : 0;
+    mNumNodes = r_mesh.GetNumNodes();
+    mNumRebuilds++;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void CellAttributeCache<ELEMENT_DIM,SPACE_DIM>::Invalidate()
+{
+    mIsValid = false;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void CellAttributeCache<ELEMENT_DIM,SPACE_DIM>::SetSimulationContext(boost::shared_ptr<UtericBudSimulationContext> pSimulationContext)
+{
+    mpSimulationContext = pSimulationContext;
+    mIsValid = false;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+boost::shared_ptr<UtericBudSimulationContext> CellAttributeCache<ELEMENT_DIM,SPACE_DIM>::GetSimulationContext() const
+{
+    return mpSimulationContext;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void CellAttributeCache<ELEMENT_DIM,SPACE_DIM>::RefreshCell(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation, CellPtr pCell, unsigned nodeIndex)
+{
+    if (!mIsValid)
+    {
+        return;
+    }
+    assert(HasCell(nodeIndex));
+
+    mMutationStateCounts[mMutationStates[nodeIndex]]--;
+    mProliferativeTypeCounts[mProliferativeTypes[nodeIndex]]--;
+
+    StoreCell(rCellPopulation, pCell, nodeIndex);
+
+    mMutationStateCounts[mMutationStates[nodeIndex]]++;
+    mProliferativeTypeCounts[mProliferativeTypes[nodeIndex]]++;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned CellAttributeCache<ELEMENT_DIM,SPACE_DIM>::GetNumCellsWithMutationState(CachedMutationState mutationState) const
+{
+    assert(mutationState <= OTHER_MUTATION_STATE);
+    return mMutationStateCounts[mutationState];
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned CellAttributeCache<ELEMENT_DIM,SPACE_DIM>::GetNumCellsWithProliferativeType(CachedProliferativeType proliferativeType) const
+{
+    assert(proliferativeType <= OTHER_PROLIFERATIVE_TYPE);
+    return mProliferativeTypeCounts[proliferativeType];
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned CellAttributeCache<ELEMENT_DIM,SPACE_DIM>::GetNumRebuilds() const
+{
+    return mNumRebuilds;
+}
+
+// Explicit instantiation
+template class CellAttributeCache<1,1>;
+template class CellAttributeCache<1,2>;
+template class CellAttributeCache<2,2>;
+template class CellAttributeCache<1,3>;
+template class CellAttributeCache<2,3>;
+template class CellAttributeCache<3,3>;
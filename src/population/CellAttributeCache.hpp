@@ -0,0 +1,287 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef CELLATTRIBUTECACHE_HPP_
+#define CELLATTRIBUTECACHE_HPP_
+
+#include <vector>
+#include <cassert>
+
+#include "AbstractCellPopulation.hpp"
+#include "UtericBudSimulationContext.hpp"
+#include "AbstractSimulationContextUser.hpp"
+
+/**
+ * The mutation states distinguished by CellAttributeCache.
+ */
+typedef enum CachedMutationState_
+{
+    WILD_TYPE_MUTATION_STATE,
+    ATTACHED_MUTATION_STATE,
+    RV_MUTATION_STATE,
+    OTHER_MUTATION_STATE
+} CachedMutationState;
+
+/**
+ * The proliferative types distinguished by CellAttributeCache.
+ */
+typedef enum CachedProliferativeType_
+{
+    TRANSIT_PROLIFERATIVE_TYPE,
+    DIFFERENTIATED_PROLIFERATIVE_TYPE,
+    OTHER_PROLIFERATIVE_TYPE
+} CachedProliferativeType;
+
+/**
+ * A dense, node-indexed store of the cell attributes read in the inner loops of the
+ * project's forces, modifiers, boundary conditions and writers: the cell ID, the
+ * mutation state, the proliferative type and the damping constant.
+ *
+ * The cache is rebuilt by Refresh() at most once per time step, so the components
+ * sharing it make one pass of cell lookups and type checks between them rather than
+ * one each per evaluation. It is rebuilt whenever the number of time steps elapsed on
+ * the clock of its simulation context or the number of nodes has changed since the
+ * last rebuild, or after Invalidate(). A cache without a context, or whose context has
+ * no clock, cannot tell when a time step has passed, so Refresh() always rebuilds it.
+ * OffLatticeSimulationUT gives its cache the simulation's context in SetupSolve().
+ *
+ * Components called at different points of a time step may see the population change
+ * in between without either of these changing, for instance when a cell differentiates.
+ * A cache shared between such components must therefore be invalidated once the
+ * population has been updated; OffLatticeSimulationUT does this at the start of each
+ * call to UpdateCellLocationsAndTopology(). Components that change a cell's state
+ * should call RefreshCell() afterwards.
+ *
+ * Node locations are not cached. They change within a time step as the nodes move,
+ * and every consumer already visits the nodes, so reading them there is both cheaper
+ * and always current.
+ *
+ * Caches are not archived. Objects restored from an archive use a cache of their own
+ * until they are given another one.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM=ELEMENT_DIM>
+class CellAttributeCache : public AbstractSimulationContextUser
+{
+private:
+
+    /** Whether each node index has a cell attached. */
+    std::vector<bool> mHasCell;
+
+    /** The ID of the cell at each node index. */
+    std::vector<unsigned> mCellIds;
+
+    /** The mutation state of the cell at each node index. */
+    std::vector<unsigned char> mMutationStates;
+
+    /** The proliferative type of the cell at each node index. */
+    std::vector<unsigned char> mProliferativeTypes;
+
+    /** The damping constant of the cell at each node index, or zero if the population is not off-lattice. */
+    std::vector<double> mDampingConstants;
+
+    /** The number of cells with each mutation state. */
+    unsigned mMutationStateCounts[OTHER_MUTATION_STATE + 1];
+
+    /** The number of cells with each proliferative type. */
+    unsigned mProliferativeTypeCounts[OTHER_PROLIFERATIVE_TYPE + 1];
+
+    /** Whether the cache has been rebuilt since it was created or last invalidated. */
+    bool mIsValid;
+
+    /** The simulation context whose clock tells when a time step has passed. Not archived. */
+    boost::shared_ptr<UtericBudSimulationContext> mpSimulationContext;
+
+    /** The number of time steps elapsed on the clock of #mpSimulationContext when the cache was last rebuilt. */
+    unsigned mTimeStepsElapsed;
+
+    /** The number of nodes when the cache was last rebuilt. */
+    unsigned mNumNodes;
+
+    /** The number of times the cache has been rebuilt. */
+    unsigned mNumRebuilds;
+
+    /**
+     * Fill in the attributes of one cell, without touching the counts.
+     *
+     * @param rCellPopulation the cell population
+     * @param pCell the cell
+     * @param nodeIndex the index of the cell's node
+     */
+    void StoreCell(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation, CellPtr pCell, unsigned nodeIndex);
+
+public:
+
+    /**
+     * Constructor.
+     */
+    CellAttributeCache();
+
+    /**
+     * Rebuild the cache from a cell population if it is out of date.
+     *
+     * @param rCellPopulation the cell population
+     * @return whether the cache was rebuilt
+     */
+    bool Refresh(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
+    /**
+     * Rebuild the cache from a cell population.
+     *
+     * @param rCellPopulation the cell population
+     */
+    void Rebuild(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
+    /**
+     * Mark the cache as out of date, so that the next call to Refresh() rebuilds it.
+     */
+    void Invalidate();
+
+    /**
+     * Set #mpSimulationContext.
+     *
+     * @param pSimulationContext the simulation context
+     */
+    void SetSimulationContext(boost::shared_ptr<UtericBudSimulationContext> pSimulationContext);
+
+    /** @return #mpSimulationContext. */
+    boost::shared_ptr<UtericBudSimulationContext> GetSimulationContext() const;
+
+    /**
+     * Re-read the attributes of one cell whose state has changed since the cache was
+     * rebuilt. Does nothing if the cache is out of date, as it will be rebuilt anyway.
+     *
+     * @param rCellPopulation the cell population
+     * @param pCell the cell
+     * @param nodeIndex the index of the cell's node
+     */
+    void RefreshCell(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation, CellPtr pCell, unsigned nodeIndex);
+
+    /**
+     * @return whether a cell is attached to a node index.
+     *
+     * @param nodeIndex the node index
+     */
+    bool HasCell(unsigned nodeIndex) const
+    {
+        return nodeIndex < mHasCell.size() && mHasCell[nodeIndex];
+    }
+
+    /**
+     * @return the ID of the cell at a node index.
+     *
+     * @param nodeIndex the node index
+     */
+    unsigned GetCellId(unsigned nodeIndex) const
+    {
+        assert(HasCell(nodeIndex));
+        return mCellIds[nodeIndex];
+    }
+
+    /**
+     * @return the mutation state of the cell at a node index.
+     *
+     * @param nodeIndex the node index
+     */
+    CachedMutationState GetMutationState(unsigned nodeIndex) const
+    {
+        assert(HasCell(nodeIndex));
+        return (CachedMutationState) mMutationStates[nodeIndex];
+    }
+
+    /**
+     * @return whether the cell at a node index has an AttachedCellMutationState.
+     *
+     * @param nodeIndex the node index
+     */
+    bool IsAttached(unsigned nodeIndex) const
+    {
+        assert(HasCell(nodeIndex));
+        return mMutationStates[nodeIndex] == ATTACHED_MUTATION_STATE;
+    }
+
+    /**
+     * @return whether the cell at a node index has an RVCellMutationState.
+     *
+     * @param nodeIndex the node index
+     */
+    bool IsRV(unsigned nodeIndex) const
+    {
+        assert(HasCell(nodeIndex));
+        return mMutationStates[nodeIndex] == RV_MUTATION_STATE;
+    }
+
+    /**
+     * @return the proliferative type of the cell at a node index.
+     *
+     * @param nodeIndex the node index
+     */
+    CachedProliferativeType GetProliferativeType(unsigned nodeIndex) const
+    {
+        assert(HasCell(nodeIndex));
+        return (CachedProliferativeType) mProliferativeTypes[nodeIndex];
+    }
+
+    /**
+     * @return the damping constant of the cell at a node index.
+     *
+     * @param nodeIndex the node index
+     */
+    double GetDampingConstant(unsigned nodeIndex) const
+    {
+        assert(HasCell(nodeIndex));
+        return mDampingConstants[nodeIndex];
+    }
+
+    /**
+     * @return the number of cells with a given mutation state.
+     *
+     * @param mutationState the mutation state
+     */
+    unsigned GetNumCellsWithMutationState(CachedMutationState mutationState) const;
+
+    /**
+     * @return the number of cells with a given proliferative type.
+     *
+     * @param proliferativeType the proliferative type
+     */
+    unsigned GetNumCellsWithProliferativeType(CachedProliferativeType proliferativeType) const;
+
+    /**
+     * @return the number of times the cache has been rebuilt.
+     */
+    unsigned GetNumRebuilds() const;
+};
+
+#endif /*CELLATTRIBUTECACHE_HPP_*/
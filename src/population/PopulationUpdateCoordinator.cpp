@@ -0,0 +1,139 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "PopulationUpdateCoordinator.hpp"
+
+#include <climits>
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM>::PopulationUpdateCoordinator()
+    : mTopologyChanged(true),
+      mNodesMoved(true),
+      mNumNodes(UINT_MAX),
+      mNumNodeMoves(0),
+      mNumRequests(0),
+      mNumUpdates(0),
+      mNumRecordedUpdates(0)
+{
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM>::MarkNodesMoved()
+{
+    mNodesMoved = true;
+    mNumNodeMoves++;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM>::MarkTopologyChanged()
+{
+    mTopologyChanged = true;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM>::RecordUpdate(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    mNumRecordedUpdates++;
+    mTopologyChanged = false;
+    mNodesMoved = false;
+    mNumNodes = rCellPopulation.rGetMesh().GetNumNodes();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM>::RequestUpdate(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation, PopulationUpdateNeed need)
+{
+    mNumRequests++;
+
+    bool is_out_of_date = mTopologyChanged || rCellPopulation.rGetMesh().GetNumNodes() != mNumNodes;
+    if (need == NEIGHBOUR_DATA_NEED)
+    {
+        is_out_of_date = is_out_of_date || mNodesMoved;
+    }
+    if (!is_out_of_date)
+    {
+        return false;
+    }
+
+    rCellPopulation.Update();
+    mNumUpdates++;
+    mTopologyChanged = false;
+    mNodesMoved = false;
+    mNumNodes = rCellPopulation.rGetMesh().GetNumNodes();
+    return true;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM>::IsTopologyCurrent(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation) const
+{
+    return !mTopologyChanged && rCellPopulation.rGetMesh().GetNumNodes() == mNumNodes;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM>::GetNumRequests() const
+{
+    return mNumRequests;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM>::GetNumUpdates() const
+{
+    return mNumUpdates;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM>::GetNumSkippedUpdates() const
+{
+    return mNumRequests - mNumUpdates;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM>::GetNumRecordedUpdates() const
+{
+    return mNumRecordedUpdates;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM>::GetNumNodeMoves() const
+{
+    return mNumNodeMoves;
+}
+
+// Explicit instantiation
+template class PopulationUpdateCoordinator<1,1>;
+template class PopulationUpdateCoordinator<1,2>;
+template class PopulationUpdateCoordinator<2,2>;
+template class PopulationUpdateCoordinator<1,3>;
+template class PopulationUpdateCoordinator<2,3>;
+template class PopulationUpdateCoordinator<3,3>;
@@ -0,0 +1,156 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef POPULATIONUPDATECOORDINATOR_HPP_
+#define POPULATIONUPDATECOORDINATOR_HPP_
+
+#include "AbstractCellPopulation.hpp"
+
+/**
+ * What a component needs to be up to date in the cell population before it reads it.
+ */
+typedef enum PopulationUpdateNeed_
+{
+    /** The maps between cells and nodes must take account of any births and deaths. */
+    CELL_LOCATION_MAPS_NEED,
+    /** The neighbour data must also take account of where the nodes have since moved. */
+    NEIGHBOUR_DATA_NEED
+} PopulationUpdateNeed;
+
+/**
+ * Decides when the cell population really has to be updated, so that components which
+ * used to call AbstractCellPopulation::Update() to be safe only do so when something
+ * they read is out of date.
+ *
+ * The coordinator keeps track of whether the nodes have moved, and whether cells may
+ * have been born or died, since the population was last updated. The simulation marks
+ * these events and records the update it makes at the start of each time step.
+ * Components declare what they need through RequestUpdate(), which updates the
+ * population only if that is out of date. A change in the number of nodes is always
+ * taken as a birth or death, so a coordinator that is not told of every event still
+ * catches most of them.
+ *
+ * The coordinator is not archived. Components that are not given one update the
+ * population themselves as before.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM=ELEMENT_DIM>
+class PopulationUpdateCoordinator
+{
+private:
+
+    /** Whether cells may have been born or died since the population was last updated. */
+    bool mTopologyChanged;
+
+    /** Whether the nodes have moved since the population was last updated. */
+    bool mNodesMoved;
+
+    /** The number of nodes when the population was last updated. */
+    unsigned mNumNodes;
+
+    /**
+     * The number of calls to MarkNodesMoved(), which a component can compare with the
+     * value it last saw to tell whether anything has moved the nodes since.
+     */
+    unsigned mNumNodeMoves;
+
+    /** The number of calls to RequestUpdate(). */
+    unsigned mNumRequests;
+
+    /** The number of updates made by RequestUpdate(). */
+    unsigned mNumUpdates;
+
+    /** The number of updates recorded by RecordUpdate(). */
+    unsigned mNumRecordedUpdates;
+
+public:
+
+    /**
+     * Constructor. The population is taken to be out of date until an update is made
+     * or recorded.
+     */
+    PopulationUpdateCoordinator();
+
+    /**
+     * Note that the nodes have moved.
+     */
+    void MarkNodesMoved();
+
+    /**
+     * Note that cells may have been born or died, or the mesh otherwise changed.
+     */
+    void MarkTopologyChanged();
+
+    /**
+     * Note that the population has just been updated elsewhere.
+     *
+     * @param rCellPopulation the cell population
+     */
+    void RecordUpdate(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
+    /**
+     * Update the population if what a component needs is out of date.
+     *
+     * @param rCellPopulation the cell population
+     * @param need what the component needs to be up to date
+     * @return whether the population was updated
+     */
+    bool RequestUpdate(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation, PopulationUpdateNeed need);
+
+    /**
+     * @return whether the population has been updated since any births and deaths, so
+     *     that what Update() builds from the nodes, such as the boxes of a NodesOnlyMesh,
+     *     still holds every node.
+     *
+     * @param rCellPopulation the cell population
+     */
+    bool IsTopologyCurrent(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation) const;
+
+    /** @return #mNumRequests. */
+    unsigned GetNumRequests() const;
+
+    /** @return #mNumUpdates. */
+    unsigned GetNumUpdates() const;
+
+    /** @return the number of calls to RequestUpdate() that did not need an update. */
+    unsigned GetNumSkippedUpdates() const;
+
+    /** @return #mNumRecordedUpdates. */
+    unsigned GetNumRecordedUpdates() const;
+
+    /** @return #mNumNodeMoves. */
+    unsigned GetNumNodeMoves() const;
+};
+
+#endif /*POPULATIONUPDATECOORDINATOR_HPP_*/
@@ -0,0 +1,222 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "BoundaryBandIndex.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "AbstractOffLatticeCellPopulation.hpp"
+#include "DistributedBoxCollection.hpp"
+#include "NodesOnlyMesh.hpp"
+
+/**
+ * @return whether one node has a lower index than another.
+ *
+ * @param pNodeA a node
+ * @param pNodeB another node
+ */
+template<unsigned SPACE_DIM>
+static bool HasLowerNodeIndex(Node<SPACE_DIM>* pNodeA, Node<SPACE_DIM>* pNodeB)
+{
+    return pNodeA->GetIndex() < pNodeB->GetIndex();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+BoundaryBandIndex<ELEMENT_DIM,SPACE_DIM>::BoundaryBandIndex()
+    : mDomainSize(zero_vector<double>(2*SPACE_DIM)),
+      mBoxWidth(0.0),
+      mNumBoxes(0),
+      mBandWidth(-1.0),
+      mNumQueries(0),
+      mNumFullScans(0)
+{
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void BoundaryBandIndex<ELEMENT_DIM,SPACE_DIM>::ChooseCandidateBoxes(DistributedBoxCollection<SPACE_DIM>& rBoxCollection)
+{
+    mCandidateBoxes.clear();
+
+    // The outermost boxes also hold any nodes beyond the edge of the domain
+    unsigned num_boxes = rBoxCollection.GetNumBoxes();
+    c_vector<unsigned, SPACE_DIM> max_grid_indices = zero_vector<unsigned>(SPACE_DIM);
+    for (unsigned box=0; box<num_boxes; box++)
+    {
+        c_vector<unsigned, SPACE_DIM> grid_indices = rBoxCollection.CalculateGridIndices(box);
+        for (unsigned d=0; d<SPACE_DIM; d++)
+        {
+            max_grid_indices[d] = std::max(max_grid_indices[d], grid_indices[d]);
+        }
+    }
+
+    unsigned num_planes = mNormalsToPlanes.size()/SPACE_DIM;
+    for (unsigned box=0; box<num_boxes; box++)
+    {
+        if (!rBoxCollection.IsBoxOwned(box))
+        {
+            continue;
+        }
+
+        c_vector<unsigned, SPACE_DIM> grid_indices = rBoxCollection.CalculateGridIndices(box);
+        for (unsigned plane=0; plane<num_planes; plane++)
+        {
+            // The furthest any point of the box reaches along the normal, relative to the plane
+            double furthest_distance = 0.0;
+            for (unsigned d=0; d<SPACE_DIM; d++)
+            {
+                double normal = mNormalsToPlanes[plane*SPACE_DIM + d];
+                double lower = mDomainSize[2*d] + grid_indices[d]*mBoxWidth - mPointsOnPlanes[plane*SPACE_DIM + d];
+                double upper = lower + mBoxWidth;
+                if ((normal < 0.0 && grid_indices[d] == 0) || (normal > 0.0 && grid_indices[d] == max_grid_indices[d]))
+                {
+                    furthest_distance = DBL_MAX;
+                    break;
+                }
+                furthest_distance += std::max(lower*normal, upper*normal);
+            }
+
+            if (furthest_distance > -mBandWidth)
+            {
+                mCandidateBoxes.push_back(box);
+                break;
+            }
+        }
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const std::vector<Node<SPACE_DIM>*>& BoundaryBandIndex<ELEMENT_DIM,SPACE_DIM>::rGetCandidateNodes(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation,
+                                                                                                  const std::vector<double>& rPointsOnPlanes,
+                                                                                                  const std::vector<double>& rNormalsToPlanes,
+                                                                                                  unsigned numPositionUpdates)
+{
+    assert(rPointsOnPlanes.size() == rNormalsToPlanes.size());
+    mNumQueries++;
+
+    NodesOnlyMesh<SPACE_DIM>* p_mesh = dynamic_cast<NodesOnlyMesh<SPACE_DIM>*>(&(rCellPopulation.rGetMesh()));
+    AbstractOffLatticeCellPopulation<ELEMENT_DIM,SPACE_DIM>* p_population = dynamic_cast<AbstractOffLatticeCellPopulation<ELEMENT_DIM,SPACE_DIM>*>(&rCellPopulation);
+    DistributedBoxCollection<SPACE_DIM>* p_box_collection = (p_mesh == NULL) ? NULL : p_mesh->GetBoxCollection();
+
+    // The boxes only hold every node if the population has been updated since any births and deaths
+    if (p_box_collection == NULL || p_population == NULL
+        || !mpPopulationUpdateCoordinator || !mpPopulationUpdateCoordinator->IsTopologyCurrent(rCellPopulation))
+    {
+        mNumFullScans++;
+        return rGetAllNodes(rCellPopulation);
+    }
+
+    double band_width = numPositionUpdates*p_population->GetAbsoluteMovementThreshold();
+    if (rPointsOnPlanes != mPointsOnPlanes
+        || rNormalsToPlanes != mNormalsToPlanes
+        || !std::equal(mDomainSize.begin(), mDomainSize.end(), p_box_collection->rGetDomainSize().begin())
+        || p_box_collection->GetBoxWidth() != mBoxWidth
+        || p_box_collection->GetNumBoxes() != mNumBoxes
+        || band_width != mBandWidth)
+    {
+        mPointsOnPlanes = rPointsOnPlanes;
+        mNormalsToPlanes = rNormalsToPlanes;
+        mDomainSize = p_box_collection->rGetDomainSize();
+        mBoxWidth = p_box_collection->GetBoxWidth();
+        mNumBoxes = p_box_collection->GetNumBoxes();
+        mBandWidth = band_width;
+        ChooseCandidateBoxes(*p_box_collection);
+    }
+
+    mCandidateNodes.clear();
+    for (unsigned i=0; i<mCandidateBoxes.size(); i++)
+    {
+        const std::set<Node<SPACE_DIM>*>& r_nodes = p_box_collection->rGetBox(mCandidateBoxes[i]).rGetNodesContained();
+        mCandidateNodes.insert(mCandidateNodes.end(), r_nodes.begin(), r_nodes.end());
+    }
+
+    // The boxes are sets ordered by address, so sort to make the order reproducible
+    std::sort(mCandidateNodes.begin(), mCandidateNodes.end(), HasLowerNodeIndex<SPACE_DIM>);
+
+    return mCandidateNodes;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const std::vector<Node<SPACE_DIM>*>& BoundaryBandIndex<ELEMENT_DIM,SPACE_DIM>::rGetAllNodes(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    mCandidateNodes.clear();
+    AbstractMesh<ELEMENT_DIM,SPACE_DIM>& r_mesh = rCellPopulation.rGetMesh();
+    for (typename AbstractMesh<ELEMENT_DIM,SPACE_DIM>::NodeIterator node_iter = r_mesh.GetNodeIteratorBegin();
+         node_iter != r_mesh.GetNodeIteratorEnd();
+         ++node_iter)
+    {
+        mCandidateNodes.push_back(&(*node_iter));
+    }
+    return mCandidateNodes;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void BoundaryBandIndex<ELEMENT_DIM,SPACE_DIM>::SetPopulationUpdateCoordinator(boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > pPopulationUpdateCoordinator)
+{
+    mpPopulationUpdateCoordinator = pPopulationUpdateCoordinator;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > BoundaryBandIndex<ELEMENT_DIM,SPACE_DIM>::GetPopulationUpdateCoordinator() const
+{
+    return mpPopulationUpdateCoordinator;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned BoundaryBandIndex<ELEMENT_DIM,SPACE_DIM>::GetNumQueries() const
+{
+    return mNumQueries;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned BoundaryBandIndex<ELEMENT_DIM,SPACE_DIM>::GetNumFullScans() const
+{
+    return mNumFullScans;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned BoundaryBandIndex<ELEMENT_DIM,SPACE_DIM>::GetNumCandidateBoxes() const
+{
+    return mCandidateBoxes.size();
+}
+
+// Explicit instantiation
+template class BoundaryBandIndex<1,1>;
+template class BoundaryBandIndex<1,2>;
+template class BoundaryBandIndex<2,2>;
+template class BoundaryBandIndex<1,3>;
+template class BoundaryBandIndex<2,3>;
+template class BoundaryBandIndex<3,3>;
@@ -0,0 +1,171 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef BOUNDARYBANDINDEX_HPP_
+#define BOUNDARYBANDINDEX_HPP_
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "AbstractCellPopulation.hpp"
+#include "PopulationUpdateCoordinator.hpp"
+#include "Node.hpp"
+#include "UblasVectorInclude.hpp"
+
+template<unsigned DIM> class DistributedBoxCollection;
+
+/**
+ * Finds the nodes that may have crossed any of a set of half-planes, for boundary
+ * conditions whose planes only bound a thin band of a large population.
+ *
+ * For a NodeBasedCellPopulation the nodes are taken from the boxes of the NodesOnlyMesh
+ * box collection, which the population rebuilds on every call to Update(), so at the
+ * start of each time step. Since then no node can have moved further than the absolute
+ * movement threshold of the population per position update, or the numerical method
+ * would have thrown a StepSizeException. Only the boxes that reach within that distance
+ * of a plane, or beyond it, can hold a node that has crossed the plane, so the cost of
+ * a query scales with the length of the boundary rather than the size of the population.
+ * The boxes are chosen again only when the planes, the box collection or the band width
+ * change.
+ *
+ * The boxes only hold every node if the population has been updated since any births
+ * and deaths. The index learns this from the PopulationUpdateCoordinator of the
+ * simulation, which records each update and the number of nodes at the time, so a
+ * query does not have to look at every box to find out.
+ *
+ * The candidate nodes are returned in order of node index. If the population has no
+ * box collection, the index has no coordinator, or the population has not been
+ * updated since a birth or death, every node in the mesh is returned instead.
+ *
+ * The nodes moved by any other boundary condition must not move towards a plane, as is
+ * the case for the axis-aligned planes of the bud.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM=ELEMENT_DIM>
+class BoundaryBandIndex
+{
+private:
+
+    /** The points on the planes the boxes were last chosen for, SPACE_DIM values per plane. */
+    std::vector<double> mPointsOnPlanes;
+
+    /** The unit normals to the planes the boxes were last chosen for, SPACE_DIM values per plane. */
+    std::vector<double> mNormalsToPlanes;
+
+    /** The domain of the box collection when the boxes were last chosen. */
+    c_vector<double, 2*SPACE_DIM> mDomainSize;
+
+    /** The box width when the boxes were last chosen. */
+    double mBoxWidth;
+
+    /** The number of boxes when the boxes were last chosen. */
+    unsigned mNumBoxes;
+
+    /** The band width the boxes were last chosen for. */
+    double mBandWidth;
+
+    /** The global indices of the boxes that may hold a node beyond a plane. */
+    std::vector<unsigned> mCandidateBoxes;
+
+    /** The nodes found by the last query. */
+    std::vector<Node<SPACE_DIM>*> mCandidateNodes;
+
+    /** The coordinator that says whether the boxes are up to date. Not archived. */
+    boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > mpPopulationUpdateCoordinator;
+
+    /** The number of queries. */
+    unsigned mNumQueries;
+
+    /** The number of queries that had to return every node. */
+    unsigned mNumFullScans;
+
+    /**
+     * Choose #mCandidateBoxes.
+     *
+     * @param rBoxCollection the box collection
+     */
+    void ChooseCandidateBoxes(DistributedBoxCollection<SPACE_DIM>& rBoxCollection);
+
+public:
+
+    /**
+     * Constructor.
+     */
+    BoundaryBandIndex();
+
+    /**
+     * Find the nodes that may be beyond any of the given planes.
+     *
+     * @param rCellPopulation the cell population
+     * @param rPointsOnPlanes a point on each plane, SPACE_DIM values per plane
+     * @param rNormalsToPlanes the outward-facing unit normal to each plane, SPACE_DIM values per plane
+     * @param numPositionUpdates the number of times the nodes have been moved since the
+     *     population was last updated, which is the number of substeps taken so far in
+     *     the current time step
+     * @return the candidate nodes, in order of node index
+     */
+    const std::vector<Node<SPACE_DIM>*>& rGetCandidateNodes(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation,
+                                                           const std::vector<double>& rPointsOnPlanes,
+                                                           const std::vector<double>& rNormalsToPlanes,
+                                                           unsigned numPositionUpdates);
+
+    /**
+     * @return every node in the mesh of a cell population, in mesh order.
+     *
+     * @param rCellPopulation the cell population
+     */
+    const std::vector<Node<SPACE_DIM>*>& rGetAllNodes(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
+    /**
+     * Set #mpPopulationUpdateCoordinator.
+     *
+     * @param pPopulationUpdateCoordinator the population update coordinator
+     */
+    void SetPopulationUpdateCoordinator(boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > pPopulationUpdateCoordinator);
+
+    /** @return #mpPopulationUpdateCoordinator. */
+    boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > GetPopulationUpdateCoordinator() const;
+
+    /** @return #mNumQueries. */
+    unsigned GetNumQueries() const;
+
+    /** @return #mNumFullScans. */
+    unsigned GetNumFullScans() const;
+
+    /** @return the number of boxes searched by a query. */
+    unsigned GetNumCandidateBoxes() const;
+};
+
+#endif /*BOUNDARYBANDINDEX_HPP_*/
@@ -0,0 +1,367 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "HalfPlaneDomainBoundaryCondition.hpp"
+
+#include <climits>
+#include <boost/make_shared.hpp>
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::HalfPlaneDomainBoundaryCondition(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>* pCellPopulation)
+        : AbstractSnapshotBoundaryCondition<ELEMENT_DIM,SPACE_DIM>(pCellPopulation),
+          mpCellAttributeCache(boost::make_shared<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> >()),
+          mLastImposeTimeStep(UINT_MAX),
+          mNumImposesThisTimeStep(0),
+          mNumResidualViolations(0),
+          mLastImposeNumNodes(UINT_MAX),
+          mLastImposeNumNodeMoves(UINT_MAX),
+          mUseBoundaryBandIndex(false)
+{
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::AddPlane(const c_vector<double, SPACE_DIM>& point,
+                                                                          const c_vector<double, SPACE_DIM>& normal,
+                                                                          bool kills,
+                                                                          bool useJiggle,
+                                                                          unsigned exemptTags)
+{
+    assert(norm_2(normal) > 0.0);
+    c_vector<double, SPACE_DIM> unit_normal = normal/norm_2(normal);
+    for (unsigned d=0; d<SPACE_DIM; d++)
+    {
+        mPointsOnPlanes.push_back(point[d]);
+        mNormalsToPlanes.push_back(unit_normal[d]);
+    }
+    mPlaneKills.push_back(kills ? 1u : 0u);
+    mPlaneJiggles.push_back(useJiggle ? 1u : 0u);
+    mPlaneExemptTags.push_back(exemptTags);
+    mNumClamps.push_back(0);
+    mNumKills.push_back(0);
+
+    return mPlaneKills.size() - 1;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::AddClampingPlane(const c_vector<double, SPACE_DIM>& point,
+                                                                                  const c_vector<double, SPACE_DIM>& normal,
+                                                                                  bool useJiggle,
+                                                                                  unsigned exemptTags)
+{
+    return AddPlane(point, normal, false, useJiggle, exemptTags);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::AddKillingPlane(const c_vector<double, SPACE_DIM>& point,
+                                                                                 const c_vector<double, SPACE_DIM>& normal,
+                                                                                 unsigned exemptTags)
+{
+    return AddPlane(point, normal, true, false, exemptTags);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::GetNumPlanes() const
+{
+    return mPlaneKills.size();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+c_vector<double, SPACE_DIM> HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::GetPointOnPlane(unsigned plane) const
+{
+    assert(plane < GetNumPlanes());
+    c_vector<double, SPACE_DIM> point;
+    for (unsigned d=0; d<SPACE_DIM; d++)
+    {
+        point[d] = mPointsOnPlanes[plane*SPACE_DIM + d];
+    }
+    return point;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+c_vector<double, SPACE_DIM> HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::GetNormalToPlane(unsigned plane) const
+{
+    assert(plane < GetNumPlanes());
+    c_vector<double, SPACE_DIM> normal;
+    for (unsigned d=0; d<SPACE_DIM; d++)
+    {
+        normal[d] = mNormalsToPlanes[plane*SPACE_DIM + d];
+    }
+    return normal;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::IsKillingPlane(unsigned plane) const
+{
+    assert(plane < GetNumPlanes());
+    return mPlaneKills[plane] != 0;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::GetNumClamps(unsigned plane) const
+{
+    assert(plane < GetNumPlanes());
+    return mNumClamps[plane];
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::GetNumKills(unsigned plane) const
+{
+    assert(plane < GetNumPlanes());
+    return mNumKills[plane];
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::SetSimulationContext(boost::shared_ptr<UtericBudSimulationContext> pSimulationContext)
+{
+    assert(pSimulationContext);
+    mpSimulationContext = pSimulationContext;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+boost::shared_ptr<UtericBudSimulationContext> HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::GetSimulationContext() const
+{
+    return mpSimulationContext;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::SetCellAttributeCache(boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > pCellAttributeCache)
+{
+    assert(pCellAttributeCache);
+    mpCellAttributeCache = pCellAttributeCache;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::GetCellAttributeCache() const
+{
+    return mpCellAttributeCache;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::SetUseBoundaryBandIndex(bool useBoundaryBandIndex)
+{
+    mUseBoundaryBandIndex = useBoundaryBandIndex;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::GetUseBoundaryBandIndex() const
+{
+    return mUseBoundaryBandIndex;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const BoundaryBandIndex<ELEMENT_DIM,SPACE_DIM>& HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::rGetBoundaryBandIndex() const
+{
+    return mBoundaryBandIndex;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::SetPopulationUpdateCoordinator(boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > pPopulationUpdateCoordinator)
+{
+    mBoundaryBandIndex.SetPopulationUpdateCoordinator(pPopulationUpdateCoordinator);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::GetPopulationUpdateCoordinator() const
+{
+    return mBoundaryBandIndex.GetPopulationUpdateCoordinator();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::ConnectToSimulation(boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > pCellAttributeCache,
+                                                                                  boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > pPopulationUpdateCoordinator,
+                                                                                  unsigned numForceThreads)
+{
+    SetCellAttributeCache(pCellAttributeCache);
+    if (!GetPopulationUpdateCoordinator())
+    {
+        SetPopulationUpdateCoordinator(pPopulationUpdateCoordinator);
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::ImposeBoundaryCondition(const NodeLocationSnapshot<ELEMENT_DIM,SPACE_DIM>& rOldLocations)
+{
+    if (!mpSimulationContext)
+    {
+        EXCEPTION("HalfPlaneDomainBoundaryCondition needs a simulation context; add it to an OffLatticeSimulationUT or call SetSimulationContext().");
+    }
+    mpCellAttributeCache->Refresh(*(this->mpCellPopulation));
+
+    unsigned time_step = mpSimulationContext->GetTimeStepsElapsed();
+    if (time_step != mLastImposeTimeStep)
+    {
+        mLastImposeTimeStep = time_step;
+        mNumImposesThisTimeStep = 0;
+    }
+    unsigned draw_index = mNumImposesThisTimeStep++;
+
+    mNumResidualViolations = 0;
+    unsigned num_planes = GetNumPlanes();
+
+    AbstractMesh<ELEMENT_DIM,SPACE_DIM>& r_mesh = this->mpCellPopulation->rGetMesh();
+    const std::vector<Node<SPACE_DIM>*>& r_nodes = mUseBoundaryBandIndex ?
+        mBoundaryBandIndex.rGetCandidateNodes(*(this->mpCellPopulation), mPointsOnPlanes, mNormalsToPlanes, mNumImposesThisTimeStep) :
+        mBoundaryBandIndex.rGetAllNodes(*(this->mpCellPopulation));
+
+    for (unsigned i=0; i<r_nodes.size(); i++)
+    {
+        unsigned node_index = r_nodes[i]->GetIndex();
+        if (!mpCellAttributeCache->HasCell(node_index))
+        {
+            continue;
+        }
+
+        // Clamp to each clamping plane in turn
+        c_vector<double, SPACE_DIM>& r_location = r_nodes[i]->rGetModifiableLocation();
+        for (unsigned plane=0; plane<num_planes; plane++)
+        {
+            if (mPlaneKills[plane])
+            {
+                continue;
+            }
+
+            double signed_distance = GetSignedDistance(r_location, plane);
+            if (signed_distance > 0.0 && !IsExempt(node_index, plane))
+            {
+                double shift = signed_distance;
+                if (mPlaneJiggles[plane])
+                {
+                    // Keyed by cell and plane, so each plane sees different numbers
+                    double max_jiggle = 1e-4;
+                    unsigned draw = draw_index*num_planes + plane;
+                    shift += max_jiggle*mpSimulationContext->ranf(JIGGLE_RANDOM_STREAM, mpCellAttributeCache->GetCellId(node_index), draw);
+                }
+                for (unsigned d=0; d<SPACE_DIM; d++)
+                {
+                    r_location[d] -= shift*mNormalsToPlanes[plane*SPACE_DIM + d];
+                }
+                mNumClamps[plane]++;
+            }
+        }
+
+        // Then test the clamped location against the clamping planes, and the killing planes
+        for (unsigned plane=0; plane<num_planes; plane++)
+        {
+            if (GetSignedDistance(r_location, plane) > 0.0 && !IsExempt(node_index, plane))
+            {
+                if (!mPlaneKills[plane])
+                {
+                    mNumResidualViolations++;
+                }
+                else
+                {
+                    CellPtr p_cell = this->mpCellPopulation->GetCellUsingLocationIndex(node_index);
+                    if (!p_cell->IsDead())
+                    {
+                        p_cell->Kill();
+                        mNumKills[plane]++;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+    mLastImposeNumNodes = r_mesh.GetNumNodes();
+    mLastImposeNumNodeMoves = GetPopulationUpdateCoordinator() ? GetPopulationUpdateCoordinator()->GetNumNodeMoves() : UINT_MAX;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::VerifyBoundaryCondition()
+{
+    AbstractMesh<ELEMENT_DIM,SPACE_DIM>& r_mesh = this->mpCellPopulation->rGetMesh();
+
+    // If nothing has moved the nodes since they were clamped, the last pass already has the answer
+    boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > p_coordinator = GetPopulationUpdateCoordinator();
+    if (mpSimulationContext && mLastImposeTimeStep == mpSimulationContext->GetTimeStepsElapsed() && mLastImposeNumNodes == r_mesh.GetNumNodes()
+        && p_coordinator && mLastImposeNumNodeMoves == p_coordinator->GetNumNodeMoves())
+    {
+        return (mNumResidualViolations == 0);
+    }
+
+    mpCellAttributeCache->Refresh(*(this->mpCellPopulation));
+    for (typename AbstractMesh<ELEMENT_DIM,SPACE_DIM>::NodeIterator node_iter = r_mesh.GetNodeIteratorBegin();
+         node_iter != r_mesh.GetNodeIteratorEnd();
+         ++node_iter)
+    {
+        unsigned node_index = node_iter->GetIndex();
+        if (!mpCellAttributeCache->HasCell(node_index))
+        {
+            continue;
+        }
+
+        for (unsigned plane=0; plane<GetNumPlanes(); plane++)
+        {
+            if (!mPlaneKills[plane] && GetSignedDistance(node_iter->rGetLocation(), plane) > 0.0 && !IsExempt(node_index, plane))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void HalfPlaneDomainBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::OutputCellPopulationBoundaryConditionParameters(out_stream& rParamsFile)
+{
+    for (unsigned plane=0; plane<GetNumPlanes(); plane++)
+    {
+        *rParamsFile << "\t\t\t<Plane>";
+        for (unsigned d=0; d<SPACE_DIM; d++)
+        {
+            *rParamsFile << mPointsOnPlanes[plane*SPACE_DIM + d] << ",";
+        }
+        for (unsigned d=0; d<SPACE_DIM; d++)
+        {
+            *rParamsFile << mNormalsToPlanes[plane*SPACE_DIM + d] << ",";
+        }
+        *rParamsFile << (mPlaneKills[plane] ? "kill" : "clamp") << "," << mPlaneJiggles[plane] << "," << mPlaneExemptTags[plane] << "</Plane>\n";
+    }
+    *rParamsFile << "\t\t\t<UseBoundaryBandIndex>" << mUseBoundaryBandIndex << "</UseBoundaryBandIndex>\n";
+
+    // Call method on direct parent class
+    AbstractSnapshotBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::OutputCellPopulationBoundaryConditionParameters(rParamsFile);
+}
+
+// Explicit instantiation
+template class HalfPlaneDomainBoundaryCondition<1,1>;
+template class HalfPlaneDomainBoundaryCondition<1,2>;
+template class HalfPlaneDomainBoundaryCondition<2,2>;
+template class HalfPlaneDomainBoundaryCondition<1,3>;
+template class HalfPlaneDomainBoundaryCondition<2,3>;
+template class HalfPlaneDomainBoundaryCondition<3,3>;
+
+// Serialization for Boost >= 1.36
+#include "SerializationExportWrapperForCpp.hpp"
+EXPORT_TEMPLATE_CLASS_ALL_DIMS(HalfPlaneDomainBoundaryCondition)
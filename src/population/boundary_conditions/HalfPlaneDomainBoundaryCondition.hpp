@@ -0,0 +1,402 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef HALFPLANEDOMAINBOUNDARYCONDITION_HPP_
+#define HALFPLANEDOMAINBOUNDARYCONDITION_HPP_
+
+#include <vector>
+
+#include "AbstractSnapshotBoundaryCondition.hpp"
+#include "UtericBudSimulationContext.hpp"
+#include "CellAttributeCache.hpp"
+#include "BoundaryBandIndex.hpp"
+#include "AbstractSimulationComponent.hpp"
+#include "AbstractSimulationContextUser.hpp"
+
+#include "ChasteSerialization.hpp"
+#include <boost/serialization/base_object.hpp>
+#include <boost/serialization/vector.hpp>
+
+/**
+ * A boundary condition that keeps the cells within a domain bounded by any number of
+ * half-planes, in place of a stack of PlaneBoundaryConditions,
+ * SelectivePlaneBoundaryConditions and PlaneBasedCellKillers.
+ *
+ * Each plane either clamps nodes that have crossed it back onto it, optionally with a
+ * small jiggle, or kills their cells. Cells may be exempted from a plane by their
+ * mutation state, read from the cell attribute cache; for example, the barrier that
+ * only RV cells may cross is a clamping plane exempting RV_MUTATION_STATE.
+ *
+ * ImposeBoundaryCondition() makes one pass over the nodes, applying every clamping
+ * plane to each node in the order they were added and then testing the result
+ * against every killing plane. Killed cells are removed by the population at the
+ * start of the next time step, as they would be by a cell killer. The number of
+ * clamps and kills made by each plane are counted from the start of the simulation.
+ *
+ * As for SelectivePlaneBoundaryCondition, VerifyBoundaryCondition() uses the count of
+ * nodes left beyond a clamping plane by the last pass if the population update
+ * coordinator shows that nothing has moved the nodes since, and SetUseBoundaryBandIndex()
+ * restricts the pass to the nodes near the planes.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM=ELEMENT_DIM>
+class HalfPlaneDomainBoundaryCondition : public AbstractSnapshotBoundaryCondition<ELEMENT_DIM,SPACE_DIM>,
+                                         public AbstractSimulationComponent<ELEMENT_DIM,SPACE_DIM>,
+                                         public AbstractSimulationContextUser
+{
+private:
+
+    /** A point on each plane, SPACE_DIM values per plane. */
+    std::vector<double> mPointsOnPlanes;
+
+    /** The outward-facing unit normal of each plane, SPACE_DIM values per plane. */
+    std::vector<double> mNormalsToPlanes;
+
+    /** Whether each plane kills cells (1) or clamps nodes (0). */
+    std::vector<unsigned> mPlaneKills;
+
+    /** Whether each clamping plane jiggles the nodes it clamps (1) or not (0). */
+    std::vector<unsigned> mPlaneJiggles;
+
+    /** The mutation states exempt from each plane, as a mask of GetTag() values. */
+    std::vector<unsigned> mPlaneExemptTags;
+
+    /** The number of nodes clamped by each plane so far. */
+    std::vector<unsigned> mNumClamps;
+
+    /** The number of cells killed by each plane so far. */
+    std::vector<unsigned> mNumKills;
+
+    /**
+     * The source of the random numbers used to jiggle the nodes. Given by
+     * OffLatticeSimulationUT in SetupSolve() if not set beforehand. Not archived.
+     */
+    boost::shared_ptr<UtericBudSimulationContext> mpSimulationContext;
+
+    /** The cell attributes, used for the exemptions. Not archived. */
+    boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > mpCellAttributeCache;
+
+    /** The time step of the last call to ImposeBoundaryCondition(). */
+    unsigned mLastImposeTimeStep;
+
+    /** The number of calls to ImposeBoundaryCondition() made so far in #mLastImposeTimeStep, which keys the jiggles. */
+    unsigned mNumImposesThisTimeStep;
+
+    /** The number of nodes still beyond a clamping plane after the last call to ImposeBoundaryCondition(). */
+    unsigned mNumResidualViolations;
+
+    /** The number of nodes in the mesh at the last call to ImposeBoundaryCondition(). */
+    unsigned mLastImposeNumNodes;
+
+    /** The number of node moves marked on the population update coordinator at the last call to ImposeBoundaryCondition(). */
+    unsigned mLastImposeNumNodeMoves;
+
+    /** Whether to only visit the nodes near the planes, found by #mBoundaryBandIndex. Defaults to false. */
+    bool mUseBoundaryBandIndex;
+
+    /** Finds the nodes near the planes. Not archived. */
+    BoundaryBandIndex<ELEMENT_DIM,SPACE_DIM> mBoundaryBandIndex;
+
+    /** Needed for serialization. */
+    friend class boost::serialization::access;
+    /**
+     * Serialize the object and its member variables.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void serialize(Archive & archive, const unsigned int version)
+    {
+        archive & boost::serialization::base_object<AbstractSnapshotBoundaryCondition<ELEMENT_DIM, SPACE_DIM> >(*this);
+        archive & mPointsOnPlanes;
+        archive & mNormalsToPlanes;
+        archive & mPlaneKills;
+        archive & mPlaneJiggles;
+        archive & mPlaneExemptTags;
+        archive & mNumClamps;
+        archive & mNumKills;
+        archive & mUseBoundaryBandIndex;
+    }
+
+    /**
+     * Add a plane.
+     *
+     * @param point a point on the plane
+     * @param normal the outward-facing normal to the plane
+     * @param kills whether the plane kills cells rather than clamping nodes
+     * @param useJiggle whether to jiggle clamped nodes
+     * @param exemptTags the mutation states exempt from the plane, as a mask of GetTag() values
+     * @return the index of the plane
+     */
+    unsigned AddPlane(const c_vector<double, SPACE_DIM>& point,
+                      const c_vector<double, SPACE_DIM>& normal,
+                      bool kills,
+                      bool useJiggle,
+                      unsigned exemptTags);
+
+    /**
+     * @return the signed distance of a location beyond a plane.
+     *
+     * @param rLocation the location
+     * @param plane the index of the plane
+     */
+    double GetSignedDistance(const c_vector<double, SPACE_DIM>& rLocation, unsigned plane) const
+    {
+        const double* p_point = &mPointsOnPlanes[plane*SPACE_DIM];
+        const double* p_normal = &mNormalsToPlanes[plane*SPACE_DIM];
+        double signed_distance = 0.0;
+        for (unsigned d=0; d<SPACE_DIM; d++)
+        {
+            signed_distance += (rLocation[d] - p_point[d])*p_normal[d];
+        }
+        return signed_distance;
+    }
+
+    /**
+     * @return whether the cell at a node is exempt from a plane.
+     *
+     * @param nodeIndex the node index, which must have a cell
+     * @param plane the index of the plane
+     */
+    bool IsExempt(unsigned nodeIndex, unsigned plane) const
+    {
+        return (mPlaneExemptTags[plane] & GetTag(mpCellAttributeCache->GetMutationState(nodeIndex))) != 0;
+    }
+
+public:
+
+    /**
+     * Constructor. The domain has no planes until some are added.
+     *
+     * @param pCellPopulation pointer to the cell population
+     */
+    HalfPlaneDomainBoundaryCondition(AbstractCellPopulation<ELEMENT_DIM, SPACE_DIM>* pCellPopulation);
+
+    /**
+     * @return the tag of a mutation state, for building exemption masks.
+     *
+     * @param mutationState the mutation state
+     */
+    static unsigned GetTag(CachedMutationState mutationState)
+    {
+        return 1u << mutationState;
+    }
+
+    /**
+     * Add a plane that clamps nodes which cross it back onto it.
+     *
+     * @param point a point on the plane
+     * @param normal the outward-facing normal to the plane
+     * @param useJiggle whether to move clamped nodes a random distance of up to 1e-4
+     *     further inside, which can help stop overcrowding on the plane (defaults to false)
+     * @param exemptTags the mutation states exempt from the plane, as a mask of GetTag()
+     *     values (defaults to none)
+     * @return the index of the plane
+     */
+    unsigned AddClampingPlane(const c_vector<double, SPACE_DIM>& point,
+                              const c_vector<double, SPACE_DIM>& normal,
+                              bool useJiggle=false,
+                              unsigned exemptTags=0u);
+
+    /**
+     * Add a plane that kills the cells whose nodes cross it.
+     *
+     * @param point a point on the plane
+     * @param normal the outward-facing normal to the plane
+     * @param exemptTags the mutation states exempt from the plane, as a mask of GetTag()
+     *     values (defaults to none)
+     * @return the index of the plane
+     */
+    unsigned AddKillingPlane(const c_vector<double, SPACE_DIM>& point,
+                             const c_vector<double, SPACE_DIM>& normal,
+                             unsigned exemptTags=0u);
+
+    /** @return the number of planes. */
+    unsigned GetNumPlanes() const;
+
+    /**
+     * @return a point on a plane.
+     *
+     * @param plane the index of the plane
+     */
+    c_vector<double, SPACE_DIM> GetPointOnPlane(unsigned plane) const;
+
+    /**
+     * @return the outward-facing unit normal to a plane.
+     *
+     * @param plane the index of the plane
+     */
+    c_vector<double, SPACE_DIM> GetNormalToPlane(unsigned plane) const;
+
+    /**
+     * @return whether a plane kills cells rather than clamping nodes.
+     *
+     * @param plane the index of the plane
+     */
+    bool IsKillingPlane(unsigned plane) const;
+
+    /**
+     * @return the number of nodes clamped by a plane so far.
+     *
+     * @param plane the index of the plane
+     */
+    unsigned GetNumClamps(unsigned plane) const;
+
+    /**
+     * @return the number of cells killed by a plane so far.
+     *
+     * @param plane the index of the plane
+     */
+    unsigned GetNumKills(unsigned plane) const;
+
+    /**
+     * Set #mpSimulationContext.
+     *
+     * @param pSimulationContext the source of random numbers
+     */
+    void SetSimulationContext(boost::shared_ptr<UtericBudSimulationContext> pSimulationContext);
+
+    /** @return #mpSimulationContext. */
+    boost::shared_ptr<UtericBudSimulationContext> GetSimulationContext() const;
+
+    /**
+     * Set #mpCellAttributeCache, so that it may be shared with other components.
+     *
+     * @param pCellAttributeCache the cell attribute cache
+     */
+    void SetCellAttributeCache(boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > pCellAttributeCache);
+
+    /** @return #mpCellAttributeCache. */
+    boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > GetCellAttributeCache() const;
+
+    /**
+     * Set #mUseBoundaryBandIndex.
+     *
+     * @param useBoundaryBandIndex whether to only visit the nodes near the planes
+     */
+    void SetUseBoundaryBandIndex(bool useBoundaryBandIndex);
+
+    /** @return #mUseBoundaryBandIndex. */
+    bool GetUseBoundaryBandIndex() const;
+
+    /** @return #mBoundaryBandIndex. */
+    const BoundaryBandIndex<ELEMENT_DIM,SPACE_DIM>& rGetBoundaryBandIndex() const;
+
+    /**
+     * Give #mBoundaryBandIndex the population update coordinator of the simulation,
+     * which tells it whether the boxes of the mesh hold every node.
+     *
+     * @param pPopulationUpdateCoordinator the population update coordinator
+     */
+    void SetPopulationUpdateCoordinator(boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > pPopulationUpdateCoordinator);
+
+    /** @return the population update coordinator of #mBoundaryBandIndex. */
+    boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > GetPopulationUpdateCoordinator() const;
+
+    /**
+     * Overridden ConnectToSimulation() method, which shares the simulation's
+     * cell attribute cache and, unless one has been set, its population update coordinator.
+     *
+     * @param pCellAttributeCache the cell attribute cache of the simulation
+     * @param pPopulationUpdateCoordinator the population update coordinator of the simulation
+     * @param numForceThreads the number of threads the forces of the simulation may use
+     */
+    virtual void ConnectToSimulation(boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > pCellAttributeCache,
+                                     boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > pPopulationUpdateCoordinator,
+                                     unsigned numForceThreads);
+
+    /**
+     * Overridden ImposeBoundaryCondition() method.
+     *
+     * Clamp the nodes to, and kill the cells beyond, every plane in one pass.
+     *
+     * @param rOldLocations the node locations before any boundary conditions are applied
+     */
+    void ImposeBoundaryCondition(const NodeLocationSnapshot<ELEMENT_DIM,SPACE_DIM>& rOldLocations);
+
+    using AbstractSnapshotBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::ImposeBoundaryCondition;
+
+    /**
+     * Overridden VerifyBoundaryCondition() method.
+     *
+     * @return whether every node is within every clamping plane it is not exempt from.
+     */
+    bool VerifyBoundaryCondition();
+
+    /**
+     * Overridden OutputCellPopulationBoundaryConditionParameters() method.
+     *
+     * @param rParamsFile the file stream to which the parameters are output
+     */
+    void OutputCellPopulationBoundaryConditionParameters(out_stream& rParamsFile);
+};
+
+#include "SerializationExportWrapper.hpp"
+EXPORT_TEMPLATE_CLASS_ALL_DIMS(HalfPlaneDomainBoundaryCondition)
+
+namespace boost
+{
+namespace serialization
+{
+/**
+ * Serialize information required to construct a HalfPlaneDomainBoundaryCondition.
+ */
+template<class Archive, unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+inline void save_construct_data(
+    Archive & ar, const HalfPlaneDomainBoundaryCondition<ELEMENT_DIM, SPACE_DIM>* t, const unsigned int file_version)
+{
+    // Save data required to construct instance
+    const AbstractCellPopulation<ELEMENT_DIM, SPACE_DIM>* const p_cell_population = t->GetCellPopulation();
+    ar << p_cell_population;
+}
+
+/**
+ * De-serialize constructor parameters and initialize a HalfPlaneDomainBoundaryCondition.
+ */
+template<class Archive, unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+inline void load_construct_data(
+    Archive & ar, HalfPlaneDomainBoundaryCondition<ELEMENT_DIM, SPACE_DIM>* t, const unsigned int file_version)
+{
+    // Retrieve data from archive required to construct new instance
+    AbstractCellPopulation<ELEMENT_DIM, SPACE_DIM>* p_cell_population;
+    ar >> p_cell_population;
+
+    // Invoke inplace constructor to initialise instance
+    ::new(t)HalfPlaneDomainBoundaryCondition<ELEMENT_DIM, SPACE_DIM>(p_cell_population);
+}
+}
+} // namespace ...
+
+#endif /*HALFPLANEDOMAINBOUNDARYCONDITION_HPP_*/
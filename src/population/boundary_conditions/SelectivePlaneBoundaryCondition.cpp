@@ -36,18 +36,25 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "SelectivePlaneBoundaryCondition.hpp"
 #include "AbstractCentreBasedCellPopulation.hpp"
 #include "VertexBasedCellPopulation.hpp"
-#include "RandomNumberGenerator.hpp"
-#include "RVCellMutationState.hpp"
 
-#include "Debug.hpp"
+#include <climits>
+#include <boost/make_shared.hpp>
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 SelectivePlaneBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::SelectivePlaneBoundaryCondition(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>* pCellPopulation,
                                                     c_vector<double, SPACE_DIM> point,
                                                     c_vector<double, SPACE_DIM> normal)
-        : AbstractCellPopulationBoundaryCondition<ELEMENT_DIM,SPACE_DIM>(pCellPopulation),
+        : AbstractSnapshotBoundaryCondition<ELEMENT_DIM,SPACE_DIM>(pCellPopulation),
           mPointOnPlane(point),
-          mUseJiggledNodesOnPlane(false)
+          mUseJiggledNodesOnPlane(false),
+          mpCellAttributeCache(boost::make_shared<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> >()),
+          mLastImposeTimeStep(UINT_MAX),
+          mNumImposesThisTimeStep(0),
+          mNumViolations(0),
+          mNumResidualViolations(0),
+          mLastImposeNumNodes(UINT_MAX),
+          mLastImposeNumNodeMoves(UINT_MAX),
+          mUseBoundaryBandIndex(false)
 {
     assert(norm_2(normal) > 0.0);
     mNormalToPlane = normal/norm_2(normal);
@@ -79,46 +86,153 @@ bool SelectivePlaneBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::GetUseJiggledNodesO
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-void SelectivePlaneBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::ImposeBoundaryCondition(const std::map<Node<SPACE_DIM>*, c_vector<double, SPACE_DIM> >& rOldLocations)
+void SelectivePlaneBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::SetSimulationContext(boost::shared_ptr<UtericBudSimulationContext> pSimulationContext)
 {
-    for (typename AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>::Iterator cell_iter = this->mpCellPopulation->Begin();
-         cell_iter != this->mpCellPopulation->End();
-         ++cell_iter)
+    assert(pSimulationContext);
+    mpSimulationContext = pSimulationContext;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+boost::shared_ptr<UtericBudSimulationContext> SelectivePlaneBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::GetSimulationContext() const
+{
+    return mpSimulationContext;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void SelectivePlaneBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::SetCellAttributeCache(boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > pCellAttributeCache)
+{
+    assert(pCellAttributeCache);
+    mpCellAttributeCache = pCellAttributeCache;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > SelectivePlaneBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::GetCellAttributeCache() const
+{
+    return mpCellAttributeCache;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned SelectivePlaneBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::GetNumViolations() const
+{
+    return mNumViolations;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void SelectivePlaneBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::SetUseBoundaryBandIndex(bool useBoundaryBandIndex)
+{
+    mUseBoundaryBandIndex = useBoundaryBandIndex;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool SelectivePlaneBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::GetUseBoundaryBandIndex() const
+{
+    return mUseBoundaryBandIndex;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const BoundaryBandIndex<ELEMENT_DIM,SPACE_DIM>& SelectivePlaneBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::rGetBoundaryBandIndex() const
+{
+    return mBoundaryBandIndex;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void SelectivePlaneBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::SetPopulationUpdateCoordinator(boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > pPopulationUpdateCoordinator)
+{
+    mBoundaryBandIndex.SetPopulationUpdateCoordinator(pPopulationUpdateCoordinator);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > SelectivePlaneBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::GetPopulationUpdateCoordinator() const
+{
+    return mBoundaryBandIndex.GetPopulationUpdateCoordinator();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void SelectivePlaneBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::ConnectToSimulation(boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > pCellAttributeCache,
+                                                                                 boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > pPopulationUpdateCoordinator,
+                                                                                 unsigned numForceThreads)
+{
+    SetCellAttributeCache(pCellAttributeCache);
+    if (!GetPopulationUpdateCoordinator())
     {
-        unsigned node_index = this->mpCellPopulation->GetLocationIndexUsingCell(*cell_iter);
-        CellPtr p_cell = this->mpCellPopulation->GetCellUsingLocationIndex(node_index);
-        
-        if (!p_cell->GetMutationState()->IsType<RVCellMutationState>())
-        {
-            Node<SPACE_DIM>* p_node = this->mpCellPopulation->GetNode(node_index);
-            c_vector<double, SPACE_DIM> node_location = p_node->rGetLocation();
-            
-            double signed_distance = inner_prod(node_location - mPointOnPlane, mNormalToPlane);
-            if (signed_distance > 0.0)
-            {
-                c_vector<double, SPACE_DIM> nearest_point;
-                //wumbo = 10;
-                //PRINT_VARIABLE(wumbo);
-                //wumbo = 0;
-                
-                
-                if (mUseJiggledNodesOnPlane)
-                {
-                    double max_jiggle = 1e-4;
-                    nearest_point = node_location - (signed_distance+max_jiggle*RandomNumberGenerator::Instance()->ranf())*mNormalToPlane;
-                }
-                else
-                {
-                    nearest_point = node_location - signed_distance*mNormalToPlane;
-                }
-                p_node->rGetModifiableLocation() = nearest_point;
-            }
-        }
+        SetPopulationUpdateCoordinator(pPopulationUpdateCoordinator);
     }
 }
-    
 
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void SelectivePlaneBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::ImposeBoundaryCondition(const NodeLocationSnapshot<ELEMENT_DIM,SPACE_DIM>& rOldLocations)
+{
+    if (!mpSimulationContext)
+    {
+        EXCEPTION("SelectivePlaneBoundaryCondition needs a simulation context; add it to an OffLatticeSimulationUT or call SetSimulationContext().");
+    }
+    mpCellAttributeCache->Refresh(*(this->mpCellPopulation));
+
+    unsigned time_step = mpSimulationContext->GetTimeStepsElapsed();
+    if (time_step != mLastImposeTimeStep)
+    {
+        mLastImposeTimeStep = time_step;
+        mNumImposesThisTimeStep = 0;
+    }
+    unsigned draw_index = mNumImposesThisTimeStep++;
+
+    mNumViolations = 0;
+    mNumResidualViolations = 0;
+
+    AbstractMesh<ELEMENT_DIM,SPACE_DIM>& r_mesh = this->mpCellPopulation->rGetMesh();
+    const std::vector<Node<SPACE_DIM>*>* p_nodes;
+    if (mUseBoundaryBandIndex)
+    {
+        std::vector<double> point_on_plane(mPointOnPlane.begin(), mPointOnPlane.end());
+        std::vector<double> normal_to_plane(mNormalToPlane.begin(), mNormalToPlane.end());
+        p_nodes = &(mBoundaryBandIndex.rGetCandidateNodes(*(this->mpCellPopulation), point_on_plane, normal_to_plane, mNumImposesThisTimeStep));
+    }
+    else
+    {
+        p_nodes = &(mBoundaryBandIndex.rGetAllNodes(*(this->mpCellPopulation)));
+    }
+
+    // The jiggles are keyed by cell, so with counter-based streams they do not depend on the node order
+    for (unsigned i=0; i<p_nodes->size(); i++)
+    {
+        Node<SPACE_DIM>* p_node = (*p_nodes)[i];
+
+        // Test the plane first, as most nodes are well inside it
+        const c_vector<double, SPACE_DIM>& r_node_location = p_node->rGetLocation();
+        double signed_distance = inner_prod(r_node_location - mPointOnPlane, mNormalToPlane);
+        if (signed_distance <= 0.0)
+        {
+            continue;
+        }
 
+        unsigned node_index = p_node->GetIndex();
+        if (!mpCellAttributeCache->HasCell(node_index) || mpCellAttributeCache->IsRV(node_index))
+        {
+            continue;
+        }
+
+        mNumViolations++;
+        c_vector<double, SPACE_DIM> nearest_point;
+        if (mUseJiggledNodesOnPlane)
+        {
+            double max_jiggle = 1e-4;
+            double u = mpSimulationContext->ranf(JIGGLE_RANDOM_STREAM, mpCellAttributeCache->GetCellId(node_index), draw_index);
+            nearest_point = r_node_location - (signed_distance+max_jiggle*u)*mNormalToPlane;
+        }
+        else
+        {
+            nearest_point = r_node_location - signed_distance*mNormalToPlane;
+        }
+        p_node->rGetModifiableLocation() = nearest_point;
+
+        if (inner_prod(nearest_point - mPointOnPlane, mNormalToPlane) > 0.0)
+        {
+            mNumResidualViolations++;
+        }
+    }
+    mLastImposeNumNodes = r_mesh.GetNumNodes();
+    mLastImposeNumNodeMoves = GetPopulationUpdateCoordinator() ? GetPopulationUpdateCoordinator()->GetNumNodeMoves() : UINT_MAX;
+}
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 bool SelectivePlaneBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::VerifyBoundaryCondition()
@@ -131,18 +245,26 @@ bool SelectivePlaneBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::VerifyBoundaryCondi
     }
     else
     {
-        for (typename AbstractCellPopulation<ELEMENT_DIM, SPACE_DIM>::Iterator cell_iter = this->mpCellPopulation->Begin();
-             cell_iter != this->mpCellPopulation->End();
-             ++cell_iter)
+        AbstractMesh<ELEMENT_DIM,SPACE_DIM>& r_mesh = this->mpCellPopulation->rGetMesh();
+
+        // If nothing has moved the nodes since they were clamped, the last pass already has the answer
+        boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > p_coordinator = GetPopulationUpdateCoordinator();
+        if (mpSimulationContext && mLastImposeTimeStep == mpSimulationContext->GetTimeStepsElapsed() && mLastImposeNumNodes == r_mesh.GetNumNodes()
+            && p_coordinator && mLastImposeNumNodeMoves == p_coordinator->GetNumNodeMoves())
         {
-            unsigned node_index = this->mpCellPopulation->GetLocationIndexUsingCell(*cell_iter);
-            CellPtr p_cell = this->mpCellPopulation->GetCellUsingLocationIndex(node_index);
-            
-            c_vector<double, SPACE_DIM> cell_location = this->mpCellPopulation->GetLocationOfCellCentre(*cell_iter);
+            return (mNumResidualViolations == 0);
+        }
+
+        mpCellAttributeCache->Refresh(*(this->mpCellPopulation));
+        for (typename AbstractMesh<ELEMENT_DIM,SPACE_DIM>::NodeIterator node_iter = r_mesh.GetNodeIteratorBegin();
+             node_iter != r_mesh.GetNodeIteratorEnd();
+             ++node_iter)
+        {
+            unsigned node_index = node_iter->GetIndex();
             
-            if (!p_cell->GetMutationState()->IsType<RVCellMutationState>())
+            if (mpCellAttributeCache->HasCell(node_index) && !mpCellAttributeCache->IsRV(node_index))
             {
-                if (inner_prod(cell_location - mPointOnPlane, mNormalToPlane) > 0.0)
+                if (inner_prod(node_iter->rGetLocation() - mPointOnPlane, mNormalToPlane) > 0.0)
                 {
                    condition_satisfied = false;
                    break;
@@ -171,9 +293,10 @@ void SelectivePlaneBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::OutputCellPopulatio
     }
     *rParamsFile << mNormalToPlane[SPACE_DIM-1] << "</NormalToPlane>\n";
     *rParamsFile << "\t\t\t<UseJiggledNodesOnPlane>" << mUseJiggledNodesOnPlane << "</UseJiggledNodesOnPlane>\n";
+    *rParamsFile << "\t\t\t<UseBoundaryBandIndex>" << mUseBoundaryBandIndex << "</UseBoundaryBandIndex>\n";
 
     // Call method on direct parent class
-    AbstractCellPopulationBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::OutputCellPopulationBoundaryConditionParameters(rParamsFile);
+    AbstractSnapshotBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::OutputCellPopulationBoundaryConditionParameters(rParamsFile);
 }
 
 // Explicit instantiation
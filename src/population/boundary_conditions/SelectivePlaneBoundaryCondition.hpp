@@ -33,11 +33,17 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 */
 
-#include "AbstractCellPopulationBoundaryCondition.hpp"
+#include "AbstractSnapshotBoundaryCondition.hpp"
+#include "UtericBudSimulationContext.hpp"
+#include "CellAttributeCache.hpp"
+#include "BoundaryBandIndex.hpp"
+#include "AbstractSimulationComponent.hpp"
+#include "AbstractSimulationContextUser.hpp"
 
 #include "ChasteSerialization.hpp"
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
 
 /**
  * A plane cell population boundary condition class, which stops nodes moving through
@@ -47,9 +53,22 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *
  *
  * MODIFIED FROM PLANEBOUNDARYCONDITION, Ignores cells with RVCellMutationState.
+ *
+ * ImposeBoundaryCondition() clamps the nodes in a single pass, reading which cells
+ * are RV from the cell attribute cache, and counts the nodes it finds beyond the plane
+ * and any still beyond it afterwards. VerifyBoundaryCondition() then only needs that
+ * count, so long as nothing has moved the nodes since. The simulation marks the nodes
+ * as moved on its population update coordinator before each boundary condition is
+ * imposed, so the count is only used when this was the last boundary condition to be
+ * imposed. Otherwise, or without a coordinator, it checks every node as before.
+ *
+ * If SetUseBoundaryBandIndex() is set, ImposeBoundaryCondition() only visits the nodes
+ * a BoundaryBandIndex finds near the plane, in order of node index.
  */
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM=ELEMENT_DIM>
-class SelectivePlaneBoundaryCondition : public AbstractCellPopulationBoundaryCondition<ELEMENT_DIM,SPACE_DIM>
+class SelectivePlaneBoundaryCondition : public AbstractSnapshotBoundaryCondition<ELEMENT_DIM,SPACE_DIM>,
+                                        public AbstractSimulationComponent<ELEMENT_DIM,SPACE_DIM>,
+                                        public AbstractSimulationContextUser
 {
 private:
 
@@ -69,6 +88,45 @@ private:
      */
     bool mUseJiggledNodesOnPlane;
 
+    /**
+     * The source of the random numbers used to jiggle the nodes. Given by
+     * OffLatticeSimulationUT in SetupSolve() if not set beforehand. Not archived.
+     */
+    boost::shared_ptr<UtericBudSimulationContext> mpSimulationContext;
+
+    /**
+     * The cell attributes, used to pick out the RV cells. Defaults to a cache of the
+     * boundary condition's own, and is not archived.
+     */
+    boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > mpCellAttributeCache;
+
+    /** The time step of the last call to ImposeBoundaryCondition(). */
+    unsigned mLastImposeTimeStep;
+
+    /**
+     * The number of calls to ImposeBoundaryCondition() made so far in #mLastImposeTimeStep,
+     * which keys the jiggles so that each substep of a time step sees different numbers.
+     */
+    unsigned mNumImposesThisTimeStep;
+
+    /** The number of nodes found beyond the plane by the last call to ImposeBoundaryCondition(). */
+    unsigned mNumViolations;
+
+    /** The number of nodes still beyond the plane after the last call to ImposeBoundaryCondition(). */
+    unsigned mNumResidualViolations;
+
+    /** The number of nodes in the mesh at the last call to ImposeBoundaryCondition(). */
+    unsigned mLastImposeNumNodes;
+
+    /** The number of node moves marked on the population update coordinator at the last call to ImposeBoundaryCondition(). */
+    unsigned mLastImposeNumNodeMoves;
+
+    /** Whether to only visit the nodes near the plane, found by #mBoundaryBandIndex. Defaults to false. */
+    bool mUseBoundaryBandIndex;
+
+    /** Finds the nodes near the plane. Not archived. */
+    BoundaryBandIndex<ELEMENT_DIM,SPACE_DIM> mBoundaryBandIndex;
+
     /** Needed for serialization. */
     friend class boost::serialization::access;
     /**
@@ -80,8 +138,17 @@ private:
     template<class Archive>
     void serialize(Archive & archive, const unsigned int version)
     {
-        archive & boost::serialization::base_object<AbstractCellPopulationBoundaryCondition<ELEMENT_DIM, SPACE_DIM> >(*this);
-        //archive & mUseJiggledNodesOnPlane;
+        // Before version 1 the condition derived directly from AbstractCellPopulationBoundaryCondition and archived nothing else
+        if (version > 0)
+        {
+            archive & boost::serialization::base_object<AbstractSnapshotBoundaryCondition<ELEMENT_DIM, SPACE_DIM> >(*this);
+            archive & mUseJiggledNodesOnPlane;
+            archive & mUseBoundaryBandIndex;
+        }
+        else
+        {
+            archive & boost::serialization::base_object<AbstractCellPopulationBoundaryCondition<ELEMENT_DIM, SPACE_DIM> >(*this);
+        }
     }
 
 public:
@@ -117,19 +184,83 @@ public:
     /** @return #mUseJiggledNodesOnPlane. */
     bool GetUseJiggledNodesOnPlane();
 
+    /**
+     * Set #mpSimulationContext.
+     *
+     * @param pSimulationContext the source of random numbers
+     */
+    void SetSimulationContext(boost::shared_ptr<UtericBudSimulationContext> pSimulationContext);
+
+    /** @return #mpSimulationContext. */
+    boost::shared_ptr<UtericBudSimulationContext> GetSimulationContext() const;
+
+    /**
+     * Set #mpCellAttributeCache, so that it may be shared with other components.
+     *
+     * @param pCellAttributeCache the cell attribute cache
+     */
+    void SetCellAttributeCache(boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > pCellAttributeCache);
+
+    /** @return #mpCellAttributeCache. */
+    boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > GetCellAttributeCache() const;
+
+    /** @return #mNumViolations. */
+    unsigned GetNumViolations() const;
+
+    /**
+     * Set #mUseBoundaryBandIndex.
+     *
+     * @param useBoundaryBandIndex whether to only visit the nodes near the plane
+     */
+    void SetUseBoundaryBandIndex(bool useBoundaryBandIndex);
+
+    /** @return #mUseBoundaryBandIndex. */
+    bool GetUseBoundaryBandIndex() const;
+
+    /** @return #mBoundaryBandIndex. */
+    const BoundaryBandIndex<ELEMENT_DIM,SPACE_DIM>& rGetBoundaryBandIndex() const;
+
+    /**
+     * Give #mBoundaryBandIndex the population update coordinator of the simulation,
+     * which tells it whether the boxes of the mesh hold every node.
+     *
+     * @param pPopulationUpdateCoordinator the population update coordinator
+     */
+    void SetPopulationUpdateCoordinator(boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > pPopulationUpdateCoordinator);
+
+    /** @return the population update coordinator of #mBoundaryBandIndex. */
+    boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > GetPopulationUpdateCoordinator() const;
+
+    /**
+     * Overridden ConnectToSimulation() method, which shares the simulation's
+     * cell attribute cache and, unless one has been set, its population update coordinator.
+     *
+     * @param pCellAttributeCache the cell attribute cache of the simulation
+     * @param pPopulationUpdateCoordinator the population update coordinator of the simulation
+     * @param numForceThreads the number of threads the forces of the simulation may use
+     */
+    virtual void ConnectToSimulation(boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > pCellAttributeCache,
+                                     boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > pPopulationUpdateCoordinator,
+                                     unsigned numForceThreads);
+
     /**
      * Overridden ImposeBoundaryCondition() method.
      *
-     * Apply the cell population boundary conditions.
+     * Apply the cell population boundary conditions, counting the violations as they
+     * are clamped.
      *
      * @param rOldLocations the node locations before any boundary conditions are applied
      */
-    void ImposeBoundaryCondition(const std::map<Node<SPACE_DIM>*, c_vector<double, SPACE_DIM> >& rOldLocations);
+    void ImposeBoundaryCondition(const NodeLocationSnapshot<ELEMENT_DIM,SPACE_DIM>& rOldLocations);
+
+    using AbstractSnapshotBoundaryCondition<ELEMENT_DIM,SPACE_DIM>::ImposeBoundaryCondition;
 
     /**
      * Overridden VerifyBoundaryCondition() method.
      * Verify the boundary conditions have been applied.
      * This is called after ImposeBoundaryCondition() to ensure the condition is still satisfied.
+     * Uses the count of residual violations from ImposeBoundaryCondition() if no node has
+     * moved since, and otherwise checks every node.
      *
      * @return whether the boundary conditions are satisfied.
      */
@@ -201,6 +332,19 @@ inline void load_construct_data(
     // Invoke inplace constructor to initialise instance
     ::new(t)SelectivePlaneBoundaryCondition<ELEMENT_DIM, SPACE_DIM>(p_cell_population, point, normal);
 }
+
+/**
+ * The archive version of SelectivePlaneBoundaryCondition. Version 1 adds the
+ * AbstractSnapshotBoundaryCondition base, whether to jiggle nodes on the plane and
+ * whether to use the boundary band index.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+struct version<SelectivePlaneBoundaryCondition<ELEMENT_DIM, SPACE_DIM> >
+{
+    typedef mpl::int_<1> type;
+    typedef mpl::integral_c_tag tag;
+    BOOST_STATIC_CONSTANT(int, value = version::type::value);
+};
 }
 } // namespace ...
 
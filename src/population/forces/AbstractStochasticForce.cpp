@@ -0,0 +1,136 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "AbstractStochasticForce.hpp"
+
+#include <climits>
+
+#include "Exception.hpp"
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+AbstractStochasticForce<ELEMENT_DIM,SPACE_DIM>::AbstractStochasticForce()
+    : AbstractThreadedForce<ELEMENT_DIM,SPACE_DIM>(),
+      mNoiseFrozen(false),
+      mLastDrawTimeStep(UINT_MAX),
+      mNumDrawsThisTimeStep(0)
+{
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+AbstractStochasticForce<ELEMENT_DIM,SPACE_DIM>::~AbstractStochasticForce()
+{
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool AbstractStochasticForce<ELEMENT_DIM,SPACE_DIM>::GetNoiseFrozen() const
+{
+    return mNoiseFrozen;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void AbstractStochasticForce<ELEMENT_DIM,SPACE_DIM>::SetNoiseFrozen(bool noiseFrozen)
+{
+    mNoiseFrozen = noiseFrozen;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+boost::shared_ptr<UtericBudSimulationContext> AbstractStochasticForce<ELEMENT_DIM,SPACE_DIM>::GetSimulationContext() const
+{
+    return mpSimulationContext;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void AbstractStochasticForce<ELEMENT_DIM,SPACE_DIM>::SetSimulationContext(boost::shared_ptr<UtericBudSimulationContext> pSimulationContext)
+{
+    assert(pSimulationContext);
+    mpSimulationContext = pSimulationContext;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void AbstractStochasticForce<ELEMENT_DIM,SPACE_DIM>::FillNodeNormalDeviates(UtericBudRandomStream stream, std::vector<double>& rDeviates)
+{
+    if (!mpSimulationContext)
+    {
+        EXCEPTION("Stochastic forces need a simulation context; add the force to an OffLatticeSimulationUT or call SetSimulationContext().");
+    }
+
+    unsigned time_step = mpSimulationContext->GetTimeStepsElapsed();
+    if (time_step != mLastDrawTimeStep)
+    {
+        mLastDrawTimeStep = time_step;
+        mNumDrawsThisTimeStep = 0;
+    }
+
+    // Only the unattached nodes are given draws, in node order, as attached cells do not diffuse
+    unsigned num_nodes = this->mNodes.size();
+    mCellIds.clear();
+    for (unsigned i=0; i<num_nodes; i++)
+    {
+        unsigned node_index = this->mNodes[i]->GetIndex();
+        if (!this->mpCellAttributeCache->IsAttached(node_index))
+        {
+            mCellIds.push_back(this->mpCellAttributeCache->GetCellId(node_index));
+        }
+    }
+
+    unsigned num_draws = mCellIds.size();
+    mDrawnDeviates.resize(2*num_draws);
+    if (num_draws > 0)
+    {
+        mpSimulationContext->FillStandardNormalRandomDeviates(stream, &mCellIds[0], num_draws, mNumDrawsThisTimeStep, &mDrawnDeviates[0]);
+    }
+
+    // Spread the draws out over the nodes, leaving zeros for the attached nodes
+    rDeviates.assign(2*num_nodes, 0.0);
+    unsigned draw = 0;
+    for (unsigned i=0; i<num_nodes; i++)
+    {
+        if (!this->mpCellAttributeCache->IsAttached(this->mNodes[i]->GetIndex()))
+        {
+            rDeviates[2*i] = mDrawnDeviates[2*draw];
+            rDeviates[2*i + 1] = mDrawnDeviates[2*draw + 1];
+            draw++;
+        }
+    }
+    mNumDrawsThisTimeStep++;
+}
+
+// Explicit instantiation
+template class AbstractStochasticForce<1,1>;
+template class AbstractStochasticForce<1,2>;
+template class AbstractStochasticForce<2,2>;
+template class AbstractStochasticForce<1,3>;
+template class AbstractStochasticForce<2,3>;
+template class AbstractStochasticForce<3,3>;
@@ -0,0 +1,157 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef ABSTRACTSTOCHASTICFORCE_HPP_
+#define ABSTRACTSTOCHASTICFORCE_HPP_
+
+#include "AbstractThreadedForce.hpp"
+#include "UtericBudSimulationContext.hpp"
+#include "AbstractSimulationContextUser.hpp"
+
+#include "ChasteSerialization.hpp"
+#include "ClassIsAbstract.hpp"
+#include <boost/serialization/base_object.hpp>
+
+/**
+ * An abstract threaded force that draws random numbers.
+ *
+ * Numerical methods that evaluate the forces more than once per time step freeze
+ * the noise after the first evaluation, so every stage sees the same random numbers.
+ * Subclasses must then reuse their previous draws rather than making new ones.
+ *
+ * Random numbers and the time step are taken from #mpSimulationContext. Subclasses
+ * should draw through FillNodeNormalDeviates(), which keys the draws by cell, so that
+ * they are independent of the node order when the context has counter-based streams.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM=ELEMENT_DIM>
+class AbstractStochasticForce : public AbstractThreadedForce<ELEMENT_DIM,SPACE_DIM>,
+                                public AbstractSimulationContextUser
+{
+private:
+
+    /** Needed for serialization. */
+    friend class boost::serialization::access;
+    /**
+     * Archive the object and its member variables. #mNoiseFrozen is
+     * transient and #mpSimulationContext is given by the simulation, so
+     * neither is archived.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void serialize(Archive & archive, const unsigned int version)
+    {
+        archive & boost::serialization::base_object<AbstractThreadedForce<ELEMENT_DIM,SPACE_DIM> >(*this);
+    }
+
+protected:
+
+    /** Whether to reuse the random numbers from the previous evaluation. Defaults to false. */
+    bool mNoiseFrozen;
+
+    /**
+     * The source of random numbers and the time step. Given by OffLatticeSimulationUT
+     * in SetupSolve() if not set beforehand.
+     */
+    boost::shared_ptr<UtericBudSimulationContext> mpSimulationContext;
+
+    /** The time step of the last call to FillNodeNormalDeviates(). */
+    unsigned mLastDrawTimeStep;
+
+    /** The number of calls to FillNodeNormalDeviates() made so far in #mLastDrawTimeStep. */
+    unsigned mNumDrawsThisTimeStep;
+
+    /** The cell IDs of the unattached entries of mNodes, used to key the draws. */
+    std::vector<unsigned> mCellIds;
+
+    /** The deviates drawn for the unattached entries of mNodes, before they are spread out. */
+    std::vector<double> mDrawnDeviates;
+
+    /**
+     * Fill a vector with two standard normal deviates per entry of mNodes, in a single
+     * batch from #mpSimulationContext. Only the unattached nodes are given draws, in
+     * node order, so the random number sequence is the same as that of the original
+     * serial BasicDiffusionForce; the entries of attached nodes are zero. The draws are
+     * keyed by the IDs of the cells and by the number of earlier calls in the present
+     * time step, so that successive substeps of a time step see different numbers.
+     *
+     * Must be called serially, after #mpCellAttributeCache has been refreshed.
+     *
+     * @param stream the use the random numbers are for
+     * @param rDeviates the vector to fill
+     */
+    void FillNodeNormalDeviates(UtericBudRandomStream stream, std::vector<double>& rDeviates);
+
+public:
+
+    /**
+     * Default constructor.
+     */
+    AbstractStochasticForce();
+
+    /**
+     * Destructor.
+     */
+    virtual ~AbstractStochasticForce();
+
+    /**
+     * @return #mNoiseFrozen
+     */
+    bool GetNoiseFrozen() const;
+
+    /**
+     * Set #mNoiseFrozen.
+     *
+     * @param noiseFrozen whether to reuse the random numbers from the previous evaluation
+     */
+    void SetNoiseFrozen(bool noiseFrozen);
+
+    /**
+     * @return #mpSimulationContext
+     */
+    boost::shared_ptr<UtericBudSimulationContext> GetSimulationContext() const;
+
+    /**
+     * Set #mpSimulationContext.
+     *
+     * @param pSimulationContext the source of random numbers and the time step
+     */
+    void SetSimulationContext(boost::shared_ptr<UtericBudSimulationContext> pSimulationContext);
+};
+
+TEMPLATED_CLASS_IS_ABSTRACT_2_UNSIGNED(AbstractStochasticForce)
+
+#endif /*ABSTRACTSTOCHASTICFORCE_HPP_*/
@@ -0,0 +1,137 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "AbstractThreadedForce.hpp"
+
+#include <algorithm>
+#include <boost/make_shared.hpp>
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+AbstractThreadedForce<ELEMENT_DIM,SPACE_DIM>::AbstractThreadedForce()
+    : AbstractForce<ELEMENT_DIM,SPACE_DIM>(),
+      mNumThreads(1),
+      mpCellAttributeCache(boost::make_shared<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> >())
+{
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+AbstractThreadedForce<ELEMENT_DIM,SPACE_DIM>::~AbstractThreadedForce()
+{
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void AbstractThreadedForce<ELEMENT_DIM,SPACE_DIM>::PrepareForceContribution(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void AbstractThreadedForce<ELEMENT_DIM,SPACE_DIM>::AddForceContribution(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    // List the nodes, so that they can be shared out between threads by position
+    mNodes.clear();
+    for (typename AbstractMesh<ELEMENT_DIM, SPACE_DIM>::NodeIterator node_iter = rCellPopulation.rGetMesh().GetNodeIteratorBegin();
+         node_iter != rCellPopulation.rGetMesh().GetNodeIteratorEnd();
+         ++node_iter)
+    {
+        mNodes.push_back(&(*node_iter));
+    }
+
+    unsigned num_nodes = mNodes.size();
+    if (num_nodes == 0)
+    {
+        return;
+    }
+
+    PrepareForceContribution(rCellPopulation);
+
+    // Give each thread one contiguous range of nodes
+    mForceBuffer.Resize(std::min(mNumThreads, num_nodes), num_nodes);
+    NodeRangeContribution add_range = {this, &rCellPopulation};
+    mForceBuffer.AccumulateOverRanges(num_nodes, add_range);
+
+    mForceBuffer.ReduceInto(mNodes);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned AbstractThreadedForce<ELEMENT_DIM,SPACE_DIM>::GetNumThreads() const
+{
+    return mNumThreads;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void AbstractThreadedForce<ELEMENT_DIM,SPACE_DIM>::SetNumThreads(unsigned numThreads)
+{
+    assert(numThreads > 0);
+    mNumThreads = numThreads;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > AbstractThreadedForce<ELEMENT_DIM,SPACE_DIM>::GetCellAttributeCache() const
+{
+    return mpCellAttributeCache;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void AbstractThreadedForce<ELEMENT_DIM,SPACE_DIM>::SetCellAttributeCache(boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > pCellAttributeCache)
+{
+    assert(pCellAttributeCache);
+    mpCellAttributeCache = pCellAttributeCache;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void AbstractThreadedForce<ELEMENT_DIM,SPACE_DIM>::ConnectToSimulation(boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > pCellAttributeCache,
+                                                                      boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > pPopulationUpdateCoordinator,
+                                                                      unsigned numForceThreads)
+{
+    SetNumThreads(numForceThreads);
+    SetCellAttributeCache(pCellAttributeCache);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void AbstractThreadedForce<ELEMENT_DIM,SPACE_DIM>::OutputForceParameters(out_stream& rParamsFile)
+{
+    *rParamsFile << "\t\t\t<NumThreads>" << mNumThreads << "</NumThreads>\n";
+
+    // Call method on direct parent class
+    AbstractForce<ELEMENT_DIM,SPACE_DIM>::OutputForceParameters(rParamsFile);
+}
+
+// Explicit instantiation
+template class AbstractThreadedForce<1,1>;
+template class AbstractThreadedForce<1,2>;
+template class AbstractThreadedForce<2,2>;
+template class AbstractThreadedForce<1,3>;
+template class AbstractThreadedForce<2,3>;
+template class AbstractThreadedForce<3,3>;
@@ -0,0 +1,220 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef ABSTRACTTHREADEDFORCE_HPP_
+#define ABSTRACTTHREADEDFORCE_HPP_
+
+#include <vector>
+
+#include "AbstractForce.hpp"
+#include "ForceAccumulationBuffer.hpp"
+#include "CellAttributeCache.hpp"
+#include "AbstractSimulationComponent.hpp"
+
+#include "ChasteSerialization.hpp"
+#include "ClassIsAbstract.hpp"
+#include <boost/serialization/base_object.hpp>
+
+/**
+ * An abstract force whose contributions can be computed by several threads at once.
+ *
+ * AddForceContribution() lists the nodes in mesh order, splits the list into one
+ * contiguous range per thread and calls AddForceContributionToNodes() on each range
+ * in parallel. Contributions go into a ForceAccumulationBuffer rather than straight
+ * onto the nodes, and are added to the nodes once all threads have finished. The
+ * ranges depend only on the number of threads, so the resulting forces are bitwise
+ * reproducible for a given thread count.
+ *
+ * Anything that must happen in a fixed order, such as drawing random numbers, should
+ * be done serially in PrepareForceContribution(), which is called first. Subclasses
+ * that need per-cell attributes should refresh #mpCellAttributeCache there and read
+ * it in AddForceContributionToNodes(), rather than looking up each node's cell.
+ *
+ * The threads are only used if the project is built with OpenMP (openmp=1); otherwise
+ * the ranges are processed one after another, giving the same result.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM=ELEMENT_DIM>
+class AbstractThreadedForce : public AbstractForce<ELEMENT_DIM,SPACE_DIM>,
+                              public AbstractSimulationComponent<ELEMENT_DIM,SPACE_DIM>
+{
+private:
+
+    /** Needed for serialization. */
+    friend class boost::serialization::access;
+    /**
+     * Archive the object and its member variables.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void serialize(Archive & archive, const unsigned int version)
+    {
+        archive & boost::serialization::base_object<AbstractForce<ELEMENT_DIM,SPACE_DIM> >(*this);
+        archive & mNumThreads;
+    }
+
+protected:
+
+    /** The number of threads to use. Defaults to 1. */
+    unsigned mNumThreads;
+
+    /** The nodes of the cell population, in mesh order, for the present call to AddForceContribution(). */
+    std::vector<Node<SPACE_DIM>*> mNodes;
+
+    /** Per-thread storage for force contributions, with one entry per element of #mNodes. */
+    ForceAccumulationBuffer<SPACE_DIM> mForceBuffer;
+
+    /**
+     * The cell attributes, addressed by node index. Defaults to a cache of the force's
+     * own. Not archived.
+     */
+    boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > mpCellAttributeCache;
+
+    /**
+     * Do any serial set-up needed before the force contributions are computed in
+     * parallel. Called once per call to AddForceContribution(), after #mNodes has been
+     * filled in. By default does nothing.
+     *
+     * @param rCellPopulation reference to the cell population
+     */
+    virtual void PrepareForceContribution(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
+    /**
+     * Compute the force contributions for a range of nodes, adding them to
+     * #mForceBuffer using the given thread index. Called concurrently for disjoint
+     * ranges, so must not modify any shared state.
+     *
+     * As this method is pure virtual, it must be overridden in subclasses.
+     *
+     * @param rCellPopulation reference to the cell population
+     * @param begin the position in #mNodes of the first node in the range
+     * @param end one past the position in #mNodes of the last node in the range
+     * @param threadIndex the index of the calling thread, for use with #mForceBuffer
+     */
+    virtual void AddForceContributionToNodes(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation,
+                                             unsigned begin,
+                                             unsigned end,
+                                             unsigned threadIndex)=0;
+
+    /**
+     * Calls AddForceContributionToNodes() on a range of #mNodes, for
+     * ForceAccumulationBuffer::AccumulateOverRanges().
+     */
+    struct NodeRangeContribution
+    {
+        /** The force. */
+        AbstractThreadedForce* mpForce;
+
+        /** The cell population. */
+        AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>* mpCellPopulation;
+
+        /**
+         * @param threadIndex the index of the calling thread
+         * @param begin the position in #mNodes of the first node in the range
+         * @param end one past the position in #mNodes of the last node in the range
+         */
+        void operator()(unsigned threadIndex, unsigned begin, unsigned end) const
+        {
+            mpForce->AddForceContributionToNodes(*mpCellPopulation, begin, end, threadIndex);
+        }
+    };
+
+public:
+
+    /**
+     * Default constructor.
+     */
+    AbstractThreadedForce();
+
+    /**
+     * Destructor.
+     */
+    virtual ~AbstractThreadedForce();
+
+    /**
+     * Overridden AddForceContribution() method.
+     *
+     * @param rCellPopulation reference to the cell population
+     */
+    void AddForceContribution(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
+    /**
+     * @return #mNumThreads
+     */
+    unsigned GetNumThreads() const;
+
+    /**
+     * Set #mNumThreads.
+     *
+     * @param numThreads the new value of #mNumThreads
+     */
+    void SetNumThreads(unsigned numThreads);
+
+    /**
+     * @return #mpCellAttributeCache
+     */
+    boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > GetCellAttributeCache() const;
+
+    /**
+     * Set #mpCellAttributeCache, so that it may be shared with other components.
+     *
+     * @param pCellAttributeCache the cell attribute cache
+     */
+    void SetCellAttributeCache(boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > pCellAttributeCache);
+
+    /**
+     * Overridden ConnectToSimulation() method, which shares the
+     * simulation's cell attribute cache and uses its number of force threads.
+     *
+     * @param pCellAttributeCache the cell attribute cache of the simulation
+     * @param pPopulationUpdateCoordinator the population update coordinator of the simulation
+     * @param numForceThreads the number of threads the forces of the simulation may use
+     */
+    virtual void ConnectToSimulation(boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > pCellAttributeCache,
+                                     boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > pPopulationUpdateCoordinator,
+                                     unsigned numForceThreads);
+
+    /**
+     * Overridden OutputForceParameters() method.
+     *
+     * @param rParamsFile the file stream to which the parameters are output
+     */
+    virtual void OutputForceParameters(out_stream& rParamsFile);
+};
+
+TEMPLATED_CLASS_IS_ABSTRACT_2_UNSIGNED(AbstractThreadedForce)
+
+#endif /*ABSTRACTTHREADEDFORCE_HPP_*/
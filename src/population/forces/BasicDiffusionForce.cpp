@@ -34,42 +34,51 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "BasicDiffusionForce.hpp"
-#include "AttachedCellMutationState.hpp"
-#include "RVCellMutationState.hpp"
-#include "WildTypeCellMutationState.hpp"
 
 BasicDiffusionForce::BasicDiffusionForce(double strength=1.0)
-    : AbstractForce<2>(),
+    : AbstractStochasticForce<2>(),
       mStrength(strength)
 {
     assert(mStrength > 0.0);
 }
 
-void BasicDiffusionForce::AddForceContribution(AbstractCellPopulation<2>& rCellPopulation)
+void BasicDiffusionForce::PrepareForceContribution(AbstractCellPopulation<2>& rCellPopulation)
 {
-    double dt = SimulationTime::Instance()->GetTimeStep();
+    mpCellAttributeCache->Refresh(rCellPopulation);
+
+    // Reuse the previous draws if asked to, as long as the nodes are the same
+    if (mNoiseFrozen && mNormalDeviates.size() == 2*mNodes.size())
+    {
+        return;
+    }
+
+    // Draw two per unattached node in one batch, in node order, exactly as if the force were computed serially
+    FillNodeNormalDeviates(DIFFUSION_RANDOM_STREAM, mNormalDeviates);
+}
+
+void BasicDiffusionForce::AddForceContributionToNodes(AbstractCellPopulation<2>& rCellPopulation, unsigned begin, unsigned end, unsigned threadIndex)
+{
+    double dt = mpSimulationContext->GetTimeStep();
+    double kick_scale = sqrt(2.0*mStrength*dt)/dt;
     
-    for (typename AbstractMesh<2, 2>::NodeIterator node_iter = rCellPopulation.rGetMesh().GetNodeIteratorBegin(); 
-        node_iter != rCellPopulation.rGetMesh().GetNodeIteratorEnd();
-        ++node_iter)
+    for (unsigned i=begin; i<end; i++)
     {
-        unsigned node_index = node_iter->GetIndex();
-        CellPtr p_cell = rCellPopulation.GetCellUsingLocationIndex(node_index);
+        unsigned node_index = mNodes[i]->GetIndex();
         
-        double nu = dynamic_cast<AbstractOffLatticeCellPopulation<2>*>(&rCellPopulation)->GetDampingConstant(node_index);
+        double nu = mpCellAttributeCache->GetDampingConstant(node_index);
         
         c_vector<double, 2> force = zero_vector<double>(2);
         
-        if (!(p_cell->GetMutationState()->IsType<AttachedCellMutationState>()))
+        if (!mpCellAttributeCache->IsAttached(node_index))
         {
-            for (unsigned i=0; i<2; i++)
+            for (unsigned j=0; j<2; j++)
             {
-                double xi = RandomNumberGenerator::Instance()->StandardNormalRandomDeviate();
-                force[i] = (nu*sqrt(2.0*mStrength*dt)/dt)*xi;
+                double xi = mNormalDeviates[2*i + j];
+                force[j] = (nu*kick_scale)*xi;
             }
         }
         
-        node_iter->AddAppliedForceContribution(force);
+        mForceBuffer.AddForce(threadIndex, i, force);
     }
 }
 
@@ -81,7 +90,7 @@ double BasicDiffusionForce::GetStrength()
 void BasicDiffusionForce::OutputForceParameters(out_stream& rParamsFile)
 {
     *rParamsFile << "\t\t\t<Strength>" << mStrength << "</Strength>\n";
-    AbstractForce<2>::OutputForceParameters(rParamsFile);
+    AbstractStochasticForce<2>::OutputForceParameters(rParamsFile);
 }
 
 #include "SerializationExportWrapperForCpp.hpp"
@@ -34,12 +34,13 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 
-#include "AbstractForce.hpp"
+#include "AbstractStochasticForce.hpp"
 #include "NodeBasedCellPopulation.hpp"
 #include "RandomNumberGenerator.hpp"
+#include <boost/serialization/version.hpp>
 
 
-class BasicDiffusionForce : public AbstractForce<2>
+class BasicDiffusionForce : public AbstractStochasticForce<2>
 {
 private : 
     
@@ -49,15 +50,47 @@ private :
     template<class Archive>
     void serialize(Archive & archive, const unsigned int version)
     {
-        archive & boost::serialization::base_object<AbstractForce<2> >(*this);
+        // Before version 1 the force derived directly from AbstractForce
+        if (version > 0)
+        {
+            archive & boost::serialization::base_object<AbstractStochasticForce<2> >(*this);
+        }
+        else
+        {
+            archive & boost::serialization::base_object<AbstractForce<2> >(*this);
+        }
         archive & mStrength;
     }
 
+    /**
+     * Standard normal deviates for the present call to AddForceContribution(), two
+     * per entry of mNodes. Drawn serially in one batch, in node order, so that the
+     * random number sequence does not depend on the number of threads.
+     */
+    std::vector<double> mNormalDeviates;
+
+    /**
+     * Overridden PrepareForceContribution() method.
+     *
+     * Draw the random numbers for every node.
+     *
+     * @param rCellPopulation reference to the cell population
+     */
+    void PrepareForceContribution(AbstractCellPopulation<2>& rCellPopulation);
+
+    /**
+     * Overridden AddForceContributionToNodes() method.
+     *
+     * @param rCellPopulation reference to the cell population
+     * @param begin the position of the first node in the range
+     * @param end one past the position of the last node in the range
+     * @param threadIndex the index of the calling thread
+     */
+    void AddForceContributionToNodes(AbstractCellPopulation<2>& rCellPopulation, unsigned begin, unsigned end, unsigned threadIndex);
+
 public : 
     BasicDiffusionForce(double);
     
-    void AddForceContribution(AbstractCellPopulation<2>& rCellPopulation);
-    
     double GetStrength();
     
     virtual void OutputForceParameters(out_stream& rParamsFile);
@@ -66,5 +99,6 @@ public :
 
 #include "SerializationExportWrapper.hpp"
 CHASTE_CLASS_EXPORT(BasicDiffusionForce)
+BOOST_CLASS_VERSION(BasicDiffusionForce, 1)
 
 
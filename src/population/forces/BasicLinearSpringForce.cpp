@@ -36,12 +36,23 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "BasicLinearSpringForce.hpp"
 #include "IsNan.hpp"
 
+#include <cfloat>
+#include <climits>
+#include <algorithm>
+
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::BasicLinearSpringForce()
    : AbstractTwoBodyInteractionForce<ELEMENT_DIM,SPACE_DIM>(),
      mMeinekeSpringStiffness(15.0),        // denoted by mu in Meineke et al, 2001 (doi:10.1046/j.0960-7722.2001.00216.x)
      mMeinekeDivisionRestingSpringLength(0.5),
-     mMeinekeSpringGrowthDuration(1.0)
+     mMeinekeSpringGrowthDuration(1.0),
+     mUseVerletList(false),
+     mVerletSkin(0.3),
+     mUseBatchedKernel(false),
+     mUseTabulatedForceLaw(false),
+     mTabulatedForceLawTolerance(1e-6),
+     mNumThreads(1),
+     mUseSinglePrecision(false)
 {
     if (SPACE_DIM == 1)
     {
@@ -205,6 +216,11 @@ c_vector<double, SPACE_DIM> BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::Calcu
     }
     else
     {
+        if (mUseTabulatedForceLaw)
+        {
+            return multiplication_factor * rGetTabulatedForceLaw().GetForceMagnitude(overlap, rest_length_final, spring_stiffness) * unit_difference;
+        }
+
         // A reasonably stable simple force law
         if (is_closer_than_rest_length) //overlap is negative
         {
@@ -222,6 +238,185 @@ c_vector<double, SPACE_DIM> BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::Calcu
     }
 }
 
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::AddForceContribution(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    if (mUseVerletList)
+    {
+        if (mVerletList.GetSkin() != mVerletSkin)
+        {
+            mVerletList.SetSkin(mVerletSkin);
+        }
+
+        if (mUseBatchedKernel)
+        {
+            mVerletList.Update(rCellPopulation, this->GetCutOffLength());
+            AddBatchedForceContribution(mVerletList.rGetNodePairs(), rCellPopulation);
+        }
+        else if (mNumThreads > 1)
+        {
+            mVerletList.Update(rCellPopulation, this->GetCutOffLength());
+            AddThreadedForceContribution(mVerletList.rGetNodePairs(), rCellPopulation);
+        }
+        else
+        {
+            mVerletList.AddForceContribution(*this, rCellPopulation);
+        }
+    }
+    else if (mUseBatchedKernel || mNumThreads > 1)
+    {
+        // Throw an exception message if not using a subclass of AbstractCentreBasedCellPopulation
+        if (dynamic_cast<AbstractCentreBasedCellPopulation<ELEMENT_DIM,SPACE_DIM>*>(&rCellPopulation) == NULL)
+        {
+            EXCEPTION("Subclasses of AbstractTwoBodyInteractionForce are to be used with subclasses of AbstractCentreBasedCellPopulation only");
+        }
+
+        AbstractCentreBasedCellPopulation<ELEMENT_DIM,SPACE_DIM>* p_static_cast_cell_population = static_cast<AbstractCentreBasedCellPopulation<ELEMENT_DIM,SPACE_DIM>*>(&rCellPopulation);
+        if (mUseBatchedKernel)
+        {
+            AddBatchedForceContribution(p_static_cast_cell_population->rGetNodePairs(), rCellPopulation);
+        }
+        else
+        {
+            AddThreadedForceContribution(p_static_cast_cell_population->rGetNodePairs(), rCellPopulation);
+        }
+    }
+    else
+    {
+        AbstractTwoBodyInteractionForce<ELEMENT_DIM,SPACE_DIM>::AddForceContribution(rCellPopulation);
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::AddBatchedForceContribution(const std::vector<std::pair<Node<SPACE_DIM>*, Node<SPACE_DIM>*> >& rNodePairs,
+                                                                                AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    if (mUseSinglePrecision)
+    {
+        AddBatchedForceContribution(rNodePairs, rCellPopulation, mSinglePrecisionKernel,
+                                    mSinglePrecisionLocations, mSinglePrecisionRadii, mSinglePrecisionMultipliers);
+    }
+    else
+    {
+        AddBatchedForceContribution(rNodePairs, rCellPopulation, mBatchedKernel,
+                                    mBatchedLocations, mBatchedRadii, mBatchedMultipliers);
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+template<class REAL>
+void BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::AddBatchedForceContribution(const std::vector<std::pair<Node<SPACE_DIM>*, Node<SPACE_DIM>*> >& rNodePairs,
+                                                                                AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation,
+                                                                                BatchedSpringForceKernel<SPACE_DIM, REAL>& rKernel,
+                                                                                std::vector<REAL>& rLocations,
+                                                                                std::vector<REAL>& rRadii,
+                                                                                std::vector<REAL>& rMultipliers)
+{
+    unsigned num_pairs = rNodePairs.size();
+    if (num_pairs == 0)
+    {
+        return;
+    }
+
+    // Gather the node locations and radii into flat arrays indexed by global index
+    AbstractMesh<ELEMENT_DIM,SPACE_DIM>& r_mesh = rCellPopulation.rGetMesh();
+    unsigned num_nodes = r_mesh.GetMaximumNodeIndex();
+    rLocations.assign(num_nodes*SPACE_DIM, 0);
+    rRadii.assign(num_nodes, 1);
+
+    for (typename AbstractMesh<ELEMENT_DIM,SPACE_DIM>::NodeIterator node_iter = r_mesh.GetNodeIteratorBegin();
+         node_iter != r_mesh.GetNodeIteratorEnd();
+         ++node_iter)
+    {
+        unsigned node_index = node_iter->GetIndex();
+        const c_vector<double, SPACE_DIM>& r_location = node_iter->rGetLocation();
+        for (unsigned d=0; d<SPACE_DIM; d++)
+        {
+            rLocations[d*num_nodes + node_index] = r_location[d];
+        }
+        rRadii[node_index] = node_iter->GetRadius();
+    }
+
+    mBatchedFirstNodes.resize(num_pairs);
+    mBatchedSecondNodes.resize(num_pairs);
+    mBatchedFirstIndices.resize(num_pairs);
+    mBatchedSecondIndices.resize(num_pairs);
+    for (unsigned pair=0; pair<num_pairs; pair++)
+    {
+        mBatchedFirstNodes[pair] = rNodePairs[pair].first;
+        mBatchedSecondNodes[pair] = rNodePairs[pair].second;
+        mBatchedFirstIndices[pair] = rNodePairs[pair].first->GetIndex();
+        mBatchedSecondIndices[pair] = rNodePairs[pair].second->GetIndex();
+    }
+
+    bool use_hookean_law = bool(dynamic_cast<MeshBasedCellPopulation<ELEMENT_DIM,SPACE_DIM>*>(&rCellPopulation));
+    double cut_off_length = this->mUseCutOffLength ? this->GetCutOffLength() : DBL_MAX;
+    rKernel.SetParameters(mMeinekeSpringStiffness, cut_off_length, use_hookean_law);
+    rKernel.ComputeGeometry(&mBatchedFirstIndices[0], &mBatchedSecondIndices[0], num_pairs,
+                            &rLocations[0], num_nodes, &rRadii[0]);
+
+    // The multiplication factor may be overridden in subclasses, so is evaluated pair by pair
+    const std::vector<REAL>& r_overlaps = rKernel.rGetOverlaps();
+    rMultipliers.resize(num_pairs);
+    for (unsigned pair=0; pair<num_pairs; pair++)
+    {
+        rMultipliers[pair] = VariableSpringConstantMultiplicationFactor(mBatchedFirstIndices[pair],
+                                                                        mBatchedSecondIndices[pair],
+                                                                        rCellPopulation,
+                                                                        r_overlaps[pair] <= 0);
+    }
+    rKernel.ComputeForces(&rMultipliers[0]);
+
+    // Scatter the forces back to the nodes
+    const std::vector<REAL>& r_forces = rKernel.rGetForces();
+    for (unsigned pair=0; pair<num_pairs; pair++)
+    {
+        c_vector<double, SPACE_DIM> force;
+        for (unsigned d=0; d<SPACE_DIM; d++)
+        {
+            force[d] = r_forces[d*num_pairs + pair];
+        }
+        c_vector<double, SPACE_DIM> negative_force = -1.0 * force;
+        mBatchedSecondNodes[pair]->AddAppliedForceContribution(negative_force);
+        mBatchedFirstNodes[pair]->AddAppliedForceContribution(force);
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::ListThreadedNodes(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    AbstractMesh<ELEMENT_DIM,SPACE_DIM>& r_mesh = rCellPopulation.rGetMesh();
+    mThreadedNodes.clear();
+    mThreadedEntries.assign(r_mesh.GetMaximumNodeIndex(), UINT_MAX);
+    for (typename AbstractMesh<ELEMENT_DIM,SPACE_DIM>::NodeIterator node_iter = r_mesh.GetNodeIteratorBegin();
+         node_iter != r_mesh.GetNodeIteratorEnd();
+         ++node_iter)
+    {
+        mThreadedEntries[node_iter->GetIndex()] = mThreadedNodes.size();
+        mThreadedNodes.push_back(&(*node_iter));
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::AddThreadedForceContribution(const std::vector<std::pair<Node<SPACE_DIM>*, Node<SPACE_DIM>*> >& rNodePairs,
+                                                                                 AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    unsigned num_pairs = rNodePairs.size();
+    if (num_pairs == 0)
+    {
+        return;
+    }
+
+    // The tables are built lazily, which must not happen on several threads at once
+    if (mUseTabulatedForceLaw)
+    {
+        rGetTabulatedForceLaw();
+    }
+
+    VirtualPairForce pair_force = {this, &rCellPopulation};
+    AddThreadedPairForces(rNodePairs, rCellPopulation, pair_force);
+}
+
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 double BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::GetMeinekeSpringStiffness()
 {
@@ -264,12 +459,130 @@ void BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::SetMeinekeSpringGrowthDurati
     mMeinekeSpringGrowthDuration = springGrowthDuration;
 }
 
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::SetUseVerletList(bool useVerletList)
+{
+    mUseVerletList = useVerletList;
+    mVerletList.Invalidate();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::GetUseVerletList()
+{
+    return mUseVerletList;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::SetVerletSkin(double verletSkin)
+{
+    assert(verletSkin >= 0.0);
+    mVerletSkin = verletSkin;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+double BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::GetVerletSkin()
+{
+    return mVerletSkin;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const VerletNeighbourList<ELEMENT_DIM,SPACE_DIM>& BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::rGetVerletNeighbourList() const
+{
+    return mVerletList;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::SetUseBatchedKernel(bool useBatchedKernel)
+{
+    mUseBatchedKernel = useBatchedKernel;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::GetUseBatchedKernel()
+{
+    return mUseBatchedKernel;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::SetUseSinglePrecision(bool useSinglePrecision)
+{
+    mUseSinglePrecision = useSinglePrecision;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::GetUseSinglePrecision()
+{
+    return mUseSinglePrecision;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::SetUseTabulatedForceLaw(bool useTabulatedForceLaw, double maxRelativeError)
+{
+    assert(maxRelativeError > 0.0);
+    mUseTabulatedForceLaw = useTabulatedForceLaw;
+    mTabulatedForceLawTolerance = maxRelativeError;
+    if (mUseTabulatedForceLaw)
+    {
+        mTabulatedForceLaw.Setup(mTabulatedForceLawTolerance);
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::GetUseTabulatedForceLaw()
+{
+    return mUseTabulatedForceLaw;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+double BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::GetTabulatedForceLawTolerance()
+{
+    return mTabulatedForceLawTolerance;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const TabulatedSpringForceLaw& BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::rGetTabulatedForceLaw()
+{
+    if (!mTabulatedForceLaw.IsSetUp() || mTabulatedForceLaw.GetMaxRelativeError() != mTabulatedForceLawTolerance)
+    {
+        mTabulatedForceLaw.Setup(mTabulatedForceLawTolerance);
+    }
+    return mTabulatedForceLaw;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::SetNumThreads(unsigned numThreads)
+{
+    assert(numThreads > 0);
+    mNumThreads = numThreads;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::GetNumThreads() const
+{
+    return mNumThreads;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::ConnectToSimulation(boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > pCellAttributeCache,
+                                                                       boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > pPopulationUpdateCoordinator,
+                                                                       unsigned numForceThreads)
+{
+    SetNumThreads(numForceThreads);
+}
+
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 void BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::OutputForceParameters(out_stream& rParamsFile)
 {
     *rParamsFile << "\t\t\t<MeinekeSpringStiffness>" << mMeinekeSpringStiffness << "</MeinekeSpringStiffness>\n";
     *rParamsFile << "\t\t\t<MeinekeDivisionRestingSpringLength>" << mMeinekeDivisionRestingSpringLength << "</MeinekeDivisionRestingSpringLength>\n";
     *rParamsFile << "\t\t\t<MeinekeSpringGrowthDuration>" << mMeinekeSpringGrowthDuration << "</MeinekeSpringGrowthDuration>\n";
+    *rParamsFile << "\t\t\t<UseVerletList>" << mUseVerletList << "</UseVerletList>\n";
+    *rParamsFile << "\t\t\t<VerletSkin>" << mVerletSkin << "</VerletSkin>\n";
+    *rParamsFile << "\t\t\t<UseBatchedKernel>" << mUseBatchedKernel << "</UseBatchedKernel>\n";
+    *rParamsFile << "\t\t\t<UseSinglePrecision>" << mUseSinglePrecision << "</UseSinglePrecision>\n";
+    *rParamsFile << "\t\t\t<UseTabulatedForceLaw>" << mUseTabulatedForceLaw << "</UseTabulatedForceLaw>\n";
+    *rParamsFile << "\t\t\t<TabulatedForceLawTolerance>" << mTabulatedForceLawTolerance << "</TabulatedForceLawTolerance>\n";
+    *rParamsFile << "\t\t\t<NumThreads>" << mNumThreads << "</NumThreads>\n";
 
     // Call method on direct parent class
     AbstractTwoBodyInteractionForce<ELEMENT_DIM,SPACE_DIM>::OutputForceParameters(rParamsFile);
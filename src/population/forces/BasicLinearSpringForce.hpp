@@ -33,10 +33,23 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 */
 
+#ifndef BASICLINEARSPRINGFORCE_HPP_
+#define BASICLINEARSPRINGFORCE_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+
 #include "AbstractTwoBodyInteractionForce.hpp"
+#include "VerletNeighbourList.hpp"
+#include "BatchedSpringForceKernel.hpp"
+#include "TabulatedSpringForceLaw.hpp"
+#include "ForceAccumulationBuffer.hpp"
+#include "AbstractSimulationComponent.hpp"
 
 #include "ChasteSerialization.hpp"
 #include <boost/serialization/base_object.hpp>
+#include <boost/serialization/version.hpp>
 
 /**
  * A force law employed by Meineke et al (2001) in their off-lattice
@@ -57,9 +70,29 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *
  * Length is scaled by natural length.
  * Time is in hours.
+ *
+ * If a cut-off is set, the pairs of interacting nodes may optionally be taken from
+ * a VerletNeighbourList owned by the force, rather than from the cell population.
+ *
+ * The force law may optionally be evaluated for all pairs at once by a
+ * BatchedSpringForceKernel, rather than by calling CalculateForceBetweenNodes()
+ * for each pair. This cannot be used with periodic meshes. The batched kernel may
+ * also optionally work in single precision, gathering the node locations and radii
+ * into float arrays, for speed where ensemble statistics do not need full precision.
+ *
+ * The node-based force law may also optionally be evaluated from a
+ * TabulatedSpringForceLaw, to a given relative error, rather than with log() and exp().
+ *
+ * If more than one thread is set, the pairs are split into one contiguous range per
+ * thread and each pair is still evaluated once. Each thread adds the equal and opposite
+ * contributions of its pairs to its own slab of a ForceAccumulationBuffer, and the slabs
+ * are summed as a binary tree, so the forces are bitwise reproducible for a given
+ * thread count. Overrides of VariableSpringConstantMultiplicationFactor() must then be
+ * safe to call concurrently. The batched kernel, if used, is always serial.
  */
 template<unsigned  ELEMENT_DIM, unsigned SPACE_DIM=ELEMENT_DIM>
-class BasicLinearSpringForce : public AbstractTwoBodyInteractionForce<ELEMENT_DIM, SPACE_DIM>
+class BasicLinearSpringForce : public AbstractTwoBodyInteractionForce<ELEMENT_DIM, SPACE_DIM>,
+                               public AbstractSimulationComponent<ELEMENT_DIM, SPACE_DIM>
 {
     friend class TestForces;
 
@@ -80,6 +113,18 @@ private:
         archive & mMeinekeSpringStiffness;
         archive & mMeinekeDivisionRestingSpringLength;
         archive & mMeinekeSpringGrowthDuration;
+
+        // Archives of version 0 were written before any of the options below were added
+        if (version > 0)
+        {
+            archive & mUseVerletList;
+            archive & mVerletSkin;
+            archive & mUseBatchedKernel;
+            archive & mUseTabulatedForceLaw;
+            archive & mTabulatedForceLawTolerance;
+            archive & mNumThreads;
+            archive & mUseSinglePrecision;
+        }
     }
 
 protected:
@@ -110,6 +155,218 @@ protected:
      */
     double mMeinekeSpringGrowthDuration;
 
+    /** Whether to take the interacting pairs from #mVerletList. Defaults to false. */
+    bool mUseVerletList;
+
+    /** The skin distance of #mVerletList. Defaults to 0.3. */
+    double mVerletSkin;
+
+    /** The Verlet neighbour list, rebuilt as needed so not archived. */
+    VerletNeighbourList<ELEMENT_DIM, SPACE_DIM> mVerletList;
+
+    /** Whether to evaluate the force law with #mBatchedKernel. Defaults to false. */
+    bool mUseBatchedKernel;
+
+    /** The batched force kernel, which only holds workspace so is not archived. */
+    BatchedSpringForceKernel<SPACE_DIM> mBatchedKernel;
+
+    /** Whether to evaluate the node-based force law from #mTabulatedForceLaw. Defaults to false. */
+    bool mUseTabulatedForceLaw;
+
+    /** The maximum relative error of #mTabulatedForceLaw. Defaults to 1e-6. */
+    double mTabulatedForceLawTolerance;
+
+    /** The tabulated force law, rebuilt when first needed so not archived. */
+    TabulatedSpringForceLaw mTabulatedForceLaw;
+
+    /** The first node of each pair passed to #mBatchedKernel. */
+    std::vector<Node<SPACE_DIM>*> mBatchedFirstNodes;
+
+    /** The second node of each pair passed to #mBatchedKernel. */
+    std::vector<Node<SPACE_DIM>*> mBatchedSecondNodes;
+
+    /** The global index of the first node of each pair passed to #mBatchedKernel. */
+    std::vector<unsigned> mBatchedFirstIndices;
+
+    /** The global index of the second node of each pair passed to #mBatchedKernel. */
+    std::vector<unsigned> mBatchedSecondIndices;
+
+    /** The node locations passed to #mBatchedKernel, indexed by global index, dimension by dimension. */
+    std::vector<double> mBatchedLocations;
+
+    /** The node radii passed to #mBatchedKernel, indexed by global index. */
+    std::vector<double> mBatchedRadii;
+
+    /** The spring constant multiplication factor of each pair passed to #mBatchedKernel. */
+    std::vector<double> mBatchedMultipliers;
+
+    /** Whether the batched kernel works in single precision. Defaults to false. */
+    bool mUseSinglePrecision;
+
+    /** The single precision batched force kernel, which only holds workspace so is not archived. */
+    BatchedSpringForceKernel<SPACE_DIM, float> mSinglePrecisionKernel;
+
+    /** The node locations passed to #mSinglePrecisionKernel, laid out as #mBatchedLocations. */
+    std::vector<float> mSinglePrecisionLocations;
+
+    /** The node radii passed to #mSinglePrecisionKernel, indexed by global index. */
+    std::vector<float> mSinglePrecisionRadii;
+
+    /** The spring constant multiplication factor of each pair passed to #mSinglePrecisionKernel. */
+    std::vector<float> mSinglePrecisionMultipliers;
+
+    /** The number of threads over which to share the pairs. Defaults to 1. */
+    unsigned mNumThreads;
+
+    /** The nodes of the cell population, in mesh order, for the present threaded call. */
+    std::vector<Node<SPACE_DIM>*> mThreadedNodes;
+
+    /** The position in #mThreadedNodes of each node, indexed by global index. */
+    std::vector<unsigned> mThreadedEntries;
+
+    /** Per-thread storage for the threaded force contributions, with one entry per element of #mThreadedNodes. */
+    ForceAccumulationBuffer<SPACE_DIM> mForceBuffer;
+
+    /**
+     * Add the force between each pair of interacting nodes, evaluated with #mBatchedKernel,
+     * or with #mSinglePrecisionKernel if #mUseSinglePrecision is set.
+     *
+     * @param rNodePairs the pairs of interacting nodes
+     * @param rCellPopulation the cell population
+     */
+    void AddBatchedForceContribution(const std::vector<std::pair<Node<SPACE_DIM>*, Node<SPACE_DIM>*> >& rNodePairs,
+                                     AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
+    /**
+     * Add the force between each pair of interacting nodes, evaluated with the given
+     * batched kernel in precision REAL.
+     *
+     * @param rNodePairs the pairs of interacting nodes
+     * @param rCellPopulation the cell population
+     * @param rKernel the batched kernel
+     * @param rLocations workspace for the node locations
+     * @param rRadii workspace for the node radii
+     * @param rMultipliers workspace for the spring constant multiplication factors
+     */
+    template<class REAL>
+    void AddBatchedForceContribution(const std::vector<std::pair<Node<SPACE_DIM>*, Node<SPACE_DIM>*> >& rNodePairs,
+                                     AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation,
+                                     BatchedSpringForceKernel<SPACE_DIM, REAL>& rKernel,
+                                     std::vector<REAL>& rLocations,
+                                     std::vector<REAL>& rRadii,
+                                     std::vector<REAL>& rMultipliers);
+
+    /**
+     * Fill in #mThreadedNodes and #mThreadedEntries from the nodes of the cell population,
+     * so that each node has an entry in #mForceBuffer with no gaps for deleted nodes.
+     *
+     * @param rCellPopulation the cell population
+     */
+    void ListThreadedNodes(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
+    /**
+     * Adds the forces of a range of pairs to both of their nodes' entries in the slab
+     * of a thread, for ForceAccumulationBuffer::AccumulateOverRanges().
+     */
+    template<class PAIR_FORCE>
+    struct PairRangeContribution
+    {
+        /** The force. */
+        BasicLinearSpringForce* mpForce;
+
+        /** The pairs of interacting nodes. */
+        const std::vector<std::pair<Node<SPACE_DIM>*, Node<SPACE_DIM>*> >* mpNodePairs;
+
+        /** Computes the force on the first node of a pair, as for AddThreadedPairForces(). */
+        const PAIR_FORCE* mpPairForce;
+
+        /**
+         * @param threadIndex the index of the calling thread
+         * @param begin the first pair in the range
+         * @param end one past the last pair in the range
+         */
+        void operator()(unsigned threadIndex, unsigned begin, unsigned end) const
+        {
+            for (unsigned pair=begin; pair<end; pair++)
+            {
+                Node<SPACE_DIM>* p_node_a = (*mpNodePairs)[pair].first;
+                Node<SPACE_DIM>* p_node_b = (*mpNodePairs)[pair].second;
+
+                c_vector<double, SPACE_DIM> force;
+                if ((*mpPairForce)(p_node_a, p_node_b, force))
+                {
+                    unsigned entry_a = mpForce->mThreadedEntries[p_node_a->GetIndex()];
+                    unsigned entry_b = mpForce->mThreadedEntries[p_node_b->GetIndex()];
+                    assert(entry_a != UINT_MAX && entry_b != UINT_MAX);
+
+                    c_vector<double, SPACE_DIM> negative_force = -1.0 * force;
+                    mpForce->mForceBuffer.AddForce(threadIndex, entry_b, negative_force);
+                    mpForce->mForceBuffer.AddForce(threadIndex, entry_a, force);
+                }
+            }
+        }
+    };
+
+    /**
+     * Add the force between each pair of nodes to both nodes, sharing the pairs out
+     * between #mNumThreads threads, each adding both halves of its pairs to its own slab
+     * of #mForceBuffer. The slabs are summed as a binary tree.
+     *
+     * @param rNodePairs the pairs of interacting nodes, at least one
+     * @param rCellPopulation the cell population
+     * @param rPairForce the function object called as rPairForce(pNodeA, pNodeB, rForce),
+     *     which sets rForce to the force on the first node and returns whether there is one;
+     *     it must be safe to call concurrently
+     */
+    template<class PAIR_FORCE>
+    void AddThreadedPairForces(const std::vector<std::pair<Node<SPACE_DIM>*, Node<SPACE_DIM>*> >& rNodePairs,
+                               AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation,
+                               const PAIR_FORCE& rPairForce)
+    {
+        unsigned num_pairs = rNodePairs.size();
+        ListThreadedNodes(rCellPopulation);
+        mForceBuffer.Resize(std::min(mNumThreads, num_pairs), mThreadedNodes.size());
+
+        PairRangeContribution<PAIR_FORCE> add_range = {this, &rNodePairs, &rPairForce};
+        mForceBuffer.AccumulateOverRanges(num_pairs, add_range);
+
+        mForceBuffer.TreeReduceInto(mThreadedNodes);
+    }
+
+    /**
+     * Calls CalculateForceBetweenNodes() on a pair, for AddThreadedPairForces().
+     */
+    struct VirtualPairForce
+    {
+        /** The force. */
+        BasicLinearSpringForce* mpForce;
+
+        /** The cell population. */
+        AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>* mpCellPopulation;
+
+        /**
+         * @param pNodeA the first node of the pair
+         * @param pNodeB the second node of the pair
+         * @param rForce the force on the first node (output)
+         * @return true
+         */
+        bool operator()(Node<SPACE_DIM>* pNodeA, Node<SPACE_DIM>* pNodeB, c_vector<double, SPACE_DIM>& rForce) const
+        {
+            rForce = mpForce->CalculateForceBetweenNodes(pNodeA->GetIndex(), pNodeB->GetIndex(), *mpCellPopulation);
+            return true;
+        }
+    };
+
+    /**
+     * Add the force between each pair of interacting nodes, sharing the pairs out
+     * between #mNumThreads threads.
+     *
+     * @param rNodePairs the pairs of interacting nodes
+     * @param rCellPopulation the cell population
+     */
+    void AddThreadedForceContribution(const std::vector<std::pair<Node<SPACE_DIM>*, Node<SPACE_DIM>*> >& rNodePairs,
+                                      AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
 public:
 
     /**
@@ -155,6 +412,18 @@ public:
     c_vector<double, SPACE_DIM> CalculateForceBetweenNodes(unsigned nodeAGlobalIndex,
                                                      unsigned nodeBGlobalIndex,
                                                      AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+    /**
+     * Overridden AddForceContribution() method.
+     *
+     * Uses #mVerletList if #mUseVerletList is set, and otherwise the pairs found by
+     * the cell population. Evaluates the force law with #mBatchedKernel if
+     * #mUseBatchedKernel is set, and otherwise on #mNumThreads threads if there
+     * are more than one.
+     *
+     * @param rCellPopulation reference to the cell population
+     */
+    virtual void AddForceContribution(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
     /**
      * @return mMeinekeSpringStiffness
      */
@@ -191,6 +460,108 @@ public:
      */
     void SetMeinekeSpringGrowthDuration(double springGrowthDuration);
 
+    /**
+     * Set mUseVerletList. A cut-off length must also be set.
+     *
+     * @param useVerletList whether to take the interacting pairs from a Verlet neighbour list
+     */
+    void SetUseVerletList(bool useVerletList);
+
+    /**
+     * @return mUseVerletList
+     */
+    bool GetUseVerletList();
+
+    /**
+     * Set mVerletSkin.
+     *
+     * @param verletSkin the skin distance of the Verlet neighbour list
+     */
+    void SetVerletSkin(double verletSkin);
+
+    /**
+     * @return mVerletSkin
+     */
+    double GetVerletSkin();
+
+    /**
+     * @return the Verlet neighbour list, for its rebuild counters.
+     */
+    const VerletNeighbourList<ELEMENT_DIM, SPACE_DIM>& rGetVerletNeighbourList() const;
+
+    /**
+     * Set mUseBatchedKernel.
+     *
+     * @param useBatchedKernel whether to evaluate the force law for all pairs at once
+     */
+    void SetUseBatchedKernel(bool useBatchedKernel);
+
+    /**
+     * @return mUseBatchedKernel
+     */
+    bool GetUseBatchedKernel();
+
+    /**
+     * Set mUseSinglePrecision. Only the batched kernel uses it.
+     *
+     * @param useSinglePrecision whether the batched kernel works in single precision
+     */
+    void SetUseSinglePrecision(bool useSinglePrecision);
+
+    /**
+     * @return mUseSinglePrecision
+     */
+    bool GetUseSinglePrecision();
+
+    /**
+     * Set mUseTabulatedForceLaw and mTabulatedForceLawTolerance. The tables are built
+     * straight away. The batched kernel does not use them.
+     *
+     * @param useTabulatedForceLaw whether to evaluate the node-based force law from tables
+     * @param maxRelativeError the maximum relative error of the tables (defaults to 1e-6)
+     */
+    void SetUseTabulatedForceLaw(bool useTabulatedForceLaw, double maxRelativeError=1e-6);
+
+    /**
+     * @return mUseTabulatedForceLaw
+     */
+    bool GetUseTabulatedForceLaw();
+
+    /**
+     * @return mTabulatedForceLawTolerance
+     */
+    double GetTabulatedForceLawTolerance();
+
+    /**
+     * @return the tabulated force law, first building its tables if they are missing
+     *     (for example after loading from an archive).
+     */
+    const TabulatedSpringForceLaw& rGetTabulatedForceLaw();
+
+    /**
+     * Set mNumThreads. Only has an effect if built with OpenMP.
+     *
+     * @param numThreads the number of threads over which to share the pairs
+     */
+    void SetNumThreads(unsigned numThreads);
+
+    /**
+     * @return mNumThreads
+     */
+    unsigned GetNumThreads() const;
+
+    /**
+     * Overridden ConnectToSimulation() method, which uses the simulation's
+     * number of force threads.
+     *
+     * @param pCellAttributeCache the cell attribute cache of the simulation
+     * @param pPopulationUpdateCoordinator the population update coordinator of the simulation
+     * @param numForceThreads the number of threads the forces of the simulation may use
+     */
+    virtual void ConnectToSimulation(boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > pCellAttributeCache,
+                                     boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > pPopulationUpdateCoordinator,
+                                     unsigned numForceThreads);
+
     /**
      * Overridden OutputForceParameters() method.
      *
@@ -201,3 +572,24 @@ public:
 
 #include "SerializationExportWrapper.hpp"
 EXPORT_TEMPLATE_CLASS_ALL_DIMS(BasicLinearSpringForce)
+
+namespace boost
+{
+namespace serialization
+{
+/**
+ * The archive version of BasicLinearSpringForce. Version 1 adds the Verlet list settings,
+ * the batched kernel switch, the tabulated force law settings, the number of threads and
+ * the single precision switch.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+struct version<BasicLinearSpringForce<ELEMENT_DIM, SPACE_DIM> >
+{
+    typedef mpl::int_<1> type;
+    typedef mpl::integral_c_tag tag;
+    BOOST_STATIC_CONSTANT(int, value = version::type::value);
+};
+}
+} // namespace
+
+#endif /*BASICLINEARSPRINGFORCE_HPP_*/
@@ -0,0 +1,250 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "BatchedSpringForceKernel.hpp"
+
+#include <cassert>
+#include <cmath>
+
+/*
+ * The gathers are done by these helpers because GCC only uses __restrict__ on function
+ * parameters. Without it the compiler must assume the outputs may overlap the values
+ * being gathered, and it cannot check that at run time for indexed loads, so the loops
+ * are not vectorised.
+ */
+
+/**
+ * Set pDifferences[i] = pValues[pSecond[i]] - pValues[pFirst[i]] and add its square
+ * to pSquaredSums[i].
+ *
+ * @param pDifferences the differences (output)
+ * @param pSquaredSums the running sums of squared differences (input and output)
+ * @param pValues the values to gather from
+ * @param pFirst the index of the first value of each difference
+ * @param pSecond the index of the second value of each difference
+ * @param num the number of differences
+ */
+template<class REAL>
+static void GatherDifferences(REAL* __restrict__ pDifferences,
+                              REAL* __restrict__ pSquaredSums,
+                              const REAL* pValues,
+                              const unsigned* pFirst,
+                              const unsigned* pSecond,
+                              unsigned num)
+{
+    for (unsigned i=0; i<num; i++)
+    {
+        REAL difference = pValues[pSecond[i]] - pValues[pFirst[i]];
+        pDifferences[i] = difference;
+        pSquaredSums[i] += difference*difference;
+    }
+}
+
+/**
+ * Set pSums[i] = pValues[pFirst[i]] + pValues[pSecond[i]].
+ *
+ * @param pSums the sums (output)
+ * @param pValues the values to gather from
+ * @param pFirst the index of the first value of each sum
+ * @param pSecond the index of the second value of each sum
+ * @param num the number of sums
+ */
+template<class REAL>
+static void GatherSums(REAL* __restrict__ pSums,
+                       const REAL* pValues,
+                       const unsigned* pFirst,
+                       const unsigned* pSecond,
+                       unsigned num)
+{
+    for (unsigned i=0; i<num; i++)
+    {
+        pSums[i] = pValues[pFirst[i]] + pValues[pSecond[i]];
+    }
+}
+
+template<unsigned SPACE_DIM, class REAL>
+BatchedSpringForceKernel<SPACE_DIM,REAL>::BatchedSpringForceKernel()
+    : mSpringStiffness(15.0),
+      mCutOffLength(std::numeric_limits<REAL>::max()),
+      mUseHookeanLaw(false),
+      mNumPairs(0)
+{
+}
+
+template<unsigned SPACE_DIM, class REAL>
+void BatchedSpringForceKernel<SPACE_DIM,REAL>::SetParameters(double springStiffness, double cutOffLength, bool useHookeanLaw)
+{
+    mSpringStiffness = springStiffness;
+    mCutOffLength = (cutOffLength < std::numeric_limits<REAL>::max()) ? cutOffLength : std::numeric_limits<REAL>::max();
+    mUseHookeanLaw = useHookeanLaw;
+}
+
+template<unsigned SPACE_DIM, class REAL>
+void BatchedSpringForceKernel<SPACE_DIM,REAL>::ComputeGeometry(const unsigned* pFirstNodes,
+                                                               const unsigned* pSecondNodes,
+                                                               unsigned numPairs,
+                                                               const REAL* pLocations,
+                                                               unsigned numNodes,
+                                                               const REAL* pRadii)
+{
+    mNumPairs = numPairs;
+    mUnitVectors.resize(numPairs*SPACE_DIM);
+    mDistances.resize(numPairs);
+    mOverlaps.resize(numPairs);
+    mRestLengths.resize(numPairs);
+    mForces.resize(numPairs*SPACE_DIM);
+
+    if (numPairs == 0)
+    {
+        return;
+    }
+
+    REAL* p_unit_vectors = &mUnitVectors[0];
+    REAL* p_distances = &mDistances[0];
+
+    // Displacements, dimension by dimension, accumulating the squared distances
+    for (unsigned pair=0; pair<numPairs; pair++)
+    {
+        p_distances[pair] = 0;
+    }
+    for (unsigned d=0; d<SPACE_DIM; d++)
+    {
+        GatherDifferences(p_unit_vectors + d*numPairs, p_distances, pLocations + d*numNodes, pFirstNodes, pSecondNodes, numPairs);
+    }
+
+    // Distances, rest lengths and overlaps
+    GatherSums(&mRestLengths[0], pRadii, pFirstNodes, pSecondNodes, numPairs);
+    for (unsigned pair=0; pair<numPairs; pair++)
+    {
+        p_distances[pair] = std::sqrt(p_distances[pair]);
+        mOverlaps[pair] = p_distances[pair] - mRestLengths[pair];
+    }
+
+    // Normalise the displacements
+    for (unsigned d=0; d<SPACE_DIM; d++)
+    {
+        REAL* p_components = p_unit_vectors + d*numPairs;
+        for (unsigned pair=0; pair<numPairs; pair++)
+        {
+            p_components[pair] /= p_distances[pair];
+        }
+    }
+}
+
+template<unsigned SPACE_DIM, class REAL>
+void BatchedSpringForceKernel<SPACE_DIM,REAL>::ComputeForces(const REAL* pMultipliers)
+{
+    // Literal constants are written as REAL so that float arithmetic is not promoted to double
+    const REAL zero = 0;
+    const REAL one = 1;
+    const REAL three = 3;
+    const REAL alpha = 5;
+    unsigned num_pairs = mNumPairs;
+    if (num_pairs == 0)
+    {
+        return;
+    }
+
+    // Use the space for the forces to hold the magnitudes, then scale the unit vectors by them
+    REAL* p_magnitudes = &mForces[0];
+    const REAL* p_overlaps = &mOverlaps[0];
+    const REAL* p_rest_lengths = &mRestLengths[0];
+    const REAL* p_distances = &mDistances[0];
+
+    if (mUseHookeanLaw)
+    {
+        for (unsigned pair=0; pair<num_pairs; pair++)
+        {
+            p_magnitudes[pair] = mSpringStiffness*p_overlaps[pair];
+        }
+    }
+    else
+    {
+        for (unsigned pair=0; pair<num_pairs; pair++)
+        {
+            // Evaluate both branches of the law and select, so the loop has no branches
+            REAL overlap = p_overlaps[pair];
+            REAL rest_length = p_rest_lengths[pair];
+            REAL ratio = overlap/rest_length;
+            REAL compressed = three*mSpringStiffness*rest_length*FastLog(one + (ratio < zero ? ratio : zero));
+            REAL stretched = mSpringStiffness*overlap*FastExp(-alpha*(ratio > zero ? ratio : zero));
+            p_magnitudes[pair] = overlap <= zero ? compressed : stretched;
+        }
+    }
+
+    for (unsigned pair=0; pair<num_pairs; pair++)
+    {
+        REAL multiplier = (pMultipliers == NULL) ? one : pMultipliers[pair];
+        REAL in_range = p_distances[pair] < mCutOffLength ? one : zero;
+        p_magnitudes[pair] *= multiplier*in_range;
+    }
+
+    // The magnitudes occupy the first dimension of mForces, so fill the other dimensions first
+    for (unsigned d=SPACE_DIM; d-->0; )
+    {
+        const REAL* p_components = &mUnitVectors[d*num_pairs];
+        REAL* p_forces = &mForces[d*num_pairs];
+        for (unsigned pair=0; pair<num_pairs; pair++)
+        {
+            p_forces[pair] = p_components[pair]*p_magnitudes[pair];
+        }
+    }
+}
+
+template<unsigned SPACE_DIM, class REAL>
+unsigned BatchedSpringForceKernel<SPACE_DIM,REAL>::GetNumPairs() const
+{
+    return mNumPairs;
+}
+
+template<unsigned SPACE_DIM, class REAL>
+const std::vector<REAL>& BatchedSpringForceKernel<SPACE_DIM,REAL>::rGetOverlaps() const
+{
+    return mOverlaps;
+}
+
+template<unsigned SPACE_DIM, class REAL>
+const std::vector<REAL>& BatchedSpringForceKernel<SPACE_DIM,REAL>::rGetForces() const
+{
+    return mForces;
+}
+
+// Explicit instantiation
+template class BatchedSpringForceKernel<1>;
+template class BatchedSpringForceKernel<2>;
+template class BatchedSpringForceKernel<3>;
+template class BatchedSpringForceKernel<1,float>;
+template class BatchedSpringForceKernel<2,float>;
+template class BatchedSpringForceKernel<3,float>;
@@ -0,0 +1,336 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef BATCHEDSPRINGFORCEKERNEL_HPP_
+#define BATCHEDSPRINGFORCEKERNEL_HPP_
+
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+/**
+ * Evaluates the BasicLinearSpringForce law for a batch of node pairs at once.
+ *
+ * Node locations and radii are passed in as flat arrays indexed by node, with the
+ * locations stored dimension by dimension (structure of arrays), and the pairs as
+ * two arrays of node indices. Each pass over the pairs is a simple loop over
+ * contiguous arrays without calls or branches, which the compiler can vectorise
+ * for whatever instruction set it is targeting. Vectorisation needs -O3 (or
+ * -ftree-vectorize), -fno-trapping-math so that GCC will turn the selects into
+ * blends and -fno-math-errno for sqrt(); building with "scons simd=1" adds these
+ * with -march=native, and "vec_report=1" lists the loops that were vectorised.
+ * Unlike -ffast-math, the first two do not change any results; -march may enable
+ * fused multiply-adds, which changes the last bits.
+ *
+ * The libm log() and exp() calls of the scalar force law stop loops being
+ * vectorised, so they are replaced here by FastLog() and FastExp(), inline
+ * polynomial approximations whose relative error is below 1e-14 over the range
+ * the force law uses. Forces therefore agree with the scalar law to about that
+ * accuracy rather than bitwise. These use only operations with packed
+ * instructions in SSE2/AVX2: there is no conversion between double and 64 bit
+ * integers, which would stop the loop being vectorised before AVX-512.
+ *
+ * Displacements are computed by subtracting locations, so the kernel cannot be
+ * used with periodic meshes.
+ *
+ * The locations, radii, workspaces and arithmetic are all of type REAL. With float,
+ * twice as many pairs fit in each vector register and half as much memory is read
+ * and written, but forces only agree with the scalar law to a relative accuracy of
+ * about 1e-6. FastLog() and FastExp() have single precision overloads to match.
+ */
+template<unsigned SPACE_DIM, class REAL=double>
+class BatchedSpringForceKernel
+{
+private:
+
+    /** The spring stiffness. */
+    REAL mSpringStiffness;
+
+    /** The cut-off length; pairs at least this far apart feel no force. */
+    REAL mCutOffLength;
+
+    /** Whether to use the Hookean law of mesh-based populations rather than the log/exp law. */
+    bool mUseHookeanLaw;
+
+    /** The number of pairs in the current batch. */
+    unsigned mNumPairs;
+
+    /** The unit vector from the first to the second node of each pair, dimension by dimension. */
+    std::vector<REAL> mUnitVectors;
+
+    /** The distance between the nodes of each pair. */
+    std::vector<REAL> mDistances;
+
+    /** The overlap (distance minus rest length) of each pair. */
+    std::vector<REAL> mOverlaps;
+
+    /** The rest length (sum of the radii) of each pair. */
+    std::vector<REAL> mRestLengths;
+
+    /** The force on the first node of each pair, dimension by dimension. */
+    std::vector<REAL> mForces;
+
+public:
+
+    /**
+     * Constructor.
+     */
+    BatchedSpringForceKernel();
+
+    /**
+     * Set the parameters of the force law.
+     *
+     * @param springStiffness the spring stiffness
+     * @param cutOffLength the cut-off length, or DBL_MAX for none (clamped to the largest REAL)
+     * @param useHookeanLaw whether to use the Hookean law of mesh-based populations
+     */
+    void SetParameters(double springStiffness, double cutOffLength, bool useHookeanLaw);
+
+    /**
+     * Compute the geometry of a batch of pairs: the unit vectors, distances, rest
+     * lengths and overlaps.
+     *
+     * @param pFirstNodes the index of the first node of each pair
+     * @param pSecondNodes the index of the second node of each pair
+     * @param numPairs the number of pairs
+     * @param pLocations the node locations, numNodes values for each dimension in turn
+     * @param numNodes the number of nodes (the stride between dimensions in pLocations)
+     * @param pRadii the node radii
+     */
+    void ComputeGeometry(const unsigned* pFirstNodes,
+                         const unsigned* pSecondNodes,
+                         unsigned numPairs,
+                         const REAL* pLocations,
+                         unsigned numNodes,
+                         const REAL* pRadii);
+
+    /**
+     * Compute the force on the first node of each pair of the batch passed to
+     * ComputeGeometry(). The force on the second node is its negative.
+     *
+     * @param pMultipliers the spring constant multiplication factor of each pair,
+     *     or NULL if they are all one
+     */
+    void ComputeForces(const REAL* pMultipliers);
+
+    /**
+     * @return the number of pairs in the current batch.
+     */
+    unsigned GetNumPairs() const;
+
+    /**
+     * @return the overlaps of the current batch.
+     */
+    const std::vector<REAL>& rGetOverlaps() const;
+
+    /**
+     * @return the forces on the first nodes of the current batch, dimension by dimension.
+     */
+    const std::vector<REAL>& rGetForces() const;
+
+    /**
+     * A vectorisable approximation to exp(x), with relative error below 1e-14.
+     * Arguments are clamped to [-708, 709], so underflow gives about 3e-308
+     * rather than zero.
+     *
+     * @param x the argument
+     * @return exp(x)
+     */
+    static inline double FastExp(double x)
+    {
+        const double log2e = 1.4426950408889634;
+        const double ln2_hi = 6.93147180369123816490e-01;
+        const double ln2_lo = 1.90821492927058770002e-10;
+
+        x = x < -708.0 ? -708.0 : (x > 709.0 ? 709.0 : x);
+
+        // x = k ln2 + r with |r| <= ln2/2. Adding 1.5*2^52 rounds x log2(e) to the
+        // nearest integer and leaves it in the low bits of the sum, so k is found
+        // without a double to integer conversion (which has no packed instruction
+        // before AVX-512)
+        const double round_shift = 6755399441055744.0;
+        double shifted = x*log2e + round_shift;
+        double k = shifted - round_shift;
+        double r = (x - k*ln2_hi) - k*ln2_lo;
+
+        // Taylor series to degree 11, in Horner form
+        double p = 1.0/39916800.0;
+        p = p*r + 1.0/3628800.0;
+        p = p*r + 1.0/362880.0;
+        p = p*r + 1.0/40320.0;
+        p = p*r + 1.0/5040.0;
+        p = p*r + 1.0/720.0;
+        p = p*r + 1.0/120.0;
+        p = p*r + 1.0/24.0;
+        p = p*r + 1.0/6.0;
+        p = p*r + 0.5;
+        p = p*r + 1.0;
+        p = p*r + 1.0;
+
+        // Multiply by 2^k by building its bit pattern from the low bits of the shifted sum
+        boost::uint64_t bits;
+        std::memcpy(&bits, &shifted, sizeof(double));
+        bits = (bits + 1023) << 52;
+        double scale;
+        std::memcpy(&scale, &bits, sizeof(double));
+        return p*scale;
+    }
+
+    /**
+     * A vectorisable approximation to log(x) for positive, normal x, with relative
+     * error below 1e-14 away from x = 1 and absolute error below 1e-16 near it.
+     *
+     * @param x the argument
+     * @return log(x)
+     */
+    static inline double FastLog(double x)
+    {
+        const double ln2_hi = 6.93147180369123816490e-01;
+        const double ln2_lo = 1.90821492927058770002e-10;
+        const double sqrt2 = 1.4142135623730951;
+
+        // Split x = m 2^e with m in [sqrt(1/2), sqrt(2))
+        boost::uint64_t bits;
+        std::memcpy(&bits, &x, sizeof(double));
+        // The biased exponent is put in the low bits of 2^52 and converted by subtraction,
+        // as there is no packed integer to double conversion before AVX-512
+        boost::uint64_t exponent_bits = ((bits >> 52) & 0x7ff) | 0x4330000000000000ULL;
+        double e;
+        std::memcpy(&e, &exponent_bits, sizeof(double));
+        e -= 4503599627371519.0; // 2^52 + 1023
+        bits = (bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL;
+        double m;
+        std::memcpy(&m, &bits, sizeof(double));
+        double adjust = m > sqrt2 ? 1.0 : 0.0;
+        m *= (1.0 - 0.5*adjust);
+        double exponent = e + adjust;
+
+        // log(m) = 2 atanh(s) with s = (m-1)/(m+1), |s| < 0.1716
+        double s = (m - 1.0)/(m + 1.0);
+        double s2 = s*s;
+        double p = 1.0/19.0;
+        p = p*s2 + 1.0/17.0;
+        p = p*s2 + 1.0/15.0;
+        p = p*s2 + 1.0/13.0;
+        p = p*s2 + 1.0/11.0;
+        p = p*s2 + 1.0/9.0;
+        p = p*s2 + 1.0/7.0;
+        p = p*s2 + 1.0/5.0;
+        p = p*s2 + 1.0/3.0;
+        double log_m = 2.0*s + 2.0*s*s2*p;
+
+        return exponent*ln2_hi + (log_m + exponent*ln2_lo);
+    }
+
+    /**
+     * A vectorisable approximation to exp(x) in single precision, with relative
+     * error within a few units in the last place. Arguments are clamped to [-87, 88].
+     *
+     * @param x the argument
+     * @return exp(x)
+     */
+    static inline float FastExp(float x)
+    {
+        const float log2e = 1.44269504f;
+        const float ln2_hi = 0.693359375f;
+        const float ln2_lo = -2.12194440e-4f;
+
+        x = x < -87.0f ? -87.0f : (x > 88.0f ? 88.0f : x);
+
+        // x = k ln2 + r with |r| <= ln2/2, rounding with 1.5*2^23 as in the double version
+        const float round_shift = 12582912.0f;
+        float shifted = x*log2e + round_shift;
+        float k = shifted - round_shift;
+        float r = (x - k*ln2_hi) - k*ln2_lo;
+
+        // Taylor series to degree 7, in Horner form
+        float p = 1.0f/5040.0f;
+        p = p*r + 1.0f/720.0f;
+        p = p*r + 1.0f/120.0f;
+        p = p*r + 1.0f/24.0f;
+        p = p*r + 1.0f/6.0f;
+        p = p*r + 0.5f;
+        p = p*r + 1.0f;
+        p = p*r + 1.0f;
+
+        // Multiply by 2^k by building its bit pattern from the low bits of the shifted sum
+        boost::uint32_t bits;
+        std::memcpy(&bits, &shifted, sizeof(float));
+        bits = (bits + 127) << 23;
+        float scale;
+        std::memcpy(&scale, &bits, sizeof(float));
+        return p*scale;
+    }
+
+    /**
+     * A vectorisable approximation to log(x) in single precision for positive, normal
+     * x, with relative error within a few units in the last place away from x = 1.
+     *
+     * @param x the argument
+     * @return log(x)
+     */
+    static inline float FastLog(float x)
+    {
+        const float ln2_hi = 0.693359375f;
+        const float ln2_lo = -2.12194440e-4f;
+        const float sqrt2 = 1.41421356f;
+
+        // Split x = m 2^e with m in [sqrt(1/2), sqrt(2))
+        boost::uint32_t bits;
+        std::memcpy(&bits, &x, sizeof(float));
+        boost::int32_t e = (boost::int32_t) ((bits >> 23) & 0xff) - 127;
+        bits = (bits & 0x007fffffU) | 0x3f800000U;
+        float m;
+        std::memcpy(&m, &bits, sizeof(float));
+        float adjust = m > sqrt2 ? 1.0f : 0.0f;
+        m *= (1.0f - 0.5f*adjust);
+        float exponent = (float) e + adjust;
+
+        // log(m) = 2 atanh(s) with s = (m-1)/(m+1), |s| < 0.1716
+        float s = (m - 1.0f)/(m + 1.0f);
+        float s2 = s*s;
+        float p = 1.0f/9.0f;
+        p = p*s2 + 1.0f/7.0f;
+        p = p*s2 + 1.0f/5.0f;
+        p = p*s2 + 1.0f/3.0f;
+        float log_m = 2.0f*s + 2.0f*s*s2*p;
+
+        return exponent*ln2_hi + (log_m + exponent*ln2_lo);
+    }
+};
+
+#endif /*BATCHEDSPRINGFORCEKERNEL_HPP_*/
@@ -0,0 +1,98 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "CubicHermiteTable.hpp"
+
+CubicHermiteTable::CubicHermiteTable()
+    : mStart(0.0),
+      mSpacing(0.0),
+      mInverseSpacing(0.0),
+      mMeasuredRelativeError(0.0)
+{
+}
+
+void CubicHermiteTable::Clear()
+{
+    mValues.clear();
+    mScaledDerivatives.clear();
+    mMeasuredRelativeError = 0.0;
+}
+
+bool CubicHermiteTable::IsEmpty() const
+{
+    return mValues.empty();
+}
+
+unsigned CubicHermiteTable::GetNumIntervals() const
+{
+    return mValues.empty() ? 0 : mValues.size() - 1;
+}
+
+double CubicHermiteTable::GetStart() const
+{
+    return mStart;
+}
+
+double CubicHermiteTable::GetEnd() const
+{
+    return mStart + GetNumIntervals()*mSpacing;
+}
+
+double CubicHermiteTable::GetMeasuredRelativeError() const
+{
+    return mMeasuredRelativeError;
+}
+
+void CubicHermiteTable::Interpolate(const double* pX, double* pValues, unsigned numPoints) const
+{
+    assert(!mValues.empty());
+
+    const double* p_values = &mValues[0];
+    const double* p_scaled_derivatives = &mScaledDerivatives[0];
+    const double last = (double) (mValues.size() - 2);
+
+    for (unsigned point=0; point<numPoints; point++)
+    {
+        // Clamp in floating point, so the index conversion cannot overflow
+        double s = (pX[point] - mStart)*mInverseSpacing;
+        double s_clamped = s < 0.0 ? 0.0 : (s > last ? last : s);
+        unsigned i = (unsigned) s_clamped;
+        double t = s - i;
+        double one_minus_t = 1.0 - t;
+
+        pValues[point] = one_minus_t*one_minus_t*((1.0 + 2.0*t)*p_values[i] + t*p_scaled_derivatives[i])
+                         + t*t*((3.0 - 2.0*t)*p_values[i+1] - one_minus_t*p_scaled_derivatives[i+1]);
+    }
+}
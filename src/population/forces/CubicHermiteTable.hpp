@@ -0,0 +1,224 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef CUBICHERMITETABLE_HPP_
+#define CUBICHERMITETABLE_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+#include "Exception.hpp"
+
+/**
+ * A piecewise cubic Hermite interpolant of a smooth function of one variable on a
+ * uniform grid, built from the exact values and derivatives at the grid points.
+ *
+ * Setup() doubles the number of intervals until the error, measured at several points
+ * in every interval, is within a requested tolerance: a relative error plus, where
+ * the function crosses zero inside the table, an absolute error. The grid may run in
+ * either direction from its start, so that a table can start where the function is
+ * zero and keep its relative accuracy there.
+ *
+ * The function is given as a profile object with const methods GetValue(x) and
+ * GetDerivative(x).
+ */
+class CubicHermiteTable
+{
+private:
+
+    /** The start of the table. */
+    double mStart;
+
+    /** The grid spacing, negative if the table runs downwards from #mStart. */
+    double mSpacing;
+
+    /** The reciprocal of #mSpacing. */
+    double mInverseSpacing;
+
+    /** The largest relative error measured when the table was built. */
+    double mMeasuredRelativeError;
+
+    /** The values at the grid points. */
+    std::vector<double> mValues;
+
+    /** The derivatives at the grid points, multiplied by #mSpacing. */
+    std::vector<double> mScaledDerivatives;
+
+    /**
+     * Fill the table with the given number of intervals, and set #mMeasuredRelativeError.
+     *
+     * @param rProfile the profile to tabulate
+     * @param numIntervals the number of intervals
+     * @param maxRelativeError the maximum relative error of the table
+     * @param maxAbsoluteError the absolute error allowed on top of the relative error
+     * @return the largest error measured within the table, as a multiple of the tolerance
+     */
+    template<class PROFILE>
+    double Fill(const PROFILE& rProfile, unsigned numIntervals, double maxRelativeError, double maxAbsoluteError)
+    {
+        mValues.resize(numIntervals + 1);
+        mScaledDerivatives.resize(numIntervals + 1);
+        for (unsigned i=0; i<=numIntervals; i++)
+        {
+            mValues[i] = rProfile.GetValue(mStart + i*mSpacing);
+            mScaledDerivatives[i] = mSpacing*rProfile.GetDerivative(mStart + i*mSpacing);
+        }
+
+        unsigned num_samples = 8;
+        double max_relative_error = 0.0;
+        double max_error_ratio = 0.0;
+        for (unsigned i=0; i<numIntervals; i++)
+        {
+            for (unsigned sample=1; sample<num_samples; sample++)
+            {
+                double x = mStart + (i + (double)sample/num_samples)*mSpacing;
+                double exact = rProfile.GetValue(x);
+                double error = fabs(Interpolate(x) - exact);
+                max_relative_error = std::max(max_relative_error, error/std::max(fabs(exact), DBL_MIN));
+                max_error_ratio = std::max(max_error_ratio, error/std::max(maxRelativeError*fabs(exact) + maxAbsoluteError, DBL_MIN));
+            }
+        }
+        mMeasuredRelativeError = max_relative_error;
+        return max_error_ratio;
+    }
+
+public:
+
+    /**
+     * Constructor. The table is empty until Setup() is called.
+     */
+    CubicHermiteTable();
+
+    /**
+     * Build the table, so that |error| <= maxRelativeError*|f| + maxAbsoluteError
+     * everywhere it was measured. Throws an exception if the tolerance cannot be met,
+     * which a purely relative tolerance cannot be where f crosses zero.
+     *
+     * @param rProfile the profile to tabulate
+     * @param start the start of the table
+     * @param end the end of the table, which may be below start
+     * @param maxRelativeError the maximum relative error of the table
+     * @param maxAbsoluteError the absolute error allowed on top of the relative error (defaults to 0)
+     */
+    template<class PROFILE>
+    void Setup(const PROFILE& rProfile, double start, double end, double maxRelativeError, double maxAbsoluteError=0.0)
+    {
+        assert(end != start);
+        assert(maxRelativeError > 0.0);
+        assert(maxAbsoluteError >= 0.0);
+
+        const unsigned max_num_intervals = 1u << 20;
+        mStart = start;
+
+        double error = DBL_MAX;
+        unsigned num_intervals = 8;
+        while (error > 1.0)
+        {
+            num_intervals *= 2;
+            if (num_intervals > max_num_intervals)
+            {
+                Clear();
+                EXCEPTION("A profile cannot be tabulated to the requested accuracy");
+            }
+            mSpacing = (end - start)/num_intervals;
+            mInverseSpacing = 1.0/mSpacing;
+            error = Fill(rProfile, num_intervals, maxRelativeError, maxAbsoluteError);
+        }
+    }
+
+    /**
+     * Empty the table.
+     */
+    void Clear();
+
+    /**
+     * @return whether the table is empty.
+     */
+    bool IsEmpty() const;
+
+    /**
+     * @return the number of intervals in the table.
+     */
+    unsigned GetNumIntervals() const;
+
+    /**
+     * @return the start of the table.
+     */
+    double GetStart() const;
+
+    /**
+     * @return the end of the table.
+     */
+    double GetEnd() const;
+
+    /**
+     * @return mMeasuredRelativeError
+     */
+    double GetMeasuredRelativeError() const;
+
+    /**
+     * Interpolate within the table, which must not be empty. Points beyond either
+     * end are extrapolated from the end interval.
+     *
+     * @param x the point
+     * @return the interpolated value
+     */
+    inline double Interpolate(double x) const
+    {
+        double s = (x - mStart)*mInverseSpacing;
+        double last = (double) (mValues.size() - 2);
+        unsigned i = (unsigned) (s < 0.0 ? 0.0 : (s > last ? last : s));
+        double t = s - i;
+        double one_minus_t = 1.0 - t;
+
+        return one_minus_t*one_minus_t*((1.0 + 2.0*t)*mValues[i] + t*mScaledDerivatives[i])
+               + t*t*((3.0 - 2.0*t)*mValues[i+1] - one_minus_t*mScaledDerivatives[i+1]);
+    }
+
+    /**
+     * Interpolate at many points at once, as Interpolate(). The loop has no calls or
+     * branches, so can be vectorised by the compiler.
+     *
+     * @param pX the points
+     * @param pValues the interpolated values (filled in)
+     * @param numPoints the number of points
+     */
+    void Interpolate(const double* pX, double* pValues, unsigned numPoints) const;
+};
+
+#endif /*CUBICHERMITETABLE_HPP_*/
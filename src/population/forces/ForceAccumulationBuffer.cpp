@@ -0,0 +1,211 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ForceAccumulationBuffer.hpp"
+
+#include <algorithm>
+
+template<unsigned SPACE_DIM>
+ForceAccumulationBuffer<SPACE_DIM>::ForceAccumulationBuffer()
+    : mNumThreads(0),
+      mNumEntries(0)
+{
+}
+
+template<unsigned SPACE_DIM>
+void ForceAccumulationBuffer<SPACE_DIM>::Resize(unsigned numThreads, unsigned numEntries)
+{
+    if (numThreads == mNumThreads && numEntries == mNumEntries)
+    {
+        return;
+    }
+
+    mNumThreads = numThreads;
+    mNumEntries = numEntries;
+
+    unsigned size = mNumThreads*mNumEntries*SPACE_DIM;
+    if (size > mForces.size())
+    {
+        mForces.resize(size);
+    }
+
+    // The slabs have moved, so the next call to ZeroSlab() must clear each of them in full
+    mTouchedRanges.assign(2*mNumThreads*PADDING, 0);
+    for (unsigned thread=0; thread<mNumThreads; thread++)
+    {
+        mTouchedRanges[2*thread*PADDING + 1] = mNumEntries;
+    }
+}
+
+template<unsigned SPACE_DIM>
+void ForceAccumulationBuffer<SPACE_DIM>::ZeroSlab(unsigned threadIndex)
+{
+    assert(threadIndex < mNumThreads);
+
+    unsigned* p_range = &mTouchedRanges[2*threadIndex*PADDING];
+    if (p_range[0] < p_range[1])
+    {
+        std::vector<double>::iterator slab_begin = mForces.begin() + threadIndex*mNumEntries*SPACE_DIM;
+        std::fill(slab_begin + p_range[0]*SPACE_DIM, slab_begin + p_range[1]*SPACE_DIM, 0.0);
+    }
+
+    // Mark the slab as empty
+    p_range[0] = mNumEntries;
+    p_range[1] = 0;
+}
+
+template<unsigned SPACE_DIM>
+c_vector<double, SPACE_DIM> ForceAccumulationBuffer<SPACE_DIM>::GetReducedForce(unsigned entry) const
+{
+    assert(entry < mNumEntries);
+
+    c_vector<double, SPACE_DIM> force = zero_vector<double>(SPACE_DIM);
+    for (unsigned thread=0; thread<mNumThreads; thread++)
+    {
+        const unsigned* p_range = &mTouchedRanges[2*thread*PADDING];
+        if (entry >= p_range[0] && entry < p_range[1])
+        {
+            const double* p_force = &mForces[(thread*mNumEntries + entry)*SPACE_DIM];
+            for (unsigned d=0; d<SPACE_DIM; d++)
+            {
+                force[d] += p_force[d];
+            }
+        }
+    }
+    return force;
+}
+
+template<unsigned SPACE_DIM>
+void ForceAccumulationBuffer<SPACE_DIM>::ReduceInto(const std::vector<Node<SPACE_DIM>*>& rNodes) const
+{
+    assert(rNodes.size() == mNumEntries);
+
+    // Each entry is reduced by exactly one thread, so the nodes can be written to without locking
+    int num_entries = mNumEntries;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(mNumThreads) schedule(static)
+#endif // _OPENMP
+    for (int entry=0; entry<num_entries; entry++)
+    {
+        c_vector<double, SPACE_DIM> force = GetReducedForce(entry);
+        rNodes[entry]->AddAppliedForceContribution(force);
+    }
+}
+
+template<unsigned SPACE_DIM>
+void ForceAccumulationBuffer<SPACE_DIM>::TreeReduceInto(const std::vector<Node<SPACE_DIM>*>& rNodes)
+{
+    assert(rNodes.size() == mNumEntries);
+
+    /*
+     * Work out which entries each slab will hold once the partial sums below it in
+     * the tree have been added in, so that only those entries need be read, and so
+     * that ZeroSlab() later clears everything written here.
+     */
+    for (unsigned stride=1; stride<mNumThreads; stride*=2)
+    {
+        for (unsigned thread=0; thread+stride<mNumThreads; thread+=2*stride)
+        {
+            unsigned* p_range = &mTouchedRanges[2*thread*PADDING];
+            const unsigned* p_other_range = &mTouchedRanges[2*(thread + stride)*PADDING];
+            if (p_other_range[0] < p_other_range[1])
+            {
+                p_range[0] = std::min(p_range[0], p_other_range[0]);
+                p_range[1] = std::max(p_range[1], p_other_range[1]);
+            }
+        }
+    }
+
+    if (mNumThreads == 0 || mTouchedRanges[0] >= mTouchedRanges[1])
+    {
+        return;
+    }
+
+    /*
+     * Each entry is reduced by exactly one thread, which walks the whole tree for that
+     * entry, so neither the slabs nor the nodes need locking. A slab that is not in use
+     * at some entry holds zero there, so adding it in would not change the result;
+     * it is skipped only to save the memory traffic.
+     */
+    int range_begin = mTouchedRanges[0];
+    int range_end = mTouchedRanges[1];
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(mNumThreads) schedule(static)
+#endif // _OPENMP
+    for (int entry=range_begin; entry<range_end; entry++)
+    {
+        for (unsigned stride=1; stride<mNumThreads; stride*=2)
+        {
+            for (unsigned thread=0; thread+stride<mNumThreads; thread+=2*stride)
+            {
+                const unsigned* p_other_range = &mTouchedRanges[2*(thread + stride)*PADDING];
+                if ((unsigned)entry >= p_other_range[0] && (unsigned)entry < p_other_range[1])
+                {
+                    double* p_force = &mForces[(thread*mNumEntries + entry)*SPACE_DIM];
+                    const double* p_other_force = &mForces[((thread + stride)*mNumEntries + entry)*SPACE_DIM];
+                    for (unsigned d=0; d<SPACE_DIM; d++)
+                    {
+                        p_force[d] += p_other_force[d];
+                    }
+                }
+            }
+        }
+
+        const double* p_total_force = &mForces[entry*SPACE_DIM];
+        c_vector<double, SPACE_DIM> force;
+        for (unsigned d=0; d<SPACE_DIM; d++)
+        {
+            force[d] = p_total_force[d];
+        }
+        rNodes[entry]->AddAppliedForceContribution(force);
+    }
+}
+
+template<unsigned SPACE_DIM>
+unsigned ForceAccumulationBuffer<SPACE_DIM>::GetNumThreads() const
+{
+    return mNumThreads;
+}
+
+template<unsigned SPACE_DIM>
+unsigned ForceAccumulationBuffer<SPACE_DIM>::GetNumEntries() const
+{
+    return mNumEntries;
+}
+
+// Explicit instantiation
+template class ForceAccumulationBuffer<1>;
+template class ForceAccumulationBuffer<2>;
+template class ForceAccumulationBuffer<3>;
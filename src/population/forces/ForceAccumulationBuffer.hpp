@@ -0,0 +1,211 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef FORCEACCUMULATIONBUFFER_HPP_
+#define FORCEACCUMULATIONBUFFER_HPP_
+
+#include <vector>
+
+#include "Node.hpp"
+#include "UblasVectorInclude.hpp"
+
+/**
+ * Per-thread storage for force contributions computed in parallel.
+ *
+ * Each thread adds its contributions to its own slab, so threads never write to
+ * the same memory. The slabs are then summed in thread order and the totals added
+ * to the nodes. Since the order of summation only depends on the number of threads,
+ * the forces are bitwise reproducible for a given thread count.
+ *
+ * Entries are addressed by position in a list of nodes, not by node index, so the
+ * buffer has no gaps where nodes have been deleted. Each slab keeps track of the
+ * range of entries it has written to, and only that range is zeroed and reduced.
+ * A thread that only touches its own share of the nodes therefore only pays for
+ * that share, however many threads there are.
+ *
+ * Forces that add equal and opposite contributions to both nodes of a pair touch
+ * entries all over each slab, and a long sum in thread order loses accuracy as the
+ * number of threads grows. For these the slabs may instead be summed pairwise, as
+ * a binary tree, by TreeReduceInto(). The order of summation is again fixed by the
+ * number of threads.
+ *
+ * AccumulateOverRanges() shares the work out between the threads, so that the
+ * threaded forces all split it the same way.
+ */
+template<unsigned SPACE_DIM>
+class ForceAccumulationBuffer
+{
+private:
+
+    /** The number of slabs. */
+    unsigned mNumThreads;
+
+    /** The number of entries in each slab. */
+    unsigned mNumEntries;
+
+    /** The force components, slab by slab, then entry by entry. */
+    std::vector<double> mForces;
+
+    /**
+     * The first and one past the last entry written to in each slab. Slab t uses
+     * elements 2*t*PADDING and 2*t*PADDING+1, so that threads updating their own
+     * ranges do not share a cache line.
+     */
+    std::vector<unsigned> mTouchedRanges;
+
+    /** Spacing between the touched ranges of consecutive slabs. */
+    static const unsigned PADDING = 8;
+
+public:
+
+    /**
+     * Constructor.
+     */
+    ForceAccumulationBuffer();
+
+    /**
+     * Set the number of slabs and the number of entries in each. Storage is only
+     * reallocated if it needs to grow.
+     *
+     * @param numThreads the number of slabs
+     * @param numEntries the number of entries in each slab
+     */
+    void Resize(unsigned numThreads, unsigned numEntries);
+
+    /**
+     * Zero the entries written to in one slab. Called by each thread on its own slab.
+     *
+     * @param threadIndex the slab
+     */
+    void ZeroSlab(unsigned threadIndex);
+
+    /**
+     * Add a force contribution to an entry in one slab.
+     *
+     * @param threadIndex the slab, which must belong to the calling thread
+     * @param entry the entry
+     * @param rForce the force contribution
+     */
+    void AddForce(unsigned threadIndex, unsigned entry, const c_vector<double, SPACE_DIM>& rForce)
+    {
+        assert(threadIndex < mNumThreads);
+        assert(entry < mNumEntries);
+        double* p_force = &mForces[(threadIndex*mNumEntries + entry)*SPACE_DIM];
+        for (unsigned d=0; d<SPACE_DIM; d++)
+        {
+            p_force[d] += rForce[d];
+        }
+
+        unsigned* p_range = &mTouchedRanges[2*threadIndex*PADDING];
+        if (entry < p_range[0])
+        {
+            p_range[0] = entry;
+        }
+        if (entry >= p_range[1])
+        {
+            p_range[1] = entry + 1;
+        }
+    }
+
+    /**
+     * Share items (nodes or pairs) out between the slabs, one contiguous range per slab,
+     * and have a thread zero each slab and call rAddRange(threadIndex, begin, end) on its
+     * range, where begin and end are the first and one past the last item. The ranges
+     * depend only on the number of slabs. The threads are only used if built with
+     * OpenMP; otherwise the ranges are processed one after another.
+     *
+     * @param numItems the number of items, at least the number of slabs
+     * @param rAddRange the function object adding the contributions of a range of items
+     */
+    template<class RANGE_FUNCTION>
+    void AccumulateOverRanges(unsigned numItems, const RANGE_FUNCTION& rAddRange)
+    {
+        unsigned num_threads = mNumThreads;
+        int num_ranges = num_threads;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(static, 1)
+#endif // _OPENMP
+        for (int range=0; range<num_ranges; range++)
+        {
+            unsigned begin = (range*numItems)/num_threads;
+            unsigned end = ((range + 1)*numItems)/num_threads;
+
+            ZeroSlab(range);
+            rAddRange(range, begin, end);
+        }
+    }
+
+    /**
+     * @return the total force on an entry, summed over the slabs in thread order.
+     *
+     * @param entry the entry
+     */
+    c_vector<double, SPACE_DIM> GetReducedForce(unsigned entry) const;
+
+    /**
+     * Sum the slabs in thread order and add the total for each entry to the applied
+     * force on the corresponding node. Uses the same number of threads as there are
+     * slabs, each handling a contiguous range of entries.
+     *
+     * @param rNodes the nodes, one per entry
+     */
+    void ReduceInto(const std::vector<Node<SPACE_DIM>*>& rNodes) const;
+
+    /**
+     * Sum the slabs pairwise, as a binary tree over the thread indices, and add the
+     * total for each entry to the applied force on the corresponding node. At each
+     * level, slab t gains the partial sum held by slab t+stride, for t a multiple of
+     * 2*stride. Uses the same number of threads as there are slabs, each handling a
+     * contiguous range of entries.
+     *
+     * The partial sums are left in the slabs, so GetReducedForce() is meaningless
+     * until the slabs have been zeroed again.
+     *
+     * @param rNodes the nodes, one per entry
+     */
+    void TreeReduceInto(const std::vector<Node<SPACE_DIM>*>& rNodes);
+
+    /**
+     * @return #mNumThreads
+     */
+    unsigned GetNumThreads() const;
+
+    /**
+     * @return #mNumEntries
+     */
+    unsigned GetNumEntries() const;
+};
+
+#endif /*FORCEACCUMULATIONBUFFER_HPP_*/
@@ -52,8 +52,23 @@ GravityForce::GravityForce(double strength=1.0)
 void GravityForce::AddForceContribution(AbstractCellPopulation<2>& rCellPopulation)
 {
     c_vector<double, 2> down_force = zero_vector<double>(2);
-    c_vector<double, 2> bc_repulsion = zero_vector<double>(2);
     
+    // Evaluate the vertical force for all nodes at once
+    mVerticalForceProfile.SetParameters(mRepulsionDistance, mRepulsionStrength, 0.0, -mStrength, 0.0, 0.0);
+    mHeights.clear();
+    for (typename AbstractMesh<2, 2>::NodeIterator node_iter = rCellPopulation.rGetMesh().GetNodeIteratorBegin(); 
+        node_iter != rCellPopulation.rGetMesh().GetNodeIteratorEnd();
+        ++node_iter)
+    {
+        mHeights.push_back(node_iter->rGetLocation()[1]);
+    }
+    mVerticalForces.resize(mHeights.size());
+    if (!mHeights.empty())
+    {
+        mVerticalForceProfile.GetForces(&mHeights[0], &mVerticalForces[0], mHeights.size());
+    }
+    
+    unsigned i = 0;
     for (typename AbstractMesh<2, 2>::NodeIterator node_iter = rCellPopulation.rGetMesh().GetNodeIteratorBegin(); 
         node_iter != rCellPopulation.rGetMesh().GetNodeIteratorEnd();
         ++node_iter)
@@ -66,8 +81,9 @@ void GravityForce::AddForceContribution(AbstractCellPopulation<2>& rCellPopulati
         {
             double conc_a = p_cell->GetCellData()->GetItem("concentrationA");
             
+            // Repulsion below mRepulsionDistance, then -mStrength
             down_force(0) = 0;
-            down_force(1) = -mStrength;
+            down_force(1) = mVerticalForces[i];
             //down_force(1) = -((mStrength - 0.5) * conc_a + 0.5); //down_force(1) = -mStrength;
             
             if (p_cell->GetMutationState()->IsType<RVCellMutationState>())
@@ -75,13 +91,6 @@ void GravityForce::AddForceContribution(AbstractCellPopulation<2>& rCellPopulati
                 down_force(0) = mRVRightStrength;
             }
             
-            double cell_location_y = rCellPopulation.GetLocationOfCellCentre(p_cell)[1];
-            if (cell_location_y < mRepulsionDistance)
-            {
-                //down_force(1) = mRepulsionStrength * mStrength * (mRepulsionDistance - cell_location_y)/mRepulsionDistance;
-                down_force(1) = mRepulsionStrength;
-            }
-            
         }
         
         if (p_cell->GetMutationState()->IsType<AttachedCellMutationState>())
@@ -91,6 +100,7 @@ void GravityForce::AddForceContribution(AbstractCellPopulation<2>& rCellPopulati
         }
         
         rCellPopulation.GetNode(node_index)->AddAppliedForceContribution(down_force);
+        i++;
     }
     
 }
@@ -52,8 +52,23 @@ GravityForce2::GravityForce2(double strength=1.0)
 void GravityForce2::AddForceContribution(AbstractCellPopulation<2>& rCellPopulation)
 {
     c_vector<double, 2> down_force = zero_vector<double>(2);
-    c_vector<double, 2> bc_repulsion = zero_vector<double>(2);
     
+    // Evaluate the vertical force for all nodes at once
+    mVerticalForceProfile.SetParameters(mRepulsionDistance, mRepulsionStrength, 2*mStrength, 0.0, 0.0, 0.0);
+    mHeights.clear();
+    for (typename AbstractMesh<2, 2>::NodeIterator node_iter = rCellPopulation.rGetMesh().GetNodeIteratorBegin(); 
+        node_iter != rCellPopulation.rGetMesh().GetNodeIteratorEnd();
+        ++node_iter)
+    {
+        mHeights.push_back(node_iter->rGetLocation()[1]);
+    }
+    mVerticalForces.resize(mHeights.size());
+    if (!mHeights.empty())
+    {
+        mVerticalForceProfile.GetForces(&mHeights[0], &mVerticalForces[0], mHeights.size());
+    }
+    
+    unsigned i = 0;
     for (typename AbstractMesh<2, 2>::NodeIterator node_iter = rCellPopulation.rGetMesh().GetNodeIteratorBegin(); 
         node_iter != rCellPopulation.rGetMesh().GetNodeIteratorEnd();
         ++node_iter)
@@ -66,17 +81,9 @@ void GravityForce2::AddForceContribution(AbstractCellPopulation<2>& rCellPopulat
         {
             double conc_a = p_cell->GetCellData()->GetItem("concentrationA");
             
-            double cell_location_y = rCellPopulation.GetLocationOfCellCentre(p_cell)[1];
+            // Repulsion below mRepulsionDistance, then -2*mStrength/(y + 1 - mRepulsionDistance)
             down_force(0) = 0;
-            if (cell_location_y < mRepulsionDistance)
-            {
-                //down_force(1) = mRepulsionStrength * mStrength * (mRepulsionDistance - cell_location_y)/mRepulsionDistance;
-                down_force(1) = mRepulsionStrength;
-            }
-            else 
-            {
-                 down_force(1) = -2*mStrength/(cell_location_y + 1 - mRepulsionDistance);
-            }
+            down_force(1) = mVerticalForces[i];
             
             
             if (p_cell->GetMutationState()->IsType<RVCellMutationState>())
@@ -96,6 +103,7 @@ void GravityForce2::AddForceContribution(AbstractCellPopulation<2>& rCellPopulat
         }
         
         rCellPopulation.GetNode(node_index)->AddAppliedForceContribution(down_force);
+        i++;
     }
     
 }
@@ -36,6 +36,7 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "AbstractForce.hpp"
 #include "NodeBasedCellPopulation.hpp"
+#include "VerticalForceProfile.hpp"
 
 
 class GravityForce2 : public AbstractForce<2>
@@ -69,6 +70,15 @@ protected:
     
     double mDampingConst;
 
+    /** The vertical force on non-attached cells, tabulated whenever the parameters change. */
+    VerticalForceProfile mVerticalForceProfile;
+
+    /** The height of each node, in mesh order. */
+    std::vector<double> mHeights;
+
+    /** The vertical force from #mVerticalForceProfile at each height in #mHeights. */
+    std::vector<double> mVerticalForces;
+
 public : 
 
     GravityForce2(double);
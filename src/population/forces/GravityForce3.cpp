@@ -34,70 +34,52 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "GravityForce3.hpp"
-#include "AttachedCellMutationState.hpp"
-#include "RVCellMutationState.hpp"
-#include "WildTypeCellMutationState.hpp"
 
 GravityForce3::GravityForce3(double strength=1.0)
-    : AbstractForce<2>(), 
+    : AbstractThreadedForce<2>(),
       mStrength(strength),
       mRVRightStrength(1.0),
       mDampingConst(100.0),
       mRepulsionDistance(2.0),
       mRepulsionStrength(2.0),
-      mAttachmentStrength(10.0)
+      mAttachmentStrength(10.0),
+      mStromaHeight(10.0)
 {
 }
 
-void GravityForce3::AddForceContribution(AbstractCellPopulation<2>& rCellPopulation)
+void GravityForce3::PrepareForceContribution(AbstractCellPopulation<2>& rCellPopulation)
+{
+    mpCellAttributeCache->Refresh(rCellPopulation);
+    mVerticalForceProfile.SetParameters(mRepulsionDistance, mRepulsionStrength, 2*mStrength, 0.0, 4.0, mStromaHeight);
+    mHeights.resize(mNodes.size());
+    mVerticalForces.resize(mNodes.size());
+}
+
+void GravityForce3::AddForceContributionToNodes(AbstractCellPopulation<2>& rCellPopulation, unsigned begin, unsigned end, unsigned threadIndex)
 {
     c_vector<double, 2> down_force = zero_vector<double>(2);
-    c_vector<double, 2> bc_repulsion = zero_vector<double>(2);
-    
-    for (typename AbstractMesh<2, 2>::NodeIterator node_iter = rCellPopulation.rGetMesh().GetNodeIteratorBegin(); 
-        node_iter != rCellPopulation.rGetMesh().GetNodeIteratorEnd();
-        ++node_iter)
+
+    // Evaluate the vertical force for the whole range at once
+    for (unsigned i=begin; i<end; i++)
     {
-        unsigned node_index = node_iter->GetIndex();
-        CellPtr p_cell = rCellPopulation.GetCellUsingLocationIndex(node_index);
-        
-        
-        if (!p_cell->GetMutationState()->IsType<AttachedCellMutationState>())
+        mHeights[i] = mNodes[i]->rGetLocation()[1];
+    }
+    mVerticalForceProfile.GetForces(&mHeights[begin], &mVerticalForces[begin], end - begin);
+
+    for (unsigned i=begin; i<end; i++)
+    {
+        // Attached cells are held down; the others feel the profile of VerticalForceProfile
+        if (mpCellAttributeCache->IsAttached(mNodes[i]->GetIndex()))
         {
-            double conc_a = p_cell->GetCellData()->GetItem("concentrationA");
-            double cell_location_y = rCellPopulation.GetLocationOfCellCentre(p_cell)[1];
-            double StromaHeight = 10;
-            
-            down_force(0) = 0;
-            if (cell_location_y < mRepulsionDistance)
-            {
-                //down_force(1) = mRepulsionStrength * mStrength * (mRepulsionDistance - cell_location_y)/mRepulsionDistance;
-                down_force(1) = mRepulsionStrength;
-            }
-            else 
-            {
-                 down_force(1) = -2*mStrength/(cell_location_y + 1 - mRepulsionDistance) + 4/(cell_location_y - StromaHeight) - 4/(mRepulsionDistance- StromaHeight);
-            }
-            
-            /* DISABLE HORIZONTAL FORCE
-            if ( p_cell->GetMutationState()->IsType<RVCellMutationState>() )
-            {
-                down_force(0) = mRepulsionStrength/10;
-            }
-            */
-            
-            
+            down_force(1) = -mAttachmentStrength * mDampingConst;
         }
-        
-        if (p_cell->GetMutationState()->IsType<AttachedCellMutationState>())
+        else
         {
-            down_force(0) = 0;
-            down_force(1) = -mAttachmentStrength * mDampingConst;
+            down_force(1) = mVerticalForces[i];
         }
-        
-        rCellPopulation.GetNode(node_index)->AddAppliedForceContribution(down_force);
+
+        mForceBuffer.AddForce(threadIndex, i, down_force);
     }
-    
 }
 
 double GravityForce3::GetStrength()
@@ -159,12 +141,24 @@ double GravityForce3::GetDampingConst()
 {
     return mDampingConst;
 }
+
+
+void GravityForce3::SetStromaHeight(double stromaHeight)
+{
+    mStromaHeight = stromaHeight;
+}
+
+double GravityForce3::GetStromaHeight()
+{
+    return mStromaHeight;
+}
     
 
 void GravityForce3::OutputForceParameters(out_stream& rParamsFile)
 {
     *rParamsFile << "\t\t\t<Strength>" << mStrength << "</Strength>\n";
-    AbstractForce<2>::OutputForceParameters(rParamsFile);
+    *rParamsFile << "\t\t\t<StromaHeight>" << mStromaHeight << "</StromaHeight>\n";
+    AbstractThreadedForce<2>::OutputForceParameters(rParamsFile);
 }
 
 #include "SerializationExportWrapperForCpp.hpp"
@@ -34,11 +34,13 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 
-#include "AbstractForce.hpp"
+#include "AbstractThreadedForce.hpp"
 #include "NodeBasedCellPopulation.hpp"
+#include "VerticalForceProfile.hpp"
+#include <boost/serialization/version.hpp>
 
 
-class GravityForce3 : public AbstractForce<2>
+class GravityForce3 : public AbstractThreadedForce<2>
 {
 private : 
 
@@ -48,13 +50,25 @@ private :
     template<class Archive>
     void serialize(Archive & archive, const unsigned int version)
     {
-        archive & boost::serialization::base_object<AbstractForce<2> >(*this);
+        // Before version 1 the force derived directly from AbstractForce, and the stroma was always at height 10
+        if (version > 0)
+        {
+            archive & boost::serialization::base_object<AbstractThreadedForce<2> >(*this);
+        }
+        else
+        {
+            archive & boost::serialization::base_object<AbstractForce<2> >(*this);
+        }
         archive & mStrength;
         archive & mRepulsionDistance;
         archive & mRepulsionStrength;
         archive & mAttachmentStrength;
         archive & mRVRightStrength;
         archive & mDampingConst;
+        if (version > 0)
+        {
+            archive & mStromaHeight;
+        }
     }
 
 protected:
@@ -69,12 +83,41 @@ protected:
     
     double mDampingConst;
 
+    /** The height of the stroma, which repels cells from above. Defaults to 10. */
+    double mStromaHeight;
+
+    /** The vertical force on non-attached cells, tabulated whenever the parameters change. */
+    VerticalForceProfile mVerticalForceProfile;
+
+    /** The height of each node in #mNodes. */
+    std::vector<double> mHeights;
+
+    /** The vertical force from #mVerticalForceProfile at each height in #mHeights. */
+    std::vector<double> mVerticalForces;
+
+    /**
+     * Overridden PrepareForceContribution() method.
+     *
+     * Updates #mVerticalForceProfile with the current parameters.
+     *
+     * @param rCellPopulation reference to the cell population
+     */
+    void PrepareForceContribution(AbstractCellPopulation<2>& rCellPopulation);
+
+    /**
+     * Overridden AddForceContributionToNodes() method.
+     *
+     * @param rCellPopulation reference to the cell population
+     * @param begin the position of the first node in the range
+     * @param end one past the position of the last node in the range
+     * @param threadIndex the index of the calling thread
+     */
+    void AddForceContributionToNodes(AbstractCellPopulation<2>& rCellPopulation, unsigned begin, unsigned end, unsigned threadIndex);
+
 public : 
 
     GravityForce3(double);
     
-    void AddForceContribution(AbstractCellPopulation<2>& rCellPopulation);
-    
     double GetStrength();
     
     
@@ -103,11 +146,17 @@ public :
     double GetDampingConst();
     
     
+    void SetStromaHeight(double stromaHeight);
+    
+    double GetStromaHeight();
+    
+    
     virtual void OutputForceParameters(out_stream& rParamsFile);
     
 };
 
 #include "SerializationExportWrapper.hpp"
 CHASTE_CLASS_EXPORT(GravityForce3)
+BOOST_CLASS_VERSION(GravityForce3, 1)
     
     
@@ -0,0 +1,91 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "NodeBasedLinearSpringForce.hpp"
+#include "NodeBasedCellPopulation.hpp"
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+NodeBasedLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::NodeBasedLinearSpringForce()
+   : BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>()
+{
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void NodeBasedLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::AddForceContribution(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    NodeBasedCellPopulation<SPACE_DIM>* p_node_based_population = dynamic_cast<NodeBasedCellPopulation<SPACE_DIM>*>(&rCellPopulation);
+    if (p_node_based_population == NULL)
+    {
+        EXCEPTION("NodeBasedLinearSpringForce is to be used with a NodeBasedCellPopulation only");
+    }
+
+    if (this->mUseBatchedKernel)
+    {
+        BasicLinearSpringForce<ELEMENT_DIM,SPACE_DIM>::AddForceContribution(rCellPopulation);
+        return;
+    }
+
+    if (this->mUseVerletList)
+    {
+        if (this->mVerletList.GetSkin() != this->mVerletSkin)
+        {
+            this->mVerletList.SetSkin(this->mVerletSkin);
+        }
+        this->mVerletList.Update(rCellPopulation, this->GetCutOffLength());
+    }
+    const std::vector<std::pair<Node<SPACE_DIM>*, Node<SPACE_DIM>*> >& r_node_pairs =
+        this->mUseVerletList ? this->mVerletList.rGetNodePairs() : p_node_based_population->rGetNodePairs();
+
+    if (this->mUseTabulatedForceLaw)
+    {
+        AddPairForces(r_node_pairs, rCellPopulation, UnitSpringConstantMultiplier(), this->rGetTabulatedForceLaw());
+    }
+    else
+    {
+        AddPairForces(r_node_pairs, rCellPopulation, UnitSpringConstantMultiplier(), AnalyticSpringForceLaw());
+    }
+}
+
+// Explicit instantiation
+template class NodeBasedLinearSpringForce<1,1>;
+template class NodeBasedLinearSpringForce<1,2>;
+template class NodeBasedLinearSpringForce<2,2>;
+template class NodeBasedLinearSpringForce<1,3>;
+template class NodeBasedLinearSpringForce<2,3>;
+template class NodeBasedLinearSpringForce<3,3>;
+
+// Serialization for Boost >= 1.36
+#include "SerializationExportWrapperForCpp.hpp"
+EXPORT_TEMPLATE_CLASS_ALL_DIMS(NodeBasedLinearSpringForce)
@@ -0,0 +1,268 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef NODEBASEDLINEARSPRINGFORCE_HPP_
+#define NODEBASEDLINEARSPRINGFORCE_HPP_
+
+#include "BasicLinearSpringForce.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+
+#include "ChasteSerialization.hpp"
+#include <boost/serialization/base_object.hpp>
+
+/**
+ * Spring constant multiplier policy for NodeBasedLinearSpringForce::AddPairForces(),
+ * giving every spring the same stiffness.
+ */
+struct UnitSpringConstantMultiplier
+{
+    /**
+     * @param nodeAGlobalIndex index of one neighbouring node
+     * @param nodeBGlobalIndex index of the other neighbouring node
+     * @param isCloserThanRestLength whether the nodes lie closer than the rest length of their spring
+     * @return the multiplication factor, always 1.
+     */
+    inline double operator()(unsigned nodeAGlobalIndex, unsigned nodeBGlobalIndex, bool isCloserThanRestLength) const
+    {
+        return 1.0;
+    }
+};
+
+/**
+ * Force law policy for NodeBasedLinearSpringForce::AddPairForces(), evaluating the
+ * node-based law of BasicLinearSpringForce with log() and exp().
+ */
+struct AnalyticSpringForceLaw
+{
+    /**
+     * @param overlap the distance between the nodes minus the rest length
+     * @param restLength the rest length (the sum of the node radii)
+     * @param springStiffness the spring stiffness
+     * @return the magnitude of the force, positive values pulling the nodes together
+     */
+    inline double GetForceMagnitude(double overlap, double restLength, double springStiffness) const
+    {
+        if (overlap <= 0.0)
+        {
+            //log(x+1) is undefined for x<=-1
+            assert(overlap > -restLength);
+            return 3.0*springStiffness*restLength*log(1.0 + overlap/restLength);
+        }
+        else
+        {
+            double alpha = 5.0;
+            return springStiffness*overlap*exp(-alpha*overlap/restLength);
+        }
+    }
+};
+
+/**
+ * A BasicLinearSpringForce specialised to node-based cell populations.
+ *
+ * BasicLinearSpringForce::CalculateForceBetweenNodes() works out which force law to
+ * use with a dynamic_cast, fetches the multiplication factor through a virtual
+ * call and the displacement through the virtual GetVectorFromAtoB(), all for every
+ * pair. Here the population type is checked once per call to AddForceContribution(),
+ * and the node-based force law (analytic or tabulated) and the multiplication factor
+ * are policy classes inlined into the pair loop, so the loop contains no RTTI or
+ * virtual calls. Like BasicLinearSpringForce, the pairs are shared out between
+ * threads if SetNumThreads() has been given more than one.
+ *
+ * The forces are the same as those of BasicLinearSpringForce with the default
+ * multiplication factor; VariableSpringConstantMultiplicationFactor() is not called.
+ * Subclasses needing a variable spring constant should override AddForceContribution()
+ * and call AddPairForces() with their own multiplier policy. Displacements are
+ * computed by subtracting locations, so this force cannot be used with periodic meshes.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM=ELEMENT_DIM>
+class NodeBasedLinearSpringForce : public BasicLinearSpringForce<ELEMENT_DIM, SPACE_DIM>
+{
+private:
+
+    /** Needed for serialization. */
+    friend class boost::serialization::access;
+    /**
+     * Archive the object and its member variables.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void serialize(Archive & archive, const unsigned int version)
+    {
+        archive & boost::serialization::base_object<BasicLinearSpringForce<ELEMENT_DIM, SPACE_DIM> >(*this);
+    }
+
+protected:
+
+    /**
+     * Calculate the force on the first node of a pair, which is the negative of the
+     * force on the second.
+     *
+     * @param pNodeA the first node of the pair
+     * @param pNodeB the second node of the pair
+     * @param cutOffLength the cut-off length, or DBL_MAX for none
+     * @param rMultiplier the spring constant multiplier policy
+     * @param rForceLaw the force law policy
+     * @param rForce the force on the first node (output)
+     * @return whether the nodes are closer than the cut-off length, and so feel a force
+     */
+    template<class MULTIPLIER_POLICY, class FORCE_LAW_POLICY>
+    inline bool CalculatePairForce(Node<SPACE_DIM>* pNodeA,
+                                   Node<SPACE_DIM>* pNodeB,
+                                   double cutOffLength,
+                                   const MULTIPLIER_POLICY& rMultiplier,
+                                   const FORCE_LAW_POLICY& rForceLaw,
+                                   c_vector<double, SPACE_DIM>& rForce) const
+    {
+        c_vector<double, SPACE_DIM> difference = pNodeB->rGetLocation() - pNodeA->rGetLocation();
+        double distance_between_nodes = norm_2(difference);
+        assert(distance_between_nodes > 0);
+
+        if (distance_between_nodes >= cutOffLength)
+        {
+            return false;
+        }
+
+        double rest_length = pNodeA->GetRadius() + pNodeB->GetRadius();
+        double overlap = distance_between_nodes - rest_length;
+        double magnitude = rMultiplier(pNodeA->GetIndex(), pNodeB->GetIndex(), overlap <= 0.0)
+                           * rForceLaw.GetForceMagnitude(overlap, rest_length, this->mMeinekeSpringStiffness);
+
+        rForce = (magnitude/distance_between_nodes) * difference;
+        return true;
+    }
+
+    /**
+     * Calls CalculatePairForce() on a pair with the given policies, for
+     * BasicLinearSpringForce::AddThreadedPairForces().
+     */
+    template<class MULTIPLIER_POLICY, class FORCE_LAW_POLICY>
+    struct PolicyPairForce
+    {
+        /** The force. */
+        const NodeBasedLinearSpringForce* mpForce;
+
+        /** The cut-off length, or DBL_MAX for none. */
+        double mCutOffLength;
+
+        /** The spring constant multiplier policy. */
+        const MULTIPLIER_POLICY* mpMultiplier;
+
+        /** The force law policy. */
+        const FORCE_LAW_POLICY* mpForceLaw;
+
+        /**
+         * @param pNodeA the first node of the pair
+         * @param pNodeB the second node of the pair
+         * @param rForce the force on the first node (output)
+         * @return whether the nodes are closer than the cut-off length, and so feel a force
+         */
+        bool operator()(Node<SPACE_DIM>* pNodeA, Node<SPACE_DIM>* pNodeB, c_vector<double, SPACE_DIM>& rForce) const
+        {
+            return mpForce->CalculatePairForce(pNodeA, pNodeB, mCutOffLength, *mpMultiplier, *mpForceLaw, rForce);
+        }
+    };
+
+    /**
+     * Add the force between each pair of nodes to both nodes.
+     *
+     * If #mNumThreads is more than one, the pairs are shared out between that many
+     * threads by BasicLinearSpringForce::AddThreadedPairForces(), so the policies must
+     * be safe to call concurrently.
+     *
+     * @param rNodePairs the pairs of interacting nodes
+     * @param rCellPopulation the cell population
+     * @param rMultiplier the spring constant multiplier policy, called as
+     *     rMultiplier(nodeAGlobalIndex, nodeBGlobalIndex, isCloserThanRestLength)
+     * @param rForceLaw the force law policy, such as AnalyticSpringForceLaw or TabulatedSpringForceLaw
+     */
+    template<class MULTIPLIER_POLICY, class FORCE_LAW_POLICY>
+    void AddPairForces(const std::vector<std::pair<Node<SPACE_DIM>*, Node<SPACE_DIM>*> >& rNodePairs,
+                       AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation,
+                       const MULTIPLIER_POLICY& rMultiplier,
+                       const FORCE_LAW_POLICY& rForceLaw)
+    {
+        const double cut_off_length = this->mUseCutOffLength ? this->GetCutOffLength() : DBL_MAX;
+        unsigned num_pairs = rNodePairs.size();
+
+        if (this->mNumThreads <= 1 || num_pairs == 0)
+        {
+            for (unsigned pair=0; pair<num_pairs; pair++)
+            {
+                Node<SPACE_DIM>* p_node_a = rNodePairs[pair].first;
+                Node<SPACE_DIM>* p_node_b = rNodePairs[pair].second;
+
+                c_vector<double, SPACE_DIM> force;
+                if (CalculatePairForce(p_node_a, p_node_b, cut_off_length, rMultiplier, rForceLaw, force))
+                {
+                    c_vector<double, SPACE_DIM> negative_force = -1.0 * force;
+                    p_node_b->AddAppliedForceContribution(negative_force);
+                    p_node_a->AddAppliedForceContribution(force);
+                }
+            }
+            return;
+        }
+
+        PolicyPairForce<MULTIPLIER_POLICY, FORCE_LAW_POLICY> pair_force = {this, cut_off_length, &rMultiplier, &rForceLaw};
+        this->AddThreadedPairForces(rNodePairs, rCellPopulation, pair_force);
+    }
+
+public:
+
+    /**
+     * Constructor.
+     */
+    NodeBasedLinearSpringForce();
+
+    /**
+     * Overridden AddForceContribution() method.
+     *
+     * Throws an exception unless the population is a NodeBasedCellPopulation. Defers
+     * to BasicLinearSpringForce if the batched kernel has been selected.
+     *
+     * @param rCellPopulation reference to the cell population
+     */
+    virtual void AddForceContribution(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+};
+
+#include "SerializationExportWrapper.hpp"
+EXPORT_TEMPLATE_CLASS_ALL_DIMS(NodeBasedLinearSpringForce)
+
+#endif /*NODEBASEDLINEARSPRINGFORCE_HPP_*/
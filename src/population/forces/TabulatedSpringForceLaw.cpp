@@ -0,0 +1,175 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "TabulatedSpringForceLaw.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+/** The compression branch of the profile, in the form CubicHermiteTable::Setup() takes. */
+struct CompressionProfile
+{
+    /**
+     * @param x the normalised overlap
+     * @return the profile
+     */
+    double GetValue(double x) const
+    {
+        return TabulatedSpringForceLaw::GetCompressionProfile(x);
+    }
+
+    /**
+     * @param x the normalised overlap
+     * @return the derivative of the profile
+     */
+    double GetDerivative(double x) const
+    {
+        return TabulatedSpringForceLaw::GetCompressionProfileDerivative(x);
+    }
+};
+
+/** The tension branch of the profile, in the form CubicHermiteTable::Setup() takes. */
+struct TensionProfile
+{
+    /**
+     * @param x the normalised overlap
+     * @return the profile
+     */
+    double GetValue(double x) const
+    {
+        return TabulatedSpringForceLaw::GetTensionProfile(x);
+    }
+
+    /**
+     * @param x the normalised overlap
+     * @return the derivative of the profile
+     */
+    double GetDerivative(double x) const
+    {
+        return TabulatedSpringForceLaw::GetTensionProfileDerivative(x);
+    }
+};
+
+TabulatedSpringForceLaw::TabulatedSpringForceLaw()
+    : mMaxRelativeError(0.0),
+      mMinOverlap(0.0),
+      mMaxOverlap(0.0)
+{
+}
+
+void TabulatedSpringForceLaw::Setup(double maxRelativeError, double minOverlap, double maxOverlap)
+{
+    assert(maxRelativeError > 0.0);
+    assert(minOverlap > -1.0 && minOverlap < 0.0);
+    assert(maxOverlap > 0.0);
+
+    mMaxRelativeError = maxRelativeError;
+    mMinOverlap = minOverlap;
+    mMaxOverlap = maxOverlap;
+
+    mCompressionTable.Setup(CompressionProfile(), 0.0, minOverlap, maxRelativeError);
+    mTensionTable.Setup(TensionProfile(), 0.0, maxOverlap, maxRelativeError);
+}
+
+bool TabulatedSpringForceLaw::IsSetUp() const
+{
+    return !mCompressionTable.IsEmpty();
+}
+
+double TabulatedSpringForceLaw::GetMaxRelativeError() const
+{
+    return mMaxRelativeError;
+}
+
+double TabulatedSpringForceLaw::GetMeasuredRelativeError() const
+{
+    return std::max(mCompressionTable.GetMeasuredRelativeError(), mTensionTable.GetMeasuredRelativeError());
+}
+
+double TabulatedSpringForceLaw::GetMinOverlap() const
+{
+    return mMinOverlap;
+}
+
+double TabulatedSpringForceLaw::GetMaxOverlap() const
+{
+    return mMaxOverlap;
+}
+
+unsigned TabulatedSpringForceLaw::GetNumCompressionIntervals() const
+{
+    return mCompressionTable.GetNumIntervals();
+}
+
+unsigned TabulatedSpringForceLaw::GetNumTensionIntervals() const
+{
+    return mTensionTable.GetNumIntervals();
+}
+
+double TabulatedSpringForceLaw::GetCompressionProfile(double normalisedOverlap)
+{
+    //log(x+1) is undefined for x<=-1
+    assert(normalisedOverlap > -1.0);
+    return 3.0*log(1.0 + normalisedOverlap);
+}
+
+double TabulatedSpringForceLaw::GetCompressionProfileDerivative(double normalisedOverlap)
+{
+    return 3.0/(1.0 + normalisedOverlap);
+}
+
+double TabulatedSpringForceLaw::GetTensionProfile(double normalisedOverlap)
+{
+    double alpha = 5.0;
+    return normalisedOverlap*exp(-alpha*normalisedOverlap);
+}
+
+double TabulatedSpringForceLaw::GetTensionProfileDerivative(double normalisedOverlap)
+{
+    double alpha = 5.0;
+    return (1.0 - alpha*normalisedOverlap)*exp(-alpha*normalisedOverlap);
+}
+
+double TabulatedSpringForceLaw::GetAnalyticProfile(double normalisedOverlap)
+{
+    if (normalisedOverlap <= 0.0)
+    {
+        return GetCompressionProfile(normalisedOverlap);
+    }
+    else
+    {
+        return GetTensionProfile(normalisedOverlap);
+    }
+}
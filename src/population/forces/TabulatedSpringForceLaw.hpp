@@ -0,0 +1,191 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TABULATEDSPRINGFORCELAW_HPP_
+#define TABULATEDSPRINGFORCELAW_HPP_
+
+#include <cmath>
+
+#include "CubicHermiteTable.hpp"
+
+/**
+ * A tabulated version of the node-based force law of BasicLinearSpringForce.
+ *
+ * In terms of the normalised overlap x = overlap/restLength, the magnitude of the
+ * force is k restLength p(x), with the profile p(x) = 3 log(1+x) for x <= 0
+ * (compression) and p(x) = x exp(-5x) for x > 0 (tension).
+ *
+ * Each branch of the profile is replaced on a range of x by a CubicHermiteTable
+ * starting at x = 0, built to the requested relative error. Outside the tabulated
+ * range the analytic profile is used.
+ */
+class TabulatedSpringForceLaw
+{
+private:
+
+    /** The requested maximum relative error of the tables. */
+    double mMaxRelativeError;
+
+    /** The lower end of the compression table, in normalised overlap. */
+    double mMinOverlap;
+
+    /** The upper end of the tension table, in normalised overlap. */
+    double mMaxOverlap;
+
+    /** The table of the compression profile, running from zero down to #mMinOverlap. */
+    CubicHermiteTable mCompressionTable;
+
+    /** The table of the tension profile, running from zero up to #mMaxOverlap. */
+    CubicHermiteTable mTensionTable;
+
+public:
+
+    /**
+     * Constructor. The tables are empty, so the analytic profile is used, until
+     * Setup() is called.
+     */
+    TabulatedSpringForceLaw();
+
+    /**
+     * Build the tables.
+     *
+     * @param maxRelativeError the maximum relative error of the tabulated profile
+     * @param minOverlap the lower end of the compression table, in (-1, 0). Defaults to -0.5.
+     * @param maxOverlap the upper end of the tension table. Defaults to 1.
+     */
+    void Setup(double maxRelativeError, double minOverlap=-0.5, double maxOverlap=1.0);
+
+    /**
+     * @return whether Setup() has been called.
+     */
+    bool IsSetUp() const;
+
+    /**
+     * @return mMaxRelativeError
+     */
+    double GetMaxRelativeError() const;
+
+    /**
+     * @return the largest relative error measured when the tables were built.
+     */
+    double GetMeasuredRelativeError() const;
+
+    /**
+     * @return mMinOverlap
+     */
+    double GetMinOverlap() const;
+
+    /**
+     * @return mMaxOverlap
+     */
+    double GetMaxOverlap() const;
+
+    /**
+     * @return the number of intervals in the compression table.
+     */
+    unsigned GetNumCompressionIntervals() const;
+
+    /**
+     * @return the number of intervals in the tension table.
+     */
+    unsigned GetNumTensionIntervals() const;
+
+    /**
+     * @param normalisedOverlap the normalised overlap x, greater than -1
+     * @return the analytic compression profile 3 log(1+x)
+     */
+    static double GetCompressionProfile(double normalisedOverlap);
+
+    /**
+     * @param normalisedOverlap the normalised overlap x, greater than -1
+     * @return the derivative of the compression profile
+     */
+    static double GetCompressionProfileDerivative(double normalisedOverlap);
+
+    /**
+     * @param normalisedOverlap the normalised overlap x
+     * @return the analytic tension profile x exp(-5x)
+     */
+    static double GetTensionProfile(double normalisedOverlap);
+
+    /**
+     * @param normalisedOverlap the normalised overlap x
+     * @return the derivative of the tension profile
+     */
+    static double GetTensionProfileDerivative(double normalisedOverlap);
+
+    /**
+     * @param normalisedOverlap the normalised overlap x, greater than -1
+     * @return the analytic profile
+     */
+    static double GetAnalyticProfile(double normalisedOverlap);
+
+    /**
+     * @param normalisedOverlap the normalised overlap x, greater than -1
+     * @return the profile, tabulated where the tables cover x
+     */
+    inline double GetProfile(double normalisedOverlap) const
+    {
+        if (normalisedOverlap <= 0.0)
+        {
+            if (normalisedOverlap >= mMinOverlap && !mCompressionTable.IsEmpty())
+            {
+                return mCompressionTable.Interpolate(normalisedOverlap);
+            }
+            return GetCompressionProfile(normalisedOverlap);
+        }
+        else
+        {
+            if (normalisedOverlap < mMaxOverlap && !mTensionTable.IsEmpty())
+            {
+                return mTensionTable.Interpolate(normalisedOverlap);
+            }
+            return GetTensionProfile(normalisedOverlap);
+        }
+    }
+
+    /**
+     * @param overlap the distance between the nodes minus the rest length
+     * @param restLength the rest length
+     * @param springStiffness the spring stiffness
+     * @return the magnitude of the force, positive values pulling the nodes together
+     */
+    inline double GetForceMagnitude(double overlap, double restLength, double springStiffness) const
+    {
+        return springStiffness*restLength*GetProfile(overlap/restLength);
+    }
+};
+
+#endif /*TABULATEDSPRINGFORCELAW_HPP_*/
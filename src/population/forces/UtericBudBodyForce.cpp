@@ -0,0 +1,189 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "UtericBudBodyForce.hpp"
+
+UtericBudBodyForce::UtericBudBodyForce(double strength, double diffusionStrength)
+    : AbstractStochasticForce<2>(),
+      mStrength(strength),
+      mRepulsionDistance(2.0),
+      mRepulsionStrength(2.0),
+      mAttachmentStrength(10.0),
+      mDampingConst(100.0),
+      mDiffusionStrength(diffusionStrength),
+      mStromaHeight(10.0)
+{
+    assert(mDiffusionStrength > 0.0);
+}
+
+void UtericBudBodyForce::PrepareForceContribution(AbstractCellPopulation<2>& rCellPopulation)
+{
+    mpCellAttributeCache->Refresh(rCellPopulation);
+    mVerticalForceProfile.SetParameters(mRepulsionDistance, mRepulsionStrength, 2*mStrength, 0.0, 4.0, mStromaHeight);
+    mHeights.resize(mNodes.size());
+    mVerticalForces.resize(mNodes.size());
+
+    // Reuse the previous lookups and draws if asked to, as long as the nodes are the same
+    if (mNoiseFrozen && mIsAttached.size() == mNodes.size())
+    {
+        return;
+    }
+
+    double dt = mpSimulationContext->GetTimeStep();
+    double kick_scale = sqrt(2.0*mDiffusionStrength*dt)/dt;
+
+    // Draw two per node in one batch, exactly as BasicDiffusionForce does, then scale in place
+    mIsAttached.assign(mNodes.size(), false);
+    FillNodeNormalDeviates(DIFFUSION_RANDOM_STREAM, mBrownianForces);
+    for (unsigned i=0; i<mNodes.size(); i++)
+    {
+        unsigned node_index = mNodes[i]->GetIndex();
+        mIsAttached[i] = mpCellAttributeCache->IsAttached(node_index);
+
+        double scale = mIsAttached[i] ? 0.0 : mpCellAttributeCache->GetDampingConstant(node_index)*kick_scale;
+        mBrownianForces[2*i] *= scale;
+        mBrownianForces[2*i + 1] *= scale;
+    }
+}
+
+void UtericBudBodyForce::AddForceContributionToNodes(AbstractCellPopulation<2>& rCellPopulation, unsigned begin, unsigned end, unsigned threadIndex)
+{
+    // Vertical potential for the whole range at once
+    for (unsigned i=begin; i<end; i++)
+    {
+        mHeights[i] = mNodes[i]->rGetLocation()[1];
+    }
+    mVerticalForceProfile.GetForces(&mHeights[begin], &mVerticalForces[begin], end - begin);
+
+    c_vector<double, 2> force;
+    for (unsigned i=begin; i<end; i++)
+    {
+        if (mIsAttached[i])
+        {
+            // Anchoring
+            force(0) = 0;
+            force(1) = -mAttachmentStrength * mDampingConst;
+        }
+        else
+        {
+            // Vertical potential
+            force(0) = 0;
+            force(1) = mVerticalForces[i];
+
+            // Brownian kick
+            force(0) += mBrownianForces[2*i];
+            force(1) += mBrownianForces[2*i + 1];
+        }
+
+        mForceBuffer.AddForce(threadIndex, i, force);
+    }
+}
+
+double UtericBudBodyForce::GetStrength()
+{
+    return mStrength;
+}
+
+void UtericBudBodyForce::SetRepulsionDistance(double repulsionDist)
+{
+    mRepulsionDistance = repulsionDist;
+}
+
+double UtericBudBodyForce::GetRepulsionDistance()
+{
+    return mRepulsionDistance;
+}
+
+void UtericBudBodyForce::SetRepulsionStrength(double repulsionStrength)
+{
+    mRepulsionStrength = repulsionStrength;
+}
+
+double UtericBudBodyForce::GetRepulsionStrength()
+{
+    return mRepulsionStrength;
+}
+
+void UtericBudBodyForce::SetAttachmentStrength(double attachStrength)
+{
+    mAttachmentStrength = attachStrength;
+}
+
+double UtericBudBodyForce::GetAttachmentStrength()
+{
+    return mAttachmentStrength;
+}
+
+void UtericBudBodyForce::SetDampingConst(double dampingConst)
+{
+    mDampingConst = dampingConst;
+}
+
+double UtericBudBodyForce::GetDampingConst()
+{
+    return mDampingConst;
+}
+
+double UtericBudBodyForce::GetDiffusionStrength()
+{
+    return mDiffusionStrength;
+}
+
+void UtericBudBodyForce::SetStromaHeight(double stromaHeight)
+{
+    mStromaHeight = stromaHeight;
+}
+
+double UtericBudBodyForce::GetStromaHeight()
+{
+    return mStromaHeight;
+}
+
+void UtericBudBodyForce::OutputForceParameters(out_stream& rParamsFile)
+{
+    *rParamsFile << "\t\t\t<Strength>" << mStrength << "</Strength>\n";
+    *rParamsFile << "\t\t\t<RepulsionDistance>" << mRepulsionDistance << "</RepulsionDistance>\n";
+    *rParamsFile << "\t\t\t<RepulsionStrength>" << mRepulsionStrength << "</RepulsionStrength>\n";
+    *rParamsFile << "\t\t\t<AttachmentStrength>" << mAttachmentStrength << "</AttachmentStrength>\n";
+    *rParamsFile << "\t\t\t<DampingConst>" << mDampingConst << "</DampingConst>\n";
+    *rParamsFile << "\t\t\t<DiffusionStrength>" << mDiffusionStrength << "</DiffusionStrength>\n";
+    *rParamsFile << "\t\t\t<StromaHeight>" << mStromaHeight << "</StromaHeight>\n";
+
+    // Call method on direct parent class
+    AbstractStochasticForce<2>::OutputForceParameters(rParamsFile);
+}
+
+#include "SerializationExportWrapperForCpp.hpp"
+CHASTE_CLASS_EXPORT(UtericBudBodyForce)
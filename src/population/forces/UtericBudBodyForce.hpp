@@ -0,0 +1,237 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef UTERICBUDBODYFORCE_HPP_
+#define UTERICBUDBODYFORCE_HPP_
+
+#include <vector>
+
+#include "AbstractStochasticForce.hpp"
+#include "VerticalForceProfile.hpp"
+
+#include "ChasteSerialization.hpp"
+#include <boost/serialization/base_object.hpp>
+
+/**
+ * The body forces of the uteric bud model in a single pass: the vertical potential
+ * and attached-cell anchoring of GravityForce3, and the Brownian kick of
+ * BasicDiffusionForce.
+ *
+ * Each cell is looked up once per evaluation, in a serial pass that also draws the
+ * random numbers. The draws are made in one batch, two per node in node order,
+ * exactly as BasicDiffusionForce makes them, so replacing GravityForce3 and
+ * BasicDiffusionForce with this force consumes the same random number sequence and
+ * gives the same trajectories up to the order in which force contributions are
+ * summed. The forces themselves are then computed in parallel.
+ *
+ * This force is for node-based populations, in which the location of a cell centre
+ * is the location of its node.
+ */
+class UtericBudBodyForce : public AbstractStochasticForce<2>
+{
+private:
+
+    /** Needed for serialization. */
+    friend class boost::serialization::access;
+    /**
+     * Archive the object and its member variables.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void serialize(Archive & archive, const unsigned int version)
+    {
+        archive & boost::serialization::base_object<AbstractStochasticForce<2> >(*this);
+        archive & mStrength;
+        archive & mRepulsionDistance;
+        archive & mRepulsionStrength;
+        archive & mAttachmentStrength;
+        archive & mDampingConst;
+        archive & mDiffusionStrength;
+        archive & mStromaHeight;
+    }
+
+    /** Strength of the downward pull on cells that are not attached, as GravityForce3. */
+    double mStrength;
+
+    /** Height below which cells are pushed up, as GravityForce3. */
+    double mRepulsionDistance;
+
+    /** Strength of the upward push below #mRepulsionDistance, as GravityForce3. */
+    double mRepulsionStrength;
+
+    /** Speed at which attached cells are pulled down, as GravityForce3. */
+    double mAttachmentStrength;
+
+    /** Damping constant of attached cells, as GravityForce3. */
+    double mDampingConst;
+
+    /** Diffusion coefficient of cells that are not attached, as BasicDiffusionForce. */
+    double mDiffusionStrength;
+
+    /** Height of the stroma, which repels cells from above, as GravityForce3. */
+    double mStromaHeight;
+
+    /** The vertical potential, tabulated whenever the parameters change. */
+    VerticalForceProfile mVerticalForceProfile;
+
+    /** The height of the node at each entry of mNodes. */
+    std::vector<double> mHeights;
+
+    /** The vertical force at each height in #mHeights. */
+    std::vector<double> mVerticalForces;
+
+    /** Whether the cell at each entry of mNodes is attached. Filled in by PrepareForceContribution(). */
+    std::vector<bool> mIsAttached;
+
+    /**
+     * The Brownian force on the cell at each entry of mNodes, two components per
+     * entry. Filled in by PrepareForceContribution().
+     */
+    std::vector<double> mBrownianForces;
+
+    /**
+     * Overridden PrepareForceContribution() method.
+     *
+     * Update #mVerticalForceProfile, then look up every cell once, recording whether
+     * it is attached, and compute the Brownian force on it.
+     *
+     * @param rCellPopulation reference to the cell population
+     */
+    void PrepareForceContribution(AbstractCellPopulation<2>& rCellPopulation);
+
+    /**
+     * Overridden AddForceContributionToNodes() method.
+     *
+     * @param rCellPopulation reference to the cell population
+     * @param begin the position of the first node in the range
+     * @param end one past the position of the last node in the range
+     * @param threadIndex the index of the calling thread
+     */
+    void AddForceContributionToNodes(AbstractCellPopulation<2>& rCellPopulation, unsigned begin, unsigned end, unsigned threadIndex);
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param strength the strength of the downward pull (defaults to 1.0)
+     * @param diffusionStrength the diffusion coefficient (defaults to 1.0)
+     */
+    UtericBudBodyForce(double strength=1.0, double diffusionStrength=1.0);
+
+    /**
+     * @return #mStrength
+     */
+    double GetStrength();
+
+    /**
+     * Set #mRepulsionDistance.
+     *
+     * @param repulsionDist the new value of #mRepulsionDistance
+     */
+    void SetRepulsionDistance(double repulsionDist);
+
+    /**
+     * @return #mRepulsionDistance
+     */
+    double GetRepulsionDistance();
+
+    /**
+     * Set #mRepulsionStrength.
+     *
+     * @param repulsionStrength the new value of #mRepulsionStrength
+     */
+    void SetRepulsionStrength(double repulsionStrength);
+
+    /**
+     * @return #mRepulsionStrength
+     */
+    double GetRepulsionStrength();
+
+    /**
+     * Set #mAttachmentStrength.
+     *
+     * @param attachStrength the new value of #mAttachmentStrength
+     */
+    void SetAttachmentStrength(double attachStrength);
+
+    /**
+     * @return #mAttachmentStrength
+     */
+    double GetAttachmentStrength();
+
+    /**
+     * Set #mDampingConst.
+     *
+     * @param dampingConst the new value of #mDampingConst
+     */
+    void SetDampingConst(double dampingConst);
+
+    /**
+     * @return #mDampingConst
+     */
+    double GetDampingConst();
+
+    /**
+     * @return #mDiffusionStrength
+     */
+    double GetDiffusionStrength();
+
+    /**
+     * Set #mStromaHeight.
+     *
+     * @param stromaHeight the new value of #mStromaHeight
+     */
+    void SetStromaHeight(double stromaHeight);
+
+    /**
+     * @return #mStromaHeight
+     */
+    double GetStromaHeight();
+
+    /**
+     * Overridden OutputForceParameters() method.
+     *
+     * @param rParamsFile the file stream to which the parameters are output
+     */
+    virtual void OutputForceParameters(out_stream& rParamsFile);
+};
+
+#include "SerializationExportWrapper.hpp"
+CHASTE_CLASS_EXPORT(UtericBudBodyForce)
+
+#endif /*UTERICBUDBODYFORCE_HPP_*/
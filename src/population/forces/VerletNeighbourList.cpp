@@ -0,0 +1,275 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "VerletNeighbourList.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+VerletNeighbourList<ELEMENT_DIM,SPACE_DIM>::VerletNeighbourList(double skin)
+    : mSkin(skin),
+      mCutOffLength(0.0),
+      mNumUpdates(0),
+      mNumRebuilds(0)
+{
+    assert(mSkin >= 0.0);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool VerletNeighbourList<ELEMENT_DIM,SPACE_DIM>::IsRebuildNeeded(double cutOffLength) const
+{
+    if (cutOffLength != mCutOffLength || mCurrentNodes != mNodes)
+    {
+        return true;
+    }
+
+    double max_displacement_squared = 0.25*mSkin*mSkin;
+    for (unsigned i=0; i<mNodes.size(); i++)
+    {
+        const c_vector<double, SPACE_DIM>& r_location = mNodes[i]->rGetLocation();
+        double displacement_squared = 0.0;
+        for (unsigned d=0; d<SPACE_DIM; d++)
+        {
+            double displacement = r_location[d] - mReferenceLocations[i*SPACE_DIM + d];
+            displacement_squared += displacement*displacement;
+        }
+        if (displacement_squared > max_displacement_squared)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void VerletNeighbourList<ELEMENT_DIM,SPACE_DIM>::Rebuild(double cutOffLength)
+{
+    mNumRebuilds++;
+    mCutOffLength = cutOffLength;
+    mNodes = mCurrentNodes;
+    mNodePairs.clear();
+
+    unsigned num_nodes = mNodes.size();
+    mReferenceLocations.resize(num_nodes*SPACE_DIM);
+    if (num_nodes == 0)
+    {
+        return;
+    }
+
+    // Bounding box of the nodes
+    c_vector<double, SPACE_DIM> min_corner = mNodes[0]->rGetLocation();
+    c_vector<double, SPACE_DIM> max_corner = min_corner;
+    for (unsigned i=0; i<num_nodes; i++)
+    {
+        const c_vector<double, SPACE_DIM>& r_location = mNodes[i]->rGetLocation();
+        for (unsigned d=0; d<SPACE_DIM; d++)
+        {
+            mReferenceLocations[i*SPACE_DIM + d] = r_location[d];
+            min_corner[d] = std::min(min_corner[d], r_location[d]);
+            max_corner[d] = std::max(max_corner[d], r_location[d]);
+        }
+    }
+
+    // Bin the nodes into boxes of width the list radius, using a linked list per box
+    double list_radius = cutOffLength + mSkin;
+    double list_radius_squared = list_radius*list_radius;
+    assert(list_radius > 0.0);
+
+    unsigned num_boxes_in_dim[SPACE_DIM];
+    unsigned box_stride[SPACE_DIM];
+    unsigned num_boxes = 1;
+    for (unsigned d=0; d<SPACE_DIM; d++)
+    {
+        num_boxes_in_dim[d] = (unsigned) floor((max_corner[d] - min_corner[d])/list_radius) + 1;
+        box_stride[d] = num_boxes;
+        num_boxes *= num_boxes_in_dim[d];
+    }
+
+    std::vector<unsigned> box_coords(num_nodes*SPACE_DIM);
+    std::vector<int> first_in_box(num_boxes, -1);
+    std::vector<int> next_in_box(num_nodes, -1);
+    for (int i=num_nodes-1; i>=0; i--)
+    {
+        unsigned box = 0;
+        for (unsigned d=0; d<SPACE_DIM; d++)
+        {
+            unsigned coord = std::min((unsigned) floor((mReferenceLocations[i*SPACE_DIM + d] - min_corner[d])/list_radius), num_boxes_in_dim[d] - 1);
+            box_coords[i*SPACE_DIM + d] = coord;
+            box += coord*box_stride[d];
+        }
+        next_in_box[i] = first_in_box[box];
+        first_in_box[box] = i;
+    }
+
+    // Compare each node with the later nodes in its own and neighbouring boxes
+    unsigned num_neighbour_boxes = 1;
+    for (unsigned d=0; d<SPACE_DIM; d++)
+    {
+        num_neighbour_boxes *= 3;
+    }
+    for (unsigned i=0; i<num_nodes; i++)
+    {
+        for (unsigned offset=0; offset<num_neighbour_boxes; offset++)
+        {
+            // Decode the offset into a shift of -1, 0 or 1 in each dimension
+            unsigned box = 0;
+            bool is_inside = true;
+            unsigned remainder = offset;
+            for (unsigned d=0; d<SPACE_DIM; d++)
+            {
+                int coord = (int) box_coords[i*SPACE_DIM + d] + (int) (remainder%3) - 1;
+                remainder /= 3;
+                if (coord < 0 || coord >= (int) num_boxes_in_dim[d])
+                {
+                    is_inside = false;
+                    break;
+                }
+                box += coord*box_stride[d];
+            }
+            if (!is_inside)
+            {
+                continue;
+            }
+
+            for (int j=first_in_box[box]; j>=0; j=next_in_box[j])
+            {
+                if ((unsigned) j <= i)
+                {
+                    continue;
+                }
+                double distance_squared = 0.0;
+                for (unsigned d=0; d<SPACE_DIM; d++)
+                {
+                    double difference = mReferenceLocations[j*SPACE_DIM + d] - mReferenceLocations[i*SPACE_DIM + d];
+                    distance_squared += difference*difference;
+                }
+                if (distance_squared < list_radius_squared)
+                {
+                    mNodePairs.push_back(std::make_pair(mNodes[i], mNodes[j]));
+                }
+            }
+        }
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool VerletNeighbourList<ELEMENT_DIM,SPACE_DIM>::Update(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation, double cutOffLength)
+{
+    mNumUpdates++;
+
+    mCurrentNodes.clear();
+    AbstractMesh<ELEMENT_DIM,SPACE_DIM>& r_mesh = rCellPopulation.rGetMesh();
+    for (typename AbstractMesh<ELEMENT_DIM,SPACE_DIM>::NodeIterator node_iter = r_mesh.GetNodeIteratorBegin();
+         node_iter != r_mesh.GetNodeIteratorEnd();
+         ++node_iter)
+    {
+        mCurrentNodes.push_back(&(*node_iter));
+    }
+
+    if (IsRebuildNeeded(cutOffLength))
+    {
+        Rebuild(cutOffLength);
+        return true;
+    }
+    return false;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void VerletNeighbourList<ELEMENT_DIM,SPACE_DIM>::AddForceContribution(AbstractTwoBodyInteractionForce<ELEMENT_DIM,SPACE_DIM>& rForce,
+                                                                      AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    assert(rForce.GetUseCutOffLength());
+    Update(rCellPopulation, rForce.GetCutOffLength());
+
+    for (unsigned pair=0; pair<mNodePairs.size(); pair++)
+    {
+        Node<SPACE_DIM>* p_node_a = mNodePairs[pair].first;
+        Node<SPACE_DIM>* p_node_b = mNodePairs[pair].second;
+
+        // The force is zero for pairs that are in the list but beyond the cut-off
+        c_vector<double, SPACE_DIM> force = rForce.CalculateForceBetweenNodes(p_node_a->GetIndex(), p_node_b->GetIndex(), rCellPopulation);
+        c_vector<double, SPACE_DIM> negative_force = -1.0 * force;
+        p_node_b->AddAppliedForceContribution(negative_force);
+        p_node_a->AddAppliedForceContribution(force);
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void VerletNeighbourList<ELEMENT_DIM,SPACE_DIM>::Invalidate()
+{
+    mNodes.clear();
+    mCutOffLength = 0.0;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const std::vector<std::pair<Node<SPACE_DIM>*, Node<SPACE_DIM>*> >& VerletNeighbourList<ELEMENT_DIM,SPACE_DIM>::rGetNodePairs() const
+{
+    return mNodePairs;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+double VerletNeighbourList<ELEMENT_DIM,SPACE_DIM>::GetSkin() const
+{
+    return mSkin;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void VerletNeighbourList<ELEMENT_DIM,SPACE_DIM>::SetSkin(double skin)
+{
+    assert(skin >= 0.0);
+    mSkin = skin;
+    Invalidate();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned VerletNeighbourList<ELEMENT_DIM,SPACE_DIM>::GetNumUpdates() const
+{
+    return mNumUpdates;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned VerletNeighbourList<ELEMENT_DIM,SPACE_DIM>::GetNumRebuilds() const
+{
+    return mNumRebuilds;
+}
+
+// Explicit instantiation
+template class VerletNeighbourList<1,1>;
+template class VerletNeighbourList<1,2>;
+template class VerletNeighbourList<2,2>;
+template class VerletNeighbourList<1,3>;
+template class VerletNeighbourList<2,3>;
+template class VerletNeighbourList<3,3>;
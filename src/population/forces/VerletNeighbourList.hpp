@@ -0,0 +1,165 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef VERLETNEIGHBOURLIST_HPP_
+#define VERLETNEIGHBOURLIST_HPP_
+
+#include <utility>
+#include <vector>
+
+#include "AbstractCellPopulation.hpp"
+#include "AbstractTwoBodyInteractionForce.hpp"
+#include "Node.hpp"
+
+/**
+ * A Verlet neighbour list for two-body forces with a cut-off.
+ *
+ * The list holds every pair of nodes closer than the cut-off plus a skin distance,
+ * and remembers where the nodes were when it was built. No pair can come within the
+ * cut-off without one of its nodes moving more than half the skin, so the list only
+ * has to be rebuilt once some node has moved that far. It is also rebuilt whenever
+ * the nodes themselves change, through births, deaths or remeshing.
+ *
+ * Rebuilding bins the nodes into boxes whose width is the cut-off plus the skin and
+ * only compares nodes in neighbouring boxes. Distances are computed by subtracting
+ * locations, so the list cannot be used with periodic meshes.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM=ELEMENT_DIM>
+class VerletNeighbourList
+{
+private:
+
+    /** The skin distance added to the cut-off. */
+    double mSkin;
+
+    /** The cut-off the list was last built for. */
+    double mCutOffLength;
+
+    /** The nodes when the list was last built, in mesh order. */
+    std::vector<Node<SPACE_DIM>*> mNodes;
+
+    /** The node locations when the list was last built, node by node. */
+    std::vector<double> mReferenceLocations;
+
+    /** The pairs of nodes closer than the cut-off plus the skin when the list was last built. */
+    std::vector<std::pair<Node<SPACE_DIM>*, Node<SPACE_DIM>*> > mNodePairs;
+
+    /** The number of calls to Update(). */
+    unsigned mNumUpdates;
+
+    /** The number of times the list has been rebuilt. */
+    unsigned mNumRebuilds;
+
+    /** Scratch space for the nodes in the mesh at the current update. */
+    std::vector<Node<SPACE_DIM>*> mCurrentNodes;
+
+    /**
+     * @return whether the list must be rebuilt before it can be used for the nodes
+     *     in #mCurrentNodes.
+     *
+     * @param cutOffLength the cut-off of the force
+     */
+    bool IsRebuildNeeded(double cutOffLength) const;
+
+    /**
+     * Rebuild the list from the nodes in #mCurrentNodes.
+     *
+     * @param cutOffLength the cut-off of the force
+     */
+    void Rebuild(double cutOffLength);
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param skin the skin distance (defaults to 0.3)
+     */
+    VerletNeighbourList(double skin=0.3);
+
+    /**
+     * Bring the list up to date with the cell population, rebuilding it if needed.
+     *
+     * @param rCellPopulation the cell population
+     * @param cutOffLength the cut-off of the force
+     * @return whether the list was rebuilt
+     */
+    bool Update(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation, double cutOffLength);
+
+    /**
+     * Update the list, then add the force between each pair of nodes in it to both
+     * nodes, exactly as AbstractTwoBodyInteractionForce::AddForceContribution() does
+     * for the pairs found by the cell population. The force must have a cut-off.
+     *
+     * @param rForce the force
+     * @param rCellPopulation the cell population
+     */
+    void AddForceContribution(AbstractTwoBodyInteractionForce<ELEMENT_DIM,SPACE_DIM>& rForce,
+                              AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
+    /**
+     * Force the list to be rebuilt at the next update.
+     */
+    void Invalidate();
+
+    /**
+     * @return the pairs of nodes in the list.
+     */
+    const std::vector<std::pair<Node<SPACE_DIM>*, Node<SPACE_DIM>*> >& rGetNodePairs() const;
+
+    /**
+     * @return #mSkin
+     */
+    double GetSkin() const;
+
+    /**
+     * Set #mSkin. The list is rebuilt at the next update.
+     *
+     * @param skin the new skin distance
+     */
+    void SetSkin(double skin);
+
+    /**
+     * @return #mNumUpdates
+     */
+    unsigned GetNumUpdates() const;
+
+    /**
+     * @return #mNumRebuilds
+     */
+    unsigned GetNumRebuilds() const;
+};
+
+#endif /*VERLETNEIGHBOURLIST_HPP_*/
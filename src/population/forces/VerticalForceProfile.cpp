@@ -0,0 +1,204 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "VerticalForceProfile.hpp"
+
+/** The profile above the repulsion distance, in the form CubicHermiteTable::Setup() takes. */
+struct AnalyticVerticalForce
+{
+    /** The profile being tabulated. */
+    const VerticalForceProfile* mpProfile;
+
+    /**
+     * @param y the height
+     * @return the force
+     */
+    double GetValue(double y) const
+    {
+        return mpProfile->GetAnalyticForce(y);
+    }
+
+    /**
+     * @param y the height
+     * @return the derivative of the force
+     */
+    double GetDerivative(double y) const
+    {
+        return mpProfile->GetAnalyticForceDerivative(y);
+    }
+};
+
+VerticalForceProfile::VerticalForceProfile()
+    : mRepulsionDistance(0.0),
+      mRepulsionStrength(0.0),
+      mAttractionStrength(0.0),
+      mConstantForce(0.0),
+      mStromaStrength(0.0),
+      mStromaHeight(0.0),
+      mMaxRelativeError(1e-8),
+      mMaxAbsoluteError(1e-10),
+      mIsSetUp(false),
+      mTableEnd(0.0)
+{
+}
+
+void VerticalForceProfile::SetParameters(double repulsionDistance,
+                                         double repulsionStrength,
+                                         double attractionStrength,
+                                         double constantForce,
+                                         double stromaStrength,
+                                         double stromaHeight)
+{
+    if (mIsSetUp
+        && repulsionDistance == mRepulsionDistance
+        && repulsionStrength == mRepulsionStrength
+        && attractionStrength == mAttractionStrength
+        && constantForce == mConstantForce
+        && stromaStrength == mStromaStrength
+        && stromaHeight == mStromaHeight)
+    {
+        return;
+    }
+
+    mRepulsionDistance = repulsionDistance;
+    mRepulsionStrength = repulsionStrength;
+    mAttractionStrength = attractionStrength;
+    mConstantForce = constantForce;
+    mStromaStrength = stromaStrength;
+    mStromaHeight = stromaHeight;
+
+    // Keep the table clear of the singularity at the stroma
+    double table_end = mRepulsionDistance + 20.0;
+    if (mStromaStrength != 0.0)
+    {
+        table_end = mStromaHeight - 0.5;
+    }
+
+    mTable.Clear();
+    mTableEnd = mRepulsionDistance;
+    if (table_end > mRepulsionDistance)
+    {
+        AnalyticVerticalForce analytic_force;
+        analytic_force.mpProfile = this;
+        mTable.Setup(analytic_force, mRepulsionDistance, table_end, mMaxRelativeError, mMaxAbsoluteError);
+        mTableEnd = table_end;
+    }
+    mIsSetUp = true;
+}
+
+void VerticalForceProfile::SetMaxRelativeError(double maxRelativeError)
+{
+    assert(maxRelativeError > 0.0);
+    mMaxRelativeError = maxRelativeError;
+    mIsSetUp = false;
+}
+
+double VerticalForceProfile::GetMaxRelativeError() const
+{
+    return mMaxRelativeError;
+}
+
+void VerticalForceProfile::SetMaxAbsoluteError(double maxAbsoluteError)
+{
+    assert(maxAbsoluteError >= 0.0);
+    mMaxAbsoluteError = maxAbsoluteError;
+    mIsSetUp = false;
+}
+
+double VerticalForceProfile::GetMaxAbsoluteError() const
+{
+    return mMaxAbsoluteError;
+}
+
+const CubicHermiteTable& VerticalForceProfile::rGetTable() const
+{
+    return mTable;
+}
+
+double VerticalForceProfile::GetAnalyticForce(double height) const
+{
+    if (height < mRepulsionDistance)
+    {
+        return mRepulsionStrength;
+    }
+
+    double force = mConstantForce - mAttractionStrength/(height + 1 - mRepulsionDistance);
+    if (mStromaStrength != 0.0)
+    {
+        force += mStromaStrength/(height - mStromaHeight) - mStromaStrength/(mRepulsionDistance - mStromaHeight);
+    }
+    return force;
+}
+
+double VerticalForceProfile::GetAnalyticForceDerivative(double height) const
+{
+    double shifted_height = height + 1 - mRepulsionDistance;
+    double derivative = mAttractionStrength/(shifted_height*shifted_height);
+    if (mStromaStrength != 0.0)
+    {
+        derivative -= mStromaStrength/((height - mStromaHeight)*(height - mStromaHeight));
+    }
+    return derivative;
+}
+
+void VerticalForceProfile::GetForces(const double* pHeights, double* pForces, unsigned numHeights) const
+{
+    if (mTable.IsEmpty())
+    {
+        for (unsigned i=0; i<numHeights; i++)
+        {
+            pForces[i] = GetAnalyticForce(pHeights[i]);
+        }
+        return;
+    }
+
+    // Interpolate everywhere, then overwrite the heights the table does not cover
+    mTable.Interpolate(pHeights, pForces, numHeights);
+
+    const double repulsion_distance = mRepulsionDistance;
+    const double repulsion_strength = mRepulsionStrength;
+    for (unsigned i=0; i<numHeights; i++)
+    {
+        pForces[i] = pHeights[i] < repulsion_distance ? repulsion_strength : pForces[i];
+    }
+
+    for (unsigned i=0; i<numHeights; i++)
+    {
+        if (pHeights[i] >= mTableEnd)
+        {
+            pForces[i] = GetAnalyticForce(pHeights[i]);
+        }
+    }
+}
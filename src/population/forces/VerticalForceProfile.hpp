@@ -0,0 +1,191 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef VERTICALFORCEPROFILE_HPP_
+#define VERTICALFORCEPROFILE_HPP_
+
+#include "CubicHermiteTable.hpp"
+
+/**
+ * The vertical force on a non-attached cell as a function of its height y, shared by
+ * GravityForce, GravityForce2, GravityForce3 and UtericBudBodyForce.
+ *
+ * Below the repulsion distance d the force is the constant repulsion strength R.
+ * At or above d it is
+ *
+ * \f[
+ * f(y) = C - \frac{A}{y + 1 - d} + W \left( \frac{1}{y - H} - \frac{1}{d - H} \right),
+ * \f]
+ *
+ * with C a constant force, A the attraction strength, W the stroma strength and H the
+ * stroma height. The stroma term is left out when W is zero.
+ *
+ * Every time the parameters change, f is tabulated above d by a CubicHermiteTable to
+ * the given relative error (1e-8 by default) plus the given absolute error (1e-10 by
+ * default), which the table needs where f crosses zero. The table runs to half a unit below the
+ * stroma height, or 20 units above d when there is no stroma term, and the analytic
+ * profile is used beyond it. GetForces() evaluates the profile at a whole array of
+ * heights in loops the compiler can vectorise.
+ */
+class VerticalForceProfile
+{
+private:
+
+    /** The repulsion distance d. */
+    double mRepulsionDistance;
+
+    /** The repulsion strength R. */
+    double mRepulsionStrength;
+
+    /** The attraction strength A. */
+    double mAttractionStrength;
+
+    /** The constant force C. */
+    double mConstantForce;
+
+    /** The stroma strength W. */
+    double mStromaStrength;
+
+    /** The stroma height H. */
+    double mStromaHeight;
+
+    /** The maximum relative error of #mTable. */
+    double mMaxRelativeError;
+
+    /** The absolute error allowed in #mTable on top of #mMaxRelativeError. */
+    double mMaxAbsoluteError;
+
+    /** Whether SetParameters() has been called since the last change of tolerance. */
+    bool mIsSetUp;
+
+    /** The table of the profile above the repulsion distance. May be empty. */
+    CubicHermiteTable mTable;
+
+    /** The upper end of #mTable, or the repulsion distance if it is empty. */
+    double mTableEnd;
+
+public:
+
+    /**
+     * Constructor.
+     */
+    VerticalForceProfile();
+
+    /**
+     * Set the parameters of the profile, rebuilding the table if any have changed.
+     *
+     * @param repulsionDistance the repulsion distance d
+     * @param repulsionStrength the repulsion strength R
+     * @param attractionStrength the attraction strength A
+     * @param constantForce the constant force C
+     * @param stromaStrength the stroma strength W
+     * @param stromaHeight the stroma height H
+     */
+    void SetParameters(double repulsionDistance,
+                       double repulsionStrength,
+                       double attractionStrength,
+                       double constantForce,
+                       double stromaStrength,
+                       double stromaHeight);
+
+    /**
+     * Set mMaxRelativeError. The table is rebuilt by the next call to SetParameters().
+     *
+     * @param maxRelativeError the maximum relative error of the table
+     */
+    void SetMaxRelativeError(double maxRelativeError);
+
+    /**
+     * @return mMaxRelativeError
+     */
+    double GetMaxRelativeError() const;
+
+    /**
+     * Set mMaxAbsoluteError. The table is rebuilt by the next call to SetParameters().
+     *
+     * @param maxAbsoluteError the absolute error allowed on top of the relative error
+     */
+    void SetMaxAbsoluteError(double maxAbsoluteError);
+
+    /**
+     * @return mMaxAbsoluteError
+     */
+    double GetMaxAbsoluteError() const;
+
+    /**
+     * @return the table of the profile.
+     */
+    const CubicHermiteTable& rGetTable() const;
+
+    /**
+     * @param height the height y
+     * @return the analytic force f(y)
+     */
+    double GetAnalyticForce(double height) const;
+
+    /**
+     * @param height the height y, at or above the repulsion distance
+     * @return the derivative of the analytic force
+     */
+    double GetAnalyticForceDerivative(double height) const;
+
+    /**
+     * @param height the height y
+     * @return the force, from the table where it covers y
+     */
+    inline double GetForce(double height) const
+    {
+        if (height < mRepulsionDistance)
+        {
+            return mRepulsionStrength;
+        }
+        if (height < mTableEnd)
+        {
+            return mTable.Interpolate(height);
+        }
+        return GetAnalyticForce(height);
+    }
+
+    /**
+     * Evaluate the force at many heights at once, as GetForce().
+     *
+     * @param pHeights the heights
+     * @param pForces the forces (filled in)
+     * @param numHeights the number of heights
+     */
+    void GetForces(const double* pHeights, double* pForces, unsigned numHeights) const;
+};
+
+#endif /*VERTICALFORCEPROFILE_HPP_*/
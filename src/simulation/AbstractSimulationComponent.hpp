@@ -0,0 +1,76 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef ABSTRACTSIMULATIONCOMPONENT_HPP_
+#define ABSTRACTSIMULATIONCOMPONENT_HPP_
+
+#include <boost/shared_ptr.hpp>
+
+#include "CellAttributeCache.hpp"
+#include "PopulationUpdateCoordinator.hpp"
+
+/**
+ * An interface for the forces, boundary conditions and modifiers that share state
+ * with the OffLatticeSimulationUT they are added to: its cell attribute cache, its
+ * population update coordinator and the number of threads its forces may use.
+ *
+ * The simulation calls ConnectToSimulation() on each of them in SetupSolve(). None of
+ * the shared state is archived with the components, so this also reconnects restored
+ * ones. Components that also take the simulation context implement
+ * AbstractSimulationContextUser.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM=ELEMENT_DIM>
+class AbstractSimulationComponent
+{
+public:
+
+    /**
+     * Destructor.
+     */
+    virtual ~AbstractSimulationComponent();
+
+    /**
+     * Take what the component needs from the state shared by the simulation.
+     *
+     * @param pCellAttributeCache the cell attribute cache of the simulation
+     * @param pPopulationUpdateCoordinator the population update coordinator of the simulation
+     * @param numForceThreads the number of threads the forces of the simulation may use
+     */
+    virtual void ConnectToSimulation(boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > pCellAttributeCache,
+                                     boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > pPopulationUpdateCoordinator,
+                                     unsigned numForceThreads)=0;
+};
+
+#endif /*ABSTRACTSIMULATIONCOMPONENT_HPP_*/
@@ -0,0 +1,79 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef ABSTRACTSIMULATIONCONTEXTUSER_HPP_
+#define ABSTRACTSIMULATIONCONTEXTUSER_HPP_
+
+#include <boost/shared_ptr.hpp>
+
+#include "UtericBudSimulationContext.hpp"
+
+/**
+ * An interface for the objects that take their time and random numbers from a
+ * UtericBudSimulationContext. OffLatticeSimulationUT gives its context to each of
+ * its forces, boundary conditions and modifiers that implement this interface, and
+ * to the cell cycle model of each of its cells, without needing to know their types.
+ */
+class AbstractSimulationContextUser
+{
+public:
+
+    /**
+     * Destructor.
+     */
+    virtual ~AbstractSimulationContextUser();
+
+    /**
+     * Set the simulation context.
+     *
+     * @param pSimulationContext the source of time and random numbers
+     */
+    virtual void SetSimulationContext(boost::shared_ptr<UtericBudSimulationContext> pSimulationContext)=0;
+
+    /**
+     * @return the simulation context, or an empty pointer if none has been set.
+     */
+    virtual boost::shared_ptr<UtericBudSimulationContext> GetSimulationContext() const=0;
+
+    /**
+     * Set the simulation context if none has been set. An object with a different
+     * context would not see the clock of the simulation, so this is an error.
+     *
+     * @param pSimulationContext the context of the simulation
+     */
+    void ShareSimulationContext(boost::shared_ptr<UtericBudSimulationContext> pSimulationContext);
+};
+
+#endif /*ABSTRACTSIMULATIONCONTEXTUSER_HPP_*/
@@ -0,0 +1,201 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include "ConcurrentReplicateRunner.hpp"
+
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Exception.hpp"
+#include "PetscTools.hpp"
+
+ConcurrentReplicateRunner::ConcurrentReplicateRunner(unsigned maxNumConcurrentReplicates)
+    : mMaxNumConcurrentReplicates(maxNumConcurrentReplicates),
+      mNumRunningReplicates(0),
+      mPeakNumConcurrentReplicates(0),
+      mNumFailedReplicates(0),
+      mIsWorker(false)
+{
+    assert(maxNumConcurrentReplicates > 0);
+
+    // Forking copies the MPI state into the workers, which is undefined behaviour
+    if (maxNumConcurrentReplicates > 1 && (PetscTools::IsInitialised() || PetscTools::IsParallel()))
+    {
+        EXCEPTION("Replicates cannot be run in worker processes once PETSc and MPI have been initialised; use FakePetscSetup.hpp or run one replicate at a time.");
+    }
+}
+
+ConcurrentReplicateRunner::~ConcurrentReplicateRunner()
+{
+    // A worker only gets here if its replicate threw, so it must not carry on as the driver
+    if (mIsWorker)
+    {
+        std::cerr << "A replicate ended without finishing; ending its worker process." << std::endl;
+        EndWorker(1);
+    }
+
+    // Leave no workers behind, but do not throw from a destructor
+    while (mNumRunningReplicates > 0)
+    {
+        WaitForOneReplicate();
+    }
+}
+
+void ConcurrentReplicateRunner::WaitForOneReplicate()
+{
+    assert(mNumRunningReplicates > 0);
+
+    int status;
+    pid_t pid;
+    do
+    {
+        pid = waitpid(-1, &status, 0);
+    }
+    while (pid < 0 && errno == EINTR);
+
+    if (pid < 0)
+    {
+        // No children left to wait for, so none of those counted can have succeeded
+        mNumFailedReplicates += mNumRunningReplicates;
+        mNumRunningReplicates = 0;
+        return;
+    }
+
+    mNumRunningReplicates--;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        mNumFailedReplicates++;
+    }
+}
+
+void ConcurrentReplicateRunner::EndWorker(int status)
+{
+    // Skip the destructors and exit handlers of the copy of the driver's state
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(NULL);
+    _exit(status);
+}
+
+bool ConcurrentReplicateRunner::StartReplicate()
+{
+    assert(!mIsWorker);
+    if (mMaxNumConcurrentReplicates == 1)
+    {
+        mPeakNumConcurrentReplicates = 1;
+        return true;
+    }
+
+    while (mNumRunningReplicates >= mMaxNumConcurrentReplicates)
+    {
+        WaitForOneReplicate();
+    }
+
+    // Anything buffered now would otherwise be written by both processes
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(NULL);
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        EXCEPTION("Could not start a worker process for a replicate.");
+    }
+    if (pid == 0)
+    {
+        mIsWorker = true;
+        mNumRunningReplicates = 0;
+        return true;
+    }
+
+    mNumRunningReplicates++;
+    if (mNumRunningReplicates > mPeakNumConcurrentReplicates)
+    {
+        mPeakNumConcurrentReplicates = mNumRunningReplicates;
+    }
+    return false;
+}
+
+void ConcurrentReplicateRunner::FinishReplicate()
+{
+    if (mIsWorker)
+    {
+        EndWorker(0);
+    }
+}
+
+void ConcurrentReplicateRunner::AbandonReplicate()
+{
+    if (mIsWorker)
+    {
+        EndWorker(1);
+    }
+}
+
+void ConcurrentReplicateRunner::WaitForReplicates()
+{
+    assert(!mIsWorker);
+    while (mNumRunningReplicates > 0)
+    {
+        WaitForOneReplicate();
+    }
+
+    if (mNumFailedReplicates > 0)
+    {
+        unsigned num_failed = mNumFailedReplicates;
+        mNumFailedReplicates = 0;
+        EXCEPTION(num_failed << " replicate(s) failed in their worker processes.");
+    }
+}
+
+bool ConcurrentReplicateRunner::IsWorker() const
+{
+    return mIsWorker;
+}
+
+unsigned ConcurrentReplicateRunner::GetMaxNumConcurrentReplicates() const
+{
+    return mMaxNumConcurrentReplicates;
+}
+
+unsigned ConcurrentReplicateRunner::GetPeakNumConcurrentReplicates() const
+{
+    return mPeakNumConcurrentReplicates;
+}
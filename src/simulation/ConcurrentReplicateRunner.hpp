@@ -0,0 +1,170 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef CONCURRENTREPLICATERUNNER_HPP_
+#define CONCURRENTREPLICATERUNNER_HPP_
+
+#include <sys/types.h>
+
+/**
+ * Runs the replicates of a sweep at the same time, each in a worker process of its own.
+ *
+ * Chaste keeps the time, the cell IDs, the random number generator and the event
+ * timings in process-wide singletons, so two simulations cannot share a process, let
+ * alone run in threads of the same one. Each replicate is therefore forked off from the
+ * driver, with a copy of the singletons as they were when it started. A replicate that
+ * reseeds RandomNumberGenerator, resets the cell IDs and has its own
+ * UtericBudSimulationContext gives the same results whether it is run in a worker or
+ * in the driver itself.
+ *
+ * A driver loop looks like
+ *
+ *     for (each replicate)
+ *     {
+ *         if (runner.StartReplicate())
+ *         {
+ *             ... run the replicate ...
+ *             runner.FinishReplicate();
+ *         }
+ *     }
+ *     runner.WaitForReplicates();
+ *
+ * StartReplicate() returns true in the worker and false in the driver, which goes on
+ * to start the next replicate once fewer than the maximum number are running.
+ * FinishReplicate() ends the worker, and a worker that fails should call
+ * AbandonReplicate() instead, so that WaitForReplicates() reports it. A worker whose
+ * replicate throws ends with a failure when the runner is destroyed, rather than
+ * going on to run the rest of the driver. With at most one
+ * replicate at a time no workers are forked, and each replicate runs in the driver.
+ *
+ * Workers write their results to their own output directories; anything they leave
+ * in memory is lost when they end.
+ *
+ * A forked worker would carry on with copies of the driver's PETSc and MPI handles,
+ * which MPI does not allow, so workers can only be used by drivers that do not
+ * initialise PETSc (those that include FakePetscSetup.hpp). Asking for more than one
+ * replicate at a time once PETSc has been initialised, or when running in parallel,
+ * throws an exception.
+ */
+class ConcurrentReplicateRunner
+{
+private:
+
+    /** The largest number of replicates run at once. */
+    unsigned mMaxNumConcurrentReplicates;
+
+    /** The number of workers started and not yet waited for. */
+    unsigned mNumRunningReplicates;
+
+    /** The largest number of workers that have been running at once. */
+    unsigned mPeakNumConcurrentReplicates;
+
+    /** The number of workers that have failed. */
+    unsigned mNumFailedReplicates;
+
+    /** Whether this is a worker process. */
+    bool mIsWorker;
+
+    /**
+     * Wait for any one worker to end, and count it if it failed.
+     */
+    void WaitForOneReplicate();
+
+    /**
+     * End the worker process.
+     *
+     * @param status the exit status
+     */
+    void EndWorker(int status);
+
+public:
+
+    /**
+     * Constructor. Throws if more than one replicate at a time is asked for once PETSc
+     * has been initialised.
+     *
+     * @param maxNumConcurrentReplicates the largest number of replicates to run at once (defaults to 1)
+     */
+    ConcurrentReplicateRunner(unsigned maxNumConcurrentReplicates=1);
+
+    /**
+     * Destructor. Waits for any workers still running, or in a worker, ends it with
+     * a failure.
+     */
+    ~ConcurrentReplicateRunner();
+
+    /**
+     * Start a replicate, first waiting for a running one to end if the maximum number
+     * are running.
+     *
+     * @return whether the caller should run the replicate, which is true in a new
+     *     worker or if replicates run one at a time in the driver
+     */
+    bool StartReplicate();
+
+    /**
+     * End the replicate. Ends the worker process, so does not return in a worker.
+     */
+    void FinishReplicate();
+
+    /**
+     * End a replicate that has failed. Ends the worker process with a failure, so
+     * does not return in a worker.
+     */
+    void AbandonReplicate();
+
+    /**
+     * Wait for all the workers to end. Throws if any of them failed.
+     */
+    void WaitForReplicates();
+
+    /**
+     * @return whether this is a worker process.
+     */
+    bool IsWorker() const;
+
+    /**
+     * @return #mMaxNumConcurrentReplicates
+     */
+    unsigned GetMaxNumConcurrentReplicates() const;
+
+    /**
+     * @return #mPeakNumConcurrentReplicates
+     */
+    unsigned GetPeakNumConcurrentReplicates() const;
+};
+
+#endif /*CONCURRENTREPLICATERUNNER_HPP_*/
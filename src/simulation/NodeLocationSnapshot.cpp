@@ -0,0 +1,168 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "NodeLocationSnapshot.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+NodeLocationSnapshot<ELEMENT_DIM,SPACE_DIM>::NodeLocationSnapshot()
+{
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void NodeLocationSnapshot<ELEMENT_DIM,SPACE_DIM>::Reserve(unsigned nodeIndex)
+{
+    if (nodeIndex >= mCoordinates[0].size())
+    {
+        // Grow geometrically so that a growing population only rarely triggers a reallocation
+        unsigned new_size = std::max(nodeIndex + 1, 2*(unsigned)mCoordinates[0].size());
+        for (unsigned d=0; d<SPACE_DIM; d++)
+        {
+            mCoordinates[d].resize(new_size, 0.0);
+        }
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void NodeLocationSnapshot<ELEMENT_DIM,SPACE_DIM>::Store(AbstractMesh<ELEMENT_DIM,SPACE_DIM>& rMesh)
+{
+    for (typename AbstractMesh<ELEMENT_DIM, SPACE_DIM>::NodeIterator node_iter = rMesh.GetNodeIteratorBegin();
+         node_iter != rMesh.GetNodeIteratorEnd();
+         ++node_iter)
+    {
+        unsigned node_index = node_iter->GetIndex();
+        Reserve(node_index);
+
+        const c_vector<double, SPACE_DIM>& r_location = node_iter->rGetLocation();
+        for (unsigned d=0; d<SPACE_DIM; d++)
+        {
+            mCoordinates[d][node_index] = r_location[d];
+        }
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void NodeLocationSnapshot<ELEMENT_DIM,SPACE_DIM>::Store(const std::map<Node<SPACE_DIM>*, c_vector<double, SPACE_DIM> >& rLocations)
+{
+    for (typename std::map<Node<SPACE_DIM>*, c_vector<double, SPACE_DIM> >::const_iterator iter = rLocations.begin();
+         iter != rLocations.end();
+         ++iter)
+    {
+        unsigned node_index = iter->first->GetIndex();
+        Reserve(node_index);
+
+        for (unsigned d=0; d<SPACE_DIM; d++)
+        {
+            mCoordinates[d][node_index] = iter->second[d];
+        }
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void NodeLocationSnapshot<ELEMENT_DIM,SPACE_DIM>::Restore(AbstractMesh<ELEMENT_DIM,SPACE_DIM>& rMesh) const
+{
+    for (typename AbstractMesh<ELEMENT_DIM, SPACE_DIM>::NodeIterator node_iter = rMesh.GetNodeIteratorBegin();
+         node_iter != rMesh.GetNodeIteratorEnd();
+         ++node_iter)
+    {
+        unsigned node_index = node_iter->GetIndex();
+        assert(node_index < mCoordinates[0].size());
+
+        c_vector<double, SPACE_DIM>& r_location = node_iter->rGetModifiableLocation();
+        for (unsigned d=0; d<SPACE_DIM; d++)
+        {
+            r_location[d] = mCoordinates[d][node_index];
+        }
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+c_vector<double, SPACE_DIM> NodeLocationSnapshot<ELEMENT_DIM,SPACE_DIM>::GetLocation(unsigned nodeIndex) const
+{
+    assert(nodeIndex < mCoordinates[0].size());
+
+    c_vector<double, SPACE_DIM> location;
+    for (unsigned d=0; d<SPACE_DIM; d++)
+    {
+        location[d] = mCoordinates[d][nodeIndex];
+    }
+    return location;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+double NodeLocationSnapshot<ELEMENT_DIM,SPACE_DIM>::GetMaximumDisplacement(AbstractMesh<ELEMENT_DIM,SPACE_DIM>& rMesh) const
+{
+    double max_squared_displacement = 0.0;
+    for (typename AbstractMesh<ELEMENT_DIM, SPACE_DIM>::NodeIterator node_iter = rMesh.GetNodeIteratorBegin();
+         node_iter != rMesh.GetNodeIteratorEnd();
+         ++node_iter)
+    {
+        unsigned node_index = node_iter->GetIndex();
+        assert(node_index < mCoordinates[0].size());
+
+        const c_vector<double, SPACE_DIM>& r_location = node_iter->rGetLocation();
+        double squared_displacement = 0.0;
+        for (unsigned d=0; d<SPACE_DIM; d++)
+        {
+            double delta = r_location[d] - mCoordinates[d][node_index];
+            squared_displacement += delta*delta;
+        }
+        max_squared_displacement = std::max(max_squared_displacement, squared_displacement);
+    }
+    return sqrt(max_squared_displacement);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const std::vector<double>& NodeLocationSnapshot<ELEMENT_DIM,SPACE_DIM>::rGetCoordinates(unsigned dimension) const
+{
+    assert(dimension < SPACE_DIM);
+    return mCoordinates[dimension];
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned NodeLocationSnapshot<ELEMENT_DIM,SPACE_DIM>::GetCapacity() const
+{
+    return mCoordinates[0].size();
+}
+
+// Explicit instantiation
+template class NodeLocationSnapshot<1,1>;
+template class NodeLocationSnapshot<1,2>;
+template class NodeLocationSnapshot<2,2>;
+template class NodeLocationSnapshot<1,3>;
+template class NodeLocationSnapshot<2,3>;
+template class NodeLocationSnapshot<3,3>;
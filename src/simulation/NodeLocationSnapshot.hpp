@@ -0,0 +1,141 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef NODELOCATIONSNAPSHOT_HPP_
+#define NODELOCATIONSNAPSHOT_HPP_
+
+#include <map>
+#include <vector>
+
+#include "AbstractMesh.hpp"
+#include "Node.hpp"
+#include "UblasVectorInclude.hpp"
+
+/**
+ * A flat, index-addressed store of node locations.
+ *
+ * The coordinates are held in structure-of-arrays form, with one contiguous
+ * array per spatial dimension addressed by node index. The arrays are only ever
+ * grown, so once the store has reached the size of the population a snapshot
+ * can be taken and restored on every time step without any allocation.
+ *
+ * This replaces the std::map<Node*, c_vector> used by AbstractCellBasedSimulation
+ * subclasses to remember the node locations at the start of a time step.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM=ELEMENT_DIM>
+class NodeLocationSnapshot
+{
+private:
+
+    /** The node coordinates, one array per spatial dimension, addressed by node index. */
+    std::vector<double> mCoordinates[SPACE_DIM];
+
+    /**
+     * Make sure the coordinate arrays can hold the given node index.
+     *
+     * @param nodeIndex the node index
+     */
+    void Reserve(unsigned nodeIndex);
+
+public:
+
+    /**
+     * Constructor.
+     */
+    NodeLocationSnapshot();
+
+    /**
+     * Store the present location of every node in a mesh.
+     *
+     * @param rMesh the mesh
+     */
+    void Store(AbstractMesh<ELEMENT_DIM,SPACE_DIM>& rMesh);
+
+    /**
+     * Store the node locations given in a map from nodes to locations. Used to
+     * support callers that still work in terms of such maps.
+     *
+     * @param rLocations the node locations
+     */
+    void Store(const std::map<Node<SPACE_DIM>*, c_vector<double, SPACE_DIM> >& rLocations);
+
+    /**
+     * Send every node in a mesh back to its stored location.
+     *
+     * @param rMesh the mesh
+     */
+    void Restore(AbstractMesh<ELEMENT_DIM,SPACE_DIM>& rMesh) const;
+
+    /**
+     * @return the stored location of a node.
+     *
+     * @param nodeIndex the node index
+     */
+    c_vector<double, SPACE_DIM> GetLocation(unsigned nodeIndex) const;
+
+    /**
+     * @return the largest distance any node in a mesh has moved from its stored location.
+     *
+     * @param rMesh the mesh
+     */
+    double GetMaximumDisplacement(AbstractMesh<ELEMENT_DIM,SPACE_DIM>& rMesh) const;
+
+    /**
+     * @return one stored coordinate of a node.
+     *
+     * @param nodeIndex the node index
+     * @param dimension the coordinate direction
+     */
+    double GetCoordinate(unsigned nodeIndex, unsigned dimension) const
+    {
+        assert(dimension < SPACE_DIM);
+        assert(nodeIndex < mCoordinates[dimension].size());
+        return mCoordinates[dimension][nodeIndex];
+    }
+
+    /**
+     * @return the stored coordinates in one direction, addressed by node index.
+     *
+     * @param dimension the coordinate direction
+     */
+    const std::vector<double>& rGetCoordinates(unsigned dimension) const;
+
+    /**
+     * @return the number of node indices the snapshot has room for.
+     */
+    unsigned GetCapacity() const;
+};
+
+#endif /*NODELOCATIONSNAPSHOT_HPP_*/
@@ -36,6 +36,7 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "OffLatticeSimulationUT.hpp"
 
 #include <cmath>
+#include <algorithm>
 #include <boost/make_shared.hpp>
 
 #include "CellBasedEventHandler.hpp"
@@ -43,14 +44,56 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Version.hpp"
 #include "ExecutableSupport.hpp"
 #include "ForwardEulerNumericalMethod.hpp"
+#include "FixedGrowthStepSizeController.hpp"
 #include "StepSizeException.hpp"
 #include "SmartPointers.hpp"
+#include "AbstractSnapshotBoundaryCondition.hpp"
+#include "AbstractSimulationComponent.hpp"
+#include "AbstractSimulationContextUser.hpp"
+#include "SimulationTime.hpp"
+
+/**
+ * Give a force, boundary condition or modifier of a simulation the state it shares
+ * with the simulation, through whichever of the component interfaces it implements.
+ *
+ * @param pObject the force, boundary condition or modifier
+ * @param pSimulationContext the context of the simulation
+ * @param pCellAttributeCache the cell attribute cache of the simulation
+ * @param pPopulationUpdateCoordinator the population update coordinator of the simulation
+ * @param numForceThreads the number of threads the forces of the simulation may use
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM, class OBJECT>
+static void ConnectComponent(OBJECT* pObject,
+                             boost::shared_ptr<UtericBudSimulationContext> pSimulationContext,
+                             boost::shared_ptr<CellAttributeCache<ELEMENT_DIM,SPACE_DIM> > pCellAttributeCache,
+                             boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM,SPACE_DIM> > pPopulationUpdateCoordinator,
+                             unsigned numForceThreads)
+{
+    AbstractSimulationContextUser* p_context_user = dynamic_cast<AbstractSimulationContextUser*>(pObject);
+    if (p_context_user)
+    {
+        p_context_user->ShareSimulationContext(pSimulationContext);
+    }
+
+    AbstractSimulationComponent<ELEMENT_DIM,SPACE_DIM>* p_component = dynamic_cast<AbstractSimulationComponent<ELEMENT_DIM,SPACE_DIM>*>(pObject);
+    if (p_component)
+    {
+        p_component->ConnectToSimulation(pCellAttributeCache, pPopulationUpdateCoordinator, numForceThreads);
+    }
+}
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::OffLatticeSimulationUT(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation,
                                                 bool deleteCellPopulationInDestructor,
                                                 bool initialiseCells)
-    : AbstractCellBasedSimulation<ELEMENT_DIM,SPACE_DIM>(rCellPopulation, deleteCellPopulationInDestructor, initialiseCells)
+    : AbstractCellBasedSimulation<ELEMENT_DIM,SPACE_DIM>(rCellPopulation, deleteCellPopulationInDestructor, initialiseCells),
+      mNumForceThreads(1),
+      mpCellAttributeCache(boost::make_shared<CellAttributeCache<ELEMENT_DIM, SPACE_DIM> >()),
+      mpPopulationUpdateCoordinator(boost::make_shared<PopulationUpdateCoordinator<ELEMENT_DIM, SPACE_DIM> >()),
+      mpSimulationContext(boost::make_shared<UtericBudSimulationContext>()),
+      mpPreviousNodeLocations(&mNodeLocationBuffers[0]),
+      mpCurrentNodeLocations(&mNodeLocationBuffers[1]),
+      mOldNodeLocationMapIsCurrent(false)
 {
     if (!dynamic_cast<AbstractOffLatticeCellPopulation<ELEMENT_DIM,SPACE_DIM>*>(&rCellPopulation))
     {
@@ -94,53 +137,133 @@ const boost::shared_ptr<AbstractNumericalMethod<ELEMENT_DIM, SPACE_DIM> > OffLat
     return mpNumericalMethod;
 }
 
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::SetNumForceThreads(unsigned numForceThreads)
+{
+    assert(numForceThreads > 0);
+    mNumForceThreads = numForceThreads;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::GetNumForceThreads() const
+{
+    return mNumForceThreads;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::SetCellAttributeCache(boost::shared_ptr<CellAttributeCache<ELEMENT_DIM, SPACE_DIM> > pCellAttributeCache)
+{
+    assert(pCellAttributeCache);
+    mpCellAttributeCache = pCellAttributeCache;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+boost::shared_ptr<CellAttributeCache<ELEMENT_DIM, SPACE_DIM> > OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::GetCellAttributeCache() const
+{
+    return mpCellAttributeCache;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::SetPopulationUpdateCoordinator(boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM, SPACE_DIM> > pPopulationUpdateCoordinator)
+{
+    assert(pPopulationUpdateCoordinator);
+    mpPopulationUpdateCoordinator = pPopulationUpdateCoordinator;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM, SPACE_DIM> > OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::GetPopulationUpdateCoordinator() const
+{
+    return mpPopulationUpdateCoordinator;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::SetSimulationContext(boost::shared_ptr<UtericBudSimulationContext> pSimulationContext)
+{
+    assert(pSimulationContext);
+    mpSimulationContext = pSimulationContext;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+boost::shared_ptr<UtericBudSimulationContext> OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::GetSimulationContext() const
+{
+    return mpSimulationContext;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::SetStepSizeController(boost::shared_ptr<AbstractStepSizeController> pStepSizeController)
+{
+    mpStepSizeController = pStepSizeController;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const boost::shared_ptr<AbstractStepSizeController> OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::GetStepSizeController() const
+{
+    return mpStepSizeController;
+}
+
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::UpdateCellLocationsAndTopology()
 {
     CellBasedEventHandler::BeginEvent(CellBasedEventHandler::POSITION);
 
+    // Cells may have divided, died or changed type since the cell attributes were last read
+    mpCellAttributeCache->Invalidate();
+
+    bool adaptive = mpNumericalMethod->HasAdaptiveTimestep();
+
     double time_advanced_so_far = 0;
     double target_time_step  = this->mDt;
-    double present_time_step = this->mDt;
+    double present_time_step = adaptive ? mpStepSizeController->GetInitialTimeStep(target_time_step) : this->mDt;
+
+    // Store the initial node positions (these may be needed when applying boundary conditions)
+    mpPreviousNodeLocations->Store(this->mrCellPopulation.rGetMesh());
+    mOldNodeLocationMapIsCurrent = false;
 
     while (time_advanced_so_far < target_time_step)
     {
-        // Store the initial node positions (these may be needed when applying boundary conditions)    
-        std::map<Node<SPACE_DIM>*, c_vector<double, SPACE_DIM> > old_node_locations;
-
-        for (typename AbstractMesh<ELEMENT_DIM, SPACE_DIM>::NodeIterator node_iter = this->mrCellPopulation.rGetMesh().GetNodeIteratorBegin();
-             node_iter != this->mrCellPopulation.rGetMesh().GetNodeIteratorEnd();
-             ++node_iter)
-        {
-            old_node_locations[&(*node_iter)] = (node_iter)->rGetLocation();
-        }
-
         // Try to update node positions according to the numerical method 
         try
         {
             mpNumericalMethod->UpdateAllNodePositions(present_time_step);
-            ApplyBoundaries(old_node_locations);
+            ApplyBoundaries(*mpPreviousNodeLocations);
 
             // Successful time step! Update time_advanced_so_far
             time_advanced_so_far += present_time_step;
 
-            // If using adaptive timestep, then increase the present_time_step (by 1% for now)
-            if (mpNumericalMethod->HasAdaptiveTimestep())
+            // If using adaptive timestep, then let the controller choose the next substep
+            if (adaptive)
             {
-                ///\todo #2087 Make this a settable member variable
-                double timestep_increase = 0.01;
-                present_time_step = std::min((1+timestep_increase)*present_time_step, target_time_step - time_advanced_so_far);
+                mpStepSizeController->RecordAcceptedStep(present_time_step);
+
+                double error_estimate = 0.0;
+                if (mpStepSizeController->UsesErrorEstimate())
+                {
+                    // Measure the largest node movement against the threshold that triggers a StepSizeException
+                    double threshold = static_cast<AbstractOffLatticeCellPopulation<ELEMENT_DIM,SPACE_DIM>*>(&(this->mrCellPopulation))->GetAbsoluteMovementThreshold();
+                    error_estimate = mpPreviousNodeLocations->GetMaximumDisplacement(this->mrCellPopulation.rGetMesh())/threshold;
+                }
+                present_time_step = std::min(mpStepSizeController->ComputeNextTimeStep(present_time_step, error_estimate),
+                                             target_time_step - time_advanced_so_far);
             }
 
+            // The accepted positions are the starting point of the next substep
+            if (time_advanced_so_far < target_time_step)
+            {
+                mpCurrentNodeLocations->Store(this->mrCellPopulation.rGetMesh());
+                SwapNodeLocationBuffers();
+            }
         }
         catch (StepSizeException& e)
         {
             // Detects if a node has travelled too far in a single time step
-            if (mpNumericalMethod->HasAdaptiveTimestep())
+            if (adaptive)
             {
-                // If adaptivity is switched on, revert node locations and choose a suitably smaller time step
-                RevertToOldLocations(old_node_locations);
-                present_time_step = std::min(e.GetSuggestedNewStep(), target_time_step - time_advanced_so_far);
+                // If adaptivity is switched on, revert node locations and choose a suitably smaller time step.
+                // The snapshot is left untouched, so the retry starts from it without taking another.
+                RevertToOldLocations(*mpPreviousNodeLocations);
+                mpStepSizeController->RecordRejectedStep();
+                present_time_step = std::min(mpStepSizeController->ComputeRejectedTimeStep(present_time_step, e.GetSuggestedNewStep()),
+                                             target_time_step - time_advanced_so_far);
             }
             else
             {
@@ -150,29 +273,63 @@ void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::UpdateCellLocationsAndTopolo
         }
     }
 
+    // Modifiers that need the neighbour data must now update the population again
+    mpPopulationUpdateCoordinator->MarkNodesMoved();
+
+    // SimulationTime is incremented next, so keep the context's clock in step with it
+    mpSimulationContext->AdvanceClock();
+
     CellBasedEventHandler::EndEvent(CellBasedEventHandler::POSITION);
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::RevertToOldLocations(std::map<Node<SPACE_DIM>*, c_vector<double, SPACE_DIM> > oldNodeLoctions)
+void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::UpdateCellPopulation()
 {
-    for (typename AbstractMesh<ELEMENT_DIM, SPACE_DIM>::NodeIterator node_iter = this->mrCellPopulation.rGetMesh().GetNodeIteratorBegin();
-        node_iter != this->mrCellPopulation.rGetMesh().GetNodeIteratorEnd();
-        ++node_iter)
+    AbstractCellBasedSimulation<ELEMENT_DIM,SPACE_DIM>::UpdateCellPopulation();
+
+    // The population has only been updated after any births and deaths if the rule says so
+    if (this->GetUpdateCellPopulationRule())
+    {
+        mpPopulationUpdateCoordinator->RecordUpdate(this->mrCellPopulation);
+    }
+    else
     {
-        (node_iter)->rGetModifiableLocation() = oldNodeLoctions[&(*node_iter)];
+        mpPopulationUpdateCoordinator->MarkTopologyChanged();
     }
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
-void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::ApplyBoundaries(std::map<Node<SPACE_DIM>*,c_vector<double, SPACE_DIM> > oldNodeLoctions)
+void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::RevertToOldLocations(const NodeLocationSnapshot<ELEMENT_DIM, SPACE_DIM>& rOldNodeLocations)
+{
+    rOldNodeLocations.Restore(this->mrCellPopulation.rGetMesh());
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::ApplyBoundaries(const NodeLocationSnapshot<ELEMENT_DIM, SPACE_DIM>& rOldNodeLocations)
 {
     // Apply any boundary conditions
     for (typename std::vector<boost::shared_ptr<AbstractCellPopulationBoundaryCondition<ELEMENT_DIM,SPACE_DIM> > >::iterator bcs_iter = mBoundaryConditions.begin();
          bcs_iter != mBoundaryConditions.end();
          ++bcs_iter)
     {
-        (*bcs_iter)->ImposeBoundaryCondition(oldNodeLoctions);
+        // Each boundary condition may move nodes, so any checks earlier ones made are now out of date
+        mpPopulationUpdateCoordinator->MarkNodesMoved();
+
+        AbstractSnapshotBoundaryCondition<ELEMENT_DIM,SPACE_DIM>* p_snapshot_bc = dynamic_cast<AbstractSnapshotBoundaryCondition<ELEMENT_DIM,SPACE_DIM>*>(bcs_iter->get());
+        if (p_snapshot_bc)
+        {
+            p_snapshot_bc->ImposeBoundaryCondition(rOldNodeLocations);
+        }
+        else
+        {
+            // Other boundary conditions expect the old locations as a map, so only build it for them
+            if (!mOldNodeLocationMapIsCurrent)
+            {
+                UpdateOldNodeLocationMap(rOldNodeLocations);
+                mOldNodeLocationMapIsCurrent = true;
+            }
+            (*bcs_iter)->ImposeBoundaryCondition(mOldNodeLocationMap);
+        }
     }
 
     // Verify that each boundary condition is now satisfied
@@ -187,6 +344,38 @@ void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::ApplyBoundaries(std::map<Nod
     }
 }
 
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::UpdateOldNodeLocationMap(const NodeLocationSnapshot<ELEMENT_DIM, SPACE_DIM>& rOldNodeLocations)
+{
+    AbstractMesh<ELEMENT_DIM, SPACE_DIM>& r_mesh = this->mrCellPopulation.rGetMesh();
+
+    for (typename AbstractMesh<ELEMENT_DIM, SPACE_DIM>::NodeIterator node_iter = r_mesh.GetNodeIteratorBegin();
+         node_iter != r_mesh.GetNodeIteratorEnd();
+         ++node_iter)
+    {
+        mOldNodeLocationMap[&(*node_iter)] = rOldNodeLocations.GetLocation(node_iter->GetIndex());
+    }
+
+    // If nodes have been added or removed since the last call, drop any stale entries and start again
+    if (mOldNodeLocationMap.size() != r_mesh.GetNumNodes())
+    {
+        mOldNodeLocationMap.clear();
+        for (typename AbstractMesh<ELEMENT_DIM, SPACE_DIM>::NodeIterator node_iter = r_mesh.GetNodeIteratorBegin();
+             node_iter != r_mesh.GetNodeIteratorEnd();
+             ++node_iter)
+        {
+            mOldNodeLocationMap[&(*node_iter)] = rOldNodeLocations.GetLocation(node_iter->GetIndex());
+        }
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::SwapNodeLocationBuffers()
+{
+    std::swap(mpPreviousNodeLocations, mpCurrentNodeLocations);
+    mOldNodeLocationMapIsCurrent = false;
+}
+
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::WriteVisualizerSetupFile()
 {
@@ -219,6 +408,57 @@ void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::SetupSolve()
     }
     mpNumericalMethod->SetCellPopulation(dynamic_cast<AbstractOffLatticeCellPopulation<ELEMENT_DIM,SPACE_DIM>*>(&(this->mrCellPopulation)));
     mpNumericalMethod->SetForceCollection(&mForceCollection);
+
+    // The cell attributes are rebuilt once per step of the simulation's clock
+    mpCellAttributeCache->ShareSimulationContext(mpSimulationContext);
+
+    /*
+     * Give the context, cache, coordinator and number of threads to the forces, boundary
+     * conditions and modifiers that use them. None of these are archived with them, so
+     * this also reconnects restored ones.
+     */
+    for (typename std::vector<boost::shared_ptr<AbstractForce<ELEMENT_DIM,SPACE_DIM> > >::iterator iter = mForceCollection.begin();
+         iter != mForceCollection.end();
+         ++iter)
+    {
+        ConnectComponent(iter->get(), mpSimulationContext, mpCellAttributeCache, mpPopulationUpdateCoordinator, mNumForceThreads);
+    }
+    for (typename std::vector<boost::shared_ptr<AbstractCellPopulationBoundaryCondition<ELEMENT_DIM,SPACE_DIM> > >::iterator iter = mBoundaryConditions.begin();
+         iter != mBoundaryConditions.end();
+         ++iter)
+    {
+        ConnectComponent(iter->get(), mpSimulationContext, mpCellAttributeCache, mpPopulationUpdateCoordinator, mNumForceThreads);
+    }
+    for (typename std::vector<boost::shared_ptr<AbstractCellBasedSimulationModifier<ELEMENT_DIM,SPACE_DIM> > >::iterator iter = this->mSimulationModifiers.begin();
+         iter != this->mSimulationModifiers.end();
+         ++iter)
+    {
+        ConnectComponent(iter->get(), mpSimulationContext, mpCellAttributeCache, mpPopulationUpdateCoordinator, mNumForceThreads);
+    }
+
+    // Give the context to the cell cycle models that draw from it
+    for (typename AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>::Iterator cell_iter = this->mrCellPopulation.Begin();
+         cell_iter != this->mrCellPopulation.End();
+         ++cell_iter)
+    {
+        AbstractSimulationContextUser* p_model = dynamic_cast<AbstractSimulationContextUser*>(cell_iter->GetCellCycleModel());
+        if (p_model)
+        {
+            p_model->ShareSimulationContext(mpSimulationContext);
+        }
+    }
+
+    // The project classes read the time from the context rather than from SimulationTime
+    SimulationTime* p_simulation_time = SimulationTime::Instance();
+    mpSimulationContext->SetClock(p_simulation_time->GetTime(),
+                                  p_simulation_time->GetTimeStep(),
+                                  p_simulation_time->GetTimeStepsElapsed());
+
+    // Grow adaptive substeps by 1% at a time by default, unless a step size controller has been specified already
+    if (mpStepSizeController == NULL)
+    {
+        mpStepSizeController = boost::make_shared<FixedGrowthStepSizeController>();
+    }
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
@@ -250,12 +490,19 @@ void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::OutputAdditionalSimulationSe
     *rParamsFile << "\n\t<NumericalMethod>\n";
     mpNumericalMethod->OutputNumericalMethodInfo(rParamsFile);
     *rParamsFile << "\t</NumericalMethod>\n";
+
+    // Output step size controller details
+    *rParamsFile << "\n\t<StepSizeController>\n";
+    mpStepSizeController->OutputStepSizeControllerInfo(rParamsFile);
+    *rParamsFile << "\t</StepSizeController>\n";
 }
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 void OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>::OutputSimulationParameters(out_stream& rParamsFile)
 {
-    // No new parameters to output, so just call method on direct parent class
+    *rParamsFile << "\t\t<NumForceThreads>" << mNumForceThreads << "</NumForceThreads>\n";
+
+    // Call method on direct parent class
     AbstractCellBasedSimulation<ELEMENT_DIM,SPACE_DIM>::OutputSimulationParameters(rParamsFile);
 }
 
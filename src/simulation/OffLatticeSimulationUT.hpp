@@ -40,11 +40,18 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "AbstractForce.hpp"
 #include "AbstractCellPopulationBoundaryCondition.hpp"
 #include "AbstractNumericalMethod.hpp"
+#include "NodeLocationSnapshot.hpp"
+#include "AbstractStepSizeController.hpp"
+#include "CellAttributeCache.hpp"
+#include "PopulationUpdateCoordinator.hpp"
+#include "UtericBudSimulationContext.hpp"
 
 #include "ChasteSerialization.hpp"
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/set.hpp>
+#include <boost/serialization/shared_ptr.hpp>
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
 
 /**
  * Run an off-lattice 2D or 3D cell-based simulation using an off-lattice
@@ -90,6 +97,14 @@ private:
         archive & mForceCollection;
         archive & mBoundaryConditions;
         archive & mpNumericalMethod;
+
+        // Archives written before the step size controllers, force threads and contexts were added have version 0
+        if (version > 0)
+        {
+            archive & mpStepSizeController;
+            archive & mNumForceThreads;
+            archive & mpSimulationContext;
+        }
     }
 
 protected:
@@ -103,6 +118,72 @@ protected:
     /** The numerical method to use in this simulation. Defaults to the explicit forward Euler method. */
     boost::shared_ptr<AbstractNumericalMethod<ELEMENT_DIM, SPACE_DIM> > mpNumericalMethod;
 
+    /**
+     * The controller used to choose the substep size when the numerical method has an
+     * adaptive time step. Defaults to a FixedGrowthStepSizeController.
+     */
+    boost::shared_ptr<AbstractStepSizeController> mpStepSizeController;
+
+    /**
+     * The number of threads used by forces that are subclasses of AbstractThreadedForce
+     * or of BasicLinearSpringForce.
+     * Defaults to 1.
+     */
+    unsigned mNumForceThreads;
+
+    /**
+     * The cell attributes shared by the forces, boundary conditions and modifiers of the
+     * simulation that are an AbstractSimulationComponent, which are given it in SetupSolve().
+     * Invalidated once the population has been updated on each time step. Not archived.
+     */
+    boost::shared_ptr<CellAttributeCache<ELEMENT_DIM, SPACE_DIM> > mpCellAttributeCache;
+
+    /**
+     * Told when the population is updated at the start of each time step and when the
+     * nodes move, so that modifiers given it only update the population when they need to.
+     * Given in SetupSolve() to the components of the simulation, which keep it if they
+     * have none, so a restored simulation reconnects them. Not archived.
+     */
+    boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM, SPACE_DIM> > mpPopulationUpdateCoordinator;
+
+    /**
+     * The source of time and random numbers of the simulation. Its clock is set from
+     * SimulationTime in SetupSolve() and advanced once per time step, and it is given
+     * to the forces, boundary conditions, modifiers and cell cycle models that are an
+     * AbstractSimulationContextUser and do not have one. Archived, so a restored simulation keeps its random
+     * number scheme and streams; archives of version 0 restore with a new default context.
+     */
+    boost::shared_ptr<UtericBudSimulationContext> mpSimulationContext;
+
+    /**
+     * Storage for the node locations before and after a substep. Reused from one
+     * substep to the next, so taking a snapshot does not allocate.
+     */
+    NodeLocationSnapshot<ELEMENT_DIM, SPACE_DIM> mNodeLocationBuffers[2];
+
+    /**
+     * The node locations at the start of the present substep. Points into
+     * #mNodeLocationBuffers. Rejected substeps are rolled back to these.
+     */
+    NodeLocationSnapshot<ELEMENT_DIM, SPACE_DIM>* mpPreviousNodeLocations;
+
+    /**
+     * The node locations following the last accepted substep. Points into
+     * #mNodeLocationBuffers, and is swapped with #mpPreviousNodeLocations
+     * before the next substep is attempted.
+     */
+    NodeLocationSnapshot<ELEMENT_DIM, SPACE_DIM>* mpCurrentNodeLocations;
+
+    /**
+     * The node locations at the start of the present substep, in the form expected by
+     * boundary conditions that are not subclasses of AbstractSnapshotBoundaryCondition.
+     * Only filled in if such a boundary condition is present.
+     */
+    std::map<Node<SPACE_DIM>*, c_vector<double, SPACE_DIM> > mOldNodeLocationMap;
+
+    /** Whether #mOldNodeLocationMap matches #mpPreviousNodeLocations. */
+    bool mOldNodeLocationMapIsCurrent;
+
     /**
      * Overridden UpdateCellLocationsAndTopology() method.
      *
@@ -111,22 +192,47 @@ protected:
     virtual void UpdateCellLocationsAndTopology();
 
     /**
-     * Sends nodes back to the positions given in the input map. Used after a failed step
+     * Overridden UpdateCellPopulation() method.
+     *
+     * Remove dead cells, add new ones and update the population as before, then tell
+     * #mpPopulationUpdateCoordinator whether the population is up to date.
+     */
+    virtual void UpdateCellPopulation();
+
+    /**
+     * Sends nodes back to the positions given in the input snapshot. Used after a failed step
      * when adaptivity is turned on.
      *
-     * @param oldNodeLoctions A map linking nodes to their old positions.
+     * @param rOldNodeLocations the old node locations
      */
-    void RevertToOldLocations(std::map<Node<SPACE_DIM>*, c_vector<double, SPACE_DIM> > oldNodeLoctions);
+    void RevertToOldLocations(const NodeLocationSnapshot<ELEMENT_DIM, SPACE_DIM>& rOldNodeLocations);
 
     /**
      * Applies any boundary conditions.
      *
-     * @param oldNodeLoctions Mapping between node indices and old node locations
+     * @param rOldNodeLocations the node locations before the present substep
+     */
+    void ApplyBoundaries(const NodeLocationSnapshot<ELEMENT_DIM, SPACE_DIM>& rOldNodeLocations);
+
+    /**
+     * Fill in #mOldNodeLocationMap from a snapshot of the node locations.
+     *
+     * Entries are overwritten in place, so while the nodes stay the same this does
+     * not allocate. The map is only rebuilt from scratch after births or deaths.
+     *
+     * @param rOldNodeLocations the node locations before the present substep
+     */
+    void UpdateOldNodeLocationMap(const NodeLocationSnapshot<ELEMENT_DIM, SPACE_DIM>& rOldNodeLocations);
+
+    /**
+     * Make the locations following the last accepted substep the starting point
+     * of the next one, by swapping #mpPreviousNodeLocations and #mpCurrentNodeLocations.
      */
-    void ApplyBoundaries(std::map<Node<SPACE_DIM>*, c_vector<double, SPACE_DIM> > oldNodeLoctions);
+    void SwapNodeLocationBuffers();
 
     /**
-     * Overridden SetupSolve() method to clear the forces applied to the nodes.
+     * Overridden SetupSolve() method to clear the forces applied to the nodes, set the
+     * clock of #mpSimulationContext and give the context to the objects that need it.
      */
     virtual void SetupSolve();
 
@@ -186,10 +292,78 @@ public:
      */
     const boost::shared_ptr<AbstractNumericalMethod<ELEMENT_DIM, SPACE_DIM> > GetNumericalMethod() const;
 
+    /**
+     * Set the number of threads used to compute forces. Passed on to every force that
+     * is an AbstractSimulationComponent when the simulation is solved; other forces
+     * are still computed serially. The forces are bitwise reproducible for a
+     * given number of threads. Only has an effect if built with OpenMP.
+     *
+     * @param numForceThreads the number of threads
+     */
+    void SetNumForceThreads(unsigned numForceThreads);
+
+    /**
+     * @return #mNumForceThreads
+     */
+    unsigned GetNumForceThreads() const;
+
+    /**
+     * Set the cell attribute cache shared by the components of the simulation. Pass the same cache to any writers that should share it too.
+     *
+     * @param pCellAttributeCache the cell attribute cache
+     */
+    void SetCellAttributeCache(boost::shared_ptr<CellAttributeCache<ELEMENT_DIM, SPACE_DIM> > pCellAttributeCache);
+
+    /**
+     * @return #mpCellAttributeCache
+     */
+    boost::shared_ptr<CellAttributeCache<ELEMENT_DIM, SPACE_DIM> > GetCellAttributeCache() const;
+
+    /**
+     * Set the coordinator told of the population updates and node movements of the
+     * simulation. It is given to the components that have no coordinator when the
+     * simulation is solved.
+     *
+     * @param pPopulationUpdateCoordinator the population update coordinator
+     */
+    void SetPopulationUpdateCoordinator(boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM, SPACE_DIM> > pPopulationUpdateCoordinator);
+
+    /**
+     * @return #mpPopulationUpdateCoordinator
+     */
+    boost::shared_ptr<PopulationUpdateCoordinator<ELEMENT_DIM, SPACE_DIM> > GetPopulationUpdateCoordinator() const;
+
+    /**
+     * Set the source of time and random numbers of the simulation. Give the same context
+     * to the cell cycle models before the simulation is constructed, as they draw
+     * division ages when their cells are initialised.
+     *
+     * @param pSimulationContext the simulation context
+     */
+    void SetSimulationContext(boost::shared_ptr<UtericBudSimulationContext> pSimulationContext);
+
+    /**
+     * @return #mpSimulationContext
+     */
+    boost::shared_ptr<UtericBudSimulationContext> GetSimulationContext() const;
+
+    /**
+     * Set the controller used to choose the substep size when the numerical method
+     * has an adaptive time step.
+     *
+     * @param pStepSizeController pointer to a step size controller
+     */
+    void SetStepSizeController(boost::shared_ptr<AbstractStepSizeController> pStepSizeController);
+
+    /**
+     * @return the current step size controller.
+     */
+    const boost::shared_ptr<AbstractStepSizeController> GetStepSizeController() const;
+
     /**
      * Overridden OutputAdditionalSimulationSetup() method.
      *
-     * Output any force, boundary condition or numerical method information.
+     * Output any force, boundary condition, numerical method or step size controller information.
      *
      * @param rParamsFile the file stream to which the parameters are output
      */
@@ -238,6 +412,18 @@ inline void load_construct_data(
     // member variables to be deleted as they are loaded from archive and to not initialise cells.
     ::new(t)OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM>(*p_cell_population, true, false);
 }
+
+/**
+ * The archive version of OffLatticeSimulationUT. Version 1 adds the step size controller,
+ * the number of force threads and the simulation context.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+struct version<OffLatticeSimulationUT<ELEMENT_DIM,SPACE_DIM> >
+{
+    typedef mpl::int_<1> type;
+    typedef mpl::integral_c_tag tag;
+    BOOST_STATIC_CONSTANT(int, value = version::type::value);
+};
 }
 } // namespace
 
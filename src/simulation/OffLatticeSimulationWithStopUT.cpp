@@ -35,19 +35,81 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "Debug.hpp"  
 #include "OffLatticeSimulationWithStopUT.hpp"
+#include "PopulationBoundsStoppingCondition.hpp"
+#include "SmartPointers.hpp"
 
 bool OffLatticeSimulationWithStopUT::StoppingEventHasOccurred()
 {
-	double CellCount = mrCellPopulation.rGetMesh().GetNumNodes();
+    // Every condition is updated each step, so those that keep a history see every sample
+    bool has_occurred = false;
+    for (std::vector<boost::shared_ptr<AbstractStoppingCondition<2> > >::iterator iter = mStoppingConditions.begin();
+         iter != mStoppingConditions.end();
+         ++iter)
+    {
+        if ((*iter)->HasOccurred(mrCellPopulation) && !has_occurred)
+        {
+            mStoppingReason = (*iter)->rGetStoppingReason();
+            has_occurred = true;
+        }
+    }
+    return has_occurred;
+}
+
+void OffLatticeSimulationWithStopUT::SetupSolve()
+{
+    OffLatticeSimulationUT<2>::SetupSolve();
 
-    return  (CellCount > 1000);
-    //return  (SimulationTime::Instance()->GetTime() > 2);
+    mStoppingReason = "";
+    for (std::vector<boost::shared_ptr<AbstractStoppingCondition<2> > >::iterator iter = mStoppingConditions.begin();
+         iter != mStoppingConditions.end();
+         ++iter)
+    {
+        (*iter)->SetSimulationContext(mpSimulationContext);
+        (*iter)->SetupSolve(mrCellPopulation);
+    }
 }
 
 OffLatticeSimulationWithStopUT::OffLatticeSimulationWithStopUT(
         AbstractCellPopulation<2>& rCellPopulation)
-    : OffLatticeSimulation<2>(rCellPopulation)
+    : OffLatticeSimulationUT<2>(rCellPopulation)
+{
+    MAKE_PTR_ARGS(PopulationBoundsStoppingCondition<2>, p_bounds, (0, 1000));
+    mStoppingConditions.push_back(p_bounds);
+}
+
+void OffLatticeSimulationWithStopUT::AddStoppingCondition(boost::shared_ptr<AbstractStoppingCondition<2> > pStoppingCondition)
 {
+    mStoppingConditions.push_back(pStoppingCondition);
+}
+
+void OffLatticeSimulationWithStopUT::RemoveAllStoppingConditions()
+{
+    mStoppingConditions.clear();
+}
+
+const std::vector<boost::shared_ptr<AbstractStoppingCondition<2> > >& OffLatticeSimulationWithStopUT::rGetStoppingConditions() const
+{
+    return mStoppingConditions;
+}
+
+const std::string& OffLatticeSimulationWithStopUT::rGetStoppingReason() const
+{
+    return mStoppingReason;
+}
+
+void OffLatticeSimulationWithStopUT::OutputAdditionalSimulationSetup(out_stream& rParamsFile)
+{
+    OffLatticeSimulationUT<2>::OutputAdditionalSimulationSetup(rParamsFile);
+
+    // Loop over stopping conditions
+    *rParamsFile << "\n\t<StoppingConditions>\n";
+    for (std::vector<boost::shared_ptr<AbstractStoppingCondition<2> > >::iterator iter = mStoppingConditions.begin();
+         iter != mStoppingConditions.end();
+         ++iter)
+    {
+        (*iter)->OutputStoppingConditionInfo(rParamsFile);
+    }
+    *rParamsFile << "\t</StoppingConditions>\n";
 }
 
 
@@ -36,25 +36,123 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef OFFLATTICESIMULATIONWITHSTOPUT_HPP_
 #define OFFLATTICESIMULATIONWITHSTOPUT_HPP_
 
-#include "OffLatticeSimulation.hpp"
+#include <string>
+#include <vector>
+
+#include "OffLatticeSimulationUT.hpp"
+#include "AbstractStoppingCondition.hpp"
+
+#include "ChasteSerialization.hpp"
+#include <boost/serialization/base_object.hpp>
+#include <boost/serialization/shared_ptr.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
 
 /**
- * Simple subclass of OffLatticeSimulation which just overloads StoppingEventHasOccurred
- * for testing the stopping event functionality..
+ * Subclass of OffLatticeSimulationUT which overloads StoppingEventHasOccurred to
+ * stop the simulation as soon as any of a collection of stopping conditions holds.
+ *
+ * By default the collection holds a single PopulationBoundsStoppingCondition which
+ * stops the simulation once there are more than 1000 cells.
  */
-class OffLatticeSimulationWithStopUT : public OffLatticeSimulation<2>
+class OffLatticeSimulationWithStopUT : public OffLatticeSimulationUT<2>
 {
 private:
-    /** Define a stopping event which says stop if t>3.14 */
+
+    /** Needed for serialization. */
+    friend class boost::serialization::access;
+    /**
+     * Save or restore the simulation.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void serialize(Archive & archive, const unsigned int version)
+    {
+        if (version > 0)
+        {
+            archive & boost::serialization::base_object<OffLatticeSimulationUT<2> >(*this);
+            archive & mStoppingConditions;
+            archive & mStoppingReason;
+        }
+        else
+        {
+            // Before version 1 the class derived from OffLatticeSimulation<2> and kept none of its own members
+            archive & boost::serialization::base_object<AbstractCellBasedSimulation<2,2> >(*this);
+            archive & mForceCollection;
+            archive & mBoundaryConditions;
+            archive & mpNumericalMethod;
+        }
+    }
+
+    /** The stopping conditions, checked in order once per time step. */
+    std::vector<boost::shared_ptr<AbstractStoppingCondition<2> > > mStoppingConditions;
+
+    /** Why the simulation stopped, or empty if no stopping condition has held. */
+    std::string mStoppingReason;
+
+    /**
+     * Overridden StoppingEventHasOccurred() method.
+     *
+     * @return whether any of the stopping conditions holds
+     */
     bool StoppingEventHasOccurred();
 
+protected:
+
+    /**
+     * Overridden SetupSolve() method.
+     *
+     * Also set up each stopping condition.
+     */
+    virtual void SetupSolve();
+
 public:
+
+    /**
+     * Constructor.
+     *
+     * @param rCellPopulation Reference to a cell population object
+     */
     OffLatticeSimulationWithStopUT(AbstractCellPopulation<2>& rCellPopulation);
+
+    /**
+     * Add a stopping condition to be checked in this simulation.
+     *
+     * @param pStoppingCondition pointer to a stopping condition
+     */
+    void AddStoppingCondition(boost::shared_ptr<AbstractStoppingCondition<2> > pStoppingCondition);
+
+    /**
+     * Remove all the stopping conditions, including the default one.
+     */
+    void RemoveAllStoppingConditions();
+
+    /**
+     * @return the stopping conditions.
+     */
+    const std::vector<boost::shared_ptr<AbstractStoppingCondition<2> > >& rGetStoppingConditions() const;
+
+    /**
+     * @return #mStoppingReason
+     */
+    const std::string& rGetStoppingReason() const;
+
+    /**
+     * Overridden OutputAdditionalSimulationSetup() method.
+     *
+     * Also output the stopping conditions.
+     *
+     * @param rParamsFile the file stream to which the parameters are output
+     */
+    void OutputAdditionalSimulationSetup(out_stream& rParamsFile);
 };
 
 // Serialization for Boost >= 1.36
 #include "SerializationExportWrapper.hpp"
 CHASTE_CLASS_EXPORT(OffLatticeSimulationWithStopUT)
+BOOST_CLASS_VERSION(OffLatticeSimulationWithStopUT, 1)
 
 namespace boost
 {
@@ -0,0 +1,88 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "Philox4x32.hpp"
+
+/** The multiplier applied to the first counter word in each round. */
+static const boost::uint64_t PHILOX_M0 = 0xD2511F53u;
+
+/** The multiplier applied to the third counter word in each round. */
+static const boost::uint64_t PHILOX_M1 = 0xCD9E8D57u;
+
+/** The increment of the first key word between rounds (the golden ratio). */
+static const Philox4x32::Word PHILOX_W0 = 0x9E3779B9u;
+
+/** The increment of the second key word between rounds (sqrt(3) - 1). */
+static const Philox4x32::Word PHILOX_W1 = 0xBB67AE85u;
+
+/** The number of rounds, as recommended for Philox4x32 by its authors. */
+static const unsigned PHILOX_NUM_ROUNDS = 10;
+
+void Philox4x32::Generate(const Word counter[4], const Word key[2], Word result[4])
+{
+    Word c0 = counter[0];
+    Word c1 = counter[1];
+    Word c2 = counter[2];
+    Word c3 = counter[3];
+    Word k0 = key[0];
+    Word k1 = key[1];
+
+    for (unsigned round=0; round<PHILOX_NUM_ROUNDS; round++)
+    {
+        if (round > 0)
+        {
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+
+        boost::uint64_t product0 = PHILOX_M0*c0;
+        boost::uint64_t product1 = PHILOX_M1*c2;
+
+        Word hi0 = (Word) (product0 >> 32);
+        Word lo0 = (Word) product0;
+        Word hi1 = (Word) (product1 >> 32);
+        Word lo1 = (Word) product1;
+
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+    }
+
+    result[0] = c0;
+    result[1] = c1;
+    result[2] = c2;
+    result[3] = c3;
+}
@@ -0,0 +1,84 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PHILOX4X32_HPP_
+#define PHILOX4X32_HPP_
+
+#include <boost/cstdint.hpp>
+
+/**
+ * The Philox4x32-10 counter-based random number generator of Salmon et al.,
+ * "Parallel random numbers: as easy as 1, 2, 3" (SC11).
+ *
+ * A counter-based generator has no state: the output is a fixed function of a
+ * 128-bit counter and a 64-bit key, so any draw can be made independently of every
+ * other. Giving each random number its own counter, built from what the number is
+ * for, makes the results independent of the order in which the numbers are drawn
+ * and so of the number of threads drawing them.
+ *
+ * Each call gives four 32-bit words, enough for two uniform deviates with 53 bits
+ * of precision.
+ */
+class Philox4x32
+{
+public:
+
+    /** The type of the words of the counter, key and result. */
+    typedef boost::uint32_t Word;
+
+    /**
+     * Compute the random words for a counter and key.
+     *
+     * @param counter the four counter words
+     * @param key the two key words
+     * @param result the four random words
+     */
+    static void Generate(const Word counter[4], const Word key[2], Word result[4]);
+
+    /**
+     * @return a uniform deviate on [0, 1) made from two random words, with 53 bits
+     * of precision.
+     *
+     * @param high the word giving the most significant bits
+     * @param low the word giving the least significant bits
+     */
+    static double ToUniform(Word high, Word low)
+    {
+        // 27 bits from the first word and 26 from the second, as genrand_res53 of the Mersenne Twister
+        return ((high >> 5)*67108864.0 + (low >> 6))*(1.0/9007199254740992.0);
+    }
+};
+
+#endif /*PHILOX4X32_HPP_*/
@@ -0,0 +1,254 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "UtericBudSimulationContext.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <boost/random/uniform_01.hpp>
+
+#include "Exception.hpp"
+#include "RandomNumberGenerator.hpp"
+#include "Philox4x32.hpp"
+
+UtericBudSimulationContext::UtericBudSimulationContext()
+    : mNormalDistribution(0.0, 1.0),
+      mUseCounterBasedStreams(false),
+      mCounterBasedSeed(0),
+      mHasClock(false),
+      mStartTime(0.0),
+      mTimeStep(0.0),
+      mTimeStepsElapsed(0)
+{
+}
+
+UtericBudSimulationContext::UtericBudSimulationContext(unsigned seed)
+    : mNormalDistribution(0.0, 1.0),
+      mUseCounterBasedStreams(false),
+      mCounterBasedSeed(0),
+      mHasClock(false),
+      mStartTime(0.0),
+      mTimeStep(0.0),
+      mTimeStepsElapsed(0)
+{
+    Reseed(seed);
+}
+
+void UtericBudSimulationContext::Reseed(unsigned seed)
+{
+    mpEngine.reset(new boost::mt19937(seed));
+    mNormalDistribution.reset();
+}
+
+bool UtericBudSimulationContext::HasOwnRandomNumberGenerator() const
+{
+    return mpEngine.get() != NULL;
+}
+
+void UtericBudSimulationContext::UseCounterBasedStreams(unsigned seed)
+{
+    mUseCounterBasedStreams = true;
+    mCounterBasedSeed = seed;
+}
+
+bool UtericBudSimulationContext::HasCounterBasedStreams() const
+{
+    return mUseCounterBasedStreams;
+}
+
+void UtericBudSimulationContext::GenerateCounterBasedWords(UtericBudRandomStream stream, unsigned cellId, unsigned timeStep, unsigned drawIndex, boost::uint32_t result[4]) const
+{
+    // The key picks the stream; the counter picks the draw within it
+    Philox4x32::Word counter[4] = {cellId, timeStep, drawIndex, 0u};
+    Philox4x32::Word key[2] = {mCounterBasedSeed, (Philox4x32::Word) stream};
+    Philox4x32::Generate(counter, key, result);
+}
+
+void UtericBudSimulationContext::SetClock(double time, double timeStep, unsigned timeStepsElapsed)
+{
+    assert(timeStep > 0.0);
+    mHasClock = true;
+    mTimeStep = timeStep;
+    mTimeStepsElapsed = timeStepsElapsed;
+    mStartTime = time - timeStepsElapsed*timeStep;
+}
+
+void UtericBudSimulationContext::AdvanceClock()
+{
+    assert(mHasClock);
+    mTimeStepsElapsed++;
+}
+
+bool UtericBudSimulationContext::HasClock() const
+{
+    return mHasClock;
+}
+
+double UtericBudSimulationContext::GetTime() const
+{
+    return mStartTime + mTimeStepsElapsed*mTimeStep;
+}
+
+double UtericBudSimulationContext::GetTimeStep() const
+{
+    if (!mHasClock)
+    {
+        EXCEPTION("The simulation context has no clock; it is set when the simulation owning the context is solved.");
+    }
+    return mTimeStep;
+}
+
+unsigned UtericBudSimulationContext::GetTimeStepsElapsed() const
+{
+    return mTimeStepsElapsed;
+}
+
+double UtericBudSimulationContext::ranf()
+{
+    if (!mpEngine)
+    {
+        return RandomNumberGenerator::Instance()->ranf();
+    }
+    return boost::uniform_01<double>()(*mpEngine);
+}
+
+double UtericBudSimulationContext::StandardNormalRandomDeviate()
+{
+    if (!mpEngine)
+    {
+        return RandomNumberGenerator::Instance()->StandardNormalRandomDeviate();
+    }
+    return mNormalDistribution(*mpEngine);
+}
+
+void UtericBudSimulationContext::FillStandardNormalRandomDeviates(double* pDeviates, unsigned numDeviates)
+{
+    // Draw the uniform deviates in one pass, leaving the transform free of calls
+    if (!mpEngine)
+    {
+        RandomNumberGenerator* p_gen = RandomNumberGenerator::Instance();
+        for (unsigned i=0; i<numDeviates; i++)
+        {
+            pDeviates[i] = p_gen->ranf();
+        }
+    }
+    else
+    {
+        boost::uniform_01<double> uniform;
+        for (unsigned i=0; i<numDeviates; i++)
+        {
+            pDeviates[i] = uniform(*mpEngine);
+        }
+    }
+
+    // Box-Muller transform of each pair; 1 - u lies in (0, 1], so its logarithm is finite
+    const double two_pi = 2.0*M_PI;
+    unsigned num_pairs = numDeviates/2;
+    for (unsigned k=0; k<num_pairs; k++)
+    {
+        double radius = sqrt(-2.0*log(1.0 - pDeviates[2*k]));
+        double angle = two_pi*pDeviates[2*k + 1];
+        pDeviates[2*k] = radius*cos(angle);
+        pDeviates[2*k + 1] = radius*sin(angle);
+    }
+
+    // An odd one out takes half of a pair of its own
+    if (numDeviates%2 == 1)
+    {
+        double u = ranf();
+        pDeviates[numDeviates - 1] = sqrt(-2.0*log(1.0 - pDeviates[numDeviates - 1]))*cos(two_pi*u);
+    }
+}
+
+double UtericBudSimulationContext::NormalRandomDeviate(double mean, double stdDev)
+{
+    if (!mpEngine)
+    {
+        return RandomNumberGenerator::Instance()->NormalRandomDeviate(mean, stdDev);
+    }
+    return mean + stdDev*mNormalDistribution(*mpEngine);
+}
+
+double UtericBudSimulationContext::ranf(UtericBudRandomStream stream, unsigned cellId, unsigned drawIndex)
+{
+    if (!mUseCounterBasedStreams)
+    {
+        return ranf();
+    }
+
+    Philox4x32::Word words[4];
+    GenerateCounterBasedWords(stream, cellId, GetTimeStepsElapsed(), drawIndex, words);
+    return Philox4x32::ToUniform(words[0], words[1]);
+}
+
+double UtericBudSimulationContext::NormalRandomDeviate(double mean, double stdDev, UtericBudRandomStream stream, unsigned cellId, unsigned drawIndex)
+{
+    if (!mUseCounterBasedStreams)
+    {
+        return NormalRandomDeviate(mean, stdDev);
+    }
+
+    Philox4x32::Word words[4];
+    GenerateCounterBasedWords(stream, cellId, GetTimeStepsElapsed(), drawIndex, words);
+    double radius = sqrt(-2.0*log(1.0 - Philox4x32::ToUniform(words[0], words[1])));
+    return mean + stdDev*radius*cos(2.0*M_PI*Philox4x32::ToUniform(words[2], words[3]));
+}
+
+void UtericBudSimulationContext::FillStandardNormalRandomDeviates(UtericBudRandomStream stream,
+                                                                  const unsigned* pCellIds,
+                                                                  unsigned numCells,
+                                                                  unsigned drawIndex,
+                                                                  double* pDeviates)
+{
+    if (!mUseCounterBasedStreams)
+    {
+        FillStandardNormalRandomDeviates(pDeviates, 2*numCells);
+        return;
+    }
+
+    // One Philox call gives the two uniforms of one Box-Muller pair
+    const double two_pi = 2.0*M_PI;
+    unsigned time_step = GetTimeStepsElapsed();
+    for (unsigned i=0; i<numCells; i++)
+    {
+        Philox4x32::Word words[4];
+        GenerateCounterBasedWords(stream, pCellIds[i], time_step, drawIndex, words);
+
+        double radius = sqrt(-2.0*log(1.0 - Philox4x32::ToUniform(words[0], words[1])));
+        double angle = two_pi*Philox4x32::ToUniform(words[2], words[3]);
+        pDeviates[2*i] = radius*cos(angle);
+        pDeviates[2*i + 1] = radius*sin(angle);
+    }
+}
@@ -0,0 +1,353 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef UTERICBUDSIMULATIONCONTEXT_HPP_
+#define UTERICBUDSIMULATIONCONTEXT_HPP_
+
+#include <boost/shared_ptr.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/normal_distribution.hpp>
+
+#include <sstream>
+#include <string>
+#include "ChasteSerialization.hpp"
+#include <boost/serialization/split_member.hpp>
+#include <boost/serialization/string.hpp>
+
+/**
+ * The uses the project makes of random numbers, each of which has its own
+ * counter-based stream when a context has them.
+ */
+typedef enum UtericBudRandomStream_
+{
+    DIFFUSION_RANDOM_STREAM,
+    ATTACHMENT_RANDOM_STREAM,
+    INITIAL_DIVISION_AGE_RANDOM_STREAM,
+    DAUGHTER_DIVISION_AGE_RANDOM_STREAM,
+    DIVISION_AGE_RANDOM_STREAM,
+    DIFFERENTIATION_RANDOM_STREAM,
+    JIGGLE_RANDOM_STREAM
+} UtericBudRandomStream;
+
+/**
+ * The source of time and random numbers for the project classes that would otherwise
+ * reach into the SimulationTime and RandomNumberGenerator singletons directly:
+ * CMCellCycleModel, AttachmentModifier, the stochastic forces and
+ * SelectivePlaneBoundaryCondition.
+ *
+ * By default a context forwards every call to the singletons, so behaviour is
+ * unchanged. A context given a seed instead draws from its own Mersenne Twister,
+ * so that each replicate has an independent random stream that no other replicate
+ * touches.
+ *
+ * A context may also be given counter-based streams, with UseCounterBasedStreams().
+ * Draws made through the methods that take a stream, a cell ID and a draw index are
+ * then computed by Philox4x32 from those, the seed and the number of time steps
+ * elapsed, instead of being taken in turn from a sequence. The numbers a cell gets
+ * therefore do not depend on the order in which cells are visited, on the number of
+ * threads, or on what other components draw. Without counter-based streams these
+ * methods ignore their keys and draw in sequence as before.
+ *
+ * Each context keeps its own clock, which the simulation that owns the context sets
+ * in SetupSolve() and advances once per time step, so the project classes never read
+ * SimulationTime themselves. Until a clock has been set the time and the number of
+ * time steps elapsed are zero, and asking for the time step is an error.
+ *
+ * There is no shared default context. OffLatticeSimulationUT gives its context to the
+ * forces, boundary conditions, modifiers and cell cycle models that need one when the
+ * simulation is solved; anything used outside such a simulation must be given one with
+ * SetSimulationContext(). Cell cycle models need theirs before their cells are
+ * initialised, as they draw a division age then.
+ *
+ * OffLatticeSimulationUT archives its context, with the state of the random number
+ * engine and the clock. The objects that use the context do not archive it, and are
+ * given the restored context of their simulation when it is next solved. Contexts
+ * first appear in version 1 of the OffLatticeSimulationUT archive, so this class has
+ * no older archive layout to read.
+ */
+class UtericBudSimulationContext
+{
+private:
+
+    /** Needed for serialization. */
+    friend class boost::serialization::access;
+
+    /**
+     * Save the context. The engine and distribution are saved as text.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void save(Archive & archive, const unsigned int version) const
+    {
+        bool has_engine = (mpEngine.get() != NULL);
+        std::string engine_state;
+        if (has_engine)
+        {
+            std::stringstream engine_stream;
+            engine_stream << *mpEngine << " " << mNormalDistribution;
+            engine_state = engine_stream.str();
+        }
+        archive & has_engine;
+        archive & engine_state;
+        archive & mUseCounterBasedStreams;
+        archive & mCounterBasedSeed;
+        archive & mHasClock;
+        archive & mStartTime;
+        archive & mTimeStep;
+        archive & mTimeStepsElapsed;
+    }
+
+    /**
+     * Load the context.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void load(Archive & archive, const unsigned int version)
+    {
+        bool has_engine;
+        std::string engine_state;
+        archive & has_engine;
+        archive & engine_state;
+        if (has_engine)
+        {
+            mpEngine.reset(new boost::mt19937);
+            std::stringstream engine_stream(engine_state);
+            engine_stream >> *mpEngine >> mNormalDistribution;
+        }
+        else
+        {
+            mpEngine.reset();
+            mNormalDistribution.reset();
+        }
+        archive & mUseCounterBasedStreams;
+        archive & mCounterBasedSeed;
+        archive & mHasClock;
+        archive & mStartTime;
+        archive & mTimeStep;
+        archive & mTimeStepsElapsed;
+    }
+    BOOST_SERIALIZATION_SPLIT_MEMBER()
+
+    /** The random number engine, or NULL to use RandomNumberGenerator. */
+    boost::scoped_ptr<boost::mt19937> mpEngine;
+
+    /** The normal distribution drawn from #mpEngine, which may cache a deviate between calls. */
+    boost::normal_distribution<double> mNormalDistribution;
+
+    /** Whether draws keyed by stream, cell and draw index use counter-based streams. */
+    bool mUseCounterBasedStreams;
+
+    /** The seed of the counter-based streams. */
+    unsigned mCounterBasedSeed;
+
+    /** Whether SetClock() has been called. */
+    bool mHasClock;
+
+    /** The time at which the clock was last set, less the time steps elapsed by then. */
+    double mStartTime;
+
+    /** The time step of the clock. */
+    double mTimeStep;
+
+    /** The number of time steps elapsed on the clock. */
+    unsigned mTimeStepsElapsed;
+
+    /**
+     * Compute the four random words for a keyed draw from the counter-based streams.
+     *
+     * @param stream the use the random numbers are for
+     * @param cellId the ID of the cell the random numbers are for
+     * @param timeStep the number of time steps elapsed
+     * @param drawIndex distinguishes draws for the same stream and cell within a time step
+     * @param result the four random words
+     */
+    void GenerateCounterBasedWords(UtericBudRandomStream stream, unsigned cellId, unsigned timeStep, unsigned drawIndex, boost::uint32_t result[4]) const;
+
+    /** Contexts own their engine, so are not copyable. */
+    UtericBudSimulationContext(const UtericBudSimulationContext&);
+
+    /** Contexts own their engine, so are not assignable. @return this context */
+    UtericBudSimulationContext& operator=(const UtericBudSimulationContext&);
+
+public:
+
+    /**
+     * Default constructor. The context forwards to the singletons.
+     */
+    UtericBudSimulationContext();
+
+    /**
+     * Constructor for a context with its own random number engine.
+     *
+     * @param seed the seed of the engine
+     */
+    UtericBudSimulationContext(unsigned seed);
+
+    /**
+     * Give the context its own random number engine, or reseed the one it has.
+     *
+     * @param seed the seed of the engine
+     */
+    void Reseed(unsigned seed);
+
+    /**
+     * @return whether the context draws from its own random number engine.
+     */
+    bool HasOwnRandomNumberGenerator() const;
+
+    /**
+     * Make the draws keyed by stream, cell and draw index come from counter-based
+     * streams with the given seed.
+     *
+     * @param seed the seed of the streams
+     */
+    void UseCounterBasedStreams(unsigned seed);
+
+    /**
+     * @return whether keyed draws come from counter-based streams.
+     */
+    bool HasCounterBasedStreams() const;
+
+    /**
+     * Set the clock.
+     *
+     * @param time the current time
+     * @param timeStep the time step
+     * @param timeStepsElapsed the number of time steps elapsed
+     */
+    void SetClock(double time, double timeStep, unsigned timeStepsElapsed);
+
+    /**
+     * Move the clock on by one time step.
+     */
+    void AdvanceClock();
+
+    /**
+     * @return whether the clock has been set.
+     */
+    bool HasClock() const;
+
+    /**
+     * @return the current simulation time.
+     */
+    double GetTime() const;
+
+    /**
+     * @return the simulation time step. Throws if the clock has not been set.
+     */
+    double GetTimeStep() const;
+
+    /**
+     * @return the number of time steps elapsed.
+     */
+    unsigned GetTimeStepsElapsed() const;
+
+    /**
+     * @return a random number uniformly distributed on [0, 1).
+     */
+    double ranf();
+
+    /**
+     * @return a random number from the standard normal distribution.
+     */
+    double StandardNormalRandomDeviate();
+
+    /**
+     * Fill an array with random numbers from the standard normal distribution.
+     *
+     * All the uniform deviates are drawn first and then turned into normal deviates
+     * in pairs by the Box-Muller transform, in a loop with no calls out of it. This is
+     * much cheaper than calling StandardNormalRandomDeviate() once per number, but
+     * consumes the random number stream differently, so the two do not give the
+     * same numbers.
+     *
+     * @param pDeviates the array to fill
+     * @param numDeviates the length of the array
+     */
+    void FillStandardNormalRandomDeviates(double* pDeviates, unsigned numDeviates);
+
+    /**
+     * @return a random number from a normal distribution.
+     *
+     * @param mean the mean of the distribution
+     * @param stdDev the standard deviation of the distribution
+     */
+    double NormalRandomDeviate(double mean, double stdDev);
+
+    /**
+     * @return a random number uniformly distributed on [0, 1), keyed by what it is for.
+     *
+     * @param stream the use the random number is for
+     * @param cellId the ID of the cell the random number is for
+     * @param drawIndex distinguishes draws for the same stream and cell within a time step (defaults to 0)
+     */
+    double ranf(UtericBudRandomStream stream, unsigned cellId, unsigned drawIndex=0);
+
+    /**
+     * @return a random number from a normal distribution, keyed by what it is for.
+     *
+     * @param mean the mean of the distribution
+     * @param stdDev the standard deviation of the distribution
+     * @param stream the use the random number is for
+     * @param cellId the ID of the cell the random number is for
+     * @param drawIndex distinguishes draws for the same stream and cell within a time step (defaults to 0)
+     */
+    double NormalRandomDeviate(double mean, double stdDev, UtericBudRandomStream stream, unsigned cellId, unsigned drawIndex=0);
+
+    /**
+     * Fill an array with two standard normal deviates per cell, keyed by what they are for.
+     * Without counter-based streams, this is the same as FillStandardNormalRandomDeviates()
+     * for an array of twice the number of cells.
+     *
+     * @param stream the use the random numbers are for
+     * @param pCellIds the IDs of the cells
+     * @param numCells the number of cells
+     * @param drawIndex distinguishes draws for the same stream and cells within a time step
+     * @param pDeviates the array to fill, of length 2*numCells
+     */
+    void FillStandardNormalRandomDeviates(UtericBudRandomStream stream,
+                                          const unsigned* pCellIds,
+                                          unsigned numCells,
+                                          unsigned drawIndex,
+                                          double* pDeviates);
+};
+
+#endif /*UTERICBUDSIMULATIONCONTEXT_HPP_*/
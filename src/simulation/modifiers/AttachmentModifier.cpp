@@ -35,8 +35,8 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "AttachmentModifier.hpp"
 #include "MeshBasedCellPopulation.hpp"
-#include "RandomNumberGenerator.hpp"
 #include "SmartPointers.hpp"
+#include "Exception.hpp"
 
 #include "WildTypeCellMutationState.hpp"
 #include "AttachedCellMutationState.hpp"
@@ -44,6 +44,9 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "AbstractCellBasedSimulation.hpp"
 #include "OutputFileHandler.hpp"
 #include <sstream>
+#include <climits>
+#include <cmath>
+#include <boost/make_shared.hpp>
 
 #include "Debug.hpp"
 
@@ -53,7 +56,12 @@ AttachmentModifier<DIM>::AttachmentModifier()
       mAttachmentProbability(0.1),
       mDetachmentProbability(0.6),
       mAttachmentHeight(1.0),
-      mOutputAttachmentDurations(false)
+      mOutputAttachmentDurations(false),
+      mpCellAttributeCache(boost::make_shared<CellAttributeCache<DIM> >()),
+      mUseEventScheduling(false),
+      mIsEventQueueInitialised(false),
+      mMaxScheduledCellId(UINT_MAX),
+      mNumEventsProcessed(0)
 {
 }
 
@@ -71,6 +79,8 @@ void AttachmentModifier<DIM>::UpdateAtEndOfTimeStep(AbstractCellPopulation<DIM,D
 template<unsigned DIM>
 void AttachmentModifier<DIM>::SetupSolve(AbstractCellPopulation<DIM,DIM>& rCellPopulation, std::string outputDirectory)
 {
+    // Every cell is scheduled afresh at the start of each solve
+    mIsEventQueueInitialised = false;
     UpdateCellStates(rCellPopulation);
     
     if (mOutputAttachmentDurations)
@@ -83,10 +93,74 @@ void AttachmentModifier<DIM>::SetupSolve(AbstractCellPopulation<DIM,DIM>& rCellP
 template<unsigned DIM>
 void AttachmentModifier<DIM>::UpdateCellStates(AbstractCellPopulation<DIM,DIM>& rCellPopulation)
 {
-    rCellPopulation.Update();
+    if (!mpSimulationContext)
+    {
+        EXCEPTION("AttachmentModifier needs a simulation context; add it to an OffLatticeSimulationUT or call SetSimulationContext().");
+    }
+
+    // The node locations are read directly, so only births and deaths call for an update
+    if (mpPopulationUpdateCoordinator)
+    {
+        mpPopulationUpdateCoordinator->RequestUpdate(rCellPopulation, CELL_LOCATION_MAPS_NEED);
+    }
+    else
+    {
+        rCellPopulation.Update();
+    }
+    mpCellAttributeCache->Refresh(rCellPopulation);
+    
+    if (mUseEventScheduling)
+    {
+        UpdateCellStatesByEvents(rCellPopulation);
+    }
+    else
+    {
+        UpdateCellStatesByCoinFlips(rCellPopulation);
+    }
+}
+
+template<unsigned DIM>
+void AttachmentModifier<DIM>::AttachCell(AbstractCellPopulation<DIM,DIM>& rCellPopulation, CellPtr pCell, unsigned nodeIndex)
+{
     MAKE_PTR(AttachedCellMutationState, p_attached_state);
+    pCell->SetMutationState(p_attached_state);
+    mpCellAttributeCache->RefreshCell(rCellPopulation, pCell, nodeIndex);
+    
+    if (mOutputAttachmentDurations)
+    {
+        // Write time of attachment to CellData
+        double current_time = mpSimulationContext->GetTime();
+    
+        pCell->GetCellData()->SetItem("AttachTime", current_time);
+    }
+}
+
+template<unsigned DIM>
+void AttachmentModifier<DIM>::DetachCell(AbstractCellPopulation<DIM,DIM>& rCellPopulation, CellPtr pCell, unsigned nodeIndex)
+{
     MAKE_PTR(WildTypeCellMutationState, p_state);
+    pCell->SetMutationState(p_state);
+    mpCellAttributeCache->RefreshCell(rCellPopulation, pCell, nodeIndex);
     
+    if (mOutputAttachmentDurations)
+    {
+        // Get time of attachment to subtract from current time 
+        double AttachTime = pCell->GetCellData()->GetItem("AttachTime");
+        
+        double current_time = mpSimulationContext->GetTime();
+        
+        double AttachmentDuration = current_time - AttachTime;
+    
+        pCell->GetCellData()->SetItem("AttachTime", 0);
+    
+        // Write attachment suration to .dat
+        *mpAttachmentDurationsFile << AttachmentDuration << "\t";
+    }
+}
+
+template<unsigned DIM>
+void AttachmentModifier<DIM>::UpdateCellStatesByCoinFlips(AbstractCellPopulation<DIM,DIM>& rCellPopulation)
+{
     double AttachmentProbability = mAttachmentProbability;
     double DetachmentProbability = mDetachmentProbability;
     
@@ -95,50 +169,152 @@ void AttachmentModifier<DIM>::UpdateCellStates(AbstractCellPopulation<DIM,DIM>&
          ++node_iter)
     {
         unsigned node_index = node_iter->GetIndex();
-        CellPtr p_cell = rCellPopulation.GetCellUsingLocationIndex(node_index);
-        RandomNumberGenerator* p_gen = RandomNumberGenerator::Instance();
-        double dt = SimulationTime::Instance()->GetTimeStep();
+        UtericBudSimulationContext* p_gen = mpSimulationContext.get();
+        double dt = mpSimulationContext->GetTimeStep();
+        
+        // One draw per cell, keyed by its ID so that the outcome does not depend on the node order
+        double u = p_gen->ranf(ATTACHMENT_RANDOM_STREAM, mpCellAttributeCache->GetCellId(node_index));
         
-        if (!(p_cell->GetMutationState()->IsType<AttachedCellMutationState>()))
+        // The cell is only looked up if its state changes
+        if (!mpCellAttributeCache->IsAttached(node_index))
         {
-            double cell_location_y = rCellPopulation.GetLocationOfCellCentre(p_cell)[1];
-            if ((p_gen->ranf() < AttachmentProbability * dt) && (cell_location_y < mAttachmentHeight))
+            double cell_location_y = node_iter->rGetLocation()[1];
+            if ((u < AttachmentProbability * dt) && (cell_location_y < mAttachmentHeight))
             {
-                p_cell->SetMutationState(p_attached_state);
-                
-                if (mOutputAttachmentDurations)
-                {
-                    // Write time of attachment to CellData
-                    SimulationTime* p_simulation_time = SimulationTime::Instance();
-                    double current_time = p_simulation_time->GetTime();
-                
-                    p_cell->GetCellData()->SetItem("AttachTime", current_time);
-                }
-                
+                AttachCell(rCellPopulation, rCellPopulation.GetCellUsingLocationIndex(node_index), node_index);
             }
         }
         else
         {
-            if (p_gen->ranf() < DetachmentProbability * dt)
+            if (u < DetachmentProbability * dt)
+            {
+                DetachCell(rCellPopulation, rCellPopulation.GetCellUsingLocationIndex(node_index), node_index);
+            }
+        }
+    }
+}
+
+template<unsigned DIM>
+void AttachmentModifier<DIM>::ScheduleEvent(CellPtr pCell, bool isAttached, unsigned firstTimeStep, unsigned drawIndex)
+{
+    unsigned cell_id = pCell->GetCellId();
+    if (cell_id > mMaxScheduledCellId || mMaxScheduledCellId == UINT_MAX)
+    {
+        mMaxScheduledCellId = cell_id;
+    }
+    
+    // Each time step is a Bernoulli trial, so the number of trials up to and including the first success is geometric
+    double probability = (isAttached ? mDetachmentProbability : mAttachmentProbability) * mpSimulationContext->GetTimeStep();
+    if (probability <= 0.0)
+    {
+        return;
+    }
+    double num_trials = 1.0;
+    if (probability < 1.0)
+    {
+        double u = mpSimulationContext->ranf(ATTACHMENT_RANDOM_STREAM, cell_id, drawIndex);
+        num_trials += floor(log(1.0 - u)/log(1.0 - probability));
+    }
+    if (num_trials > (double)(UINT_MAX - firstTimeStep))
+    {
+        return;
+    }
+    
+    AttachmentEvent event;
+    event.mTimeStep = firstTimeStep + (unsigned)num_trials - 1;
+    event.mCellId = cell_id;
+    event.mpCell = pCell;
+    event.mWasAttached = isAttached;
+    mEventQueue.push(event);
+}
+
+template<unsigned DIM>
+void AttachmentModifier<DIM>::ScheduleAllCells(AbstractCellPopulation<DIM,DIM>& rCellPopulation)
+{
+    mEventQueue = std::priority_queue<AttachmentEvent, std::vector<AttachmentEvent>, std::greater<AttachmentEvent> >();
+    mMaxScheduledCellId = UINT_MAX;
+    
+    unsigned time_step = mpSimulationContext->GetTimeStepsElapsed();
+    for (typename AbstractMesh<DIM, DIM>::NodeIterator node_iter = rCellPopulation.rGetMesh().GetNodeIteratorBegin();
+         node_iter != rCellPopulation.rGetMesh().GetNodeIteratorEnd();
+         ++node_iter)
+    {
+        unsigned node_index = node_iter->GetIndex();
+        if (mpCellAttributeCache->HasCell(node_index))
+        {
+            ScheduleEvent(rCellPopulation.GetCellUsingLocationIndex(node_index), mpCellAttributeCache->IsAttached(node_index), time_step, 0);
+        }
+    }
+    mIsEventQueueInitialised = true;
+}
+
+template<unsigned DIM>
+void AttachmentModifier<DIM>::UpdateCellStatesByEvents(AbstractCellPopulation<DIM,DIM>& rCellPopulation)
+{
+    if (!mIsEventQueueInitialised)
+    {
+        ScheduleAllCells(rCellPopulation);
+    }
+    
+    unsigned time_step = mpSimulationContext->GetTimeStepsElapsed();
+    
+    // New cells are added to the end of the population with the highest IDs, so only the newest need looking at
+    unsigned max_scheduled_cell_id = mMaxScheduledCellId;
+    std::list<CellPtr>& r_cells = rCellPopulation.rGetCells();
+    for (typename std::list<CellPtr>::reverse_iterator cell_iter = r_cells.rbegin();
+         cell_iter != r_cells.rend();
+         ++cell_iter)
+    {
+        if (max_scheduled_cell_id != UINT_MAX && (*cell_iter)->GetCellId() <= max_scheduled_cell_id)
+        {
+            break;
+        }
+        if (!(*cell_iter)->IsDead())
+        {
+            // Daughters inherit the mutation state, so the daughter of an attached cell starts attached
+            unsigned node_index = rCellPopulation.GetLocationIndexUsingCell(*cell_iter);
+            ScheduleEvent(*cell_iter, mpCellAttributeCache->IsAttached(node_index), time_step, 0);
+        }
+    }
+    
+    // Carry out the attempts that succeed on this time step; all the others would have done nothing
+    while (!mEventQueue.empty() && mEventQueue.top().mTimeStep <= time_step)
+    {
+        AttachmentEvent event = mEventQueue.top();
+        mEventQueue.pop();
+        
+        // Events for cells that have since died or been removed are dropped here rather than when the cell dies
+        CellPtr p_cell = event.mpCell.lock();
+        if (!p_cell || p_cell->IsDead())
+        {
+            continue;
+        }
+        mNumEventsProcessed++;
+        
+        unsigned node_index = rCellPopulation.GetLocationIndexUsingCell(p_cell);
+        bool is_attached = mpCellAttributeCache->IsAttached(node_index);
+        if (is_attached != event.mWasAttached)
+        {
+            // Something else has changed the state of the cell, so the event was drawn at the wrong rate
+            ScheduleEvent(p_cell, is_attached, time_step + 1, 1);
+        }
+        else if (!is_attached)
+        {
+            // Successes away from the base are thinned out, which is the same as flipping coins only near the base
+            if (rCellPopulation.GetNode(node_index)->rGetLocation()[1] < mAttachmentHeight)
             {
-                p_cell->SetMutationState(p_state);
-                
-                if (mOutputAttachmentDurations)
-                {
-                    // Get time of attachment to subtract from current time 
-                    double AttachTime = p_cell->GetCellData()->GetItem("AttachTime");
-                    
-                    SimulationTime* p_simulation_time = SimulationTime::Instance();
-                    double current_time = p_simulation_time->GetTime();
-                    
-                    double AttachmentDuration = current_time - AttachTime;
-                
-                    p_cell->GetCellData()->SetItem("AttachTime", 0);
-                
-                    // Write attachment suration to .dat
-                    *mpAttachmentDurationsFile << AttachmentDuration << "\t";
-                }
+                AttachCell(rCellPopulation, p_cell, node_index);
+                ScheduleEvent(p_cell, true, time_step + 1, 1);
             }
+            else
+            {
+                ScheduleEvent(p_cell, false, time_step + 1, 1);
+            }
+        }
+        else
+        {
+            DetachCell(rCellPopulation, p_cell, node_index);
+            ScheduleEvent(p_cell, false, time_step + 1, 1);
         }
     }
 }
@@ -201,6 +377,75 @@ void AttachmentModifier<DIM>::SetOutputAttachmentDurations(bool outputAttachment
     mOutputAttachmentDurations = outputAttachmentDurations;
 }
 
+template<unsigned DIM>
+void AttachmentModifier<DIM>::SetSimulationContext(boost::shared_ptr<UtericBudSimulationContext> pSimulationContext)
+{
+    assert(pSimulationContext);
+    mpSimulationContext = pSimulationContext;
+}
+
+template<unsigned DIM>
+boost::shared_ptr<UtericBudSimulationContext> AttachmentModifier<DIM>::GetSimulationContext() const
+{
+    return mpSimulationContext;
+}
+
+template<unsigned DIM>
+void AttachmentModifier<DIM>::SetCellAttributeCache(boost::shared_ptr<CellAttributeCache<DIM> > pCellAttributeCache)
+{
+    assert(pCellAttributeCache);
+    mpCellAttributeCache = pCellAttributeCache;
+}
+
+template<unsigned DIM>
+boost::shared_ptr<CellAttributeCache<DIM> > AttachmentModifier<DIM>::GetCellAttributeCache()
+{
+    return mpCellAttributeCache;
+}
+
+template<unsigned DIM>
+void AttachmentModifier<DIM>::SetPopulationUpdateCoordinator(boost::shared_ptr<PopulationUpdateCoordinator<DIM> > pPopulationUpdateCoordinator)
+{
+    mpPopulationUpdateCoordinator = pPopulationUpdateCoordinator;
+}
+
+template<unsigned DIM>
+boost::shared_ptr<PopulationUpdateCoordinator<DIM> > AttachmentModifier<DIM>::GetPopulationUpdateCoordinator()
+{
+    return mpPopulationUpdateCoordinator;
+}
+
+template<unsigned DIM>
+void AttachmentModifier<DIM>::ConnectToSimulation(boost::shared_ptr<CellAttributeCache<DIM> > pCellAttributeCache,
+                                                  boost::shared_ptr<PopulationUpdateCoordinator<DIM> > pPopulationUpdateCoordinator,
+                                                  unsigned numForceThreads)
+{
+    SetCellAttributeCache(pCellAttributeCache);
+    if (!mpPopulationUpdateCoordinator)
+    {
+        SetPopulationUpdateCoordinator(pPopulationUpdateCoordinator);
+    }
+}
+
+template<unsigned DIM>
+void AttachmentModifier<DIM>::SetUseEventScheduling(bool useEventScheduling)
+{
+    mUseEventScheduling = useEventScheduling;
+    mIsEventQueueInitialised = false;
+}
+
+template<unsigned DIM>
+bool AttachmentModifier<DIM>::GetUseEventScheduling()
+{
+    return mUseEventScheduling;
+}
+
+template<unsigned DIM>
+unsigned AttachmentModifier<DIM>::GetNumEventsProcessed()
+{
+    return mNumEventsProcessed;
+}
+
 template<unsigned DIM>
 void AttachmentModifier<DIM>::OutputSimulationModifierParameters(out_stream& rParamsFile)
 {
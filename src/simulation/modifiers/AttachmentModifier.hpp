@@ -33,13 +33,30 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 */
 
+#ifndef ATTACHMENTMODIFIER_HPP_
+#define ATTACHMENTMODIFIER_HPP_
+
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include <boost/weak_ptr.hpp>
+
 #include "ChasteSerialization.hpp"
 #include <boost/serialization/base_object.hpp>
+#include <boost/serialization/version.hpp>
 
 #include "AbstractCellBasedSimulationModifier.hpp"
+#include "UtericBudSimulationContext.hpp"
+#include "CellAttributeCache.hpp"
+#include "PopulationUpdateCoordinator.hpp"
+#include "AbstractSimulationComponent.hpp"
+#include "AbstractSimulationContextUser.hpp"
 
 template<unsigned DIM>
-class AttachmentModifier : public AbstractCellBasedSimulationModifier<DIM, DIM>
+class AttachmentModifier : public AbstractCellBasedSimulationModifier<DIM, DIM>,
+                           public AbstractSimulationComponent<DIM, DIM>,
+                           public AbstractSimulationContextUser
 {
 private:
 
@@ -53,8 +70,45 @@ private:
         archive & mDetachmentProbability;
         archive & mAttachmentHeight;
         archive & mOutputAttachmentDurations;
+        if (version > 0)
+        {
+            archive & mUseEventScheduling;
+        }
     }
     
+    // A scheduled attachment or detachment attempt, ordered by time step and then cell ID
+    // (the cell is held weakly, so that the queue does not keep dead cells alive)
+    struct AttachmentEvent
+    {
+        unsigned mTimeStep;
+        unsigned mCellId;
+        boost::weak_ptr<Cell> mpCell;
+        bool mWasAttached;
+        
+        bool operator>(const AttachmentEvent& rOther) const
+        {
+            return (mTimeStep > rOther.mTimeStep) || (mTimeStep == rOther.mTimeStep && mCellId > rOther.mCellId);
+        }
+    };
+    
+    // Attach a cell, recording the time if attachment durations are output
+    void AttachCell(AbstractCellPopulation<DIM,DIM>& rCellPopulation, CellPtr pCell, unsigned nodeIndex);
+    
+    // Detach a cell, writing out how long it was attached if attachment durations are output
+    void DetachCell(AbstractCellPopulation<DIM,DIM>& rCellPopulation, CellPtr pCell, unsigned nodeIndex);
+    
+    // Flip a coin for every cell, as in the original model
+    void UpdateCellStatesByCoinFlips(AbstractCellPopulation<DIM,DIM>& rCellPopulation);
+    
+    // Schedule the next attempt for a cell, from the given time step onwards
+    void ScheduleEvent(CellPtr pCell, bool isAttached, unsigned firstTimeStep, unsigned drawIndex);
+    
+    // Schedule the first attempt for every cell, replacing any events already queued
+    void ScheduleAllCells(AbstractCellPopulation<DIM,DIM>& rCellPopulation);
+    
+    // Schedule any cells born since the last call, then carry out the attempts that are due
+    void UpdateCellStatesByEvents(AbstractCellPopulation<DIM,DIM>& rCellPopulation);
+    
     
 protected: 
 
@@ -68,6 +122,30 @@ protected:
     
     out_stream mpAttachmentDurationsFile;
     
+    // Source of random numbers and time, not archived (given by OffLatticeSimulationUT in SetupSolve if not set)
+    boost::shared_ptr<UtericBudSimulationContext> mpSimulationContext;
+    
+    // Cell attributes by node index, not archived (a cache of the modifier's own unless shared)
+    boost::shared_ptr<CellAttributeCache<DIM> > mpCellAttributeCache;
+    
+    // Decides whether the population needs updating, not archived (the modifier always updates it unless given one)
+    boost::shared_ptr<PopulationUpdateCoordinator<DIM> > mpPopulationUpdateCoordinator;
+    
+    // Whether to sample the time step of each cell's next successful attempt, instead of flipping a coin for every cell on every time step
+    bool mUseEventScheduling;
+    
+    // The attempts scheduled when using events, not archived (rebuilt in SetupSolve)
+    std::priority_queue<AttachmentEvent, std::vector<AttachmentEvent>, std::greater<AttachmentEvent> > mEventQueue;
+    
+    // Whether every cell has been scheduled since the modifier was created or loaded
+    bool mIsEventQueueInitialised;
+    
+    // The highest cell ID scheduled so far, above which cells are newly born
+    unsigned mMaxScheduledCellId;
+    
+    // The number of scheduled attempts carried out
+    unsigned mNumEventsProcessed;
+    
     
 public:
 
@@ -102,6 +180,28 @@ public:
     double GetSimIndex();
     
     void SetSimIndex(double index);
+    
+    void SetSimulationContext(boost::shared_ptr<UtericBudSimulationContext> pSimulationContext);
+    
+    boost::shared_ptr<UtericBudSimulationContext> GetSimulationContext() const;
+    
+    void SetCellAttributeCache(boost::shared_ptr<CellAttributeCache<DIM> > pCellAttributeCache);
+    
+    boost::shared_ptr<CellAttributeCache<DIM> > GetCellAttributeCache();
+    
+    void SetPopulationUpdateCoordinator(boost::shared_ptr<PopulationUpdateCoordinator<DIM> > pPopulationUpdateCoordinator);
+    
+    boost::shared_ptr<PopulationUpdateCoordinator<DIM> > GetPopulationUpdateCoordinator();
+
+    void ConnectToSimulation(boost::shared_ptr<CellAttributeCache<DIM> > pCellAttributeCache,
+                             boost::shared_ptr<PopulationUpdateCoordinator<DIM> > pPopulationUpdateCoordinator,
+                             unsigned numForceThreads);
+    
+    void SetUseEventScheduling(bool useEventScheduling);
+    
+    bool GetUseEventScheduling();
+    
+    unsigned GetNumEventsProcessed();
 
     void OutputSimulationModifierParameters(out_stream& rParamsFile);
 };
@@ -109,4 +209,21 @@ public:
 #include "SerializationExportWrapper.hpp"
 EXPORT_TEMPLATE_CLASS_SAME_DIMS(AttachmentModifier)
 
+namespace boost
+{
+namespace serialization
+{
+/**
+ * The archive version of AttachmentModifier. Version 1 adds whether to use event scheduling.
+ */
+template<unsigned DIM>
+struct version<AttachmentModifier<DIM> >
+{
+    typedef mpl::int_<1> type;
+    typedef mpl::integral_c_tag tag;
+    BOOST_STATIC_CONSTANT(int, value = version::type::value);
+};
+}
+} // namespace
 
+#endif /*ATTACHMENTMODIFIER_HPP_*/
@@ -65,7 +65,15 @@ void ChemTrackingModifier<DIM>::SetupSolve(AbstractCellPopulation<DIM,DIM>& rCel
 template<unsigned DIM>
 void ChemTrackingModifier<DIM>::UpdateCellData(AbstractCellPopulation<DIM,DIM>& rCellPopulation)
 {
-    rCellPopulation.Update();
+    // Only the cell locations are read, so the population need not be updated again after the nodes move
+    if (mpPopulationUpdateCoordinator)
+    {
+        mpPopulationUpdateCoordinator->RequestUpdate(rCellPopulation, CELL_LOCATION_MAPS_NEED);
+    }
+    else
+    {
+        rCellPopulation.Update();
+    }
     
     for (typename AbstractCellPopulation<DIM>::Iterator cell_iter = rCellPopulation.Begin();
          cell_iter != rCellPopulation.End();
@@ -150,6 +158,29 @@ double ChemTrackingModifier<DIM>::GetConcBParameter()
     return mConcBParameter;
 }
 
+template<unsigned DIM>
+void ChemTrackingModifier<DIM>::SetPopulationUpdateCoordinator(boost::shared_ptr<PopulationUpdateCoordinator<DIM> > pPopulationUpdateCoordinator)
+{
+    mpPopulationUpdateCoordinator = pPopulationUpdateCoordinator;
+}
+
+template<unsigned DIM>
+boost::shared_ptr<PopulationUpdateCoordinator<DIM> > ChemTrackingModifier<DIM>::GetPopulationUpdateCoordinator()
+{
+    return mpPopulationUpdateCoordinator;
+}
+
+template<unsigned DIM>
+void ChemTrackingModifier<DIM>::ConnectToSimulation(boost::shared_ptr<CellAttributeCache<DIM> > pCellAttributeCache,
+                                                    boost::shared_ptr<PopulationUpdateCoordinator<DIM> > pPopulationUpdateCoordinator,
+                                                    unsigned numForceThreads)
+{
+    if (!mpPopulationUpdateCoordinator)
+    {
+        SetPopulationUpdateCoordinator(pPopulationUpdateCoordinator);
+    }
+}
+
 template<unsigned DIM>
 void ChemTrackingModifier<DIM>::OutputSimulationModifierParameters(out_stream& rParamsFile)
 {
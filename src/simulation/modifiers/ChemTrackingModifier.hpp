@@ -37,9 +37,12 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/serialization/base_object.hpp>
 
 #include "AbstractCellBasedSimulationModifier.hpp"
+#include "PopulationUpdateCoordinator.hpp"
+#include "AbstractSimulationComponent.hpp"
 
 template<unsigned DIM>
-class ChemTrackingModifier : public AbstractCellBasedSimulationModifier<DIM,DIM>
+class ChemTrackingModifier : public AbstractCellBasedSimulationModifier<DIM,DIM>,
+                             public AbstractSimulationComponent<DIM,DIM>
 {
     friend class boost::serialization::access;
 
@@ -57,6 +60,9 @@ protected:
     
     double mConcBParameter;
     
+    // Decides whether the population needs updating, not archived (the modifier always updates it unless given one)
+    boost::shared_ptr<PopulationUpdateCoordinator<DIM> > mpPopulationUpdateCoordinator;
+    
 
 public:
 
@@ -77,6 +83,14 @@ public:
     void SetConcBParameter(double concBParameter);
 
     double GetConcBParameter();
+    
+    void SetPopulationUpdateCoordinator(boost::shared_ptr<PopulationUpdateCoordinator<DIM> > pPopulationUpdateCoordinator);
+    
+    boost::shared_ptr<PopulationUpdateCoordinator<DIM> > GetPopulationUpdateCoordinator();
+
+    void ConnectToSimulation(boost::shared_ptr<CellAttributeCache<DIM> > pCellAttributeCache,
+                             boost::shared_ptr<PopulationUpdateCoordinator<DIM> > pPopulationUpdateCoordinator,
+                             unsigned numForceThreads);
 
     void OutputSimulationModifierParameters(out_stream& rParamsFile);
 };
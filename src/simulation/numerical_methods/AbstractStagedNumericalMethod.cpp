@@ -0,0 +1,111 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "AbstractStagedNumericalMethod.hpp"
+#include "AbstractStochasticForce.hpp"
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+AbstractStagedNumericalMethod<ELEMENT_DIM,SPACE_DIM>::AbstractStagedNumericalMethod()
+    : AbstractNumericalMethod<ELEMENT_DIM,SPACE_DIM>()
+{
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+AbstractStagedNumericalMethod<ELEMENT_DIM,SPACE_DIM>::~AbstractStagedNumericalMethod()
+{
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void AbstractStagedNumericalMethod<ELEMENT_DIM,SPACE_DIM>::SetNoiseFrozen(bool noiseFrozen)
+{
+    for (typename std::vector<boost::shared_ptr<AbstractForce<ELEMENT_DIM, SPACE_DIM> > >::iterator iter = this->mpForceCollection->begin();
+         iter != this->mpForceCollection->end();
+         ++iter)
+    {
+        AbstractStochasticForce<ELEMENT_DIM,SPACE_DIM>* p_stochastic_force = dynamic_cast<AbstractStochasticForce<ELEMENT_DIM,SPACE_DIM>*>(iter->get());
+        if (p_stochastic_force)
+        {
+            p_stochastic_force->SetNoiseFrozen(noiseFrozen);
+        }
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void AbstractStagedNumericalMethod<ELEMENT_DIM,SPACE_DIM>::MoveNodesToStage(const std::vector<c_vector<double, SPACE_DIM> >& rInitialLocations,
+                                                                           const std::vector<c_vector<double, SPACE_DIM> >& rVelocities,
+                                                                           double dt)
+{
+    unsigned index = 0;
+    for (typename AbstractMesh<ELEMENT_DIM, SPACE_DIM>::NodeIterator node_iter = this->mpCellPopulation->rGetMesh().GetNodeIteratorBegin();
+         node_iter != this->mpCellPopulation->rGetMesh().GetNodeIteratorEnd();
+         ++node_iter, ++index)
+    {
+        c_vector<double, SPACE_DIM> stage_location = rInitialLocations[index] + dt*rVelocities[index];
+        this->SafeNodePositionUpdate(node_iter->GetIndex(), stage_location);
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void AbstractStagedNumericalMethod<ELEMENT_DIM,SPACE_DIM>::CompleteStep(const std::vector<c_vector<double, SPACE_DIM> >& rInitialLocations,
+                                                                       const std::vector<c_vector<double, SPACE_DIM> >& rVelocities,
+                                                                       double dt)
+{
+    unsigned index = 0;
+    for (typename AbstractMesh<ELEMENT_DIM, SPACE_DIM>::NodeIterator node_iter = this->mpCellPopulation->rGetMesh().GetNodeIteratorBegin();
+         node_iter != this->mpCellPopulation->rGetMesh().GetNodeIteratorEnd();
+         ++node_iter, ++index)
+    {
+        unsigned node_index = node_iter->GetIndex();
+
+        c_vector<double, SPACE_DIM> displacement = dt*rVelocities[index];
+        this->DetectStepSizeExceptions(node_index, displacement, dt);
+
+        c_vector<double, SPACE_DIM> new_location = rInitialLocations[index] + displacement;
+        this->SafeNodePositionUpdate(node_index, new_location);
+
+        // Record the force that would have produced this velocity, for velocity output
+        c_vector<double, SPACE_DIM> effective_force = rVelocities[index]*this->mpCellPopulation->GetDampingConstant(node_index);
+        node_iter->ClearAppliedForce();
+        node_iter->AddAppliedForceContribution(effective_force);
+    }
+}
+
+// Explicit instantiation
+template class AbstractStagedNumericalMethod<1,1>;
+template class AbstractStagedNumericalMethod<1,2>;
+template class AbstractStagedNumericalMethod<2,2>;
+template class AbstractStagedNumericalMethod<1,3>;
+template class AbstractStagedNumericalMethod<2,3>;
+template class AbstractStagedNumericalMethod<3,3>;
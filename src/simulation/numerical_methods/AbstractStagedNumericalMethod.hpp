@@ -0,0 +1,129 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef ABSTRACTSTAGEDNUMERICALMETHOD_HPP_
+#define ABSTRACTSTAGEDNUMERICALMETHOD_HPP_
+
+#include <vector>
+
+#include "AbstractNumericalMethod.hpp"
+
+#include "ChasteSerialization.hpp"
+#include "ClassIsAbstract.hpp"
+#include <boost/serialization/base_object.hpp>
+
+/**
+ * An abstract numerical method for schemes that evaluate the forces more than once
+ * per time step, such as Runge-Kutta methods.
+ *
+ * Provides helpers to move the nodes to an intermediate stage and to complete the
+ * step from an effective velocity. Stochastic forces (AbstractStochasticForce) are told
+ * to reuse their random numbers after the first stage, so each time step sees a single
+ * noise increment, as with the forward Euler method. This is why the staged methods are
+ * used in place of Chaste's RK4NumericalMethod and BackwardEulerNumericalMethod, which
+ * evaluate the forces several times per step with no way to hold the noise, so that
+ * BasicDiffusionForce would draw a new increment at every evaluation.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM=ELEMENT_DIM>
+class AbstractStagedNumericalMethod : public AbstractNumericalMethod<ELEMENT_DIM,SPACE_DIM>
+{
+private:
+
+    /** Needed for serialization. */
+    friend class boost::serialization::access;
+    /**
+     * Archive the object and its member variables.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void serialize(Archive & archive, const unsigned int version)
+    {
+        archive & boost::serialization::base_object<AbstractNumericalMethod<ELEMENT_DIM,SPACE_DIM> >(*this);
+    }
+
+protected:
+
+    /**
+     * Tell any stochastic forces whether to reuse the random numbers from their
+     * previous evaluation.
+     *
+     * @param noiseFrozen whether to reuse the random numbers
+     */
+    void SetNoiseFrozen(bool noiseFrozen);
+
+    /**
+     * Move every node to rInitialLocations + dt*rVelocities. No step size checks are
+     * made, as the stage positions are only used to evaluate the forces.
+     *
+     * @param rInitialLocations the node locations at the start of the step, in mesh order
+     * @param rVelocities the velocities, in mesh order
+     * @param dt the distance along the velocities to move
+     */
+    void MoveNodesToStage(const std::vector<c_vector<double, SPACE_DIM> >& rInitialLocations,
+                          const std::vector<c_vector<double, SPACE_DIM> >& rVelocities,
+                          double dt);
+
+    /**
+     * Complete the step by moving every node to rInitialLocations + dt*rVelocities,
+     * checking the step size as the forward Euler method does. The applied force on
+     * each node is set to the effective velocity times the damping constant, so that
+     * cell velocities are output correctly.
+     *
+     * @param rInitialLocations the node locations at the start of the step, in mesh order
+     * @param rVelocities the effective velocities over the step, in mesh order
+     * @param dt the time step
+     */
+    void CompleteStep(const std::vector<c_vector<double, SPACE_DIM> >& rInitialLocations,
+                      const std::vector<c_vector<double, SPACE_DIM> >& rVelocities,
+                      double dt);
+
+public:
+
+    /**
+     * Constructor.
+     */
+    AbstractStagedNumericalMethod();
+
+    /**
+     * Destructor.
+     */
+    virtual ~AbstractStagedNumericalMethod();
+};
+
+TEMPLATED_CLASS_IS_ABSTRACT_2_UNSIGNED(AbstractStagedNumericalMethod)
+
+#endif /*ABSTRACTSTAGEDNUMERICALMETHOD_HPP_*/
@@ -0,0 +1,117 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "SemiImplicitEulerNumericalMethod.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+SemiImplicitEulerNumericalMethod<ELEMENT_DIM,SPACE_DIM>::SemiImplicitEulerNumericalMethod()
+    : AbstractStagedNumericalMethod<ELEMENT_DIM,SPACE_DIM>(),
+      mSecantTolerance(1e-12)
+{
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+SemiImplicitEulerNumericalMethod<ELEMENT_DIM,SPACE_DIM>::~SemiImplicitEulerNumericalMethod()
+{
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void SemiImplicitEulerNumericalMethod<ELEMENT_DIM,SPACE_DIM>::UpdateAllNodePositions(double dt)
+{
+    // Draw a new noise increment for this step, then hold it for the secant evaluation
+    this->SetNoiseFrozen(false);
+    std::vector<c_vector<double, SPACE_DIM> > initial_locations = this->SaveCurrentLocations();
+    std::vector<c_vector<double, SPACE_DIM> > f0 = this->ComputeForcesIncludingDamping();
+    this->SetNoiseFrozen(true);
+
+    // Evaluate the forces at the forward Euler prediction
+    this->MoveNodesToStage(initial_locations, f0, dt);
+    std::vector<c_vector<double, SPACE_DIM> > f1 = this->ComputeForcesIncludingDamping();
+    this->SetNoiseFrozen(false);
+
+    std::vector<c_vector<double, SPACE_DIM> > velocities(f0.size());
+    for (unsigned i=0; i<f0.size(); i++)
+    {
+        for (unsigned d=0; d<SPACE_DIM; d++)
+        {
+            // Secant estimate of the diagonal Jacobian entry, keeping only the stabilising part
+            double delta_x = dt*f0[i][d];
+            double jacobian = 0.0;
+            if (fabs(delta_x) > mSecantTolerance)
+            {
+                jacobian = std::min(0.0, (f1[i][d] - f0[i][d])/delta_x);
+            }
+            velocities[i][d] = f0[i][d]/(1.0 - dt*jacobian);
+        }
+    }
+    this->CompleteStep(initial_locations, velocities, dt);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+double SemiImplicitEulerNumericalMethod<ELEMENT_DIM,SPACE_DIM>::GetSecantTolerance()
+{
+    return mSecantTolerance;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void SemiImplicitEulerNumericalMethod<ELEMENT_DIM,SPACE_DIM>::SetSecantTolerance(double secantTolerance)
+{
+    assert(secantTolerance > 0.0);
+    mSecantTolerance = secantTolerance;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void SemiImplicitEulerNumericalMethod<ELEMENT_DIM,SPACE_DIM>::OutputNumericalMethodParameters(out_stream& rParamsFile)
+{
+    *rParamsFile << "\t\t\t<SecantTolerance>" << mSecantTolerance << "</SecantTolerance>\n";
+
+    // Call method on direct parent class
+    AbstractStagedNumericalMethod<ELEMENT_DIM,SPACE_DIM>::OutputNumericalMethodParameters(rParamsFile);
+}
+
+// Explicit instantiation
+template class SemiImplicitEulerNumericalMethod<1,1>;
+template class SemiImplicitEulerNumericalMethod<1,2>;
+template class SemiImplicitEulerNumericalMethod<2,2>;
+template class SemiImplicitEulerNumericalMethod<1,3>;
+template class SemiImplicitEulerNumericalMethod<2,3>;
+template class SemiImplicitEulerNumericalMethod<3,3>;
+
+// Serialization for Boost >= 1.36
+#include "SerializationExportWrapperForCpp.hpp"
+EXPORT_TEMPLATE_CLASS_ALL_DIMS(SemiImplicitEulerNumericalMethod)
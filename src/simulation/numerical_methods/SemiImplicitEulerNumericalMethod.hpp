@@ -0,0 +1,131 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef SEMIIMPLICITEULERNUMERICALMETHOD_HPP_
+#define SEMIIMPLICITEULERNUMERICALMETHOD_HPP_
+
+#include "AbstractStagedNumericalMethod.hpp"
+
+#include "ChasteSerialization.hpp"
+#include <boost/serialization/base_object.hpp>
+
+/**
+ * A linearised backward Euler method for the overdamped equations of motion
+ * dx/dt = f(x), using a diagonal approximation to the Jacobian.
+ *
+ * A backward Euler step linearised about the start of the step is
+ *
+ *     x_{n+1} = x_n + dt (I - dt J)^{-1} f(x_n).
+ *
+ * Forming J for a general force collection would mean differentiating every force,
+ * so instead each component of J is estimated by a secant along the forward Euler
+ * step: the forces are evaluated again at x_n + dt f(x_n), and the change in each
+ * velocity component divided by the change in the corresponding coordinate. This
+ * measures the stiffness of exactly the motion that makes the explicit step unstable.
+ * Only negative (stabilising) estimates are used, so the method never takes a larger
+ * step than forward Euler, and reduces to it where the forces are not stiff.
+ *
+ * The step costs two force evaluations.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM=ELEMENT_DIM>
+class SemiImplicitEulerNumericalMethod : public AbstractStagedNumericalMethod<ELEMENT_DIM,SPACE_DIM>
+{
+private:
+
+    /** Needed for serialization. */
+    friend class boost::serialization::access;
+    /**
+     * Archive the object and its member variables.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void serialize(Archive & archive, const unsigned int version)
+    {
+        archive & boost::serialization::base_object<AbstractStagedNumericalMethod<ELEMENT_DIM,SPACE_DIM> >(*this);
+        archive & mSecantTolerance;
+    }
+
+    /**
+     * Coordinate changes smaller than this are treated as no change when forming the
+     * secant estimates, and the corresponding Jacobian entry taken to be zero.
+     * Defaults to 1e-12.
+     */
+    double mSecantTolerance;
+
+public:
+
+    /**
+     * Constructor.
+     */
+    SemiImplicitEulerNumericalMethod();
+
+    /**
+     * Destructor.
+     */
+    virtual ~SemiImplicitEulerNumericalMethod();
+
+    /**
+     * Overridden UpdateAllNodePositions() method.
+     *
+     * @param dt Time step size
+     */
+    virtual void UpdateAllNodePositions(double dt);
+
+    /**
+     * @return mSecantTolerance
+     */
+    double GetSecantTolerance();
+
+    /**
+     * Set mSecantTolerance.
+     *
+     * @param secantTolerance the new value of mSecantTolerance
+     */
+    void SetSecantTolerance(double secantTolerance);
+
+    /**
+     * Overridden OutputNumericalMethodParameters() method.
+     *
+     * @param rParamsFile the file stream to which the parameters are output
+     */
+    virtual void OutputNumericalMethodParameters(out_stream& rParamsFile);
+};
+
+#include "SerializationExportWrapper.hpp"
+EXPORT_TEMPLATE_CLASS_ALL_DIMS(SemiImplicitEulerNumericalMethod)
+
+#endif /*SEMIIMPLICITEULERNUMERICALMETHOD_HPP_*/
@@ -0,0 +1,202 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "AbstractStepSizeController.hpp"
+
+#include <algorithm>
+#include <cfloat>
+
+#include "Exception.hpp"
+
+AbstractStepSizeController::AbstractStepSizeController()
+    : mMinimumTimeStep(0.0),
+      mMaximumTimeStep(DBL_MAX),
+      mShrinkFactor(1.0),
+      mNumAcceptedSteps(0),
+      mNumRejectedSteps(0),
+      mMinimumAcceptedTimeStep(DBL_MAX),
+      mMaximumAcceptedTimeStep(0.0),
+      mSumOfAcceptedTimeSteps(0.0),
+      mRecordTimeStepHistory(false)
+{
+}
+
+AbstractStepSizeController::~AbstractStepSizeController()
+{
+}
+
+double AbstractStepSizeController::ClampTimeStep(double timeStep) const
+{
+    return std::max(mMinimumTimeStep, std::min(mMaximumTimeStep, timeStep));
+}
+
+double AbstractStepSizeController::GetInitialTimeStep(double targetTimeStep)
+{
+    return targetTimeStep;
+}
+
+double AbstractStepSizeController::ComputeRejectedTimeStep(double rejectedTimeStep, double suggestedTimeStep)
+{
+    if (rejectedTimeStep <= mMinimumTimeStep)
+    {
+        EXCEPTION("A step of the minimum size " << mMinimumTimeStep << " was rejected, so the step size cannot be reduced any further.");
+    }
+    return ClampTimeStep(std::min(suggestedTimeStep, mShrinkFactor*rejectedTimeStep));
+}
+
+bool AbstractStepSizeController::UsesErrorEstimate() const
+{
+    return false;
+}
+
+void AbstractStepSizeController::RecordAcceptedStep(double timeStep)
+{
+    mNumAcceptedSteps++;
+    mMinimumAcceptedTimeStep = std::min(mMinimumAcceptedTimeStep, timeStep);
+    mMaximumAcceptedTimeStep = std::max(mMaximumAcceptedTimeStep, timeStep);
+    mSumOfAcceptedTimeSteps += timeStep;
+    if (mRecordTimeStepHistory)
+    {
+        mTimeStepHistory.push_back(timeStep);
+    }
+}
+
+void AbstractStepSizeController::RecordRejectedStep()
+{
+    mNumRejectedSteps++;
+}
+
+void AbstractStepSizeController::ResetStatistics()
+{
+    mNumAcceptedSteps = 0;
+    mNumRejectedSteps = 0;
+    mMinimumAcceptedTimeStep = DBL_MAX;
+    mMaximumAcceptedTimeStep = 0.0;
+    mSumOfAcceptedTimeSteps = 0.0;
+    mTimeStepHistory.clear();
+}
+
+double AbstractStepSizeController::GetMinimumTimeStep() const
+{
+    return mMinimumTimeStep;
+}
+
+void AbstractStepSizeController::SetMinimumTimeStep(double minimumTimeStep)
+{
+    assert(minimumTimeStep >= 0.0);
+    mMinimumTimeStep = minimumTimeStep;
+}
+
+double AbstractStepSizeController::GetMaximumTimeStep() const
+{
+    return mMaximumTimeStep;
+}
+
+void AbstractStepSizeController::SetMaximumTimeStep(double maximumTimeStep)
+{
+    assert(maximumTimeStep > 0.0);
+    mMaximumTimeStep = maximumTimeStep;
+}
+
+double AbstractStepSizeController::GetShrinkFactor() const
+{
+    return mShrinkFactor;
+}
+
+void AbstractStepSizeController::SetShrinkFactor(double shrinkFactor)
+{
+    assert(shrinkFactor > 0.0 && shrinkFactor <= 1.0);
+    mShrinkFactor = shrinkFactor;
+}
+
+unsigned AbstractStepSizeController::GetNumAcceptedSteps() const
+{
+    return mNumAcceptedSteps;
+}
+
+unsigned AbstractStepSizeController::GetNumRejectedSteps() const
+{
+    return mNumRejectedSteps;
+}
+
+double AbstractStepSizeController::GetMinimumAcceptedTimeStep() const
+{
+    return mMinimumAcceptedTimeStep;
+}
+
+double AbstractStepSizeController::GetMaximumAcceptedTimeStep() const
+{
+    return mMaximumAcceptedTimeStep;
+}
+
+double AbstractStepSizeController::GetMeanAcceptedTimeStep() const
+{
+    if (mNumAcceptedSteps == 0)
+    {
+        return 0.0;
+    }
+    return mSumOfAcceptedTimeSteps/mNumAcceptedSteps;
+}
+
+bool AbstractStepSizeController::GetRecordTimeStepHistory() const
+{
+    return mRecordTimeStepHistory;
+}
+
+void AbstractStepSizeController::SetRecordTimeStepHistory(bool recordTimeStepHistory)
+{
+    mRecordTimeStepHistory = recordTimeStepHistory;
+}
+
+const std::vector<double>& AbstractStepSizeController::rGetTimeStepHistory() const
+{
+    return mTimeStepHistory;
+}
+
+void AbstractStepSizeController::OutputStepSizeControllerInfo(out_stream& rParamsFile)
+{
+    std::string controller_type = GetIdentifier();
+
+    *rParamsFile << "\t\t<" << controller_type << ">\n";
+    OutputStepSizeControllerParameters(rParamsFile);
+    *rParamsFile << "\t\t</" << controller_type << ">\n";
+}
+
+void AbstractStepSizeController::OutputStepSizeControllerParameters(out_stream& rParamsFile)
+{
+    *rParamsFile << "\t\t\t<MinimumTimeStep>" << mMinimumTimeStep << "</MinimumTimeStep>\n";
+    *rParamsFile << "\t\t\t<MaximumTimeStep>" << mMaximumTimeStep << "</MaximumTimeStep>\n";
+    *rParamsFile << "\t\t\t<ShrinkFactor>" << mShrinkFactor << "</ShrinkFactor>\n";
+}
@@ -0,0 +1,316 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef ABSTRACTSTEPSIZECONTROLLER_HPP_
+#define ABSTRACTSTEPSIZECONTROLLER_HPP_
+
+#include <algorithm>
+#include <vector>
+
+#include "ChasteSerialization.hpp"
+#include "ClassIsAbstract.hpp"
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
+
+#include "Identifiable.hpp"
+#include "OutputFileHandler.hpp"
+
+/**
+ * An abstract class for choosing the size of the substeps taken by OffLatticeSimulationUT
+ * when its numerical method has an adaptive time step.
+ *
+ * After each accepted substep the simulation passes the step taken and an error estimate
+ * to ComputeNextTimeStep(); after each rejected substep (a StepSizeException) it passes the
+ * step tried and the step suggested by the exception to ComputeRejectedTimeStep(). The error
+ * estimate is the largest node displacement over the substep as a fraction of the absolute
+ * movement threshold of the cell population, so an estimate of 1 means the substep was only
+ * just acceptable.
+ *
+ * The controller also keeps a count of accepted and rejected substeps, the smallest, largest
+ * and mean accepted substep and, optionally, a history of the accepted substep sizes. The
+ * history grows with every substep, so it is off by default and is not archived.
+ */
+class AbstractStepSizeController : public Identifiable
+{
+    /** Needed for serialization. */
+    friend class boost::serialization::access;
+    /**
+     * Archive the object and its member variables.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void serialize(Archive & archive, const unsigned int version)
+    {
+        archive & mMinimumTimeStep;
+        archive & mMaximumTimeStep;
+        archive & mShrinkFactor;
+        archive & mNumAcceptedSteps;
+        archive & mNumRejectedSteps;
+        if (version > 0)
+        {
+            archive & mMinimumAcceptedTimeStep;
+            archive & mMaximumAcceptedTimeStep;
+            archive & mSumOfAcceptedTimeSteps;
+            archive & mRecordTimeStepHistory;
+        }
+        else
+        {
+            // Version 0 archived the whole substep history, which is summarised and dropped
+            bool record_time_step_history;
+            std::vector<double> time_step_history;
+            archive & record_time_step_history;
+            archive & time_step_history;
+            for (unsigned i=0; i<time_step_history.size(); i++)
+            {
+                mMinimumAcceptedTimeStep = std::min(mMinimumAcceptedTimeStep, time_step_history[i]);
+                mMaximumAcceptedTimeStep = std::max(mMaximumAcceptedTimeStep, time_step_history[i]);
+                mSumOfAcceptedTimeSteps += time_step_history[i];
+            }
+        }
+    }
+
+protected:
+
+    /** The smallest substep the controller will choose. Defaults to 0. */
+    double mMinimumTimeStep;
+
+    /** The largest substep the controller will choose. Defaults to DBL_MAX. */
+    double mMaximumTimeStep;
+
+    /**
+     * The factor by which a rejected substep is at least reduced, whatever the
+     * StepSizeException suggests. Defaults to 1, so the suggestion is used as it is.
+     */
+    double mShrinkFactor;
+
+    /** The number of accepted substeps. */
+    unsigned mNumAcceptedSteps;
+
+    /** The number of rejected substeps. */
+    unsigned mNumRejectedSteps;
+
+    /** The smallest accepted substep. DBL_MAX until a substep is accepted. */
+    double mMinimumAcceptedTimeStep;
+
+    /** The largest accepted substep. 0 until a substep is accepted. */
+    double mMaximumAcceptedTimeStep;
+
+    /** The sum of the accepted substeps. */
+    double mSumOfAcceptedTimeSteps;
+
+    /** Whether to record the size of every accepted substep. Defaults to false. */
+    bool mRecordTimeStepHistory;
+
+    /**
+     * The size of every accepted substep since the history was switched on, in order.
+     * Not archived.
+     */
+    std::vector<double> mTimeStepHistory;
+
+    /**
+     * @return a time step restricted to lie between #mMinimumTimeStep and #mMaximumTimeStep.
+     *
+     * @param timeStep the time step
+     */
+    double ClampTimeStep(double timeStep) const;
+
+public:
+
+    /**
+     * Default constructor.
+     */
+    AbstractStepSizeController();
+
+    /**
+     * Destructor.
+     */
+    virtual ~AbstractStepSizeController();
+
+    /**
+     * @return the size of the first substep to try within a time step.
+     *
+     * By default this is the whole time step. Subclasses that keep track of a
+     * preferred step may start from that instead.
+     *
+     * @param targetTimeStep the time step of the simulation
+     */
+    virtual double GetInitialTimeStep(double targetTimeStep);
+
+    /**
+     * @return the size of the substep to try after an accepted one.
+     *
+     * @param acceptedTimeStep the substep just accepted
+     * @param errorEstimate the error estimate for that substep
+     */
+    virtual double ComputeNextTimeStep(double acceptedTimeStep, double errorEstimate)=0;
+
+    /**
+     * @return the size of the substep to try after a rejected one.
+     *
+     * This is the smaller of the step suggested by the StepSizeException and the
+     * rejected step times #mShrinkFactor. An exception is thrown if the rejected
+     * step was already the minimum.
+     *
+     * @param rejectedTimeStep the substep just rejected
+     * @param suggestedTimeStep the substep suggested by the StepSizeException
+     */
+    virtual double ComputeRejectedTimeStep(double rejectedTimeStep, double suggestedTimeStep);
+
+    /**
+     * @return whether ComputeNextTimeStep() makes use of its error estimate. If not,
+     * the simulation does not compute it.
+     */
+    virtual bool UsesErrorEstimate() const;
+
+    /**
+     * Record that a substep has been accepted.
+     *
+     * @param timeStep the substep
+     */
+    void RecordAcceptedStep(double timeStep);
+
+    /**
+     * Record that a substep has been rejected.
+     */
+    void RecordRejectedStep();
+
+    /**
+     * Reset the counts of accepted and rejected substeps, the summary of the accepted
+     * substeps and the substep history.
+     */
+    void ResetStatistics();
+
+    /**
+     * @return #mMinimumTimeStep
+     */
+    double GetMinimumTimeStep() const;
+
+    /**
+     * Set #mMinimumTimeStep.
+     *
+     * @param minimumTimeStep the new value of #mMinimumTimeStep
+     */
+    void SetMinimumTimeStep(double minimumTimeStep);
+
+    /**
+     * @return #mMaximumTimeStep
+     */
+    double GetMaximumTimeStep() const;
+
+    /**
+     * Set #mMaximumTimeStep.
+     *
+     * @param maximumTimeStep the new value of #mMaximumTimeStep
+     */
+    void SetMaximumTimeStep(double maximumTimeStep);
+
+    /**
+     * @return #mShrinkFactor
+     */
+    double GetShrinkFactor() const;
+
+    /**
+     * Set #mShrinkFactor.
+     *
+     * @param shrinkFactor the new value of #mShrinkFactor, in (0,1]
+     */
+    void SetShrinkFactor(double shrinkFactor);
+
+    /**
+     * @return #mNumAcceptedSteps
+     */
+    unsigned GetNumAcceptedSteps() const;
+
+    /**
+     * @return #mNumRejectedSteps
+     */
+    unsigned GetNumRejectedSteps() const;
+
+    /**
+     * @return #mMinimumAcceptedTimeStep
+     */
+    double GetMinimumAcceptedTimeStep() const;
+
+    /**
+     * @return #mMaximumAcceptedTimeStep
+     */
+    double GetMaximumAcceptedTimeStep() const;
+
+    /**
+     * @return the mean accepted substep, or 0 if no substep has been accepted.
+     */
+    double GetMeanAcceptedTimeStep() const;
+
+    /**
+     * @return #mRecordTimeStepHistory
+     */
+    bool GetRecordTimeStepHistory() const;
+
+    /**
+     * Set #mRecordTimeStepHistory.
+     *
+     * @param recordTimeStepHistory the new value of #mRecordTimeStepHistory
+     */
+    void SetRecordTimeStepHistory(bool recordTimeStepHistory);
+
+    /**
+     * @return #mTimeStepHistory
+     */
+    const std::vector<double>& rGetTimeStepHistory() const;
+
+    /**
+     * Output the controller type and its parameters to file.
+     *
+     * @param rParamsFile the file stream to which the parameters are output
+     */
+    void OutputStepSizeControllerInfo(out_stream& rParamsFile);
+
+    /**
+     * Output any parameters of the controller to file. Subclasses should call
+     * this method on their parent class after outputting their own parameters.
+     *
+     * @param rParamsFile the file stream to which the parameters are output
+     */
+    virtual void OutputStepSizeControllerParameters(out_stream& rParamsFile);
+};
+
+CLASS_IS_ABSTRACT(AbstractStepSizeController)
+
+/* Version 1 archives a summary of the accepted substeps instead of their history. */
+BOOST_CLASS_VERSION(AbstractStepSizeController, 1)
+
+#endif /*ABSTRACTSTEPSIZECONTROLLER_HPP_*/
@@ -0,0 +1,116 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef FIXEDGROWTHSTEPSIZECONTROLLER_HPP_
+#define FIXEDGROWTHSTEPSIZECONTROLLER_HPP_
+
+#include "AbstractStepSizeController.hpp"
+
+#include "ChasteSerialization.hpp"
+#include <boost/serialization/base_object.hpp>
+
+/**
+ * A step size controller that grows the substep by a fixed factor after every accepted
+ * substep, and otherwise only shrinks it in response to a StepSizeException.
+ *
+ * With the default growth of 1% this reproduces the behaviour OffLatticeSimulationUT
+ * had before step size controllers were introduced, and is used when no other
+ * controller has been set.
+ */
+class FixedGrowthStepSizeController : public AbstractStepSizeController
+{
+    /** Needed for serialization. */
+    friend class boost::serialization::access;
+    /**
+     * Archive the object and its member variables.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void serialize(Archive & archive, const unsigned int version)
+    {
+        archive & boost::serialization::base_object<AbstractStepSizeController>(*this);
+        archive & mGrowthFactor;
+    }
+
+    /**
+     * The fractional increase in the substep after each accepted substep.
+     * Defaults to 0.01.
+     */
+    double mGrowthFactor;
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param growthFactor the fractional increase in the substep after each accepted substep (defaults to 0.01)
+     */
+    FixedGrowthStepSizeController(double growthFactor=0.01);
+
+    /**
+     * Overridden ComputeNextTimeStep() method.
+     *
+     * @param acceptedTimeStep the substep just accepted
+     * @param errorEstimate the error estimate for that substep (not used)
+     * @return the substep increased by #mGrowthFactor
+     */
+    double ComputeNextTimeStep(double acceptedTimeStep, double errorEstimate);
+
+    /**
+     * @return #mGrowthFactor
+     */
+    double GetGrowthFactor() const;
+
+    /**
+     * Set #mGrowthFactor.
+     *
+     * @param growthFactor the new value of #mGrowthFactor
+     */
+    void SetGrowthFactor(double growthFactor);
+
+    /**
+     * Overridden OutputStepSizeControllerParameters() method.
+     *
+     * @param rParamsFile the file stream to which the parameters are output
+     */
+    void OutputStepSizeControllerParameters(out_stream& rParamsFile);
+};
+
+#include "SerializationExportWrapper.hpp"
+CHASTE_CLASS_EXPORT(FixedGrowthStepSizeController)
+
+#endif /*FIXEDGROWTHSTEPSIZECONTROLLER_HPP_*/
@@ -0,0 +1,161 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "PIStepSizeController.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+PIStepSizeController::PIStepSizeController(double targetError)
+    : AbstractStepSizeController(),
+      mTargetError(targetError),
+      mSafetyFactor(0.9),
+      mIntegralGain(0.3),
+      mProportionalGain(0.4),
+      mMinimumFactor(0.2),
+      mMaximumFactor(2.0),
+      mPreviousErrorRatio(1.0),
+      mPreferredTimeStep(DBL_MAX)
+{
+    assert(mTargetError > 0.0);
+}
+
+double PIStepSizeController::GetInitialTimeStep(double targetTimeStep)
+{
+    return std::min(targetTimeStep, mPreferredTimeStep);
+}
+
+double PIStepSizeController::ComputeNextTimeStep(double acceptedTimeStep, double errorEstimate)
+{
+    double factor = mMaximumFactor;
+
+    // A substep in which nothing moved gives no information, other than that the substep may grow
+    double error_ratio = errorEstimate/mTargetError;
+    if (error_ratio > DBL_EPSILON)
+    {
+        factor = mSafetyFactor*pow(error_ratio, -mIntegralGain)*pow(mPreviousErrorRatio/error_ratio, mProportionalGain);
+        factor = std::max(mMinimumFactor, std::min(mMaximumFactor, factor));
+        mPreviousErrorRatio = error_ratio;
+    }
+
+    mPreferredTimeStep = ClampTimeStep(factor*acceptedTimeStep);
+    return mPreferredTimeStep;
+}
+
+double PIStepSizeController::ComputeRejectedTimeStep(double rejectedTimeStep, double suggestedTimeStep)
+{
+    mPreferredTimeStep = AbstractStepSizeController::ComputeRejectedTimeStep(rejectedTimeStep, suggestedTimeStep);
+    return mPreferredTimeStep;
+}
+
+bool PIStepSizeController::UsesErrorEstimate() const
+{
+    return true;
+}
+
+double PIStepSizeController::GetTargetError() const
+{
+    return mTargetError;
+}
+
+void PIStepSizeController::SetTargetError(double targetError)
+{
+    assert(targetError > 0.0);
+    mTargetError = targetError;
+}
+
+double PIStepSizeController::GetSafetyFactor() const
+{
+    return mSafetyFactor;
+}
+
+void PIStepSizeController::SetSafetyFactor(double safetyFactor)
+{
+    assert(safetyFactor > 0.0 && safetyFactor <= 1.0);
+    mSafetyFactor = safetyFactor;
+}
+
+double PIStepSizeController::GetIntegralGain() const
+{
+    return mIntegralGain;
+}
+
+double PIStepSizeController::GetProportionalGain() const
+{
+    return mProportionalGain;
+}
+
+void PIStepSizeController::SetGains(double integralGain, double proportionalGain)
+{
+    assert(integralGain >= 0.0);
+    assert(proportionalGain >= 0.0);
+    mIntegralGain = integralGain;
+    mProportionalGain = proportionalGain;
+}
+
+double PIStepSizeController::GetMinimumFactor() const
+{
+    return mMinimumFactor;
+}
+
+double PIStepSizeController::GetMaximumFactor() const
+{
+    return mMaximumFactor;
+}
+
+void PIStepSizeController::SetFactorLimits(double minimumFactor, double maximumFactor)
+{
+    assert(minimumFactor > 0.0 && minimumFactor <= 1.0);
+    assert(maximumFactor >= 1.0);
+    mMinimumFactor = minimumFactor;
+    mMaximumFactor = maximumFactor;
+}
+
+void PIStepSizeController::OutputStepSizeControllerParameters(out_stream& rParamsFile)
+{
+    *rParamsFile << "\t\t\t<TargetError>" << mTargetError << "</TargetError>\n";
+    *rParamsFile << "\t\t\t<SafetyFactor>" << mSafetyFactor << "</SafetyFactor>\n";
+    *rParamsFile << "\t\t\t<IntegralGain>" << mIntegralGain << "</IntegralGain>\n";
+    *rParamsFile << "\t\t\t<ProportionalGain>" << mProportionalGain << "</ProportionalGain>\n";
+    *rParamsFile << "\t\t\t<MinimumFactor>" << mMinimumFactor << "</MinimumFactor>\n";
+    *rParamsFile << "\t\t\t<MaximumFactor>" << mMaximumFactor << "</MaximumFactor>\n";
+
+    // Call method on direct parent class
+    AbstractStepSizeController::OutputStepSizeControllerParameters(rParamsFile);
+}
+
+#include "SerializationExportWrapperForCpp.hpp"
+CHASTE_CLASS_EXPORT(PIStepSizeController)
@@ -0,0 +1,224 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PISTEPSIZECONTROLLER_HPP_
+#define PISTEPSIZECONTROLLER_HPP_
+
+#include "AbstractStepSizeController.hpp"
+
+#include "ChasteSerialization.hpp"
+#include <boost/serialization/base_object.hpp>
+
+/**
+ * A proportional-integral (PI) step size controller.
+ *
+ * After each accepted substep the ratio r_n of the error estimate to #mTargetError is
+ * formed and the substep is scaled by
+ *
+ *     safety * r_n^(-kI) * (r_{n-1}/r_n)^(kP),
+ *
+ * restricted to lie between #mMinimumFactor and #mMaximumFactor. The integral term drives
+ * the error towards the target; the proportional term damps the oscillation between
+ * growing and shrinking that a purely integral controller shows near the stability limit.
+ *
+ * The controller remembers the substep it last proposed and starts each time step from
+ * it, so a large simulation time step can be used and the controller left to find the
+ * largest stable substep.
+ */
+class PIStepSizeController : public AbstractStepSizeController
+{
+    /** Needed for serialization. */
+    friend class boost::serialization::access;
+    /**
+     * Archive the object and its member variables.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void serialize(Archive & archive, const unsigned int version)
+    {
+        archive & boost::serialization::base_object<AbstractStepSizeController>(*this);
+        archive & mTargetError;
+        archive & mSafetyFactor;
+        archive & mIntegralGain;
+        archive & mProportionalGain;
+        archive & mMinimumFactor;
+        archive & mMaximumFactor;
+        archive & mPreviousErrorRatio;
+        archive & mPreferredTimeStep;
+    }
+
+    /**
+     * The error estimate aimed for, as a fraction of the absolute movement
+     * threshold. Defaults to 0.5.
+     */
+    double mTargetError;
+
+    /** The safety factor applied to each new substep. Defaults to 0.9. */
+    double mSafetyFactor;
+
+    /** The integral gain kI. Defaults to 0.3. */
+    double mIntegralGain;
+
+    /** The proportional gain kP. Defaults to 0.4. */
+    double mProportionalGain;
+
+    /** The smallest factor by which an accepted substep is scaled. Defaults to 0.2. */
+    double mMinimumFactor;
+
+    /** The largest factor by which an accepted substep is scaled. Defaults to 2. */
+    double mMaximumFactor;
+
+    /** The error ratio r_{n-1} of the previous accepted substep. */
+    double mPreviousErrorRatio;
+
+    /** The substep the controller last proposed. */
+    double mPreferredTimeStep;
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param targetError the error estimate aimed for (defaults to 0.5)
+     */
+    PIStepSizeController(double targetError=0.5);
+
+    /**
+     * Overridden GetInitialTimeStep() method.
+     *
+     * @param targetTimeStep the time step of the simulation
+     * @return the smaller of the time step of the simulation and the last proposed substep
+     */
+    double GetInitialTimeStep(double targetTimeStep);
+
+    /**
+     * Overridden ComputeNextTimeStep() method.
+     *
+     * @param acceptedTimeStep the substep just accepted
+     * @param errorEstimate the error estimate for that substep
+     * @return the next substep to try
+     */
+    double ComputeNextTimeStep(double acceptedTimeStep, double errorEstimate);
+
+    /**
+     * Overridden ComputeRejectedTimeStep() method.
+     *
+     * @param rejectedTimeStep the substep just rejected
+     * @param suggestedTimeStep the substep suggested by the StepSizeException
+     * @return the next substep to try
+     */
+    double ComputeRejectedTimeStep(double rejectedTimeStep, double suggestedTimeStep);
+
+    /**
+     * Overridden UsesErrorEstimate() method.
+     *
+     * @return true
+     */
+    bool UsesErrorEstimate() const;
+
+    /**
+     * @return #mTargetError
+     */
+    double GetTargetError() const;
+
+    /**
+     * Set #mTargetError.
+     *
+     * @param targetError the new value of #mTargetError
+     */
+    void SetTargetError(double targetError);
+
+    /**
+     * @return #mSafetyFactor
+     */
+    double GetSafetyFactor() const;
+
+    /**
+     * Set #mSafetyFactor.
+     *
+     * @param safetyFactor the new value of #mSafetyFactor
+     */
+    void SetSafetyFactor(double safetyFactor);
+
+    /**
+     * @return #mIntegralGain
+     */
+    double GetIntegralGain() const;
+
+    /**
+     * @return #mProportionalGain
+     */
+    double GetProportionalGain() const;
+
+    /**
+     * Set the controller gains.
+     *
+     * @param integralGain the new value of #mIntegralGain
+     * @param proportionalGain the new value of #mProportionalGain
+     */
+    void SetGains(double integralGain, double proportionalGain);
+
+    /**
+     * @return #mMinimumFactor
+     */
+    double GetMinimumFactor() const;
+
+    /**
+     * @return #mMaximumFactor
+     */
+    double GetMaximumFactor() const;
+
+    /**
+     * Set the limits on the factor by which an accepted substep is scaled.
+     *
+     * @param minimumFactor the new value of #mMinimumFactor
+     * @param maximumFactor the new value of #mMaximumFactor
+     */
+    void SetFactorLimits(double minimumFactor, double maximumFactor);
+
+    /**
+     * Overridden OutputStepSizeControllerParameters() method.
+     *
+     * @param rParamsFile the file stream to which the parameters are output
+     */
+    void OutputStepSizeControllerParameters(out_stream& rParamsFile);
+};
+
+#include "SerializationExportWrapper.hpp"
+CHASTE_CLASS_EXPORT(PIStepSizeController)
+
+#endif /*PISTEPSIZECONTROLLER_HPP_*/
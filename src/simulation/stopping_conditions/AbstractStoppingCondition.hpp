@@ -0,0 +1,150 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef ABSTRACTSTOPPINGCONDITION_HPP_
+#define ABSTRACTSTOPPINGCONDITION_HPP_
+
+#include <string>
+
+#include "AbstractCellPopulation.hpp"
+#include "Identifiable.hpp"
+#include "OutputFileHandler.hpp"
+#include "UtericBudSimulationContext.hpp"
+
+#include "ChasteSerialization.hpp"
+#include "ClassIsAbstract.hpp"
+
+/**
+ * An abstract condition under which a simulation should stop early.
+ *
+ * Stopping conditions are registered with OffLatticeSimulationWithStopUT, which asks
+ * each of them in turn at the end of every time step whether the simulation should
+ * stop. They are expected to work from data that is already to hand, such as the
+ * number of nodes or the cell property counts, rather than by looping over the cells.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM=ELEMENT_DIM>
+class AbstractStoppingCondition : public Identifiable
+{
+private:
+
+    /** Needed for serialization. */
+    friend class boost::serialization::access;
+    /**
+     * Archive the object and its member variables.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void serialize(Archive & archive, const unsigned int version)
+    {
+    }
+
+protected:
+
+    /** A description of why the condition was met, set when HasOccurred() first returns true. */
+    std::string mStoppingReason;
+
+    /**
+     * The source of the time, given by OffLatticeSimulationWithStopUT in SetupSolve().
+     * Not archived.
+     */
+    boost::shared_ptr<UtericBudSimulationContext> mpSimulationContext;
+
+public:
+
+    /**
+     * Default constructor.
+     */
+    AbstractStoppingCondition();
+
+    /**
+     * Destructor.
+     */
+    virtual ~AbstractStoppingCondition();
+
+    /**
+     * Called once at the start of the simulation. By default does nothing.
+     *
+     * @param rCellPopulation reference to the cell population
+     */
+    virtual void SetupSolve(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
+    /**
+     * @return whether the simulation should stop. Called at the end of every time step.
+     *
+     * As this method is pure virtual, it must be overridden in subclasses.
+     *
+     * @param rCellPopulation reference to the cell population
+     */
+    virtual bool HasOccurred(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)=0;
+
+    /**
+     * @return #mStoppingReason
+     */
+    const std::string& rGetStoppingReason() const;
+
+    /**
+     * Set #mpSimulationContext.
+     *
+     * @param pSimulationContext the source of the time
+     */
+    void SetSimulationContext(boost::shared_ptr<UtericBudSimulationContext> pSimulationContext);
+
+    /**
+     * @return #mpSimulationContext
+     */
+    boost::shared_ptr<UtericBudSimulationContext> GetSimulationContext() const;
+
+    /**
+     * Output the condition type and its parameters to file.
+     *
+     * @param rParamsFile the file stream to which the parameters are output
+     */
+    void OutputStoppingConditionInfo(out_stream& rParamsFile);
+
+    /**
+     * Output any parameters of the condition to file.
+     *
+     * As this method is pure virtual, it must be overridden in subclasses.
+     *
+     * @param rParamsFile the file stream to which the parameters are output
+     */
+    virtual void OutputStoppingConditionParameters(out_stream& rParamsFile)=0;
+};
+
+TEMPLATED_CLASS_IS_ABSTRACT_2_UNSIGNED(AbstractStoppingCondition)
+
+#endif /*ABSTRACTSTOPPINGCONDITION_HPP_*/
@@ -0,0 +1,120 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ExtinctionStoppingCondition.hpp"
+
+#include <algorithm>
+
+#include "TransitCellProliferativeType.hpp"
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+ExtinctionStoppingCondition<ELEMENT_DIM,SPACE_DIM>::ExtinctionStoppingCondition()
+    : AbstractStoppingCondition<ELEMENT_DIM,SPACE_DIM>(),
+      mHasFoundTransitTypes(false)
+{
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned ExtinctionStoppingCondition<ELEMENT_DIM,SPACE_DIM>::FindTransitTypes(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    unsigned num_transit_cells = 0;
+    for (typename AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>::Iterator cell_iter = rCellPopulation.Begin();
+         cell_iter != rCellPopulation.End();
+         ++cell_iter)
+    {
+        boost::shared_ptr<AbstractCellProperty> p_type = cell_iter->GetCellProliferativeType();
+        if (p_type->IsType<TransitCellProliferativeType>())
+        {
+            num_transit_cells++;
+            if (std::find(mTransitTypes.begin(), mTransitTypes.end(), p_type) == mTransitTypes.end())
+            {
+                mTransitTypes.push_back(p_type);
+            }
+        }
+    }
+    mHasFoundTransitTypes = true;
+    return num_transit_cells;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ExtinctionStoppingCondition<ELEMENT_DIM,SPACE_DIM>::SetupSolve(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    FindTransitTypes(rCellPopulation);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool ExtinctionStoppingCondition<ELEMENT_DIM,SPACE_DIM>::HasOccurred(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    if (!mHasFoundTransitTypes)
+    {
+        FindTransitTypes(rCellPopulation);
+    }
+
+    // The cells keep the counts of their transit type objects up to date
+    for (unsigned i=0; i<mTransitTypes.size(); i++)
+    {
+        if (mTransitTypes[i]->GetCellCount() > 0)
+        {
+            return false;
+        }
+    }
+
+    // Make sure no cell has been given a transit type object that is not yet counted
+    if (FindTransitTypes(rCellPopulation) > 0)
+    {
+        return false;
+    }
+
+    this->mStoppingReason = "No transit cells left";
+    return true;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void ExtinctionStoppingCondition<ELEMENT_DIM,SPACE_DIM>::OutputStoppingConditionParameters(out_stream& rParamsFile)
+{
+    // No parameters to output
+}
+
+// Explicit instantiation
+template class ExtinctionStoppingCondition<1,1>;
+template class ExtinctionStoppingCondition<1,2>;
+template class ExtinctionStoppingCondition<2,2>;
+template class ExtinctionStoppingCondition<1,3>;
+template class ExtinctionStoppingCondition<2,3>;
+template class ExtinctionStoppingCondition<3,3>;
+
+// Serialization for Boost >= 1.36
+#include "SerializationExportWrapperForCpp.hpp"
+EXPORT_TEMPLATE_CLASS_ALL_DIMS(ExtinctionStoppingCondition)
@@ -0,0 +1,127 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef EXTINCTIONSTOPPINGCONDITION_HPP_
+#define EXTINCTIONSTOPPINGCONDITION_HPP_
+
+#include "AbstractStoppingCondition.hpp"
+
+#include <vector>
+
+#include "ChasteSerialization.hpp"
+#include <boost/serialization/base_object.hpp>
+
+/**
+ * Stop once there are no transit (proliferating) cells left, after which the
+ * population can only shrink.
+ *
+ * The cells are given their transit type by the driver rather than from the cell
+ * property registry, so the registry count stays at zero. Instead the condition keeps
+ * the transit type objects the cells hold. Each of these keeps a running count of the
+ * cells it is attached to, which Chaste updates as cells change type, divide and die,
+ * so no loop over the cells is needed while any of them is nonzero. The cells are only
+ * looked at again once the counts reach zero, to pick up any transit type objects
+ * given to cells since, which are then counted too.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM=ELEMENT_DIM>
+class ExtinctionStoppingCondition : public AbstractStoppingCondition<ELEMENT_DIM,SPACE_DIM>
+{
+private:
+
+    /** Needed for serialization. */
+    friend class boost::serialization::access;
+    /**
+     * Archive the object and its member variables.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void serialize(Archive & archive, const unsigned int version)
+    {
+        archive & boost::serialization::base_object<AbstractStoppingCondition<ELEMENT_DIM,SPACE_DIM> >(*this);
+    }
+
+    /**
+     * The transit type objects held by the cells. Not archived, as they are found
+     * again the first time the condition is checked.
+     */
+    std::vector<boost::shared_ptr<AbstractCellProperty> > mTransitTypes;
+
+    /** Whether #mTransitTypes has been filled in. */
+    bool mHasFoundTransitTypes;
+
+    /**
+     * Add the transit type objects held by the cells to #mTransitTypes.
+     *
+     * @param rCellPopulation reference to the cell population
+     * @return the number of transit cells
+     */
+    unsigned FindTransitTypes(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
+public:
+
+    /**
+     * Constructor.
+     */
+    ExtinctionStoppingCondition();
+
+    /**
+     * Overridden SetupSolve() method.
+     *
+     * @param rCellPopulation reference to the cell population
+     */
+    void SetupSolve(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
+    /**
+     * Overridden HasOccurred() method.
+     *
+     * @param rCellPopulation reference to the cell population
+     * @return whether there are no transit cells left
+     */
+    bool HasOccurred(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
+    /**
+     * Overridden OutputStoppingConditionParameters() method.
+     *
+     * @param rParamsFile the file stream to which the parameters are output
+     */
+    void OutputStoppingConditionParameters(out_stream& rParamsFile);
+};
+
+#include "SerializationExportWrapper.hpp"
+EXPORT_TEMPLATE_CLASS_ALL_DIMS(ExtinctionStoppingCondition)
+
+#endif /*EXTINCTIONSTOPPINGCONDITION_HPP_*/
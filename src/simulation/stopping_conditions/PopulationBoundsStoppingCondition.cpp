@@ -0,0 +1,92 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "PopulationBoundsStoppingCondition.hpp"
+
+#include <sstream>
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+PopulationBoundsStoppingCondition<ELEMENT_DIM,SPACE_DIM>::PopulationBoundsStoppingCondition(unsigned minNumCells, unsigned maxNumCells)
+    : AbstractStoppingCondition<ELEMENT_DIM,SPACE_DIM>(),
+      mMinNumCells(minNumCells),
+      mMaxNumCells(maxNumCells)
+{
+    assert(mMinNumCells <= mMaxNumCells);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool PopulationBoundsStoppingCondition<ELEMENT_DIM,SPACE_DIM>::HasOccurred(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    unsigned num_cells = rCellPopulation.rGetMesh().GetNumNodes();
+    if (num_cells > mMaxNumCells || num_cells < mMinNumCells)
+    {
+        std::stringstream reason;
+        reason << "Number of cells " << num_cells << " outside [" << mMinNumCells << ", " << mMaxNumCells << "]";
+        this->mStoppingReason = reason.str();
+        return true;
+    }
+    return false;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned PopulationBoundsStoppingCondition<ELEMENT_DIM,SPACE_DIM>::GetMinNumCells() const
+{
+    return mMinNumCells;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned PopulationBoundsStoppingCondition<ELEMENT_DIM,SPACE_DIM>::GetMaxNumCells() const
+{
+    return mMaxNumCells;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void PopulationBoundsStoppingCondition<ELEMENT_DIM,SPACE_DIM>::OutputStoppingConditionParameters(out_stream& rParamsFile)
+{
+    *rParamsFile << "\t\t\t<MinNumCells>" << mMinNumCells << "</MinNumCells>\n";
+    *rParamsFile << "\t\t\t<MaxNumCells>" << mMaxNumCells << "</MaxNumCells>\n";
+}
+
+// Explicit instantiation
+template class PopulationBoundsStoppingCondition<1,1>;
+template class PopulationBoundsStoppingCondition<1,2>;
+template class PopulationBoundsStoppingCondition<2,2>;
+template class PopulationBoundsStoppingCondition<1,3>;
+template class PopulationBoundsStoppingCondition<2,3>;
+template class PopulationBoundsStoppingCondition<3,3>;
+
+// Serialization for Boost >= 1.36
+#include "SerializationExportWrapperForCpp.hpp"
+EXPORT_TEMPLATE_CLASS_ALL_DIMS(PopulationBoundsStoppingCondition)
@@ -0,0 +1,207 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "QuantityConvergedStoppingCondition.hpp"
+
+#include <cmath>
+#include <sstream>
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+QuantityConvergedStoppingCondition<ELEMENT_DIM,SPACE_DIM>::QuantityConvergedStoppingCondition(unsigned samplingInterval,
+                                                                                            unsigned windowSize,
+                                                                                            double relativeTolerance)
+    : AbstractStoppingCondition<ELEMENT_DIM,SPACE_DIM>(),
+      mSamplingInterval(samplingInterval),
+      mWindowSize(windowSize),
+      mRelativeTolerance(relativeTolerance),
+      mAbsoluteTolerance(0.0),
+      mNumCalls(0),
+      mNumSamples(0),
+      mWindowSum(0.0)
+{
+    assert(mSamplingInterval > 0);
+    assert(mWindowSize > 1);
+    assert(mRelativeTolerance >= 0.0);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+QuantityConvergedStoppingCondition<ELEMENT_DIM,SPACE_DIM>::~QuantityConvergedStoppingCondition()
+{
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+double QuantityConvergedStoppingCondition<ELEMENT_DIM,SPACE_DIM>::GetQuantity(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    return rCellPopulation.rGetMesh().GetNumNodes();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void QuantityConvergedStoppingCondition<ELEMENT_DIM,SPACE_DIM>::AddSample(double value)
+{
+    unsigned sample = mNumSamples++;
+
+    mWindow.push_back(value);
+    mWindowSum += value;
+    if (mWindow.size() > mWindowSize)
+    {
+        mWindowSum -= mWindow.front();
+        mWindow.pop_front();
+    }
+
+    // Keep the queues monotonic, then drop anything that has left the window
+    while (!mMaxima.empty() && mMaxima.back().second <= value)
+    {
+        mMaxima.pop_back();
+    }
+    mMaxima.push_back(std::make_pair(sample, value));
+    while (!mMinima.empty() && mMinima.back().second >= value)
+    {
+        mMinima.pop_back();
+    }
+    mMinima.push_back(std::make_pair(sample, value));
+
+    unsigned oldest = mNumSamples - mWindow.size();
+    while (mMaxima.front().first < oldest)
+    {
+        mMaxima.pop_front();
+    }
+    while (mMinima.front().first < oldest)
+    {
+        mMinima.pop_front();
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void QuantityConvergedStoppingCondition<ELEMENT_DIM,SPACE_DIM>::SetupSolve(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    mNumCalls = 0;
+    mNumSamples = 0;
+    mWindow.clear();
+    mWindowSum = 0.0;
+    mMaxima.clear();
+    mMinima.clear();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool QuantityConvergedStoppingCondition<ELEMENT_DIM,SPACE_DIM>::HasOccurred(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    mNumCalls++;
+    if (mNumCalls % mSamplingInterval != 0)
+    {
+        return false;
+    }
+
+    AddSample(GetQuantity(rCellPopulation));
+
+    if (mWindow.size() == mWindowSize)
+    {
+        double mean = GetWindowMean();
+        double range = GetWindowRange();
+        if (range <= mAbsoluteTolerance + mRelativeTolerance*fabs(mean))
+        {
+            std::stringstream reason;
+            reason << "Quantity converged to " << mean << " (range " << range << " over " << mWindowSize << " samples)";
+            this->mStoppingReason = reason.str();
+            return true;
+        }
+    }
+    return false;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned QuantityConvergedStoppingCondition<ELEMENT_DIM,SPACE_DIM>::GetSamplingInterval() const
+{
+    return mSamplingInterval;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+unsigned QuantityConvergedStoppingCondition<ELEMENT_DIM,SPACE_DIM>::GetWindowSize() const
+{
+    return mWindowSize;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+double QuantityConvergedStoppingCondition<ELEMENT_DIM,SPACE_DIM>::GetRelativeTolerance() const
+{
+    return mRelativeTolerance;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+double QuantityConvergedStoppingCondition<ELEMENT_DIM,SPACE_DIM>::GetAbsoluteTolerance() const
+{
+    return mAbsoluteTolerance;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void QuantityConvergedStoppingCondition<ELEMENT_DIM,SPACE_DIM>::SetAbsoluteTolerance(double absoluteTolerance)
+{
+    assert(absoluteTolerance >= 0.0);
+    mAbsoluteTolerance = absoluteTolerance;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+double QuantityConvergedStoppingCondition<ELEMENT_DIM,SPACE_DIM>::GetWindowMean() const
+{
+    assert(!mWindow.empty());
+    return mWindowSum/mWindow.size();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+double QuantityConvergedStoppingCondition<ELEMENT_DIM,SPACE_DIM>::GetWindowRange() const
+{
+    assert(!mWindow.empty());
+    return mMaxima.front().second - mMinima.front().second;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void QuantityConvergedStoppingCondition<ELEMENT_DIM,SPACE_DIM>::OutputStoppingConditionParameters(out_stream& rParamsFile)
+{
+    *rParamsFile << "\t\t\t<SamplingInterval>" << mSamplingInterval << "</SamplingInterval>\n";
+    *rParamsFile << "\t\t\t<WindowSize>" << mWindowSize << "</WindowSize>\n";
+    *rParamsFile << "\t\t\t<RelativeTolerance>" << mRelativeTolerance << "</RelativeTolerance>\n";
+    *rParamsFile << "\t\t\t<AbsoluteTolerance>" << mAbsoluteTolerance << "</AbsoluteTolerance>\n";
+}
+
+// Explicit instantiation
+template class QuantityConvergedStoppingCondition<1,1>;
+template class QuantityConvergedStoppingCondition<1,2>;
+template class QuantityConvergedStoppingCondition<2,2>;
+template class QuantityConvergedStoppingCondition<1,3>;
+template class QuantityConvergedStoppingCondition<2,3>;
+template class QuantityConvergedStoppingCondition<3,3>;
+
+// Serialization for Boost >= 1.36
+#include "SerializationExportWrapperForCpp.hpp"
+EXPORT_TEMPLATE_CLASS_ALL_DIMS(QuantityConvergedStoppingCondition)
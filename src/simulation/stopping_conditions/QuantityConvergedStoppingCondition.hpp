@@ -0,0 +1,224 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef QUANTITYCONVERGEDSTOPPINGCONDITION_HPP_
+#define QUANTITYCONVERGEDSTOPPINGCONDITION_HPP_
+
+#include <deque>
+#include <utility>
+
+#include "AbstractStoppingCondition.hpp"
+
+#include "ChasteSerialization.hpp"
+#include <boost/serialization/base_object.hpp>
+#include <boost/serialization/deque.hpp>
+#include <boost/serialization/utility.hpp>
+
+/**
+ * Stop once a scalar quantity has stopped changing: over the last #mWindowSize
+ * samples, taken every #mSamplingInterval time steps, its range must be within
+ *
+ *     mAbsoluteTolerance + mRelativeTolerance*|mean|.
+ *
+ * The window is updated incrementally as each sample is taken. The mean is kept as a
+ * running sum and the maximum and minimum in monotonic queues, so each sample costs
+ * O(1) amortised however long the window.
+ *
+ * By default the quantity is the number of cells (nodes in the mesh). Subclasses may
+ * track another quantity by overriding GetQuantity().
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM=ELEMENT_DIM>
+class QuantityConvergedStoppingCondition : public AbstractStoppingCondition<ELEMENT_DIM,SPACE_DIM>
+{
+private:
+
+    /** Needed for serialization. */
+    friend class boost::serialization::access;
+    /**
+     * Archive the object and its member variables.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void serialize(Archive & archive, const unsigned int version)
+    {
+        archive & boost::serialization::base_object<AbstractStoppingCondition<ELEMENT_DIM,SPACE_DIM> >(*this);
+        archive & mSamplingInterval;
+        archive & mWindowSize;
+        archive & mRelativeTolerance;
+        archive & mAbsoluteTolerance;
+        archive & mNumCalls;
+        archive & mNumSamples;
+        archive & mWindow;
+        archive & mWindowSum;
+        archive & mMaxima;
+        archive & mMinima;
+    }
+
+    /** The number of time steps between samples. */
+    unsigned mSamplingInterval;
+
+    /** The number of samples in the window. */
+    unsigned mWindowSize;
+
+    /** The tolerance on the range of the window relative to its mean. */
+    double mRelativeTolerance;
+
+    /** The absolute tolerance on the range of the window. */
+    double mAbsoluteTolerance;
+
+    /** The number of calls to HasOccurred() so far. */
+    unsigned mNumCalls;
+
+    /** The number of samples taken so far. */
+    unsigned mNumSamples;
+
+    /** The samples in the window, oldest first. */
+    std::deque<double> mWindow;
+
+    /** The sum of the samples in the window. */
+    double mWindowSum;
+
+    /**
+     * (sample number, value) pairs whose values decrease from front to back; the
+     * front is the maximum of the window.
+     */
+    std::deque<std::pair<unsigned, double> > mMaxima;
+
+    /**
+     * (sample number, value) pairs whose values increase from front to back; the
+     * front is the minimum of the window.
+     */
+    std::deque<std::pair<unsigned, double> > mMinima;
+
+    /**
+     * Add a sample to the window, dropping the oldest if the window is full.
+     *
+     * @param value the sample
+     */
+    void AddSample(double value);
+
+protected:
+
+    /**
+     * @return the quantity to track. By default the number of nodes in the mesh.
+     *
+     * @param rCellPopulation reference to the cell population
+     */
+    virtual double GetQuantity(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param samplingInterval the number of time steps between samples (defaults to 240)
+     * @param windowSize the number of samples in the window (defaults to 20)
+     * @param relativeTolerance the relative tolerance on the range of the window (defaults to 0.01)
+     */
+    QuantityConvergedStoppingCondition(unsigned samplingInterval=240, unsigned windowSize=20, double relativeTolerance=0.01);
+
+    /**
+     * Destructor.
+     */
+    virtual ~QuantityConvergedStoppingCondition();
+
+    /**
+     * Overridden SetupSolve() method.
+     *
+     * Empty the window.
+     *
+     * @param rCellPopulation reference to the cell population
+     */
+    void SetupSolve(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
+    /**
+     * Overridden HasOccurred() method.
+     *
+     * @param rCellPopulation reference to the cell population
+     * @return whether the quantity has converged
+     */
+    bool HasOccurred(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
+    /**
+     * @return #mSamplingInterval
+     */
+    unsigned GetSamplingInterval() const;
+
+    /**
+     * @return #mWindowSize
+     */
+    unsigned GetWindowSize() const;
+
+    /**
+     * @return #mRelativeTolerance
+     */
+    double GetRelativeTolerance() const;
+
+    /**
+     * @return #mAbsoluteTolerance
+     */
+    double GetAbsoluteTolerance() const;
+
+    /**
+     * Set #mAbsoluteTolerance.
+     *
+     * @param absoluteTolerance the new value of #mAbsoluteTolerance
+     */
+    void SetAbsoluteTolerance(double absoluteTolerance);
+
+    /**
+     * @return the mean of the samples in the window.
+     */
+    double GetWindowMean() const;
+
+    /**
+     * @return the range (maximum minus minimum) of the samples in the window.
+     */
+    double GetWindowRange() const;
+
+    /**
+     * Overridden OutputStoppingConditionParameters() method.
+     *
+     * @param rParamsFile the file stream to which the parameters are output
+     */
+    void OutputStoppingConditionParameters(out_stream& rParamsFile);
+};
+
+#include "SerializationExportWrapper.hpp"
+EXPORT_TEMPLATE_CLASS_ALL_DIMS(QuantityConvergedStoppingCondition)
+
+#endif /*QUANTITYCONVERGEDSTOPPINGCONDITION_HPP_*/
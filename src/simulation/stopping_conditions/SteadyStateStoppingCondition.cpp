@@ -0,0 +1,205 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "SteadyStateStoppingCondition.hpp"
+
+#include <sstream>
+
+#include "Exception.hpp"
+#include "TransitCellProliferativeType.hpp"
+#include "DifferentiatedCellProliferativeType.hpp"
+#include "AttachedCellMutationState.hpp"
+
+SteadyStateStoppingCondition::SteadyStateStoppingCondition(unsigned samplingInterval,
+                                                           unsigned windowSize,
+                                                           unsigned numPostSteadySamples)
+    : AbstractStoppingCondition<2>(),
+      mSamplingInterval(samplingInterval),
+      mNumPostSteadySamples(numPostSteadySamples),
+      mMaxSlopeStatistic(2.0),
+      mMaxVarianceRatio(4.0),
+      mNumCalls(0),
+      mNumSteadySamples(0),
+      mSteadyStateTime(DOUBLE_UNSET),
+      mStatistics(NUM_OBSERVABLES, WindowedTrendStatistics(windowSize))
+{
+    assert(mSamplingInterval > 0);
+}
+
+void SteadyStateStoppingCondition::ComputeObservables(AbstractCellPopulation<2>& rCellPopulation, std::vector<double>& rObservables)
+{
+    rObservables.resize(NUM_OBSERVABLES);
+
+    /*
+     * The cell counts are taken from the cells themselves: states are created with MAKE_PTR
+     * throughout the project, so the counts held by the cell property registry are not complete.
+     */
+    rObservables[0] = 0.0;
+    rObservables[1] = 0.0;
+    rObservables[2] = 0.0;
+    for (AbstractCellPopulation<2>::Iterator cell_iter = rCellPopulation.Begin();
+         cell_iter != rCellPopulation.End();
+         ++cell_iter)
+    {
+        boost::shared_ptr<AbstractCellProliferativeType> p_type = cell_iter->GetCellProliferativeType();
+        if (p_type->IsType<TransitCellProliferativeType>())
+        {
+            rObservables[0] += 1.0;
+        }
+        else if (p_type->IsType<DifferentiatedCellProliferativeType>())
+        {
+            rObservables[1] += 1.0;
+        }
+        if (cell_iter->GetMutationState()->IsType<AttachedCellMutationState>())
+        {
+            rObservables[2] += 1.0;
+        }
+    }
+
+    // The shape observables need one pass over the nodes
+    mShapeObservables.Measure(rCellPopulation);
+    rObservables[3] = mShapeObservables.GetCapHeight();
+    rObservables[4] = mShapeObservables.GetHistogramSlope();
+}
+
+void SteadyStateStoppingCondition::SetupSolve(AbstractCellPopulation<2>& rCellPopulation)
+{
+    if (!mpSimulationContext)
+    {
+        EXCEPTION("SteadyStateStoppingCondition needs a simulation context; add it to an OffLatticeSimulationWithStopUT or call SetSimulationContext().");
+    }
+
+    mNumCalls = 0;
+    mNumSteadySamples = 0;
+    mSteadyStateTime = DOUBLE_UNSET;
+    for (unsigned i=0; i<mStatistics.size(); i++)
+    {
+        mStatistics[i].Reset();
+    }
+}
+
+bool SteadyStateStoppingCondition::HasOccurred(AbstractCellPopulation<2>& rCellPopulation)
+{
+    mNumCalls++;
+    if (mNumCalls % mSamplingInterval != 0)
+    {
+        return false;
+    }
+
+    std::vector<double> observables;
+    ComputeObservables(rCellPopulation, observables);
+
+    bool is_steady = true;
+    for (unsigned i=0; i<NUM_OBSERVABLES; i++)
+    {
+        mStatistics[i].AddSample(observables[i]);
+        is_steady = is_steady
+                    && mStatistics[i].IsFull()
+                    && mStatistics[i].GetSlopeStatistic() <= mMaxSlopeStatistic
+                    && mStatistics[i].GetVarianceRatio() <= mMaxVarianceRatio;
+    }
+
+    if (!is_steady)
+    {
+        mNumSteadySamples = 0;
+        mSteadyStateTime = DOUBLE_UNSET;
+        return false;
+    }
+
+    if (mNumSteadySamples == 0)
+    {
+        mSteadyStateTime = mpSimulationContext->GetTime();
+    }
+    mNumSteadySamples++;
+
+    if (mNumSteadySamples > mNumPostSteadySamples)
+    {
+        std::stringstream reason;
+        reason << "Steady state reached at t = " << mSteadyStateTime << " and sampled " << mNumPostSteadySamples << " times";
+        mStoppingReason = reason.str();
+        return true;
+    }
+    return false;
+}
+
+double SteadyStateStoppingCondition::GetSteadyStateTime() const
+{
+    return mSteadyStateTime;
+}
+
+unsigned SteadyStateStoppingCondition::GetSamplingInterval() const
+{
+    return mSamplingInterval;
+}
+
+unsigned SteadyStateStoppingCondition::GetNumPostSteadySamples() const
+{
+    return mNumPostSteadySamples;
+}
+
+double SteadyStateStoppingCondition::GetMaxSlopeStatistic() const
+{
+    return mMaxSlopeStatistic;
+}
+
+void SteadyStateStoppingCondition::SetMaxSlopeStatistic(double maxSlopeStatistic)
+{
+    assert(maxSlopeStatistic >= 0.0);
+    mMaxSlopeStatistic = maxSlopeStatistic;
+}
+
+double SteadyStateStoppingCondition::GetMaxVarianceRatio() const
+{
+    return mMaxVarianceRatio;
+}
+
+void SteadyStateStoppingCondition::SetMaxVarianceRatio(double maxVarianceRatio)
+{
+    assert(maxVarianceRatio >= 1.0);
+    mMaxVarianceRatio = maxVarianceRatio;
+}
+
+void SteadyStateStoppingCondition::OutputStoppingConditionParameters(out_stream& rParamsFile)
+{
+    *rParamsFile << "\t\t\t<SamplingInterval>" << mSamplingInterval << "</SamplingInterval>\n";
+    *rParamsFile << "\t\t\t<WindowSize>" << mStatistics[0].GetWindowSize() << "</WindowSize>\n";
+    *rParamsFile << "\t\t\t<NumPostSteadySamples>" << mNumPostSteadySamples << "</NumPostSteadySamples>\n";
+    *rParamsFile << "\t\t\t<MaxSlopeStatistic>" << mMaxSlopeStatistic << "</MaxSlopeStatistic>\n";
+    *rParamsFile << "\t\t\t<MaxVarianceRatio>" << mMaxVarianceRatio << "</MaxVarianceRatio>\n";
+}
+
+// Serialization for Boost >= 1.36
+#include "SerializationExportWrapperForCpp.hpp"
+CHASTE_CLASS_EXPORT(SteadyStateStoppingCondition)
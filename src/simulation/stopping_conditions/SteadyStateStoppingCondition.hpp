@@ -0,0 +1,216 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef STEADYSTATESTOPPINGCONDITION_HPP_
+#define STEADYSTATESTOPPINGCONDITION_HPP_
+
+#include <vector>
+
+#include "AbstractStoppingCondition.hpp"
+#include "WindowedTrendStatistics.hpp"
+#include "UtericBudShapeObservables.hpp"
+
+#include "ChasteSerialization.hpp"
+#include <boost/serialization/base_object.hpp>
+#include <boost/serialization/vector.hpp>
+
+/**
+ * Stop a UtericBud simulation once it has reached a statistical steady state and
+ * enough samples of that steady state have been collected.
+ *
+ * Every #mSamplingInterval time steps (normally the output interval, so that the
+ * samples line up with celltypescount.dat) the condition records the observables
+ * used in the analysis of the paper sweeps:
+ *  - the number of transit cells,
+ *  - the number of differentiated cells,
+ *  - the number of attached cells,
+ *  - the cap height and the slope of the histogram of x coordinates, as measured
+ *    by UtericBudShapeObservables.
+ *
+ * Each observable is considered steady when, over the last #mWindowSize samples,
+ * the t statistic of its trend is at most #mMaxSlopeStatistic and the ratio of the
+ * variances of the two halves of the window is at most #mMaxVarianceRatio. Once
+ * all of them are steady the condition counts further samples, starting again if
+ * any observable stops being steady, and stops the simulation after
+ * #mNumPostSteadySamples of them.
+ */
+class SteadyStateStoppingCondition : public AbstractStoppingCondition<2>
+{
+private:
+
+    /** Needed for serialization. */
+    friend class boost::serialization::access;
+    /**
+     * Archive the object and its member variables.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void serialize(Archive & archive, const unsigned int version)
+    {
+        archive & boost::serialization::base_object<AbstractStoppingCondition<2> >(*this);
+        archive & mSamplingInterval;
+        archive & mNumPostSteadySamples;
+        archive & mMaxSlopeStatistic;
+        archive & mMaxVarianceRatio;
+        archive & mNumCalls;
+        archive & mNumSteadySamples;
+        archive & mSteadyStateTime;
+        archive & mStatistics;
+    }
+
+    /** The number of time steps between samples. */
+    unsigned mSamplingInterval;
+
+    /** The number of samples to collect once the steady state has been reached. */
+    unsigned mNumPostSteadySamples;
+
+    /** The largest t statistic of the trend of an observable that is considered steady. */
+    double mMaxSlopeStatistic;
+
+    /** The largest ratio of half-window variances of an observable that is considered steady. */
+    double mMaxVarianceRatio;
+
+    /** The number of calls to HasOccurred() so far. */
+    unsigned mNumCalls;
+
+    /** The number of consecutive samples for which every observable has been steady. */
+    unsigned mNumSteadySamples;
+
+    /** The time at which the current steady state was reached, or DOUBLE_UNSET. */
+    double mSteadyStateTime;
+
+    /** The windowed statistics of each observable. */
+    std::vector<WindowedTrendStatistics> mStatistics;
+
+    /** Measures the shape observables, keeping its scratch space from one sample to the next. */
+    UtericBudShapeObservables mShapeObservables;
+
+protected:
+
+    /**
+     * Compute the observables for the current state of the population.
+     *
+     * @param rCellPopulation reference to the cell population
+     * @param rObservables vector to fill with one value per observable
+     */
+    virtual void ComputeObservables(AbstractCellPopulation<2>& rCellPopulation, std::vector<double>& rObservables);
+
+public:
+
+    /** The number of observables tracked. */
+    static const unsigned NUM_OBSERVABLES = 5;
+
+    /**
+     * Constructor.
+     *
+     * @param samplingInterval the number of time steps between samples (defaults to 120)
+     * @param windowSize the number of samples in the window for each test (defaults to 20)
+     * @param numPostSteadySamples the number of samples to collect after the steady
+     *     state is reached (defaults to 20)
+     */
+    SteadyStateStoppingCondition(unsigned samplingInterval=120, unsigned windowSize=20, unsigned numPostSteadySamples=20);
+
+    /**
+     * Overridden SetupSolve() method.
+     *
+     * Empty the windows. The steady state time is read from the simulation context,
+     * so one must have been set.
+     *
+     * @param rCellPopulation reference to the cell population
+     */
+    void SetupSolve(AbstractCellPopulation<2>& rCellPopulation);
+
+    /**
+     * Overridden HasOccurred() method.
+     *
+     * @param rCellPopulation reference to the cell population
+     * @return whether enough samples of the steady state have been collected
+     */
+    bool HasOccurred(AbstractCellPopulation<2>& rCellPopulation);
+
+    /**
+     * @return the time at which the current steady state was reached, or DOUBLE_UNSET
+     *     if the simulation is not in a steady state.
+     */
+    double GetSteadyStateTime() const;
+
+    /**
+     * @return #mSamplingInterval
+     */
+    unsigned GetSamplingInterval() const;
+
+    /**
+     * @return #mNumPostSteadySamples
+     */
+    unsigned GetNumPostSteadySamples() const;
+
+    /**
+     * @return #mMaxSlopeStatistic
+     */
+    double GetMaxSlopeStatistic() const;
+
+    /**
+     * Set #mMaxSlopeStatistic.
+     *
+     * @param maxSlopeStatistic the new value of #mMaxSlopeStatistic
+     */
+    void SetMaxSlopeStatistic(double maxSlopeStatistic);
+
+    /**
+     * @return #mMaxVarianceRatio
+     */
+    double GetMaxVarianceRatio() const;
+
+    /**
+     * Set #mMaxVarianceRatio.
+     *
+     * @param maxVarianceRatio the new value of #mMaxVarianceRatio
+     */
+    void SetMaxVarianceRatio(double maxVarianceRatio);
+
+    /**
+     * Overridden OutputStoppingConditionParameters() method.
+     *
+     * @param rParamsFile the file stream to which the parameters are output
+     */
+    void OutputStoppingConditionParameters(out_stream& rParamsFile);
+};
+
+#include "SerializationExportWrapper.hpp"
+CHASTE_CLASS_EXPORT(SteadyStateStoppingCondition)
+
+#endif /*STEADYSTATESTOPPINGCONDITION_HPP_*/
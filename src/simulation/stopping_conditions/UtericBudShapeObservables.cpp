@@ -0,0 +1,108 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include "UtericBudShapeObservables.hpp"
+
+#include <algorithm>
+#include <functional>
+
+UtericBudShapeObservables::UtericBudShapeObservables()
+    : mHistogram(NUM_HISTOGRAM_BINS, 0.0),
+      mCapHeight(0.0),
+      mHistogramSlope(0.0)
+{
+}
+
+void UtericBudShapeObservables::Measure(AbstractCellPopulation<2>& rCellPopulation)
+{
+    std::fill(mHistogram.begin(), mHistogram.end(), 0.0);
+    mHeights.clear();
+    AbstractMesh<2,2>& r_mesh = rCellPopulation.rGetMesh();
+    for (AbstractMesh<2,2>::NodeIterator node_iter = r_mesh.GetNodeIteratorBegin();
+         node_iter != r_mesh.GetNodeIteratorEnd();
+         ++node_iter)
+    {
+        const c_vector<double, 2>& r_location = node_iter->rGetLocation();
+        mHeights.push_back(r_location[1]);
+
+        if (r_location[0] >= 0.0 && r_location[0] <= NUM_HISTOGRAM_BINS)
+        {
+            unsigned bin = std::min((unsigned) r_location[0], NUM_HISTOGRAM_BINS - 1);
+            mHistogram[bin] += 1.0;
+        }
+    }
+
+    if (mHeights.empty())
+    {
+        mCapHeight = 0.0;
+        mHistogramSlope = 0.0;
+        return;
+    }
+
+    unsigned rank = std::min(CAP_HEIGHT_RANK, (unsigned) mHeights.size()) - 1;
+    std::nth_element(mHeights.begin(), mHeights.begin() + rank, mHeights.end(), std::greater<double>());
+    mCapHeight = mHeights[rank];
+
+    // Least-squares slope of the bin probabilities against the bin centres
+    double mean_centre = 0.5*NUM_HISTOGRAM_BINS;
+    double mean_probability = 0.0;
+    for (unsigned bin=0; bin<NUM_HISTOGRAM_BINS; bin++)
+    {
+        mHistogram[bin] /= mHeights.size();
+        mean_probability += mHistogram[bin];
+    }
+    mean_probability /= NUM_HISTOGRAM_BINS;
+
+    double s_xy = 0.0;
+    double s_xx = 0.0;
+    for (unsigned bin=0; bin<NUM_HISTOGRAM_BINS; bin++)
+    {
+        double centre_offset = bin + 0.5 - mean_centre;
+        s_xy += centre_offset*(mHistogram[bin] - mean_probability);
+        s_xx += centre_offset*centre_offset;
+    }
+    mHistogramSlope = s_xy/s_xx;
+}
+
+double UtericBudShapeObservables::GetCapHeight() const
+{
+    return mCapHeight;
+}
+
+double UtericBudShapeObservables::GetHistogramSlope() const
+{
+    return mHistogramSlope;
+}
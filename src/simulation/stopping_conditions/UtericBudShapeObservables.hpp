@@ -0,0 +1,102 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef UTERICBUDSHAPEOBSERVABLES_HPP_
+#define UTERICBUDSHAPEOBSERVABLES_HPP_
+
+#include <vector>
+
+#include "AbstractCellPopulation.hpp"
+
+/**
+ * The shape observables used in the analysis of the paper sweeps, measured from the
+ * node locations of a population:
+ *  - the cap height, the 10th highest y coordinate of any cell (as in capheight.m),
+ *  - the slope of the least-squares line through the probability histogram of x
+ *    coordinates over 20 unit bins on [0, 20] (as in steadystateshape.m).
+ *
+ * Both are measured in one pass over the nodes. The scratch space is kept between
+ * measurements, so measuring at every sample does not allocate.
+ */
+class UtericBudShapeObservables
+{
+private:
+
+    /** Scratch space for the node heights. */
+    std::vector<double> mHeights;
+
+    /** Scratch space for the histogram of x coordinates. */
+    std::vector<double> mHistogram;
+
+    /** The cap height at the last measurement. */
+    double mCapHeight;
+
+    /** The slope of the histogram of x coordinates at the last measurement. */
+    double mHistogramSlope;
+
+public:
+
+    /** The rank of the cell whose height is taken as the cap height, as in capheight.m. */
+    static const unsigned CAP_HEIGHT_RANK = 10;
+
+    /** The number of unit-width bins in the histogram of x coordinates, as in steadystateshape.m. */
+    static const unsigned NUM_HISTOGRAM_BINS = 20;
+
+    /**
+     * Constructor.
+     */
+    UtericBudShapeObservables();
+
+    /**
+     * Measure the observables for the current node locations of a population. Both
+     * are zero if the population is empty.
+     *
+     * @param rCellPopulation reference to the cell population
+     */
+    void Measure(AbstractCellPopulation<2>& rCellPopulation);
+
+    /**
+     * @return the cap height at the last measurement
+     */
+    double GetCapHeight() const;
+
+    /**
+     * @return the slope of the histogram of x coordinates at the last measurement
+     */
+    double GetHistogramSlope() const;
+};
+
+#endif /*UTERICBUDSHAPEOBSERVABLES_HPP_*/
@@ -0,0 +1,91 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "WallClockStoppingCondition.hpp"
+
+#include <sstream>
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+WallClockStoppingCondition<ELEMENT_DIM,SPACE_DIM>::WallClockStoppingCondition(double budget)
+    : AbstractStoppingCondition<ELEMENT_DIM,SPACE_DIM>(),
+      mBudget(budget),
+      mStartTime(time(NULL))
+{
+    assert(mBudget > 0.0);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void WallClockStoppingCondition<ELEMENT_DIM,SPACE_DIM>::SetupSolve(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    mStartTime = time(NULL);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+bool WallClockStoppingCondition<ELEMENT_DIM,SPACE_DIM>::HasOccurred(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation)
+{
+    double elapsed = difftime(time(NULL), mStartTime);
+    if (elapsed > mBudget)
+    {
+        std::stringstream reason;
+        reason << "Wall-clock budget of " << mBudget << " seconds used up";
+        this->mStoppingReason = reason.str();
+        return true;
+    }
+    return false;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+double WallClockStoppingCondition<ELEMENT_DIM,SPACE_DIM>::GetBudget() const
+{
+    return mBudget;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void WallClockStoppingCondition<ELEMENT_DIM,SPACE_DIM>::OutputStoppingConditionParameters(out_stream& rParamsFile)
+{
+    *rParamsFile << "\t\t\t<Budget>" << mBudget << "</Budget>\n";
+}
+
+// Explicit instantiation
+template class WallClockStoppingCondition<1,1>;
+template class WallClockStoppingCondition<1,2>;
+template class WallClockStoppingCondition<2,2>;
+template class WallClockStoppingCondition<1,3>;
+template class WallClockStoppingCondition<2,3>;
+template class WallClockStoppingCondition<3,3>;
+
+// Serialization for Boost >= 1.36
+#include "SerializationExportWrapperForCpp.hpp"
+EXPORT_TEMPLATE_CLASS_ALL_DIMS(WallClockStoppingCondition)
@@ -0,0 +1,120 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef WALLCLOCKSTOPPINGCONDITION_HPP_
+#define WALLCLOCKSTOPPINGCONDITION_HPP_
+
+#include "AbstractStoppingCondition.hpp"
+
+#include <cfloat>
+#include <ctime>
+
+#include "ChasteSerialization.hpp"
+#include <boost/serialization/base_object.hpp>
+
+/**
+ * Stop once the simulation has been running for longer than a given wall-clock time,
+ * so that a run which has slowed down cannot use up a whole allocation. The clock
+ * starts when the simulation is solved.
+ */
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM=ELEMENT_DIM>
+class WallClockStoppingCondition : public AbstractStoppingCondition<ELEMENT_DIM,SPACE_DIM>
+{
+private:
+
+    /** Needed for serialization. */
+    friend class boost::serialization::access;
+    /**
+     * Archive the object and its member variables.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void serialize(Archive & archive, const unsigned int version)
+    {
+        archive & boost::serialization::base_object<AbstractStoppingCondition<ELEMENT_DIM,SPACE_DIM> >(*this);
+        archive & mBudget;
+    }
+
+    /** The wall-clock time allowed, in seconds. */
+    double mBudget;
+
+    /** The wall-clock time at which the simulation was solved. Not archived. */
+    time_t mStartTime;
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param budget the wall-clock time allowed, in seconds (defaults to DBL_MAX)
+     */
+    WallClockStoppingCondition(double budget=DBL_MAX);
+
+    /**
+     * Overridden SetupSolve() method.
+     *
+     * Start the clock.
+     *
+     * @param rCellPopulation reference to the cell population
+     */
+    void SetupSolve(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
+    /**
+     * Overridden HasOccurred() method.
+     *
+     * @param rCellPopulation reference to the cell population
+     * @return whether the wall-clock time allowed has passed
+     */
+    bool HasOccurred(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation);
+
+    /**
+     * @return #mBudget
+     */
+    double GetBudget() const;
+
+    /**
+     * Overridden OutputStoppingConditionParameters() method.
+     *
+     * @param rParamsFile the file stream to which the parameters are output
+     */
+    void OutputStoppingConditionParameters(out_stream& rParamsFile);
+};
+
+#include "SerializationExportWrapper.hpp"
+EXPORT_TEMPLATE_CLASS_ALL_DIMS(WallClockStoppingCondition)
+
+#endif /*WALLCLOCKSTOPPINGCONDITION_HPP_*/
@@ -0,0 +1,191 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "WindowedTrendStatistics.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+WindowedTrendStatistics::WindowedTrendStatistics(unsigned windowSize)
+    : mWindowSize(windowSize)
+{
+    assert(mWindowSize >= 4);
+    Reset();
+}
+
+void WindowedTrendStatistics::Reset()
+{
+    mWindow.clear();
+    mNumSamples = 0;
+    mSum = 0.0;
+    mSumSquares = 0.0;
+    mSumIndexWeighted = 0.0;
+    mOlderSum = 0.0;
+    mOlderSumSquares = 0.0;
+}
+
+unsigned WindowedTrendStatistics::GetOlderHalfSize() const
+{
+    return mWindow.size()/2;
+}
+
+void WindowedTrendStatistics::RecomputeSums()
+{
+    mSum = 0.0;
+    mSumSquares = 0.0;
+    mSumIndexWeighted = 0.0;
+    mOlderSum = 0.0;
+    mOlderSumSquares = 0.0;
+
+    unsigned older_half_size = GetOlderHalfSize();
+    for (unsigned k=0; k<mWindow.size(); k++)
+    {
+        double value = mWindow[k];
+        mSum += value;
+        mSumSquares += value*value;
+        mSumIndexWeighted += k*value;
+        if (k < older_half_size)
+        {
+            mOlderSum += value;
+            mOlderSumSquares += value*value;
+        }
+    }
+}
+
+void WindowedTrendStatistics::AddSample(double value)
+{
+    mNumSamples++;
+
+    unsigned num_older = GetOlderHalfSize();
+    if (mWindow.size() == mWindowSize)
+    {
+        // Drop the oldest sample and renumber the rest from zero
+        double oldest = mWindow.front();
+        mWindow.pop_front();
+        mSum -= oldest;
+        mSumSquares -= oldest*oldest;
+        mSumIndexWeighted -= mSum;
+        mOlderSum -= oldest;
+        mOlderSumSquares -= oldest*oldest;
+        num_older--;
+    }
+
+    mSumIndexWeighted += mWindow.size()*value;
+    mWindow.push_back(value);
+    mSum += value;
+    mSumSquares += value*value;
+
+    // Move samples from the newer half into the older half until it has its share
+    for (unsigned k=num_older; k<GetOlderHalfSize(); k++)
+    {
+        mOlderSum += mWindow[k];
+        mOlderSumSquares += mWindow[k]*mWindow[k];
+    }
+
+    if (mNumSamples % mWindowSize == 0)
+    {
+        RecomputeSums();
+    }
+}
+
+bool WindowedTrendStatistics::IsFull() const
+{
+    return mWindow.size() == mWindowSize;
+}
+
+unsigned WindowedTrendStatistics::GetWindowSize() const
+{
+    return mWindowSize;
+}
+
+double WindowedTrendStatistics::GetMean() const
+{
+    assert(!mWindow.empty());
+    return mSum/mWindow.size();
+}
+
+double WindowedTrendStatistics::GetSlope() const
+{
+    assert(mWindow.size() > 1);
+    double n = mWindow.size();
+    double s_xx = n*(n*n - 1.0)/12.0;
+    double s_xy = mSumIndexWeighted - 0.5*(n - 1.0)*mSum;
+    return s_xy/s_xx;
+}
+
+double WindowedTrendStatistics::GetSlopeStatistic() const
+{
+    assert(mWindow.size() > 2);
+    double n = mWindow.size();
+    double s_xx = n*(n*n - 1.0)/12.0;
+    double s_xy = mSumIndexWeighted - 0.5*(n - 1.0)*mSum;
+    double s_yy = mSumSquares - mSum*mSum/n;
+    double slope = s_xy/s_xx;
+
+    double residual = std::max(s_yy - slope*s_xy, 0.0);
+    if (residual <= DBL_EPSILON*fabs(mSumSquares))
+    {
+        return (fabs(slope) <= DBL_EPSILON*(1.0 + fabs(mSum/n))) ? 0.0 : DBL_MAX;
+    }
+    double standard_error = sqrt(residual/((n - 2.0)*s_xx));
+    return fabs(slope)/standard_error;
+}
+
+double WindowedTrendStatistics::GetVarianceRatio() const
+{
+    unsigned num_older = GetOlderHalfSize();
+    unsigned num_newer = mWindow.size() - num_older;
+    assert(num_older > 1);
+
+    double newer_sum = mSum - mOlderSum;
+    double newer_sum_squares = mSumSquares - mOlderSumSquares;
+    double older_variance = std::max(mOlderSumSquares - mOlderSum*mOlderSum/num_older, 0.0)/(num_older - 1);
+    double newer_variance = std::max(newer_sum_squares - newer_sum*newer_sum/num_newer, 0.0)/(num_newer - 1);
+
+    double tolerance = DBL_EPSILON*mSumSquares/mWindow.size();
+    bool older_constant = older_variance <= tolerance;
+    bool newer_constant = newer_variance <= tolerance;
+    if (older_constant && newer_constant)
+    {
+        return 1.0;
+    }
+    else if (older_constant || newer_constant)
+    {
+        return DBL_MAX;
+    }
+    return std::max(older_variance/newer_variance, newer_variance/older_variance);
+}
@@ -0,0 +1,172 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Chaste.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef WINDOWEDTRENDSTATISTICS_HPP_
+#define WINDOWEDTRENDSTATISTICS_HPP_
+
+#include <deque>
+
+#include "ChasteSerialization.hpp"
+#include <boost/serialization/deque.hpp>
+
+/**
+ * Summary statistics of the most recent samples of a time series, used to decide
+ * whether the series has settled down.
+ *
+ * Two tests are provided. The trend test fits a least-squares line through the
+ * window against sample number and returns the t statistic of its slope. The
+ * variance test returns the ratio of the variance of the newer half of the window
+ * to that of the older half.
+ *
+ * All sums are updated in O(1) as samples enter and leave the window. They are
+ * recomputed from the window every #mWindowSize samples so that round-off does not
+ * accumulate over long runs.
+ */
+class WindowedTrendStatistics
+{
+private:
+
+    /** Needed for serialization. */
+    friend class boost::serialization::access;
+    /**
+     * Archive the object and its member variables.
+     *
+     * @param archive the archive
+     * @param version the current version of this class
+     */
+    template<class Archive>
+    void serialize(Archive & archive, const unsigned int version)
+    {
+        archive & mWindowSize;
+        archive & mWindow;
+        archive & mNumSamples;
+        archive & mSum;
+        archive & mSumSquares;
+        archive & mSumIndexWeighted;
+        archive & mOlderSum;
+        archive & mOlderSumSquares;
+    }
+
+    /** The number of samples in the window. */
+    unsigned mWindowSize;
+
+    /** The samples in the window, oldest first. */
+    std::deque<double> mWindow;
+
+    /** The number of samples added since the last Reset(). */
+    unsigned mNumSamples;
+
+    /** The sum of the samples in the window. */
+    double mSum;
+
+    /** The sum of the squares of the samples in the window. */
+    double mSumSquares;
+
+    /** The sum of k*y_k over the window, where k counts from 0 at the oldest sample. */
+    double mSumIndexWeighted;
+
+    /** The sum of the samples in the older half of the window. */
+    double mOlderSum;
+
+    /** The sum of the squares of the samples in the older half of the window. */
+    double mOlderSumSquares;
+
+    /**
+     * @return the number of samples in the older half of the window.
+     */
+    unsigned GetOlderHalfSize() const;
+
+    /**
+     * Recompute all the sums from #mWindow.
+     */
+    void RecomputeSums();
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param windowSize the number of samples in the window (defaults to 20, at least 4)
+     */
+    WindowedTrendStatistics(unsigned windowSize=20);
+
+    /**
+     * Empty the window.
+     */
+    void Reset();
+
+    /**
+     * Add a sample, dropping the oldest one if the window is full.
+     *
+     * @param value the sample
+     */
+    void AddSample(double value);
+
+    /**
+     * @return whether the window is full.
+     */
+    bool IsFull() const;
+
+    /**
+     * @return #mWindowSize
+     */
+    unsigned GetWindowSize() const;
+
+    /**
+     * @return the mean of the window.
+     */
+    double GetMean() const;
+
+    /**
+     * @return the least-squares slope of the window per sample.
+     */
+    double GetSlope() const;
+
+    /**
+     * @return the absolute t statistic of the least-squares slope. This is zero if the
+     *     window lies exactly on a horizontal line and DBL_MAX if it lies exactly on a
+     *     sloping one.
+     */
+    double GetSlopeStatistic() const;
+
+    /**
+     * @return the larger of the ratios of the variances of the two halves of the
+     *     window, so always at least one. This is one if both halves are constant and
+     *     DBL_MAX if only one of them is.
+     */
+    double GetVarianceRatio() const;
+};
+
+#endif /*WINDOWEDTRENDSTATISTICS_HPP_*/
@@ -41,21 +41,30 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "PottsBasedCellPopulation.hpp"
 #include "VertexBasedCellPopulation.hpp"
 
-#include "WildTypeCellMutationState.hpp"
-#include "AttachedCellMutationState.hpp"
-#include "RVCellMutationState.hpp"
-
-#include "TransitCellProliferativeType.hpp"
-#include "DifferentiatedCellProliferativeType.hpp"
+#include <boost/make_shared.hpp>
 
 #include "Debug.hpp"
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 UtericBudCellTypesCountWriter<ELEMENT_DIM, SPACE_DIM>::UtericBudCellTypesCountWriter()
-    : AbstractCellPopulationCountWriter<ELEMENT_DIM, SPACE_DIM>("celltypescount.dat")
+    : AbstractCellPopulationCountWriter<ELEMENT_DIM, SPACE_DIM>("celltypescount.dat"),
+      mpCellAttributeCache(boost::make_shared<CellAttributeCache<SPACE_DIM> >())
 {
 }
 
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void UtericBudCellTypesCountWriter<ELEMENT_DIM, SPACE_DIM>::SetCellAttributeCache(boost::shared_ptr<CellAttributeCache<SPACE_DIM> > pCellAttributeCache)
+{
+    assert(pCellAttributeCache);
+    mpCellAttributeCache = pCellAttributeCache;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+boost::shared_ptr<CellAttributeCache<SPACE_DIM> > UtericBudCellTypesCountWriter<ELEMENT_DIM, SPACE_DIM>::GetCellAttributeCache() const
+{
+    return mpCellAttributeCache;
+}
+
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 void UtericBudCellTypesCountWriter<ELEMENT_DIM, SPACE_DIM>::WriteHeader(AbstractCellPopulation<ELEMENT_DIM, SPACE_DIM>* pCellPopulation)
 {
@@ -70,40 +79,15 @@ void UtericBudCellTypesCountWriter<ELEMENT_DIM, SPACE_DIM>::WriteHeader(Abstract
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 void UtericBudCellTypesCountWriter<ELEMENT_DIM, SPACE_DIM>::VisitAnyPopulation(AbstractCellPopulation<SPACE_DIM, SPACE_DIM>* pCellPopulation)
 {
-    unsigned transit_cell_count = 0;
-    unsigned diff_cell_count = 0;
-    
-    unsigned wildtype_cell_count = 0;
-    unsigned attached_cell_count = 0;
-    unsigned rv_cell_count = 0;
+    // The cache keeps the counts, so this only walks the cells if it is out of date
+    mpCellAttributeCache->Refresh(*pCellPopulation);
     
+    unsigned transit_cell_count = mpCellAttributeCache->GetNumCellsWithProliferativeType(TRANSIT_PROLIFERATIVE_TYPE);
+    unsigned diff_cell_count = mpCellAttributeCache->GetNumCellsWithProliferativeType(DIFFERENTIATED_PROLIFERATIVE_TYPE);
     
-    for (typename AbstractCellPopulation<SPACE_DIM, SPACE_DIM>::Iterator cell_iter = pCellPopulation->Begin();
-        cell_iter != pCellPopulation->End();
-        ++cell_iter)
-    {
-        if (cell_iter->GetCellProliferativeType()->template IsType<TransitCellProliferativeType>())
-        {
-            transit_cell_count++;
-        }
-        else if (cell_iter->GetCellProliferativeType()->template IsType<DifferentiatedCellProliferativeType>())
-        {
-            diff_cell_count++;
-        }
-        
-        if (cell_iter->GetMutationState()->template IsType<WildTypeCellMutationState>())
-        {
-            wildtype_cell_count++;
-        }
-        else if (cell_iter->GetMutationState()->template IsType<AttachedCellMutationState>())
-        {
-            attached_cell_count++;
-        }
-        else if (cell_iter->GetMutationState()->template IsType<RVCellMutationState>())
-        {
-            rv_cell_count++;
-        }
-    }
+    unsigned wildtype_cell_count = mpCellAttributeCache->GetNumCellsWithMutationState(WILD_TYPE_MUTATION_STATE);
+    unsigned attached_cell_count = mpCellAttributeCache->GetNumCellsWithMutationState(ATTACHED_MUTATION_STATE);
+    unsigned rv_cell_count = mpCellAttributeCache->GetNumCellsWithMutationState(RV_MUTATION_STATE);
     
     if (PetscTools::AmMaster())
     {
@@ -34,6 +34,7 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "AbstractCellPopulationCountWriter.hpp"
+#include "CellAttributeCache.hpp"
 #include "ChasteSerialization.hpp"
 #include <boost/serialization/base_object.hpp>
 
@@ -41,6 +42,9 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  * A class written using the visitor pattern for writing the number of cells of each proliferative type to file.
  *
  * The output file is called celltypes.dat by default.
+ *
+ * The counts are read from a CellAttributeCache, which the writer shares with the
+ * other components of a simulation if given one through SetCellAttributeCache().
  */
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 class UtericBudCellTypesCountWriter : public AbstractCellPopulationCountWriter<ELEMENT_DIM, SPACE_DIM>
@@ -60,12 +64,30 @@ private:
         archive & boost::serialization::base_object<AbstractCellPopulationCountWriter<ELEMENT_DIM, SPACE_DIM> >(*this);
     }
 
+    /**
+     * The cell attributes the counts are read from. Defaults to a cache of the
+     * writer's own, and is not archived.
+     */
+    boost::shared_ptr<CellAttributeCache<SPACE_DIM> > mpCellAttributeCache;
+
 public:
 
     /**
      * Default constructor.
      */
     UtericBudCellTypesCountWriter();
+
+    /**
+     * Set #mpCellAttributeCache, so that it may be shared with other components.
+     *
+     * @param pCellAttributeCache the cell attribute cache
+     */
+    void SetCellAttributeCache(boost::shared_ptr<CellAttributeCache<SPACE_DIM> > pCellAttributeCache);
+
+    /**
+     * @return #mpCellAttributeCache
+     */
+    boost::shared_ptr<CellAttributeCache<SPACE_DIM> > GetCellAttributeCache() const;
     
     /**
      * Overridden WriteHeader() method.
@@ -0,0 +1,145 @@
+/*
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+This file is part of Chaste.
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cxxtest/TestSuite.h>
+#include "CheckpointArchiveTypes.hpp"
+#include "AbstractCellBasedTestSuite.hpp"
+#include "FakePetscSetup.hpp"
+#include "SmartPointers.hpp"
+
+#include <ctime>
+#include <iomanip>
+
+#include "NodeBasedCellPopulation.hpp"
+#include "CellsGenerator.hpp"
+#include "FixedDurationGenerationBasedCellCycleModel.hpp"
+#include "DifferentiatedCellProliferativeType.hpp"
+
+#include "BasicLinearSpringForce.hpp"
+#include "NodeBasedLinearSpringForce.hpp"
+
+/*
+ * Per-pair cost of the spring force loop.
+ *
+ * A random population of non-dividing cells, at about the density of the bud, is
+ * built once. AddForceContribution() is then called repeatedly with each spring
+ * force, and the time per interacting pair is printed. The forces of each variant
+ * are checked against BasicLinearSpringForce.
+ */
+class LinearSpringForceBenchmark : public AbstractCellBasedTestSuite
+{
+private:
+
+    /*
+     * Time the given number of calls to AddForceContribution(), returning nanoseconds
+     * per pair and leaving the forces of the last call on the nodes.
+     */
+    double TimeForce(AbstractForce<2>& rForce, NodeBasedCellPopulation<2>& rCellPopulation, unsigned numRepeats)
+    {
+        clock_t t1 = clock();
+        for (unsigned repeat = 0; repeat < numRepeats; repeat++)
+        {
+            for (unsigned i = 0; i < rCellPopulation.GetNumNodes(); i++)
+            {
+                rCellPopulation.GetNode(i)->ClearAppliedForce();
+            }
+            rForce.AddForceContribution(rCellPopulation);
+        }
+        double seconds = ((double)clock() - (double)t1) / CLOCKS_PER_SEC;
+        return 1e9 * seconds / ((double)numRepeats * rCellPopulation.rGetNodePairs().size());
+    }
+
+    std::vector<c_vector<double, 2> > GetForces(NodeBasedCellPopulation<2>& rCellPopulation)
+    {
+        std::vector<c_vector<double, 2> > forces;
+        for (unsigned i = 0; i < rCellPopulation.GetNumNodes(); i++)
+        {
+            forces.push_back(rCellPopulation.GetNode(i)->rGetAppliedForce());
+        }
+        return forces;
+    }
+
+public:
+
+    void TestSpringForcePerPairCost() throw (Exception)
+    {
+        unsigned num_cells = 1000;
+        unsigned num_repeats = 200;
+
+        RandomNumberGenerator::Instance()->Reseed(0);
+        std::vector<Node<2>*> nodes;
+        for (unsigned index = 0; index < num_cells; index++)
+        {
+            double x_coord = 40.0 * RandomNumberGenerator::Instance()->ranf();
+            double y_coord = 25.0 * RandomNumberGenerator::Instance()->ranf();
+            nodes.push_back(new Node<2>(index, false, x_coord, y_coord));
+        }
+
+        NodesOnlyMesh<2> mesh;
+        mesh.ConstructNodesWithoutMesh(nodes, 1.5);
+
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        std::vector<CellPtr> cells;
+        CellsGenerator<FixedDurationGenerationBasedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, mesh.GetNumNodes(), p_diff_type);
+
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+        cell_population.Update();
+        TS_ASSERT_LESS_THAN(0u, cell_population.rGetNodePairs().size());
+
+        BasicLinearSpringForce<2> basic_force;
+        basic_force.SetCutOffLength(1.5);
+        NodeBasedLinearSpringForce<2> node_based_force;
+        node_based_force.SetCutOffLength(1.5);
+        BasicLinearSpringForce<2> batched_force;
+        batched_force.SetCutOffLength(1.5);
+        batched_force.SetUseBatchedKernel(true);
+
+        double basic_time = TimeForce(basic_force, cell_population, num_repeats);
+        std::vector<c_vector<double, 2> > basic_forces = GetForces(cell_population);
+
+        double node_based_time = TimeForce(node_based_force, cell_population, num_repeats);
+        std::vector<c_vector<double, 2> > node_based_forces = GetForces(cell_population);
+
+        double batched_time = TimeForce(batched_force, cell_population, num_repeats);
+        std::vector<c_vector<double, 2> > batched_forces = GetForces(cell_population);
+
+        for (unsigned i = 0; i < basic_forces.size(); i++)
+        {
+            TS_ASSERT_DELTA(norm_2(node_based_forces[i] - basic_forces[i]), 0.0, 1e-10);
+            TS_ASSERT_DELTA(norm_2(batched_forces[i] - basic_forces[i]), 0.0, 1e-10);
+        }
+
+        cout << cell_population.rGetNodePairs().size() << " pairs, " << num_repeats << " repeats" << endl;
+        cout << std::setw(28) << "force" << std::setw(16) << "ns per pair" << endl;
+        cout << std::setw(28) << "BasicLinearSpringForce" << std::setw(16) << basic_time << endl;
+        cout << std::setw(28) << "NodeBasedLinearSpringForce" << std::setw(16) << node_based_time << endl;
+        cout << std::setw(28) << "batched kernel" << std::setw(16) << batched_time << endl;
+    }
+};
@@ -0,0 +1,463 @@
+/*
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+This file is part of Chaste.
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cxxtest/TestSuite.h>
+#include "CheckpointArchiveTypes.hpp"
+#include "AbstractCellBasedTestSuite.hpp"
+#include "FakePetscSetup.hpp"
+#include "SmartPointers.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+
+#include "AbstractForce.hpp"
+#include "NodeBasedCellPopulation.hpp"
+#include "OffLatticeSimulationUT.hpp"
+#include "GeneralisedLinearSpringForce.hpp"
+#include "CellsGenerator.hpp"
+#include "FixedDurationGenerationBasedCellCycleModel.hpp"
+#include "DifferentiatedCellProliferativeType.hpp"
+#include "PlaneBoundaryCondition.hpp"
+
+#include "GravityForce3.hpp"
+#include "AttachedCellMutationState.hpp"
+#include "ForwardEulerNumericalMethod.hpp"
+#include "RungeKutta2NumericalMethod.hpp"
+#include "RungeKutta4NumericalMethod.hpp"
+#include "SemiImplicitEulerNumericalMethod.hpp"
+
+/*
+ * A force tethering every node to its own anchor point by a linear spring, with a
+ * separate stiffness along each axis. With no other forces each coordinate of a node
+ * relaxes exponentially to its anchor, which gives an analytic solution to compare
+ * the numerical methods with.
+ */
+class AnisotropicTetherForce : public AbstractForce<2>
+{
+private:
+
+    /* The anchor of each node, by node index. */
+    std::vector<c_vector<double, 2> > mAnchors;
+
+    /* The spring constant along each axis. */
+    c_vector<double, 2> mStiffnesses;
+
+public:
+
+    AnisotropicTetherForce(const std::vector<c_vector<double, 2> >& rAnchors, double stiffnessX, double stiffnessY)
+        : AbstractForce<2>(),
+          mAnchors(rAnchors)
+    {
+        mStiffnesses(0) = stiffnessX;
+        mStiffnesses(1) = stiffnessY;
+    }
+
+    void AddForceContribution(AbstractCellPopulation<2>& rCellPopulation)
+    {
+        for (unsigned node_index = 0; node_index < mAnchors.size(); node_index++)
+        {
+            Node<2>* p_node = rCellPopulation.GetNode(node_index);
+            c_vector<double, 2> force;
+            for (unsigned d = 0; d < 2; d++)
+            {
+                force(d) = -mStiffnesses(d) * (p_node->rGetLocation()[d] - mAnchors[node_index](d));
+            }
+            p_node->AddAppliedForceContribution(force);
+        }
+    }
+
+    void OutputForceParameters(out_stream& rParamsFile)
+    {
+        *rParamsFile << "\t\t\t<StiffnessX>" << mStiffnesses(0) << "</StiffnessX>\n";
+        *rParamsFile << "\t\t\t<StiffnessY>" << mStiffnesses(1) << "</StiffnessY>\n";
+        AbstractForce<2>::OutputForceParameters(rParamsFile);
+    }
+};
+
+/*
+ * Time-to-accuracy benchmark for the numerical methods.
+ *
+ * A population of non-dividing cells, a fifth of them attached, relaxes under the
+ * spring force and GravityForce3 with the paper parameters. There is no diffusion
+ * force and no jiggling, so each run is deterministic. Every method is run over a
+ * range of time steps and compared with a fine RK4 reference; the error (largest
+ * node position difference at the end time) and run time are printed for each.
+ */
+class NumericalMethodsBenchmark : public AbstractCellBasedTestSuite
+{
+private:
+
+    /*
+     * Run the benchmark problem to the given end time with one numerical method.
+     * Returns false if the run failed (e.g. a node moved too far in a step).
+     */
+    bool RunBenchmarkProblem(boost::shared_ptr<AbstractNumericalMethod<2> > pMethod,
+                             double dt,
+                             double endTime,
+                             std::vector<c_vector<double, 2> >& rFinalLocations,
+                             double& rSeconds)
+    {
+        RandomNumberGenerator::Instance()->Reseed(0);
+
+        std::vector<Node<2>*> nodes;
+        for (unsigned index = 0; index < 60; index++)
+        {
+            double x_coord = 10.0 * RandomNumberGenerator::Instance()->ranf();
+            double y_coord = 5.0 * RandomNumberGenerator::Instance()->ranf();
+            nodes.push_back(new Node<2>(index, false, x_coord, y_coord));
+        }
+
+        NodesOnlyMesh<2> mesh;
+        mesh.ConstructNodesWithoutMesh(nodes, 1.5);
+        for (unsigned i = 0; i < nodes.size(); i++)
+        {
+            delete nodes[i];
+        }
+
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        MAKE_PTR(AttachedCellMutationState, p_attached_state);
+
+        std::vector<CellPtr> cells;
+        CellsGenerator<FixedDurationGenerationBasedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, mesh.GetNumNodes(), p_diff_type);
+        for (unsigned i = 0; i < cells.size(); i++)
+        {
+            cells[i]->GetCellData()->SetItem("concentrationA", 1.0);
+            if (i % 5 == 0)
+            {
+                cells[i]->SetMutationState(p_attached_state);
+            }
+        }
+
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+        cell_population.SetDampingConstantMutant(100.0);
+        cell_population.SetDampingConstantNormal(0.33);
+
+        OffLatticeSimulationUT<2> simulator(cell_population);
+        simulator.SetOutputDirectory("NumericalMethodsBenchmark");
+        simulator.SetSamplingTimestepMultiple(1000000);
+        simulator.SetDt(dt);
+        simulator.SetEndTime(endTime);
+        simulator.SetNumericalMethod(pMethod);
+
+        c_vector<double, 2> bc_point = zero_vector<double>(2);
+        c_vector<double, 2> bc_normal = zero_vector<double>(2);
+        bc_normal(1) = -1.0;
+        MAKE_PTR_ARGS(PlaneBoundaryCondition<2>, p_bc, (&cell_population, bc_point, bc_normal));
+        simulator.AddCellPopulationBoundaryCondition(p_bc);
+
+        MAKE_PTR(GeneralisedLinearSpringForce<2>, p_linear_force);
+        p_linear_force->SetCutOffLength(1.5);
+        simulator.AddForce(p_linear_force);
+
+        MAKE_PTR_ARGS(GravityForce3, p_gforce, (1.0));
+        p_gforce->SetRepulsionDistance(1.5);
+        p_gforce->SetRepulsionStrength(2.5);
+        p_gforce->SetAttachmentStrength(1.5);
+        p_gforce->SetDampingConst(100.0);
+        simulator.AddForce(p_gforce);
+
+        bool success = true;
+        clock_t t1 = clock();
+        try
+        {
+            simulator.Solve();
+        }
+        catch (Exception& e)
+        {
+            success = false;
+        }
+        rSeconds = ((double)clock() - (double)t1) / CLOCKS_PER_SEC;
+
+        rFinalLocations.assign(mesh.GetNumNodes(), zero_vector<double>(2));
+        for (unsigned i = 0; i < mesh.GetNumNodes(); i++)
+        {
+            rFinalLocations[i] = mesh.GetNode(i)->rGetLocation();
+        }
+
+        SimulationTime::Instance()->Destroy();
+        SimulationTime::Instance()->SetStartTime(0.0);
+
+        return success;
+    }
+
+    /*
+     * Relax a row of tethered nodes from an offset of 0.1 along each axis to the given
+     * end time with one numerical method, and return the largest difference from the
+     * analytic solution, or DBL_MAX if the run failed. The damping constant is one, so
+     * the relaxation rate along each axis is its stiffness.
+     */
+    double RunTetherProblem(boost::shared_ptr<AbstractNumericalMethod<2> > pMethod,
+                            double stiffnessX,
+                            double stiffnessY,
+                            double dt,
+                            double endTime)
+    {
+        double offset = 0.1;
+        std::vector<Node<2>*> nodes;
+        std::vector<c_vector<double, 2> > anchors;
+        for (unsigned index = 0; index < 20; index++)
+        {
+            c_vector<double, 2> anchor;
+            anchor(0) = 3.0 * index;
+            anchor(1) = 1.0;
+            anchors.push_back(anchor);
+            nodes.push_back(new Node<2>(index, false, anchor(0) + offset, anchor(1) + offset));
+        }
+
+        NodesOnlyMesh<2> mesh;
+        mesh.ConstructNodesWithoutMesh(nodes, 1.5);
+        for (unsigned i = 0; i < nodes.size(); i++)
+        {
+            delete nodes[i];
+        }
+
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        std::vector<CellPtr> cells;
+        CellsGenerator<FixedDurationGenerationBasedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, mesh.GetNumNodes(), p_diff_type);
+
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+        cell_population.SetDampingConstantNormal(1.0);
+
+        OffLatticeSimulationUT<2> simulator(cell_population);
+        simulator.SetOutputDirectory("NumericalMethodsBenchmark");
+        simulator.SetSamplingTimestepMultiple(1000000);
+        simulator.SetDt(dt);
+        simulator.SetEndTime(endTime);
+        simulator.SetNumericalMethod(pMethod);
+
+        MAKE_PTR_ARGS(AnisotropicTetherForce, p_force, (anchors, stiffnessX, stiffnessY));
+        simulator.AddForce(p_force);
+
+        double max_error = DBL_MAX;
+        try
+        {
+            simulator.Solve();
+
+            c_vector<double, 2> exact_offset;
+            exact_offset(0) = offset * exp(-stiffnessX * endTime);
+            exact_offset(1) = offset * exp(-stiffnessY * endTime);
+            max_error = 0.0;
+            for (unsigned i = 0; i < mesh.GetNumNodes(); i++)
+            {
+                double error = norm_2(mesh.GetNode(i)->rGetLocation() - anchors[i] - exact_offset);
+                max_error = std::max(max_error, error);
+            }
+            if (!(max_error < DBL_MAX))
+            {
+                max_error = DBL_MAX;
+            }
+        }
+        catch (Exception& e)
+        {
+        }
+
+        SimulationTime::Instance()->Destroy();
+        SimulationTime::Instance()->SetStartTime(0.0);
+
+        return max_error;
+    }
+
+    double MaximumError(const std::vector<c_vector<double, 2> >& rLocations,
+                        const std::vector<c_vector<double, 2> >& rReference)
+    {
+        double max_error = 0.0;
+        for (unsigned i = 0; i < rReference.size(); i++)
+        {
+            max_error = std::max(max_error, norm_2(rLocations[i] - rReference[i]));
+        }
+        return max_error;
+    }
+
+public:
+
+    /*
+     * Compare every method with the analytic solution of the tether problem, once with
+     * both axes relaxing at rate 1 and once with the x axis stiff, relaxing at rate 200
+     * while the y axis still relaxes at rate 1. The error of each method must be within
+     * its order of accuracy of zero, with constants taken from the leading error term
+     * of each scheme on the slow axis. In the stiff problem the explicit methods are
+     * only stable at the smallest step, where dt times 200 is within their stability
+     * regions, while the semi-implicit method must stay accurate at every step.
+     */
+    void TestNumericalMethodsAgainstAnalyticSolution() throw (Exception)
+    {
+        double end_time = 2.0;
+
+        std::vector<std::string> method_names;
+        std::vector<unsigned> orders;
+        std::vector<double> error_constants;
+        method_names.push_back("ForwardEuler");
+        orders.push_back(1);
+        error_constants.push_back(0.02);
+        method_names.push_back("RungeKutta2");
+        orders.push_back(2);
+        error_constants.push_back(0.01);
+        method_names.push_back("RungeKutta4");
+        orders.push_back(4);
+        error_constants.push_back(5e-4);
+        method_names.push_back("SemiImplicitEuler");
+        orders.push_back(1);
+        error_constants.push_back(0.02);
+
+        std::vector<double> dts;
+        dts.push_back(1.0/240.0);
+        dts.push_back(1.0/120.0);
+        dts.push_back(1.0/60.0);
+        dts.push_back(1.0/30.0);
+        dts.push_back(1.0/15.0);
+
+        std::vector<double> stiffnesses_x;
+        stiffnesses_x.push_back(1.0);
+        stiffnesses_x.push_back(200.0);
+
+        cout << std::setw(20) << "method" << std::setw(12) << "stiffness" << std::setw(12) << "1/dt" << std::setw(16) << "max error" << endl;
+        for (unsigned s = 0; s < stiffnesses_x.size(); s++)
+        {
+            bool is_stiff = (stiffnesses_x[s] > 1.0);
+            for (unsigned m = 0; m < method_names.size(); m++)
+            {
+                for (unsigned i = 0; i < dts.size(); i++)
+                {
+                    boost::shared_ptr<AbstractNumericalMethod<2> > p_method;
+                    switch (m)
+                    {
+                        case 0:
+                            p_method.reset(new ForwardEulerNumericalMethod<2>());
+                            break;
+                        case 1:
+                            p_method.reset(new RungeKutta2NumericalMethod<2>());
+                            break;
+                        case 2:
+                            p_method.reset(new RungeKutta4NumericalMethod<2>());
+                            break;
+                        default:
+                            p_method.reset(new SemiImplicitEulerNumericalMethod<2>());
+                    }
+
+                    double error = RunTetherProblem(p_method, stiffnesses_x[s], 1.0, dts[i], end_time);
+
+                    cout << std::setw(20) << method_names[m] << std::setw(12) << stiffnesses_x[s] << std::setw(12) << 1.0/dts[i];
+                    if (error < DBL_MAX)
+                    {
+                        cout << std::setw(16) << error << endl;
+                    }
+                    else
+                    {
+                        cout << std::setw(16) << "failed" << endl;
+                    }
+
+                    // A small allowance is made for rounding in the node locations
+                    double tolerance = error_constants[m] * pow(dts[i], (double)orders[m]) + 1e-10;
+                    bool must_be_stable = !is_stiff || i == 0 || method_names[m] == "SemiImplicitEuler";
+                    if (must_be_stable)
+                    {
+                        TS_ASSERT_LESS_THAN(error, tolerance);
+                    }
+                }
+            }
+        }
+    }
+
+    void TestNumericalMethodsTimeToAccuracy() throw (Exception)
+    {
+        double end_time = 2.0;
+
+        // Fine reference solution
+        std::vector<c_vector<double, 2> > reference;
+        double reference_seconds;
+        MAKE_PTR(RungeKutta4NumericalMethod<2>, p_reference_method);
+        TS_ASSERT(RunBenchmarkProblem(p_reference_method, 1.0/3840.0, end_time, reference, reference_seconds));
+
+        std::vector<std::string> method_names;
+        method_names.push_back("ForwardEuler");
+        method_names.push_back("RungeKutta2");
+        method_names.push_back("RungeKutta4");
+        method_names.push_back("SemiImplicitEuler");
+
+        std::vector<double> dts;
+        dts.push_back(1.0/240.0);
+        dts.push_back(1.0/120.0);
+        dts.push_back(1.0/60.0);
+        dts.push_back(1.0/30.0);
+        dts.push_back(1.0/15.0);
+
+        cout << std::setw(20) << "method" << std::setw(12) << "1/dt" << std::setw(16) << "max error" << std::setw(12) << "seconds" << endl;
+        for (unsigned m = 0; m < method_names.size(); m++)
+        {
+            std::vector<double> errors;
+            for (unsigned i = 0; i < dts.size(); i++)
+            {
+                boost::shared_ptr<AbstractNumericalMethod<2> > p_method;
+                switch (m)
+                {
+                    case 0:
+                        p_method.reset(new ForwardEulerNumericalMethod<2>());
+                        break;
+                    case 1:
+                        p_method.reset(new RungeKutta2NumericalMethod<2>());
+                        break;
+                    case 2:
+                        p_method.reset(new RungeKutta4NumericalMethod<2>());
+                        break;
+                    default:
+                        p_method.reset(new SemiImplicitEulerNumericalMethod<2>());
+                }
+
+                std::vector<c_vector<double, 2> > locations;
+                double seconds;
+                double error = DBL_MAX;
+                if (RunBenchmarkProblem(p_method, dts[i], end_time, locations, seconds))
+                {
+                    error = MaximumError(locations, reference);
+                }
+                errors.push_back(error);
+
+                cout << std::setw(20) << method_names[m] << std::setw(12) << 1.0/dts[i];
+                if (error < DBL_MAX)
+                {
+                    cout << std::setw(16) << error;
+                }
+                else
+                {
+                    cout << std::setw(16) << "failed";
+                }
+                cout << std::setw(12) << seconds << endl;
+            }
+
+            // Every method should at least be more accurate at the smallest step than at the largest
+            TS_ASSERT_LESS_THAN(errors.front(), DBL_MAX);
+            TS_ASSERT_LESS_THAN_EQUALS(errors.front(), errors.back());
+        }
+        cout << "Reference (RungeKutta4, 1/dt = 3840) : " << reference_seconds << " seconds" << endl;
+    }
+};
@@ -0,0 +1,164 @@
+/*
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+This file is part of Chaste.
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cxxtest/TestSuite.h>
+#include "CheckpointArchiveTypes.hpp"
+#include "AbstractCellBasedTestSuite.hpp"
+#include "FakePetscSetup.hpp"
+#include "SmartPointers.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+#include "Timer.hpp"
+#include "NodeBasedCellPopulation.hpp"
+#include "CellsGenerator.hpp"
+#include "FixedDurationGenerationBasedCellCycleModel.hpp"
+#include "DifferentiatedCellProliferativeType.hpp"
+
+#include "BasicLinearSpringForce.hpp"
+
+/*
+ * Thread scaling of the two-body spring force.
+ *
+ * Random populations of non-dividing cells of 1k, 10k and 100k cells, at about the
+ * density of the bud, are built once each. BasicLinearSpringForce is then called
+ * repeatedly on 1 to 32 threads, and the wall-clock time per call and speed-up over
+ * one thread are printed. The threaded forces are checked against the serial loop,
+ * and two calls on the same number of threads are checked to give bitwise identical
+ * forces. Only meaningful if built with OpenMP (openmp=1); otherwise every thread
+ * count runs serially.
+ */
+class TwoBodyForceScalingBenchmark : public AbstractCellBasedTestSuite
+{
+private:
+
+    /*
+     * Time the given number of calls to AddForceContribution(), returning seconds
+     * per call and leaving the forces of the last call on the nodes.
+     */
+    double TimeForce(AbstractForce<2>& rForce, NodeBasedCellPopulation<2>& rCellPopulation, unsigned numRepeats)
+    {
+        Timer::Reset();
+        for (unsigned repeat = 0; repeat < numRepeats; repeat++)
+        {
+            for (unsigned i = 0; i < rCellPopulation.GetNumNodes(); i++)
+            {
+                rCellPopulation.GetNode(i)->ClearAppliedForce();
+            }
+            rForce.AddForceContribution(rCellPopulation);
+        }
+        return Timer::GetElapsedTime() / numRepeats;
+    }
+
+    std::vector<c_vector<double, 2> > GetForces(NodeBasedCellPopulation<2>& rCellPopulation)
+    {
+        std::vector<c_vector<double, 2> > forces;
+        for (unsigned i = 0; i < rCellPopulation.GetNumNodes(); i++)
+        {
+            forces.push_back(rCellPopulation.GetNode(i)->rGetAppliedForce());
+        }
+        return forces;
+    }
+
+    void RunScaling(unsigned numCells)
+    {
+        // Keep about one cell per unit area, as in LinearSpringForceBenchmark
+        double scale = sqrt(numCells / 1000.0);
+        unsigned num_repeats = std::max(200000u / numCells, 2u);
+
+        RandomNumberGenerator::Instance()->Reseed(0);
+        std::vector<Node<2>*> nodes;
+        for (unsigned index = 0; index < numCells; index++)
+        {
+            double x_coord = 40.0 * scale * RandomNumberGenerator::Instance()->ranf();
+            double y_coord = 25.0 * scale * RandomNumberGenerator::Instance()->ranf();
+            nodes.push_back(new Node<2>(index, false, x_coord, y_coord));
+        }
+
+        NodesOnlyMesh<2> mesh;
+        mesh.ConstructNodesWithoutMesh(nodes, 1.5);
+
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        std::vector<CellPtr> cells;
+        CellsGenerator<FixedDurationGenerationBasedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, mesh.GetNumNodes(), p_diff_type);
+
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+        cell_population.Update();
+        TS_ASSERT_LESS_THAN(0u, cell_population.rGetNodePairs().size());
+
+        BasicLinearSpringForce<2> serial_force;
+        serial_force.SetCutOffLength(1.5);
+        TimeForce(serial_force, cell_population, 1);
+        std::vector<c_vector<double, 2> > serial_forces = GetForces(cell_population);
+
+        cout << numCells << " cells, " << cell_population.rGetNodePairs().size() << " pairs, " << num_repeats << " repeats" << endl;
+        cout << std::setw(10) << "threads" << std::setw(16) << "ms per call" << std::setw(12) << "speed-up" << endl;
+
+        double one_thread_time = 0.0;
+        for (unsigned num_threads = 1; num_threads <= 32; num_threads *= 2)
+        {
+            BasicLinearSpringForce<2> force;
+            force.SetCutOffLength(1.5);
+            force.SetNumThreads(num_threads);
+
+            TimeForce(force, cell_population, 1);
+            std::vector<c_vector<double, 2> > first_forces = GetForces(cell_population);
+
+            double time = TimeForce(force, cell_population, num_repeats);
+            std::vector<c_vector<double, 2> > forces = GetForces(cell_population);
+
+            for (unsigned i = 0; i < forces.size(); i++)
+            {
+                TS_ASSERT_DELTA(norm_2(forces[i] - serial_forces[i]), 0.0, 1e-10);
+                for (unsigned d = 0; d < 2; d++)
+                {
+                    TS_ASSERT_EQUALS(forces[i][d], first_forces[i][d]);
+                }
+            }
+
+            if (num_threads == 1)
+            {
+                one_thread_time = time;
+            }
+            cout << std::setw(10) << num_threads << std::setw(16) << 1e3 * time << std::setw(12) << one_thread_time / time << endl;
+        }
+    }
+
+public:
+
+    void TestSpringForceThreadScaling() throw (Exception)
+    {
+        RunScaling(1000);
+        RunScaling(10000);
+        RunScaling(100000);
+    }
+};
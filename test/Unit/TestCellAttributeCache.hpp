@@ -0,0 +1,212 @@
+/*
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+This file is part of Chaste.
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cxxtest/TestSuite.h>
+#include "AbstractCellBasedTestSuite.hpp"
+#include "FakePetscSetup.hpp"
+#include "SmartPointers.hpp"
+
+#include <vector>
+
+#include "NodeBasedCellPopulation.hpp"
+#include "NoCellCycleModel.hpp"
+#include "DifferentiatedCellProliferativeType.hpp"
+#include "TransitCellProliferativeType.hpp"
+#include "WildTypeCellMutationState.hpp"
+#include "AttachedCellMutationState.hpp"
+#include "RVCellMutationState.hpp"
+
+#include "CellAttributeCache.hpp"
+#include "UtericBudSimulationContext.hpp"
+
+/*
+ * Tests of CellAttributeCache: the attributes and counts it stores when rebuilt, keeping
+ * them up to date when one cell changes, and when Refresh() has to rebuild the cache.
+ */
+class TestCellAttributeCache : public AbstractCellBasedTestSuite
+{
+private:
+
+    /*
+     * Make a nodes-only mesh of numNodes nodes along the x axis. The first three
+     * cells are wild type transit cells, the next two are attached differentiated
+     * cells and any others are RV differentiated cells.
+     */
+    void MakeMeshAndCells(unsigned numNodes, NodesOnlyMesh<2>& rMesh, std::vector<CellPtr>& rCells)
+    {
+        std::vector<Node<2>*> nodes;
+        for (unsigned index = 0; index < numNodes; index++)
+        {
+            nodes.push_back(new Node<2>(index, false, 1.0*index, 0.0));
+        }
+        rMesh.ConstructNodesWithoutMesh(nodes, 1.5);
+        for (unsigned index = 0; index < numNodes; index++)
+        {
+            delete nodes[index];
+        }
+
+        MAKE_PTR(TransitCellProliferativeType, p_transit_type);
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        MAKE_PTR(WildTypeCellMutationState, p_wild_state);
+        MAKE_PTR(AttachedCellMutationState, p_attached_state);
+        MAKE_PTR(RVCellMutationState, p_rv_state);
+        for (unsigned index = 0; index < rMesh.GetNumNodes(); index++)
+        {
+            boost::shared_ptr<AbstractCellMutationState> p_state = (index < 3) ? p_wild_state : (index < 5) ? p_attached_state : p_rv_state;
+            CellPtr p_cell(new Cell(p_state, new NoCellCycleModel));
+            if (index < 3)
+            {
+                p_cell->SetCellProliferativeType(p_transit_type);
+            }
+            else
+            {
+                p_cell->SetCellProliferativeType(p_diff_type);
+            }
+            rCells.push_back(p_cell);
+        }
+    }
+
+public:
+
+    void TestRebuildStoresAttributesAndCounts() throw (Exception)
+    {
+        NodesOnlyMesh<2> mesh;
+        std::vector<CellPtr> cells;
+        MakeMeshAndCells(6, mesh, cells);
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+
+        CellAttributeCache<2> cache;
+        TS_ASSERT_EQUALS(cache.GetNumRebuilds(), 0u);
+        TS_ASSERT_EQUALS(cache.HasCell(0), false);
+
+        cache.Rebuild(cell_population);
+        TS_ASSERT_EQUALS(cache.GetNumRebuilds(), 1u);
+
+        for (AbstractCellPopulation<2>::Iterator cell_iter = cell_population.Begin();
+             cell_iter != cell_population.End();
+             ++cell_iter)
+        {
+            unsigned node_index = cell_population.GetLocationIndexUsingCell(*cell_iter);
+            TS_ASSERT_EQUALS(cache.HasCell(node_index), true);
+            TS_ASSERT_EQUALS(cache.GetCellId(node_index), cell_iter->GetCellId());
+            TS_ASSERT_EQUALS(cache.IsAttached(node_index), cell_iter->GetMutationState()->IsType<AttachedCellMutationState>());
+            TS_ASSERT_EQUALS(cache.IsRV(node_index), cell_iter->GetMutationState()->IsType<RVCellMutationState>());
+            TS_ASSERT_EQUALS(cache.GetProliferativeType(node_index) == TRANSIT_PROLIFERATIVE_TYPE,
+                             cell_iter->GetCellProliferativeType()->IsType<TransitCellProliferativeType>());
+            TS_ASSERT_DELTA(cache.GetDampingConstant(node_index), cell_population.GetDampingConstant(node_index), 1e-12);
+        }
+        TS_ASSERT_EQUALS(cache.HasCell(100), false);
+
+        TS_ASSERT_EQUALS(cache.GetNumCellsWithMutationState(WILD_TYPE_MUTATION_STATE), 3u);
+        TS_ASSERT_EQUALS(cache.GetNumCellsWithMutationState(ATTACHED_MUTATION_STATE), 2u);
+        TS_ASSERT_EQUALS(cache.GetNumCellsWithMutationState(RV_MUTATION_STATE), 1u);
+        TS_ASSERT_EQUALS(cache.GetNumCellsWithMutationState(OTHER_MUTATION_STATE), 0u);
+        TS_ASSERT_EQUALS(cache.GetNumCellsWithProliferativeType(TRANSIT_PROLIFERATIVE_TYPE), 3u);
+        TS_ASSERT_EQUALS(cache.GetNumCellsWithProliferativeType(DIFFERENTIATED_PROLIFERATIVE_TYPE), 3u);
+        TS_ASSERT_EQUALS(cache.GetNumCellsWithProliferativeType(OTHER_PROLIFERATIVE_TYPE), 0u);
+    }
+
+    void TestRefreshCellUpdatesCounts() throw (Exception)
+    {
+        NodesOnlyMesh<2> mesh;
+        std::vector<CellPtr> cells;
+        MakeMeshAndCells(6, mesh, cells);
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+
+        CellAttributeCache<2> cache;
+        cache.Rebuild(cell_population);
+
+        // Attach a wild type cell and tell the cache about it
+        CellPtr p_cell = cell_population.GetCellUsingLocationIndex(0);
+        MAKE_PTR(AttachedCellMutationState, p_attached_state);
+        p_cell->SetMutationState(p_attached_state);
+        cache.RefreshCell(cell_population, p_cell, 0);
+
+        TS_ASSERT_EQUALS(cache.IsAttached(0), true);
+        TS_ASSERT_DELTA(cache.GetDampingConstant(0), cell_population.GetDampingConstant(0), 1e-12);
+        TS_ASSERT_EQUALS(cache.GetNumCellsWithMutationState(WILD_TYPE_MUTATION_STATE), 2u);
+        TS_ASSERT_EQUALS(cache.GetNumCellsWithMutationState(ATTACHED_MUTATION_STATE), 3u);
+        TS_ASSERT_EQUALS(cache.GetNumRebuilds(), 1u);
+    }
+
+    void TestRefreshRebuildsOnlyWhenNeeded() throw (Exception)
+    {
+        NodesOnlyMesh<2> mesh;
+        std::vector<CellPtr> cells;
+        MakeMeshAndCells(6, mesh, cells);
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+
+        // Without a clock there is no way to tell that a time step has passed, so every refresh rebuilds
+        CellAttributeCache<2> cache;
+        TS_ASSERT_EQUALS(cache.Refresh(cell_population), true);
+        TS_ASSERT_EQUALS(cache.Refresh(cell_population), true);
+        TS_ASSERT_EQUALS(cache.GetNumRebuilds(), 2u);
+
+        // Setting a context invalidates the cache
+        boost::shared_ptr<UtericBudSimulationContext> p_context(new UtericBudSimulationContext(1));
+        p_context->SetClock(0.0, 0.01, 0);
+        cache.SetSimulationContext(p_context);
+        TS_ASSERT_EQUALS(cache.Refresh(cell_population), true);
+        TS_ASSERT_EQUALS(cache.Refresh(cell_population), false);
+        TS_ASSERT_EQUALS(cache.GetNumRebuilds(), 3u);
+
+        // A new time step
+        p_context->AdvanceClock();
+        TS_ASSERT_EQUALS(cache.Refresh(cell_population), true);
+        TS_ASSERT_EQUALS(cache.Refresh(cell_population), false);
+
+        // An explicit invalidation
+        cache.Invalidate();
+        TS_ASSERT_EQUALS(cache.Refresh(cell_population), true);
+
+        // A population with a different number of nodes
+        NodesOnlyMesh<2> larger_mesh;
+        std::vector<CellPtr> larger_cells;
+        MakeMeshAndCells(8, larger_mesh, larger_cells);
+        NodeBasedCellPopulation<2> larger_population(larger_mesh, larger_cells);
+        TS_ASSERT_EQUALS(cache.Refresh(larger_population), true);
+        TS_ASSERT_EQUALS(cache.GetNumCellsWithMutationState(RV_MUTATION_STATE), 3u);
+        TS_ASSERT_EQUALS(cache.GetNumRebuilds(), 6u);
+    }
+
+    void TestShareSimulationContext() throw (Exception)
+    {
+        boost::shared_ptr<UtericBudSimulationContext> p_context(new UtericBudSimulationContext(1));
+        boost::shared_ptr<UtericBudSimulationContext> p_other_context(new UtericBudSimulationContext(2));
+
+        CellAttributeCache<2> cache;
+        cache.ShareSimulationContext(p_context);
+        TS_ASSERT_EQUALS(cache.GetSimulationContext(), p_context);
+
+        // Sharing the same context again is fine, but a different one is not
+        TS_ASSERT_THROWS_NOTHING(cache.ShareSimulationContext(p_context));
+        TS_ASSERT_THROWS_THIS(cache.ShareSimulationContext(p_other_context),
+                              "An object of the simulation has a different simulation context from the simulation.");
+    }
+};
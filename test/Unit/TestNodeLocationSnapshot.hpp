@@ -0,0 +1,164 @@
+/*
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+This file is part of Chaste.
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cxxtest/TestSuite.h>
+#include "AbstractCellBasedTestSuite.hpp"
+#include "FakePetscSetup.hpp"
+
+#include <map>
+#include <vector>
+
+#include "NodesOnlyMesh.hpp"
+#include "NodeLocationSnapshot.hpp"
+
+/*
+ * Tests of NodeLocationSnapshot: storing and restoring the node locations of a mesh,
+ * storing them from a map, and measuring how far the nodes have moved.
+ */
+class TestNodeLocationSnapshot : public AbstractCellBasedTestSuite
+{
+private:
+
+    /* Make a nodes-only mesh of numNodes nodes spaced along the line y = 2x. */
+    void MakeMesh(unsigned numNodes, NodesOnlyMesh<2>& rMesh)
+    {
+        std::vector<Node<2>*> nodes;
+        for (unsigned index = 0; index < numNodes; index++)
+        {
+            nodes.push_back(new Node<2>(index, false, 0.5*index, 1.0*index));
+        }
+        rMesh.ConstructNodesWithoutMesh(nodes, 1.5);
+        for (unsigned index = 0; index < numNodes; index++)
+        {
+            delete nodes[index];
+        }
+    }
+
+public:
+
+    void TestStoreAndRestore() throw (Exception)
+    {
+        NodesOnlyMesh<2> mesh;
+        MakeMesh(10, mesh);
+
+        NodeLocationSnapshot<2> snapshot;
+        TS_ASSERT_EQUALS(snapshot.GetCapacity(), 0u);
+        snapshot.Store(mesh);
+        TS_ASSERT_LESS_THAN_EQUALS(10u, snapshot.GetCapacity());
+
+        for (AbstractMesh<2,2>::NodeIterator node_iter = mesh.GetNodeIteratorBegin();
+             node_iter != mesh.GetNodeIteratorEnd();
+             ++node_iter)
+        {
+            unsigned index = node_iter->GetIndex();
+            TS_ASSERT_DELTA(snapshot.GetCoordinate(index, 0), 0.5*index, 1e-12);
+            TS_ASSERT_DELTA(snapshot.GetCoordinate(index, 1), 1.0*index, 1e-12);
+            TS_ASSERT_DELTA(snapshot.GetLocation(index)[0], 0.5*index, 1e-12);
+            TS_ASSERT_DELTA(snapshot.GetLocation(index)[1], 1.0*index, 1e-12);
+            TS_ASSERT_DELTA(snapshot.rGetCoordinates(1)[index], 1.0*index, 1e-12);
+        }
+
+        // Nothing has moved yet
+        TS_ASSERT_DELTA(snapshot.GetMaximumDisplacement(mesh), 0.0, 1e-12);
+
+        // Move every node, one further than the others
+        for (AbstractMesh<2,2>::NodeIterator node_iter = mesh.GetNodeIteratorBegin();
+             node_iter != mesh.GetNodeIteratorEnd();
+             ++node_iter)
+        {
+            c_vector<double, 2>& r_location = node_iter->rGetModifiableLocation();
+            r_location[0] += 0.1;
+            if (node_iter->GetIndex() == 7)
+            {
+                r_location[0] += 0.2;
+                r_location[1] -= 0.4;
+            }
+        }
+        TS_ASSERT_DELTA(snapshot.GetMaximumDisplacement(mesh), 0.5, 1e-12);
+
+        // Restoring sends every node back to its stored location
+        snapshot.Restore(mesh);
+        TS_ASSERT_DELTA(snapshot.GetMaximumDisplacement(mesh), 0.0, 1e-12);
+        for (AbstractMesh<2,2>::NodeIterator node_iter = mesh.GetNodeIteratorBegin();
+             node_iter != mesh.GetNodeIteratorEnd();
+             ++node_iter)
+        {
+            unsigned index = node_iter->GetIndex();
+            TS_ASSERT_DELTA(node_iter->rGetLocation()[0], 0.5*index, 1e-12);
+            TS_ASSERT_DELTA(node_iter->rGetLocation()[1], 1.0*index, 1e-12);
+        }
+    }
+
+    void TestStoreFromMap() throw (Exception)
+    {
+        NodesOnlyMesh<2> mesh;
+        MakeMesh(5, mesh);
+
+        std::map<Node<2>*, c_vector<double, 2> > locations;
+        for (AbstractMesh<2,2>::NodeIterator node_iter = mesh.GetNodeIteratorBegin();
+             node_iter != mesh.GetNodeIteratorEnd();
+             ++node_iter)
+        {
+            c_vector<double, 2> location = node_iter->rGetLocation();
+            location[1] += 3.0;
+            locations[&(*node_iter)] = location;
+        }
+
+        NodeLocationSnapshot<2> snapshot;
+        snapshot.Store(locations);
+        TS_ASSERT_DELTA(snapshot.GetMaximumDisplacement(mesh), 3.0, 1e-12);
+
+        snapshot.Restore(mesh);
+        for (AbstractMesh<2,2>::NodeIterator node_iter = mesh.GetNodeIteratorBegin();
+             node_iter != mesh.GetNodeIteratorEnd();
+             ++node_iter)
+        {
+            TS_ASSERT_DELTA(node_iter->rGetLocation()[1], 1.0*node_iter->GetIndex() + 3.0, 1e-12);
+        }
+    }
+
+    void TestCapacityOnlyGrows() throw (Exception)
+    {
+        NodesOnlyMesh<2> large_mesh;
+        MakeMesh(20, large_mesh);
+        NodesOnlyMesh<2> small_mesh;
+        MakeMesh(3, small_mesh);
+
+        NodeLocationSnapshot<2> snapshot;
+        snapshot.Store(large_mesh);
+        unsigned capacity = snapshot.GetCapacity();
+        TS_ASSERT_LESS_THAN_EQUALS(20u, capacity);
+
+        // A smaller population reuses the arrays, and the other stored locations are untouched
+        snapshot.Store(small_mesh);
+        TS_ASSERT_EQUALS(snapshot.GetCapacity(), capacity);
+        TS_ASSERT_DELTA(snapshot.GetCoordinate(15, 0), 7.5, 1e-12);
+        TS_ASSERT_DELTA(snapshot.GetMaximumDisplacement(small_mesh), 0.0, 1e-12);
+    }
+};
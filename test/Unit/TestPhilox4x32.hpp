@@ -0,0 +1,109 @@
+/*
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+This file is part of Chaste.
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cxxtest/TestSuite.h>
+
+#include "Philox4x32.hpp"
+
+/*
+ * Known-answer tests of Philox4x32, with the Philox4x32-10 vectors published with
+ * Random123 (kat_vectors), and of the conversion of its words to uniform deviates.
+ */
+class TestPhilox4x32 : public CxxTest::TestSuite
+{
+private:
+
+    void CheckKnownAnswer(const Philox4x32::Word counter[4], const Philox4x32::Word key[2], const Philox4x32::Word expected[4])
+    {
+        Philox4x32::Word result[4];
+        Philox4x32::Generate(counter, key, result);
+        for (unsigned i = 0; i < 4; i++)
+        {
+            TS_ASSERT_EQUALS(result[i], expected[i]);
+        }
+    }
+
+public:
+
+    void TestKnownAnswers()
+    {
+        const Philox4x32::Word zero_counter[4] = {0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u};
+        const Philox4x32::Word zero_key[2] = {0x00000000u, 0x00000000u};
+        const Philox4x32::Word zero_result[4] = {0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u};
+        CheckKnownAnswer(zero_counter, zero_key, zero_result);
+
+        const Philox4x32::Word ones_counter[4] = {0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu};
+        const Philox4x32::Word ones_key[2] = {0xffffffffu, 0xffffffffu};
+        const Philox4x32::Word ones_result[4] = {0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu};
+        CheckKnownAnswer(ones_counter, ones_key, ones_result);
+
+        // The digits of pi
+        const Philox4x32::Word pi_counter[4] = {0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u};
+        const Philox4x32::Word pi_key[2] = {0xa4093822u, 0x299f31d0u};
+        const Philox4x32::Word pi_result[4] = {0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u};
+        CheckKnownAnswer(pi_counter, pi_key, pi_result);
+    }
+
+    void TestGenerateIsAFunctionOfCounterAndKey()
+    {
+        const Philox4x32::Word counter[4] = {1u, 2u, 3u, 4u};
+        const Philox4x32::Word key[2] = {5u, 6u};
+        Philox4x32::Word first[4];
+        Philox4x32::Word second[4];
+        Philox4x32::Generate(counter, key, first);
+        Philox4x32::Generate(counter, key, second);
+        for (unsigned i = 0; i < 4; i++)
+        {
+            TS_ASSERT_EQUALS(first[i], second[i]);
+        }
+
+        // A change of one bit in the counter changes every word
+        const Philox4x32::Word next_counter[4] = {1u, 2u, 3u, 5u};
+        Philox4x32::Generate(next_counter, key, second);
+        for (unsigned i = 0; i < 4; i++)
+        {
+            TS_ASSERT_DIFFERS(first[i], second[i]);
+        }
+    }
+
+    void TestToUniform()
+    {
+        TS_ASSERT_EQUALS(Philox4x32::ToUniform(0u, 0u), 0.0);
+
+        // The largest deviate is the largest double below one
+        double largest = Philox4x32::ToUniform(0xffffffffu, 0xffffffffu);
+        TS_ASSERT_LESS_THAN(largest, 1.0);
+        TS_ASSERT_EQUALS(largest, 1.0 - 1.0/9007199254740992.0);
+
+        // The top bit of the first word is worth a half, and the bits dropped from each word count for nothing
+        TS_ASSERT_EQUALS(Philox4x32::ToUniform(0x80000000u, 0u), 0.5);
+        TS_ASSERT_EQUALS(Philox4x32::ToUniform(0x0000001fu, 0x0000003fu), 0.0);
+        TS_ASSERT_EQUALS(Philox4x32::ToUniform(0u, 0x00000040u), 1.0/9007199254740992.0);
+    }
+};
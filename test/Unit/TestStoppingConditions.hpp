@@ -0,0 +1,290 @@
+/*
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+This file is part of Chaste.
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cxxtest/TestSuite.h>
+#include "AbstractCellBasedTestSuite.hpp"
+#include "FakePetscSetup.hpp"
+#include "SmartPointers.hpp"
+
+#include <ctime>
+#include <unistd.h>
+#include <vector>
+
+#include "NodeBasedCellPopulation.hpp"
+#include "NoCellCycleModel.hpp"
+#include "DifferentiatedCellProliferativeType.hpp"
+#include "TransitCellProliferativeType.hpp"
+#include "WildTypeCellMutationState.hpp"
+
+#include "PopulationBoundsStoppingCondition.hpp"
+#include "ExtinctionStoppingCondition.hpp"
+#include "QuantityConvergedStoppingCondition.hpp"
+#include "SteadyStateStoppingCondition.hpp"
+#include "WallClockStoppingCondition.hpp"
+#include "UtericBudSimulationContext.hpp"
+
+/*
+ * A QuantityConvergedStoppingCondition that samples a given series instead of the
+ * number of cells.
+ */
+class ScriptedQuantityConvergedStoppingCondition : public QuantityConvergedStoppingCondition<2>
+{
+private:
+
+    /* The series to sample, one value per sample. */
+    std::vector<double> mQuantities;
+
+    /* The number of values sampled so far. */
+    unsigned mNumSampled;
+
+protected:
+
+    double GetQuantity(AbstractCellPopulation<2>& rCellPopulation)
+    {
+        assert(mNumSampled < mQuantities.size());
+        return mQuantities[mNumSampled++];
+    }
+
+public:
+
+    ScriptedQuantityConvergedStoppingCondition(const std::vector<double>& rQuantities, unsigned samplingInterval, unsigned windowSize, double relativeTolerance)
+        : QuantityConvergedStoppingCondition<2>(samplingInterval, windowSize, relativeTolerance),
+          mQuantities(rQuantities),
+          mNumSampled(0)
+    {
+    }
+};
+
+/*
+ * Tests of the stopping conditions on small nodes-only populations that do not change
+ * unless the test changes them.
+ */
+class TestStoppingConditions : public AbstractCellBasedTestSuite
+{
+private:
+
+    /* Make a nodes-only mesh of numNodes nodes along the x axis, each with a transit cell. */
+    void MakeMeshAndCells(unsigned numNodes, NodesOnlyMesh<2>& rMesh, std::vector<CellPtr>& rCells)
+    {
+        std::vector<Node<2>*> nodes;
+        for (unsigned index = 0; index < numNodes; index++)
+        {
+            nodes.push_back(new Node<2>(index, false, 1.0*index, 0.5*index));
+        }
+        rMesh.ConstructNodesWithoutMesh(nodes, 1.5);
+        for (unsigned index = 0; index < numNodes; index++)
+        {
+            delete nodes[index];
+        }
+
+        MAKE_PTR(TransitCellProliferativeType, p_transit_type);
+        MAKE_PTR(WildTypeCellMutationState, p_state);
+        for (unsigned index = 0; index < rMesh.GetNumNodes(); index++)
+        {
+            CellPtr p_cell(new Cell(p_state, new NoCellCycleModel));
+            p_cell->SetCellProliferativeType(p_transit_type);
+            rCells.push_back(p_cell);
+        }
+    }
+
+public:
+
+    void TestPopulationBoundsStoppingCondition() throw (Exception)
+    {
+        NodesOnlyMesh<2> mesh;
+        std::vector<CellPtr> cells;
+        MakeMeshAndCells(6, mesh, cells);
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+
+        PopulationBoundsStoppingCondition<2> unbounded_condition;
+        TS_ASSERT_EQUALS(unbounded_condition.GetMinNumCells(), 0u);
+        TS_ASSERT_EQUALS(unbounded_condition.GetMaxNumCells(), UINT_MAX);
+        TS_ASSERT_EQUALS(unbounded_condition.HasOccurred(cell_population), false);
+
+        PopulationBoundsStoppingCondition<2> inside_condition(6, 6);
+        TS_ASSERT_EQUALS(inside_condition.HasOccurred(cell_population), false);
+        TS_ASSERT_EQUALS(inside_condition.rGetStoppingReason(), "");
+
+        PopulationBoundsStoppingCondition<2> below_condition(7, 10);
+        TS_ASSERT_EQUALS(below_condition.HasOccurred(cell_population), true);
+        TS_ASSERT_EQUALS(below_condition.rGetStoppingReason(), "Number of cells 6 outside [7, 10]");
+
+        PopulationBoundsStoppingCondition<2> above_condition(0, 5);
+        TS_ASSERT_EQUALS(above_condition.HasOccurred(cell_population), true);
+        TS_ASSERT_EQUALS(above_condition.rGetStoppingReason(), "Number of cells 6 outside [0, 5]");
+    }
+
+    void TestExtinctionStoppingCondition() throw (Exception)
+    {
+        NodesOnlyMesh<2> mesh;
+        std::vector<CellPtr> cells;
+        MakeMeshAndCells(4, mesh, cells);
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+
+        ExtinctionStoppingCondition<2> condition;
+        condition.SetupSolve(cell_population);
+        TS_ASSERT_EQUALS(condition.HasOccurred(cell_population), false);
+
+        // Differentiate the cells one at a time
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        for (unsigned index = 0; index < 4; index++)
+        {
+            TS_ASSERT_EQUALS(condition.HasOccurred(cell_population), false);
+            cell_population.GetCellUsingLocationIndex(index)->SetCellProliferativeType(p_diff_type);
+        }
+        TS_ASSERT_EQUALS(condition.HasOccurred(cell_population), true);
+        TS_ASSERT_EQUALS(condition.rGetStoppingReason(), "No transit cells left");
+
+        // A transit type object the condition has not seen before is still counted
+        MAKE_PTR(TransitCellProliferativeType, p_new_transit_type);
+        cell_population.GetCellUsingLocationIndex(2)->SetCellProliferativeType(p_new_transit_type);
+        TS_ASSERT_EQUALS(condition.HasOccurred(cell_population), false);
+    }
+
+    void TestQuantityConvergedStoppingCondition() throw (Exception)
+    {
+        NodesOnlyMesh<2> mesh;
+        std::vector<CellPtr> cells;
+        MakeMeshAndCells(6, mesh, cells);
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+
+        // By default the number of cells is sampled; it is constant, so converges once the window is full
+        QuantityConvergedStoppingCondition<2> condition(2, 3, 0.01);
+        TS_ASSERT_EQUALS(condition.GetSamplingInterval(), 2u);
+        TS_ASSERT_EQUALS(condition.GetWindowSize(), 3u);
+        TS_ASSERT_DELTA(condition.GetRelativeTolerance(), 0.01, 1e-12);
+        TS_ASSERT_DELTA(condition.GetAbsoluteTolerance(), 0.0, 1e-12);
+        condition.SetupSolve(cell_population);
+        for (unsigned call = 1; call < 6; call++)
+        {
+            TS_ASSERT_EQUALS(condition.HasOccurred(cell_population), false);
+        }
+        TS_ASSERT_EQUALS(condition.HasOccurred(cell_population), true);
+        TS_ASSERT_DELTA(condition.GetWindowMean(), 6.0, 1e-12);
+        TS_ASSERT_DELTA(condition.GetWindowRange(), 0.0, 1e-12);
+
+        // A series that settles within 5% of 100; the window range follows the samples in and out of the window
+        double values[] = {10.0, 200.0, 50.0, 103.0, 99.0, 101.0, 98.0};
+        std::vector<double> quantities(values, values + 7);
+        ScriptedQuantityConvergedStoppingCondition scripted_condition(quantities, 1, 4, 0.05);
+        scripted_condition.SetupSolve(cell_population);
+
+        TS_ASSERT_EQUALS(scripted_condition.HasOccurred(cell_population), false);
+        TS_ASSERT_EQUALS(scripted_condition.HasOccurred(cell_population), false);
+        TS_ASSERT_EQUALS(scripted_condition.HasOccurred(cell_population), false);
+        TS_ASSERT_EQUALS(scripted_condition.HasOccurred(cell_population), false);
+        TS_ASSERT_DELTA(scripted_condition.GetWindowRange(), 190.0, 1e-12);
+        TS_ASSERT_EQUALS(scripted_condition.HasOccurred(cell_population), false);
+        TS_ASSERT_DELTA(scripted_condition.GetWindowRange(), 150.0, 1e-12);
+        TS_ASSERT_EQUALS(scripted_condition.HasOccurred(cell_population), false);
+        TS_ASSERT_DELTA(scripted_condition.GetWindowRange(), 53.0, 1e-12);
+        TS_ASSERT_EQUALS(scripted_condition.HasOccurred(cell_population), true);
+        TS_ASSERT_DELTA(scripted_condition.GetWindowMean(), 100.25, 1e-12);
+        TS_ASSERT_DELTA(scripted_condition.GetWindowRange(), 5.0, 1e-12);
+
+        // An absolute tolerance allows convergence to zero
+        double zero_values[] = {0.5, -0.5, 0.25};
+        std::vector<double> zero_quantities(zero_values, zero_values + 3);
+        ScriptedQuantityConvergedStoppingCondition zero_condition(zero_quantities, 1, 3, 0.05);
+        zero_condition.SetAbsoluteTolerance(1.0);
+        zero_condition.SetupSolve(cell_population);
+        TS_ASSERT_EQUALS(zero_condition.HasOccurred(cell_population), false);
+        TS_ASSERT_EQUALS(zero_condition.HasOccurred(cell_population), false);
+        TS_ASSERT_EQUALS(zero_condition.HasOccurred(cell_population), true);
+    }
+
+    void TestSteadyStateStoppingCondition() throw (Exception)
+    {
+        NodesOnlyMesh<2> mesh;
+        std::vector<CellPtr> cells;
+        MakeMeshAndCells(6, mesh, cells);
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+
+        SteadyStateStoppingCondition condition(1, 4, 2);
+        TS_ASSERT_EQUALS(condition.GetSamplingInterval(), 1u);
+        TS_ASSERT_EQUALS(condition.GetNumPostSteadySamples(), 2u);
+        TS_ASSERT_THROWS_THIS(condition.SetupSolve(cell_population),
+                              "SteadyStateStoppingCondition needs a simulation context; add it to an OffLatticeSimulationWithStopUT or call SetSimulationContext().");
+
+        boost::shared_ptr<UtericBudSimulationContext> p_context(new UtericBudSimulationContext(1));
+        p_context->SetClock(0.0, 0.25, 0);
+        condition.SetSimulationContext(p_context);
+        condition.SetupSolve(cell_population);
+
+        // Nothing changes, so the population is steady as soon as the windows are full
+        for (unsigned call = 1; call <= 5; call++)
+        {
+            p_context->AdvanceClock();
+            TS_ASSERT_EQUALS(condition.HasOccurred(cell_population), false);
+        }
+        TS_ASSERT_DELTA(condition.GetSteadyStateTime(), 1.0, 1e-12);
+
+        p_context->AdvanceClock();
+        TS_ASSERT_EQUALS(condition.HasOccurred(cell_population), true);
+        TS_ASSERT_EQUALS(condition.rGetStoppingReason(), "Steady state reached at t = 1 and sampled 2 times");
+
+        // Moving the lowest cell changes the cap height and restarts the count of steady samples
+        condition.SetupSolve(cell_population);
+        for (unsigned call = 1; call <= 4; call++)
+        {
+            p_context->AdvanceClock();
+            TS_ASSERT_EQUALS(condition.HasOccurred(cell_population), false);
+        }
+        TS_ASSERT_DIFFERS(condition.GetSteadyStateTime(), DOUBLE_UNSET);
+        cell_population.GetNode(0)->rGetModifiableLocation()[1] -= 10.0;
+        p_context->AdvanceClock();
+        TS_ASSERT_EQUALS(condition.HasOccurred(cell_population), false);
+        TS_ASSERT_EQUALS(condition.GetSteadyStateTime(), DOUBLE_UNSET);
+    }
+
+    void TestWallClockStoppingCondition() throw (Exception)
+    {
+        NodesOnlyMesh<2> mesh;
+        std::vector<CellPtr> cells;
+        MakeMeshAndCells(2, mesh, cells);
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+
+        WallClockStoppingCondition<2> unlimited_condition;
+        TS_ASSERT_EQUALS(unlimited_condition.GetBudget(), DBL_MAX);
+        unlimited_condition.SetupSolve(cell_population);
+        TS_ASSERT_EQUALS(unlimited_condition.HasOccurred(cell_population), false);
+
+        // Wait until at least a whole second has passed since the budget started
+        WallClockStoppingCondition<2> condition(0.5);
+        condition.SetupSolve(cell_population);
+        time_t setup_time = time(NULL);
+        while (difftime(time(NULL), setup_time) < 1.0)
+        {
+            sleep(1);
+        }
+        TS_ASSERT_EQUALS(condition.HasOccurred(cell_population), true);
+        TS_ASSERT_EQUALS(condition.rGetStoppingReason(), "Wall-clock budget of 0.5 seconds used up");
+        TS_ASSERT_EQUALS(unlimited_condition.HasOccurred(cell_population), false);
+    }
+};
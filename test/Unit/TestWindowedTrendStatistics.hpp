@@ -0,0 +1,165 @@
+/*
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+This file is part of Chaste.
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cxxtest/TestSuite.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <deque>
+
+#include "WindowedTrendStatistics.hpp"
+
+/*
+ * Tests of WindowedTrendStatistics against series whose statistics are known exactly,
+ * and against the same statistics computed directly from the window.
+ */
+class TestWindowedTrendStatistics : public CxxTest::TestSuite
+{
+private:
+
+    /* Compute the slope, its t statistic and the variance ratio of rWindow directly. */
+    void ComputeDirectly(const std::deque<double>& rWindow, double& rSlope, double& rSlopeStatistic, double& rVarianceRatio)
+    {
+        double n = rWindow.size();
+        double mean_index = 0.5*(n - 1.0);
+        double mean = 0.0;
+        for (unsigned k = 0; k < rWindow.size(); k++)
+        {
+            mean += rWindow[k]/n;
+        }
+
+        double s_xx = 0.0;
+        double s_xy = 0.0;
+        for (unsigned k = 0; k < rWindow.size(); k++)
+        {
+            s_xx += (k - mean_index)*(k - mean_index);
+            s_xy += (k - mean_index)*(rWindow[k] - mean);
+        }
+        rSlope = s_xy/s_xx;
+
+        double residual = 0.0;
+        for (unsigned k = 0; k < rWindow.size(); k++)
+        {
+            double error = rWindow[k] - mean - rSlope*(k - mean_index);
+            residual += error*error;
+        }
+        rSlopeStatistic = fabs(rSlope)/sqrt(residual/((n - 2.0)*s_xx));
+
+        unsigned num_older = rWindow.size()/2;
+        double variances[2];
+        for (unsigned half = 0; half < 2; half++)
+        {
+            unsigned begin = (half == 0) ? 0 : num_older;
+            unsigned end = (half == 0) ? num_older : rWindow.size();
+            double half_mean = 0.0;
+            for (unsigned k = begin; k < end; k++)
+            {
+                half_mean += rWindow[k]/(end - begin);
+            }
+            double sum_squares = 0.0;
+            for (unsigned k = begin; k < end; k++)
+            {
+                sum_squares += (rWindow[k] - half_mean)*(rWindow[k] - half_mean);
+            }
+            variances[half] = sum_squares/(end - begin - 1);
+        }
+        rVarianceRatio = std::max(variances[0]/variances[1], variances[1]/variances[0]);
+    }
+
+public:
+
+    void TestConstantAndLinearSeries()
+    {
+        WindowedTrendStatistics statistics(8);
+        TS_ASSERT_EQUALS(statistics.GetWindowSize(), 8u);
+
+        for (unsigned k = 0; k < 8; k++)
+        {
+            TS_ASSERT_EQUALS(statistics.IsFull(), false);
+            statistics.AddSample(5.0);
+        }
+        TS_ASSERT_EQUALS(statistics.IsFull(), true);
+        TS_ASSERT_DELTA(statistics.GetMean(), 5.0, 1e-12);
+        TS_ASSERT_DELTA(statistics.GetSlope(), 0.0, 1e-12);
+        TS_ASSERT_EQUALS(statistics.GetSlopeStatistic(), 0.0);
+        TS_ASSERT_EQUALS(statistics.GetVarianceRatio(), 1.0);
+
+        // An exact line has a slope known to infinite confidence
+        statistics.Reset();
+        TS_ASSERT_EQUALS(statistics.IsFull(), false);
+        for (unsigned k = 0; k < 20; k++)
+        {
+            statistics.AddSample(3.0 + 2.0*k);
+        }
+        TS_ASSERT_DELTA(statistics.GetMean(), 3.0 + 2.0*15.5, 1e-10);
+        TS_ASSERT_DELTA(statistics.GetSlope(), 2.0, 1e-10);
+        TS_ASSERT_EQUALS(statistics.GetSlopeStatistic(), DBL_MAX);
+        TS_ASSERT_DELTA(statistics.GetVarianceRatio(), 1.0, 1e-10);
+
+        // Only the newer half of the window varies
+        statistics.Reset();
+        for (unsigned k = 0; k < 8; k++)
+        {
+            statistics.AddSample(k < 4 ? 1.0 : (k % 2 == 0 ? 0.0 : 2.0));
+        }
+        TS_ASSERT_EQUALS(statistics.GetVarianceRatio(), DBL_MAX);
+    }
+
+    void TestAgreesWithDirectComputation()
+    {
+        // The window slides past several recomputations of the running sums
+        unsigned window_size = 11;
+        WindowedTrendStatistics statistics(window_size);
+        std::deque<double> window;
+
+        unsigned state = 12345;
+        for (unsigned sample = 0; sample < 100; sample++)
+        {
+            state = 1664525u*state + 1013904223u;
+            double value = 1000.0 + 0.1*sample + (state >> 8)/double(1u << 24);
+
+            statistics.AddSample(value);
+            window.push_back(value);
+            if (window.size() > window_size)
+            {
+                window.pop_front();
+            }
+
+            if (window.size() > 3)
+            {
+                double slope, slope_statistic, variance_ratio;
+                ComputeDirectly(window, slope, slope_statistic, variance_ratio);
+                TS_ASSERT_DELTA(statistics.GetSlope(), slope, 1e-9);
+                TS_ASSERT_DELTA(statistics.GetSlopeStatistic(), slope_statistic, 1e-6*slope_statistic);
+                TS_ASSERT_DELTA(statistics.GetVarianceRatio(), variance_ratio, 1e-6*variance_ratio);
+            }
+        }
+    }
+};
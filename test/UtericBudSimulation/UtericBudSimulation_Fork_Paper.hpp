@@ -0,0 +1,236 @@
+/*
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+This file is part of Chaste.
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cxxtest/TestSuite.h>
+#include "CheckpointArchiveTypes.hpp"
+#include "AbstractCellBasedTestSuite.hpp"
+#include "FakePetscSetup.hpp"
+#include "SmartPointers.hpp"
+
+#include "OffLatticeSimulationWithStopUT.hpp"
+#include "CellBasedSimulationArchiver.hpp"
+#include "CMCellCycleModel.hpp"
+#include "AttachmentModifier.hpp"
+#include "UtericBudSimulationContext.hpp"
+
+/*
+ * Continue parameter variants from simulations archived part way through by
+ * UtericBudSimulation_Sweeper_Paper, instead of repeating the initial growth from
+ * 30 seeded cells for every variant.
+ *
+ * First run the paper driver up to the end of the transient with -checkpoint, e.g.
+ *     -sim_time 200 -num_sims 20 -checkpoint
+ * then fork from those archives with
+ *     -checkpoint_dir UtericBud_model_2_param_0.6_pa_0.5_pd_0.5_simtime_200
+ *     -checkpoint_time 200 -sim_time 1000 -num_sims 20
+ *     -attachment_probability 0.1 0.3 0.5 -detachment_probability 0.5 -parameter 0.6 0.8
+ *
+ * Each replicate sim_<i> is loaded once for every combination of the listed
+ * attachment probabilities, detachment probabilities and differentiation model
+ * parameters; any of the lists may be omitted to keep the archived value. Pass
+ * -replicate_rng and -counter_rng exactly when the checkpoints were made with them;
+ * the random number scheme is archived with each simulation and checked on loading.
+ */
+class UtericBudSimulationFork : public AbstractCellBasedTestSuite
+{
+private:
+
+    std::vector<double> GetVariantValues(const std::string& rOption)
+    {
+        std::vector<double> values;
+        if (CommandLineArguments::Instance()->OptionExists(rOption))
+        {
+            values = CommandLineArguments::Instance()->GetDoublesCorrespondingToOption(rOption);
+        }
+        else
+        {
+            // Keep the archived value
+            values.push_back(DOUBLE_UNSET);
+        }
+        return values;
+    }
+
+public:
+
+    void TestForkFromCheckpoint() throw (Exception)
+    {
+        if (!CommandLineArguments::Instance()->OptionExists("-checkpoint_dir"))
+        {
+            cout << "No -checkpoint_dir given, nothing to fork" << endl;
+            return;
+        }
+        std::string checkpoint_dir = CommandLineArguments::Instance()->GetStringCorrespondingToOption("-checkpoint_dir");
+
+        double checkpoint_time = 100;
+        if (CommandLineArguments::Instance()->OptionExists("-checkpoint_time"))
+        {
+            checkpoint_time = (double) atof(CommandLineArguments::Instance()->GetStringCorrespondingToOption("-checkpoint_time").c_str());
+        }
+
+        double simulation_time = 1000;
+        if (CommandLineArguments::Instance()->OptionExists("-sim_time"))
+        {
+            simulation_time = (double) atof(CommandLineArguments::Instance()->GetStringCorrespondingToOption("-sim_time").c_str());
+        }
+
+        double num_sims = 2;
+        if (CommandLineArguments::Instance()->OptionExists("-num_sims"))
+        {
+            num_sims = (double) atof(CommandLineArguments::Instance()->GetStringCorrespondingToOption("-num_sims").c_str());
+        }
+
+        // The random number scheme must be the one the checkpoints were made with
+        bool use_replicate_rng = CommandLineArguments::Instance()->OptionExists("-replicate_rng");
+        bool use_counter_rng = CommandLineArguments::Instance()->OptionExists("-counter_rng");
+
+        std::vector<double> attachment_probabilities = GetVariantValues("-attachment_probability");
+        std::vector<double> detachment_probabilities = GetVariantValues("-detachment_probability");
+        std::vector<double> diff_model_params = GetVariantValues("-parameter");
+
+        for (unsigned sim_index = 0; sim_index < num_sims; sim_index++)
+        {
+            std::stringstream checkpoint;
+            checkpoint << checkpoint_dir << "_sim_" << sim_index;
+
+            for (unsigned pa_index = 0; pa_index < attachment_probabilities.size(); pa_index++)
+            {
+                for (unsigned pd_index = 0; pd_index < detachment_probabilities.size(); pd_index++)
+                {
+                    for (unsigned param_index = 0; param_index < diff_model_params.size(); param_index++)
+                    {
+                        clock_t t1, t2;
+                        t1 = clock();
+
+                        /* Load the archived transient */
+                        OffLatticeSimulationWithStopUT* p_simulator = CellBasedSimulationArchiver<2, OffLatticeSimulationWithStopUT>::Load(checkpoint.str(), checkpoint_time);
+
+                        boost::shared_ptr<UtericBudSimulationContext> p_context = p_simulator->GetSimulationContext();
+                        if (p_context->HasOwnRandomNumberGenerator() != use_replicate_rng)
+                        {
+                            EXCEPTION("The checkpoint " << checkpoint.str() << (use_replicate_rng ? " was made without" : " was made with")
+                                      << " -replicate_rng, so it must be forked " << (use_replicate_rng ? "without" : "with") << " it too.");
+                        }
+                        if (p_context->HasCounterBasedStreams() != use_counter_rng)
+                        {
+                            EXCEPTION("The checkpoint " << checkpoint.str() << (use_counter_rng ? " was made without" : " was made with")
+                                      << " -counter_rng, so it must be forked " << (use_counter_rng ? "without" : "with") << " it too.");
+                        }
+
+                        /* Apply the variant parameters */
+                        boost::shared_ptr<AttachmentModifier<2> > p_attach_modifier;
+                        std::vector<boost::shared_ptr<AbstractCellBasedSimulationModifier<2> > >* p_modifiers = p_simulator->GetSimulationModifiers();
+                        for (unsigned i = 0; i < p_modifiers->size(); i++)
+                        {
+                            if (boost::dynamic_pointer_cast<AttachmentModifier<2> >((*p_modifiers)[i]))
+                            {
+                                p_attach_modifier = boost::dynamic_pointer_cast<AttachmentModifier<2> >((*p_modifiers)[i]);
+                            }
+                        }
+                        if (!p_attach_modifier)
+                        {
+                            EXCEPTION("The checkpoint " << checkpoint.str() << " has no AttachmentModifier to vary.");
+                        }
+
+                        if (attachment_probabilities[pa_index] != DOUBLE_UNSET)
+                        {
+                            p_attach_modifier->SetAttachmentProbability(attachment_probabilities[pa_index]);
+                        }
+                        if (detachment_probabilities[pd_index] != DOUBLE_UNSET)
+                        {
+                            p_attach_modifier->SetDetachmentProbability(detachment_probabilities[pd_index]);
+                        }
+
+                        AbstractCellPopulation<2>& r_cell_population = p_simulator->rGetCellPopulation();
+                        double diff_model_param = DOUBLE_UNSET;
+                        for (AbstractCellPopulation<2>::Iterator cell_iter = r_cell_population.Begin();
+                             cell_iter != r_cell_population.End();
+                             ++cell_iter)
+                        {
+                            CMCellCycleModel* p_model = dynamic_cast<CMCellCycleModel*>(cell_iter->GetCellCycleModel());
+                            if (p_model == NULL)
+                            {
+                                EXCEPTION("The checkpoint " << checkpoint.str() << " has a cell without a CMCellCycleModel.");
+                            }
+                            if (diff_model_params[param_index] != DOUBLE_UNSET)
+                            {
+                                p_model->SetDiffModelParam(diff_model_params[param_index]);
+                            }
+                            diff_model_param = p_model->GetDiffModelParam();
+                        }
+
+                        /* Give each variant its own output directory and random stream */
+                        std::stringstream out;
+                        out << "_param_" << diff_model_param;
+                        out << "_pa_" << p_attach_modifier->GetAttachmentProbability();
+                        out << "_pd_" << p_attach_modifier->GetDetachmentProbability();
+                        out << "_simtime_" << simulation_time;
+                        out << "_sim_" << sim_index;
+                        std::string output_directory = "UtericBudFork" + out.str();
+
+                        RandomNumberGenerator::Instance()->Reseed(100.0 * sim_index + 1.0);
+                        if (use_replicate_rng)
+                        {
+                            p_context->Reseed(100 * sim_index + 1);
+                        }
+                        if (use_counter_rng)
+                        {
+                            p_context->UseCounterBasedStreams(100 * sim_index + 1);
+                        }
+
+                        p_simulator->SetOutputDirectory(output_directory);
+                        p_simulator->SetEndTime(simulation_time);
+
+                        /* Run Simulation and output runtime */
+                        p_simulator->Solve();
+
+                        cout << "// ------------------------- " << endl;
+                        cout << "// ----- Forked run : " << output_directory << endl;
+
+                        cout << "Simulation time : " << checkpoint_time << " -> " << p_context->GetTime() << "/" << simulation_time << " hours "<< endl;
+                        if (!p_simulator->rGetStoppingReason().empty())
+                        {
+                            cout << "Stopped early : " << p_simulator->rGetStoppingReason() << endl;
+                        }
+                        cout << "Final cell count : " << r_cell_population.GetNumNodes() << endl;
+
+                        t2 = clock();
+                        cout << "Runtime : " << (((float)t2 - (float)t1) / CLOCKS_PER_SEC) << " seconds" << endl;
+
+                        delete p_simulator;
+
+                        SimulationTime::Instance()->Destroy();
+                        SimulationTime::Instance()->SetStartTime(0.0);
+                    }
+                }
+            }
+        }
+
+        cout << "// ------------------------- " << endl;
+    }
+};
@@ -58,6 +58,7 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "RVCellMutationState.hpp"
 #include "UtericBudMutationStateWriter.hpp"
 #include "SelectivePlaneBoundaryCondition.hpp"
+#include "UtericBudSimulationContext.hpp"
 #include "BasicLinearSpringForce.hpp"
 #include "UtericBudCellTypesCountWriter.hpp"
 
@@ -66,7 +67,8 @@ class UtericBudSimulation : public AbstractCellBasedTestSuite
 {
 private:
 
-    void GenerateCells(unsigned num_cells, std::vector<CellPtr>& rCells)
+    void GenerateCells(unsigned num_cells, std::vector<CellPtr>& rCells,
+                       boost::shared_ptr<UtericBudSimulationContext> p_context)
     {
         /* Cell cycle options */
         double div_age_mean = 10.0; 
@@ -86,6 +88,7 @@ private:
         for (unsigned i = 0; i < num_cells; i++)
         {
             CMCellCycleModel* p_model = new CMCellCycleModel;
+            p_model->SetSimulationContext(p_context);
             p_model->SetAverageDivisionAge(div_age_mean);
             p_model->SetStdDivisionAge(div_age_std);
             p_model->SetCritVolume(div_crit_volume);
@@ -253,7 +256,8 @@ public:
         
             /* Generate Cells */
             std::vector<CellPtr> cells;
-            GenerateCells(mesh.GetNumNodes(), cells);
+            boost::shared_ptr<UtericBudSimulationContext> p_context(new UtericBudSimulationContext);
+            GenerateCells(mesh.GetNumNodes(), cells, p_context);
         
         
         
@@ -276,6 +280,7 @@ public:
         
             /* Begin OffLatticeSimulation */ 
             OffLatticeSimulationWithStopUT simulator(cell_population);
+            simulator.SetSimulationContext(p_context);
             simulator.SetOutputDirectory(output_directory);
             simulator.SetSamplingTimestepMultiple(simulation_output_mult);
             simulator.SetDt(simulation_dt);
@@ -38,7 +38,9 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "NodeBasedCellPopulation.hpp"
 //#include "OffLatticeSimulation.hpp"
 #include "OffLatticeSimulationWithStopUT.hpp"
+#include "CellBasedSimulationArchiver.hpp"
 #include "GeneralisedLinearSpringForce.hpp"
+#include "VerletGeneralisedLinearSpringForce.hpp"
 #include "TransitCellProliferativeType.hpp"
 #include "DifferentiatedCellProliferativeType.hpp"
 #include "WildTypeCellMutationState.hpp"
@@ -51,6 +53,7 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "GravityForce3.hpp"
 #include "BasicDiffusionForce.hpp"
+#include "UtericBudBodyForce.hpp"
 #include "CMCellCycleModel.hpp"
 #include "ChemTrackingModifier.hpp"
 #include "AttachedCellMutationState.hpp"
@@ -58,15 +61,28 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "RVCellMutationState.hpp"
 #include "UtericBudMutationStateWriter.hpp"
 #include "SelectivePlaneBoundaryCondition.hpp"
+#include "HalfPlaneDomainBoundaryCondition.hpp"
+#include "RungeKutta2NumericalMethod.hpp"
+#include "RungeKutta4NumericalMethod.hpp"
+#include "SemiImplicitEulerNumericalMethod.hpp"
 #include "BasicLinearSpringForce.hpp"
 #include "UtericBudCellTypesCountWriter.hpp"
+#include "PopulationBoundsStoppingCondition.hpp"
+#include "ExtinctionStoppingCondition.hpp"
+#include "WallClockStoppingCondition.hpp"
+#include "QuantityConvergedStoppingCondition.hpp"
+#include "SteadyStateStoppingCondition.hpp"
+#include "UtericBudSimulationContext.hpp"
+#include "ConcurrentReplicateRunner.hpp"
+#include "CellId.hpp"
 
 
 class UtericBudSimulation : public AbstractCellBasedTestSuite
 {
 private:
 
-    void GenerateCells(unsigned num_cells, std::vector<CellPtr>& rCells, int diff_model, double diff_model_param)
+    void GenerateCells(unsigned num_cells, std::vector<CellPtr>& rCells, int diff_model, double diff_model_param,
+                       boost::shared_ptr<UtericBudSimulationContext> p_context)
     {
         /* Cell cycle options */
         double div_age_mean = 20.0; // 10.0
@@ -97,6 +113,7 @@ private:
             //p_model->SetTDProbability(div_td_probability);
             //p_model->SetRVProbability(RV_diff_probability);
             p_model->SetTDYThreshold(div_td_y_threshold);
+            p_model->SetSimulationContext(p_context);
             
             
             CellPtr p_cell(new Cell(p_state, p_model));
@@ -158,14 +175,76 @@ public:
             simulation_time = (double) atof(CommandLineArguments::Instance()->GetStringCorrespondingToOption("-sim_time").c_str());
         }
         
+        // Give each run its own random stream for the project classes, rather than drawing from RandomNumberGenerator
+        bool use_replicate_rng = CommandLineArguments::Instance()->OptionExists("-replicate_rng");
+        
+        // Key the project's random numbers by cell and time step, so runs do not depend on the number of threads
+        bool use_counter_rng = CommandLineArguments::Instance()->OptionExists("-counter_rng");
+        
+        // Archive each run at the end time, so that UtericBudSimulation_Fork_Paper can continue variants from it
+        bool save_checkpoint = CommandLineArguments::Instance()->OptionExists("-checkpoint");
+        
         double num_sims = 2;
         if (CommandLineArguments::Instance()->OptionExists("-num_sims"))
         {
             num_sims = (double) atof(CommandLineArguments::Instance()->GetStringCorrespondingToOption("-num_sims").c_str());
         }
         
+        // Run this many replicates at once, each in a worker process of its own
+        unsigned num_processes = 1;
+        if (CommandLineArguments::Instance()->OptionExists("-num_processes"))
+        {
+            num_processes = (unsigned) atoi(CommandLineArguments::Instance()->GetStringCorrespondingToOption("-num_processes").c_str());
+        }
+        
+        unsigned num_force_threads = 1;
+        if (CommandLineArguments::Instance()->OptionExists("-num_force_threads"))
+        {
+            num_force_threads = (unsigned) atoi(CommandLineArguments::Instance()->GetStringCorrespondingToOption("-num_force_threads").c_str());
+        }
+        
+        // 0 = forward Euler, 1 = RK2, 2 = RK4, 3 = semi-implicit Euler
+        int numerical_method = 0;
+        if (CommandLineArguments::Instance()->OptionExists("-numerical_method"))
+        {
+            numerical_method = (int) atof(CommandLineArguments::Instance()->GetStringCorrespondingToOption("-numerical_method").c_str());
+        }
+        
         double simulation_output_mult = 120;
         double simulation_dt = 1.0/240.0; // 1.0/180.0  1.0/200.0
+        if (CommandLineArguments::Instance()->OptionExists("-dt"))
+        {
+            simulation_dt = (double) atof(CommandLineArguments::Instance()->GetStringCorrespondingToOption("-dt").c_str());
+        }
+        
+        
+        /* Stopping options */
+        unsigned min_num_cells = 0;
+        if (CommandLineArguments::Instance()->OptionExists("-min_cells"))
+        {
+            min_num_cells = (unsigned) atoi(CommandLineArguments::Instance()->GetStringCorrespondingToOption("-min_cells").c_str());
+        }
+        unsigned max_num_cells = 1000;
+        if (CommandLineArguments::Instance()->OptionExists("-max_cells"))
+        {
+            max_num_cells = (unsigned) atoi(CommandLineArguments::Instance()->GetStringCorrespondingToOption("-max_cells").c_str());
+        }
+        bool stop_on_extinction = CommandLineArguments::Instance()->OptionExists("-stop_on_extinction");
+        double wall_clock_budget = 0.0; // seconds, 0 = no budget
+        if (CommandLineArguments::Instance()->OptionExists("-wall_clock_budget"))
+        {
+            wall_clock_budget = (double) atof(CommandLineArguments::Instance()->GetStringCorrespondingToOption("-wall_clock_budget").c_str());
+        }
+        double cell_count_tolerance = 0.0; // relative range of the cell count over 20 hours, 0 = never converged
+        if (CommandLineArguments::Instance()->OptionExists("-cell_count_tolerance"))
+        {
+            cell_count_tolerance = (double) atof(CommandLineArguments::Instance()->GetStringCorrespondingToOption("-cell_count_tolerance").c_str());
+        }
+        unsigned steady_state_samples = 0; // output samples to collect after steady state, 0 = run to the end time
+        if (CommandLineArguments::Instance()->OptionExists("-steady_state_samples"))
+        {
+            steady_state_samples = (unsigned) atoi(CommandLineArguments::Instance()->GetStringCorrespondingToOption("-steady_state_samples").c_str());
+        }
         
         double simulation_region_x = 20; // 20
         double simulation_region_y = 20; // 10
@@ -196,6 +275,30 @@ public:
             gforce_repulsion_strength = (double) atof(CommandLineArguments::Instance()->GetStringCorrespondingToOption("-gforce_repulsion_strength").c_str());
         }
         double gforce_attachment_strength = 1.5;
+        double stroma_height = 10.0;
+        if (CommandLineArguments::Instance()->OptionExists("-stroma_height"))
+        {
+            stroma_height = (double) atof(CommandLineArguments::Instance()->GetStringCorrespondingToOption("-stroma_height").c_str());
+        }
+        
+        // Take spring force pairs from a Verlet list with this skin, 0 = use the population's pairs
+        double verlet_skin = 0.0;
+        if (CommandLineArguments::Instance()->OptionExists("-verlet_skin"))
+        {
+            verlet_skin = (double) atof(CommandLineArguments::Instance()->GetStringCorrespondingToOption("-verlet_skin").c_str());
+        }
+        
+        // Compute gravity, anchoring and diffusion in one pass (same trajectories as the separate forces)
+        bool use_fused_body_force = CommandLineArguments::Instance()->OptionExists("-fused_body_force");
+        
+        // Clamp and kill against all the domain planes in one pass, rather than with separate boundary conditions and killers
+        bool use_composite_domain = CommandLineArguments::Instance()->OptionExists("-composite_domain");
+        
+        // Only visit the nodes in the boxes near the planes when imposing the selective and domain boundary conditions
+        bool use_boundary_band = CommandLineArguments::Instance()->OptionExists("-boundary_band");
+        
+        // Schedule each cell's next attachment or detachment instead of flipping a coin for every cell on every step
+        bool use_event_attachment = CommandLineArguments::Instance()->OptionExists("-event_attachment");
         
         
         /* Attachment options */
@@ -231,8 +334,13 @@ public:
         
         
         
+        ConcurrentReplicateRunner runner(num_processes);
         for (unsigned sim_index = 0; sim_index < num_sims; sim_index++)
         {
+            if (!runner.StartReplicate())
+            {
+                continue;
+            }
         
             /* Setup timer, output directory and RNG seed */
             clock_t t1, t2;
@@ -249,6 +357,17 @@ public:
 	        
 	        
 	        RandomNumberGenerator::Instance()->Reseed(100.0 * sim_index);
+	        CellId::ResetMaxCellId();
+	        
+	        boost::shared_ptr<UtericBudSimulationContext> p_context(new UtericBudSimulationContext);
+	        if (use_replicate_rng)
+	        {
+	            p_context->Reseed(100 * sim_index);
+	        }
+	        if (use_counter_rng)
+	        {
+	            p_context->UseCounterBasedStreams(100 * sim_index);
+	        }
         
         
         
@@ -269,12 +388,16 @@ public:
             /* Generate Mesh */ 
             NodesOnlyMesh<2> mesh;
             mesh.ConstructNodesWithoutMesh(nodes, 1.5);
+            for (unsigned i = 0; i < nodes.size(); i++)
+            {
+                delete nodes[i];
+            }
         
         
         
             /* Generate Cells */
             std::vector<CellPtr> cells;
-            GenerateCells(mesh.GetNumNodes(), cells, diff_model, diff_model_param);
+            GenerateCells(mesh.GetNumNodes(), cells, diff_model, diff_model_param, p_context);
         
         
         
@@ -289,7 +412,8 @@ public:
         
         
             /* Add CellWriters */
-            cell_population.AddCellPopulationCountWriter<UtericBudCellTypesCountWriter>();
+            boost::shared_ptr<UtericBudCellTypesCountWriter<2,2> > p_cell_types_writer(new UtericBudCellTypesCountWriter<2,2>());
+            cell_population.AddCellPopulationCountWriter(p_cell_types_writer);
             cell_population.AddCellWriter<UtericBudMutationStateWriter>();
             cell_population.AddCellWriter<CellAgesWriter>();
         
@@ -297,78 +421,173 @@ public:
         
             /* Begin OffLatticeSimulation */ 
             OffLatticeSimulationWithStopUT simulator(cell_population);
+            simulator.SetSimulationContext(p_context);
+            p_cell_types_writer->SetCellAttributeCache(simulator.GetCellAttributeCache());
             simulator.SetOutputDirectory(output_directory);
             simulator.SetSamplingTimestepMultiple(simulation_output_mult);
             simulator.SetDt(simulation_dt);
+            simulator.SetNumForceThreads(num_force_threads);
+            if (numerical_method == 1)
+            {
+                MAKE_PTR(RungeKutta2NumericalMethod<2>, p_numerical_method);
+                simulator.SetNumericalMethod(p_numerical_method);
+            }
+            else if (numerical_method == 2)
+            {
+                MAKE_PTR(RungeKutta4NumericalMethod<2>, p_numerical_method);
+                simulator.SetNumericalMethod(p_numerical_method);
+            }
+            else if (numerical_method == 3)
+            {
+                MAKE_PTR(SemiImplicitEulerNumericalMethod<2>, p_numerical_method);
+                simulator.SetNumericalMethod(p_numerical_method);
+            }
             simulator.SetEndTime(simulation_time);
             simulator.SetOutputCellVelocities(true);
             simulator.SetOutputDivisionLocations(true);
         
         
         
-            /* Add BoundaryConditions */
-            c_vector<double, 2> bc_point_1 = zero_vector<double>(2);
-            c_vector<double, 2> bc_normal_1 = zero_vector<double>(2);
-            bc_normal_1(1) = -1.0;
+            /* Add StoppingConditions */
+            simulator.RemoveAllStoppingConditions();
+            MAKE_PTR_ARGS(PopulationBoundsStoppingCondition<2>, p_bounds_stop, (min_num_cells, max_num_cells));
+            simulator.AddStoppingCondition(p_bounds_stop);
+            if (stop_on_extinction)
+            {
+                MAKE_PTR(ExtinctionStoppingCondition<2>, p_extinction_stop);
+                simulator.AddStoppingCondition(p_extinction_stop);
+            }
+            if (wall_clock_budget > 0.0)
+            {
+                MAKE_PTR_ARGS(WallClockStoppingCondition<2>, p_wall_clock_stop, (wall_clock_budget));
+                simulator.AddStoppingCondition(p_wall_clock_stop);
+            }
+            if (cell_count_tolerance > 0.0)
+            {
+                // Sample once per hour over a 20 hour window
+                unsigned samples_per_hour = (unsigned) (1.0/simulation_dt + 0.5);
+                MAKE_PTR_ARGS(QuantityConvergedStoppingCondition<2>, p_converged_stop, (samples_per_hour, 20, cell_count_tolerance));
+                simulator.AddStoppingCondition(p_converged_stop);
+            }
+            if (steady_state_samples > 0)
+            {
+                // Sample at the output times so the samples match celltypescount.dat
+                MAKE_PTR_ARGS(SteadyStateStoppingCondition, p_steady_stop, ((unsigned) simulation_output_mult, 20, steady_state_samples));
+                simulator.AddStoppingCondition(p_steady_stop);
+            }
+        
+        
+        
+            /* Add BoundaryConditions and CellKillers */
+            boost::shared_ptr<HalfPlaneDomainBoundaryCondition<2,2> > p_domain_bc(new HalfPlaneDomainBoundaryCondition<2,2>(&cell_population));
+            if (use_composite_domain)
+            {
+                c_vector<double, 2> origin = zero_vector<double>(2);
+                c_vector<double, 2> unit_x = zero_vector<double>(2);
+                unit_x(0) = 1.0;
+                c_vector<double, 2> unit_y = zero_vector<double>(2);
+                unit_y(1) = 1.0;
+                
+                p_domain_bc->AddClampingPlane(origin, -unit_y, true);
+                p_domain_bc->AddClampingPlane(origin, -unit_x, true);
+                p_domain_bc->AddClampingPlane(permeable_barrier_x*unit_x, unit_x, false,
+                                              HalfPlaneDomainBoundaryCondition<2,2>::GetTag(RV_MUTATION_STATE));
+                p_domain_bc->AddKillingPlane(simulation_region_x*unit_x, unit_x);
+                p_domain_bc->AddKillingPlane(simulation_region_y*unit_y, unit_y);
+                p_domain_bc->SetSimulationContext(p_context);
+                p_domain_bc->SetUseBoundaryBandIndex(use_boundary_band);
+                simulator.AddCellPopulationBoundaryCondition(p_domain_bc);
+            }
+            else
+            {
+                /* Add BoundaryConditions */
+                c_vector<double, 2> bc_point_1 = zero_vector<double>(2);
+                c_vector<double, 2> bc_normal_1 = zero_vector<double>(2);
+                bc_normal_1(1) = -1.0;
         
-            MAKE_PTR_ARGS(PlaneBoundaryCondition<2>, p_bc1, (&cell_population, bc_point_1, bc_normal_1));
-            p_bc1->SetUseJiggledNodesOnPlane(true);
-            simulator.AddCellPopulationBoundaryCondition(p_bc1);
+                MAKE_PTR_ARGS(PlaneBoundaryCondition<2>, p_bc1, (&cell_population, bc_point_1, bc_normal_1));
+                p_bc1->SetUseJiggledNodesOnPlane(true);
+                simulator.AddCellPopulationBoundaryCondition(p_bc1);
         
-            c_vector<double, 2> bc_point_2 = zero_vector<double>(2);
-            c_vector<double, 2> bc_normal_2 = zero_vector<double>(2);
-            bc_normal_2(0) = -1.0;
+                c_vector<double, 2> bc_point_2 = zero_vector<double>(2);
+                c_vector<double, 2> bc_normal_2 = zero_vector<double>(2);
+                bc_normal_2(0) = -1.0;
         
-            MAKE_PTR_ARGS(PlaneBoundaryCondition<2>, p_bc2, (&cell_population, bc_point_2, bc_normal_2));
-            p_bc2->SetUseJiggledNodesOnPlane(true);
-            simulator.AddCellPopulationBoundaryCondition(p_bc2);
+                MAKE_PTR_ARGS(PlaneBoundaryCondition<2>, p_bc2, (&cell_population, bc_point_2, bc_normal_2));
+                p_bc2->SetUseJiggledNodesOnPlane(true);
+                simulator.AddCellPopulationBoundaryCondition(p_bc2);
         
-            c_vector<double, 2> bc_point_3 = zero_vector<double>(2);
-            bc_point_3(0) = permeable_barrier_x;
-            c_vector<double, 2> bc_normal_3 = zero_vector<double>(2);
-            bc_normal_3(0) = 1.0;
+                c_vector<double, 2> bc_point_3 = zero_vector<double>(2);
+                bc_point_3(0) = permeable_barrier_x;
+                c_vector<double, 2> bc_normal_3 = zero_vector<double>(2);
+                bc_normal_3(0) = 1.0;
         
-            MAKE_PTR_ARGS(SelectivePlaneBoundaryCondition<2>, p_bc3, (&cell_population, bc_point_3, bc_normal_3));
-            //p_bc3->SetUseJiggledNodesOnPlane(true);
-            simulator.AddCellPopulationBoundaryCondition(p_bc3);
+                MAKE_PTR_ARGS(SelectivePlaneBoundaryCondition<2>, p_bc3, (&cell_population, bc_point_3, bc_normal_3));
+                //p_bc3->SetUseJiggledNodesOnPlane(true);
+                p_bc3->SetSimulationContext(p_context);
+                p_bc3->SetUseBoundaryBandIndex(use_boundary_band);
+                simulator.AddCellPopulationBoundaryCondition(p_bc3);
         
         
         
-            /* Add CellKillers */
-            c_vector<double, 2> ck_point_1 = zero_vector<double>(2);
-            ck_point_1(0) = simulation_region_x;
-            c_vector<double, 2> ck_normal_1 = zero_vector<double>(2);
-            ck_normal_1(0) = 1.0;
+                /* Add CellKillers */
+                c_vector<double, 2> ck_point_1 = zero_vector<double>(2);
+                ck_point_1(0) = simulation_region_x;
+                c_vector<double, 2> ck_normal_1 = zero_vector<double>(2);
+                ck_normal_1(0) = 1.0;
         
-            MAKE_PTR_ARGS(PlaneBasedCellKiller<2>, p_killer_x, (&cell_population, ck_point_1, ck_normal_1));
-            simulator.AddCellKiller(p_killer_x);
+                MAKE_PTR_ARGS(PlaneBasedCellKiller<2>, p_killer_x, (&cell_population, ck_point_1, ck_normal_1));
+                simulator.AddCellKiller(p_killer_x);
         
-            c_vector<double, 2> ck_point_2 = zero_vector<double>(2);
-            ck_point_2(1) = simulation_region_y;
-            c_vector<double, 2> ck_normal_2 = zero_vector<double>(2);
-            ck_normal_2(1) = 1.0;
+                c_vector<double, 2> ck_point_2 = zero_vector<double>(2);
+                ck_point_2(1) = simulation_region_y;
+                c_vector<double, 2> ck_normal_2 = zero_vector<double>(2);
+                ck_normal_2(1) = 1.0;
         
-            MAKE_PTR_ARGS(PlaneBasedCellKiller<2>, p_killer_y, (&cell_population, ck_point_2, ck_normal_2));
-            simulator.AddCellKiller(p_killer_y);
+                MAKE_PTR_ARGS(PlaneBasedCellKiller<2>, p_killer_y, (&cell_population, ck_point_2, ck_normal_2));
+                simulator.AddCellKiller(p_killer_y);
+            }
         
         
         
             /* Add CellForces */ 
             MAKE_PTR(GeneralisedLinearSpringForce<2>, p_linear_force);
             //MAKE_PTR(BasicLinearSpringForce<2>, p_linear_force);
+            MAKE_PTR(VerletGeneralisedLinearSpringForce<2>, p_verlet_force);
+            if (verlet_skin > 0.0)
+            {
+                p_verlet_force->SetVerletSkin(verlet_skin);
+                p_linear_force = p_verlet_force;
+            }
             p_linear_force->SetCutOffLength(1.5);
             simulator.AddForce(p_linear_force);
         
-            MAKE_PTR_ARGS(GravityForce3, p_gforce, (gforce_strength));
-            p_gforce->SetRepulsionDistance(gforce_repulsion_distance);
-            p_gforce->SetRepulsionStrength(gforce_repulsion_strength);
-            p_gforce->SetAttachmentStrength(gforce_attachment_strength);
-            p_gforce->SetRVRightStrength(rv_rforce_strength);
-            p_gforce->SetDampingConst(attached_damping_constant);
-            simulator.AddForce(p_gforce);
-        
-            MAKE_PTR_ARGS(BasicDiffusionForce, p_dforce, (dforce_strength));
-            simulator.AddForce(p_dforce);
+            if (use_fused_body_force)
+            {
+                MAKE_PTR_ARGS(UtericBudBodyForce, p_body_force, (gforce_strength, dforce_strength));
+                p_body_force->SetRepulsionDistance(gforce_repulsion_distance);
+                p_body_force->SetRepulsionStrength(gforce_repulsion_strength);
+                p_body_force->SetAttachmentStrength(gforce_attachment_strength);
+                p_body_force->SetDampingConst(attached_damping_constant);
+                p_body_force->SetStromaHeight(stroma_height);
+                p_body_force->SetSimulationContext(p_context);
+                simulator.AddForce(p_body_force);
+            }
+            else
+            {
+                MAKE_PTR_ARGS(GravityForce3, p_gforce, (gforce_strength));
+                p_gforce->SetRepulsionDistance(gforce_repulsion_distance);
+                p_gforce->SetRepulsionStrength(gforce_repulsion_strength);
+                p_gforce->SetAttachmentStrength(gforce_attachment_strength);
+                p_gforce->SetRVRightStrength(rv_rforce_strength);
+                p_gforce->SetDampingConst(attached_damping_constant);
+                p_gforce->SetStromaHeight(stroma_height);
+                simulator.AddForce(p_gforce);
+        
+                MAKE_PTR_ARGS(BasicDiffusionForce, p_dforce, (dforce_strength));
+                p_dforce->SetSimulationContext(p_context);
+                simulator.AddForce(p_dforce);
+            }
         
         
         
@@ -376,6 +595,7 @@ public:
             MAKE_PTR(ChemTrackingModifier<2>, p_chem_modifier);
             //p_chem_modifier->SetConcBModel(conc_b_model);
             //p_chem_modifier->SetConcBParameter(conc_b_parameter);
+            p_chem_modifier->SetPopulationUpdateCoordinator(simulator.GetPopulationUpdateCoordinator());
             simulator.AddSimulationModifier(p_chem_modifier);
         
             MAKE_PTR(VolumeTrackingModifier<2>, p_vol_modifier);
@@ -386,6 +606,10 @@ public:
             p_attach_modifier->SetDetachmentProbability(detachment_probability);
             p_attach_modifier->SetAttachmentHeight(attachment_height);
             p_attach_modifier->SetOutputAttachmentDurations(true); 
+            p_attach_modifier->SetSimulationContext(p_context);
+            p_attach_modifier->SetCellAttributeCache(simulator.GetCellAttributeCache());
+            p_attach_modifier->SetPopulationUpdateCoordinator(simulator.GetPopulationUpdateCoordinator());
+            p_attach_modifier->SetUseEventScheduling(use_event_attachment);
             simulator.AddSimulationModifier(p_attach_modifier);
 
         
@@ -397,6 +621,10 @@ public:
             cout << "// ----- Simulation run : " << sim_index << endl;
             
             cout << "Simulation time : " << SimulationTime::Instance()->GetTime() << "/" << simulation_time << " hours "<< endl;
+            if (!simulator.rGetStoppingReason().empty())
+            {
+                cout << "Stopped early : " << simulator.rGetStoppingReason() << endl;
+            }
         
             cout << "Diff model : " << diff_model << endl;
             cout << "Diff model parameter value : " << diff_model_param << endl;
@@ -407,6 +635,47 @@ public:
         
             unsigned cell_count = cell_population.GetNumNodes();
             cout << "Final cell count : " << cell_count << endl;
+            
+            if (verlet_skin > 0.0)
+            {
+                const VerletNeighbourList<2>& r_verlet_list = p_verlet_force->rGetVerletNeighbourList();
+                cout << "Verlet list rebuilds : " << r_verlet_list.GetNumRebuilds() << "/" << r_verlet_list.GetNumUpdates() << " steps" << endl;
+            }
+            
+            if (use_event_attachment)
+            {
+                cout << "Attachment events : " << p_attach_modifier->GetNumEventsProcessed() << endl;
+            }
+            
+            boost::shared_ptr<PopulationUpdateCoordinator<2> > p_coordinator = simulator.GetPopulationUpdateCoordinator();
+            cout << "Modifier population updates : " << p_coordinator->GetNumUpdates() << " made, "
+                 << p_coordinator->GetNumSkippedUpdates() << " skipped" << endl;
+            
+            if (use_composite_domain)
+            {
+                for (unsigned plane = 0; plane < p_domain_bc->GetNumPlanes(); plane++)
+                {
+                    cout << "Domain plane " << plane << " : " << p_domain_bc->GetNumClamps(plane) << " clamps, "
+                         << p_domain_bc->GetNumKills(plane) << " kills" << endl;
+                }
+                if (use_boundary_band)
+                {
+                    const BoundaryBandIndex<2>& r_band = p_domain_bc->rGetBoundaryBandIndex();
+                    cout << "Boundary band : " << r_band.GetNumCandidateBoxes() << " boxes, "
+                         << r_band.GetNumFullScans() << "/" << r_band.GetNumQueries() << " full scans" << endl;
+                }
+            }
+            
+            // Forks load the archive at the end time, so a run that stopped early has none
+            if (save_checkpoint && simulator.rGetStoppingReason().empty())
+            {
+                CellBasedSimulationArchiver<2, OffLatticeSimulationWithStopUT>::Save(&simulator);
+                cout << "Checkpoint : " << output_directory << " at time " << SimulationTime::Instance()->GetTime() << endl;
+            }
+            else if (save_checkpoint)
+            {
+                cout << "Checkpoint : none, as the run stopped early" << endl;
+            }
         
             t2 = clock();
             float seconds = (((float)t2 - (float)t1) / CLOCKS_PER_SEC);
@@ -415,7 +684,9 @@ public:
             SimulationTime::Instance()->Destroy();
             SimulationTime::Instance()->SetStartTime(0.0);
             
+            runner.FinishReplicate();
         }
+        runner.WaitForReplicates();
         
         cout << "// ------------------------- " << endl;
         
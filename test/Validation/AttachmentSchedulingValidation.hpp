@@ -0,0 +1,320 @@
+/*
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+This file is part of Chaste.
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cxxtest/TestSuite.h>
+#include "CheckpointArchiveTypes.hpp"
+#include "AbstractCellBasedTestSuite.hpp"
+#include "FakePetscSetup.hpp"
+#include "SmartPointers.hpp"
+
+
+#include <cmath>
+#include <sstream>
+
+#include "NodeBasedCellPopulation.hpp"
+#include "NoCellCycleModel.hpp"
+#include "FixedDurationGenerationBasedCellCycleModel.hpp"
+#include "CellsGenerator.hpp"
+#include "DifferentiatedCellProliferativeType.hpp"
+#include "TransitCellProliferativeType.hpp"
+#include "WildTypeCellMutationState.hpp"
+#include "AttachedCellMutationState.hpp"
+#include "PlaneBoundaryCondition.hpp"
+#include "RandomCellKiller.hpp"
+
+#include "AttachmentModifier.hpp"
+#include "BasicLinearSpringForce.hpp"
+#include "BasicDiffusionForce.hpp"
+#include "OffLatticeSimulationUT.hpp"
+#include "UtericBudSimulationContext.hpp"
+
+#include "EnsembleComparison.hpp"
+
+/*
+ * Statistical equivalence of event-driven attachment scheduling.
+ *
+ * A population of cells is driven up and down through the attachment band, each
+ * with its own phase, and AttachmentModifier is stepped by hand, once flipping a
+ * coin for every cell on every time step and once scheduling each cell's next
+ * successful attempt. The random numbers are used differently, so the comparison
+ * is between ensembles of runs. For each run the mean number of attached cells over
+ * the second half of the run and the numbers of attachments and detachments are
+ * measured.
+ *
+ * A second case runs the modifier in a simulation whose cells divide and die at
+ * random, so that daughters must be scheduled as they are born and the events of
+ * dead cells skipped. There the numbers of cells and of attached cells at the end
+ * are measured.
+ *
+ * The ensemble means must agree to within three standard errors of their difference,
+ * as checked by EnsembleComparison.
+ */
+class AttachmentSchedulingValidation : public AbstractCellBasedTestSuite
+{
+private:
+
+    /* The observables, in the order in which they are measured. */
+    enum Observable
+    {
+        MEAN_ATTACHED,
+        NUM_ATTACHMENTS,
+        NUM_DETACHMENTS,
+        NUM_OBSERVABLES
+    };
+
+    /* The observables of the case with division and death. */
+    enum PopulationObservable
+    {
+        TOTAL_COUNT,
+        ATTACHED_COUNT,
+        NUM_POPULATION_OBSERVABLES
+    };
+
+    /*
+     * Run the modifier over a moving population and return the observables.
+     */
+    std::vector<double> RunAttachment(unsigned runIndex, bool useEventScheduling, double endTime)
+    {
+        unsigned num_cells = 400;
+        double dt = 1.0/240.0;
+        unsigned num_steps = (unsigned) floor(endTime/dt + 0.5);
+
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(endTime, num_steps);
+        RandomNumberGenerator::Instance()->Reseed(100 * runIndex);
+        boost::shared_ptr<UtericBudSimulationContext> p_context(new UtericBudSimulationContext(100 * runIndex));
+        p_context->SetClock(0.0, dt, 0);
+
+        // Each cell moves between heights 0 and 3 with a period of four hours
+        std::vector<Node<2>*> nodes;
+        std::vector<double> phases;
+        for (unsigned index = 0; index < num_cells; index++)
+        {
+            phases.push_back(2.0 * M_PI * RandomNumberGenerator::Instance()->ranf());
+            nodes.push_back(new Node<2>(index, false, 0.5 * index, 1.5 + 1.5 * sin(phases[index])));
+        }
+
+        NodesOnlyMesh<2> mesh;
+        mesh.ConstructNodesWithoutMesh(nodes, 1.5);
+
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        MAKE_PTR(WildTypeCellMutationState, p_state);
+        std::vector<CellPtr> cells;
+        for (unsigned i = 0; i < mesh.GetNumNodes(); i++)
+        {
+            CellPtr p_cell(new Cell(p_state, new NoCellCycleModel));
+            p_cell->SetCellProliferativeType(p_diff_type);
+            p_cell->GetCellData()->SetItem("AttachTime", 0);
+            cells.push_back(p_cell);
+        }
+
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+
+        AttachmentModifier<2> modifier;
+        modifier.SetAttachmentProbability(0.5);
+        modifier.SetDetachmentProbability(0.6);
+        modifier.SetAttachmentHeight(1.0);
+        modifier.SetSimulationContext(p_context);
+        modifier.SetUseEventScheduling(useEventScheduling);
+        modifier.SetupSolve(cell_population, "AttachmentSchedulingValidation");
+
+        std::vector<bool> was_attached(num_cells, false);
+        std::vector<double> observables(NUM_OBSERVABLES, 0.0);
+        for (unsigned step = 1; step <= num_steps; step++)
+        {
+            SimulationTime::Instance()->IncrementTimeOneStep();
+            p_context->AdvanceClock();
+            double time = SimulationTime::Instance()->GetTime();
+            for (unsigned index = 0; index < num_cells; index++)
+            {
+                cell_population.GetNode(index)->rGetModifiableLocation()[1] = 1.5 + 1.5 * sin(0.5 * M_PI * time + phases[index]);
+            }
+
+            modifier.UpdateAtEndOfTimeStep(cell_population);
+
+            unsigned num_attached = 0;
+            for (unsigned index = 0; index < num_cells; index++)
+            {
+                bool is_attached = cell_population.GetCellUsingLocationIndex(index)->GetMutationState()->IsType<AttachedCellMutationState>();
+                if (is_attached && !was_attached[index])
+                {
+                    observables[NUM_ATTACHMENTS] += 1.0;
+                }
+                else if (!is_attached && was_attached[index])
+                {
+                    observables[NUM_DETACHMENTS] += 1.0;
+                }
+                was_attached[index] = is_attached;
+                num_attached += is_attached ? 1 : 0;
+            }
+            if (2 * step > num_steps)
+            {
+                observables[MEAN_ATTACHED] += num_attached;
+            }
+        }
+        observables[MEAN_ATTACHED] /= (num_steps - num_steps/2);
+
+        if (useEventScheduling)
+        {
+            // Only the cells whose attempts succeed should have been touched
+            TS_ASSERT_LESS_THAN(modifier.GetNumEventsProcessed(), num_cells * num_steps / 50);
+        }
+
+        SimulationTime::Instance()->Destroy();
+        SimulationTime::Instance()->SetStartTime(0.0);
+
+        return observables;
+    }
+
+    /*
+     * Run a simulation of dividing and dying cells with the modifier, and return the
+     * population observables at the end time.
+     */
+    std::vector<double> RunDividingPopulation(unsigned runIndex, bool useEventScheduling, double endTime)
+    {
+        RandomNumberGenerator::Instance()->Reseed(100 * runIndex);
+        boost::shared_ptr<UtericBudSimulationContext> p_context(new UtericBudSimulationContext(100 * runIndex));
+
+        std::vector<Node<2>*> nodes;
+        for (unsigned index = 0; index < 40; index++)
+        {
+            double x_coord = 10.0 * RandomNumberGenerator::Instance()->ranf();
+            double y_coord = 3.0 * RandomNumberGenerator::Instance()->ranf();
+            nodes.push_back(new Node<2>(index, false, x_coord, y_coord));
+        }
+
+        NodesOnlyMesh<2> mesh;
+        mesh.ConstructNodesWithoutMesh(nodes, 1.5);
+        for (unsigned i = 0; i < nodes.size(); i++)
+        {
+            delete nodes[i];
+        }
+
+        // Daughters inherit the cell data of their parents
+        MAKE_PTR(TransitCellProliferativeType, p_transit_type);
+        std::vector<CellPtr> cells;
+        CellsGenerator<FixedDurationGenerationBasedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, mesh.GetNumNodes(), p_transit_type);
+        for (unsigned i = 0; i < cells.size(); i++)
+        {
+            cells[i]->GetCellData()->SetItem("AttachTime", 0);
+        }
+
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+
+        OffLatticeSimulationUT<2> simulator(cell_population);
+        simulator.SetSimulationContext(p_context);
+        std::stringstream output_directory;
+        output_directory << "AttachmentSchedulingValidation/" << (useEventScheduling ? "events" : "coins") << "/run_" << runIndex;
+        simulator.SetOutputDirectory(output_directory.str());
+        simulator.SetSamplingTimestepMultiple(240);
+        simulator.SetDt(1.0/240.0);
+        simulator.SetEndTime(endTime);
+
+        c_vector<double, 2> bc_point = zero_vector<double>(2);
+        c_vector<double, 2> bc_normal = zero_vector<double>(2);
+        bc_normal(1) = -1.0;
+        MAKE_PTR_ARGS(PlaneBoundaryCondition<2>, p_bc, (&cell_population, bc_point, bc_normal));
+        simulator.AddCellPopulationBoundaryCondition(p_bc);
+
+        MAKE_PTR_ARGS(RandomCellKiller<2>, p_killer, (&cell_population, 0.02));
+        simulator.AddCellKiller(p_killer);
+
+        MAKE_PTR(BasicLinearSpringForce<2>, p_linear_force);
+        p_linear_force->SetCutOffLength(1.5);
+        simulator.AddForce(p_linear_force);
+
+        // The diffusion force and attachment modifier are given the context by the simulation
+        MAKE_PTR_ARGS(BasicDiffusionForce, p_dforce, (0.3));
+        simulator.AddForce(p_dforce);
+
+        MAKE_PTR(AttachmentModifier<2>, p_attach_modifier);
+        p_attach_modifier->SetAttachmentProbability(0.5);
+        p_attach_modifier->SetDetachmentProbability(0.6);
+        p_attach_modifier->SetAttachmentHeight(1.0);
+        p_attach_modifier->SetUseEventScheduling(useEventScheduling);
+        simulator.AddSimulationModifier(p_attach_modifier);
+
+        simulator.Solve();
+
+        std::vector<double> observables(NUM_POPULATION_OBSERVABLES, 0.0);
+        for (AbstractCellPopulation<2>::Iterator cell_iter = cell_population.Begin();
+             cell_iter != cell_population.End();
+             ++cell_iter)
+        {
+            observables[TOTAL_COUNT] += 1.0;
+            if (cell_iter->GetMutationState()->IsType<AttachedCellMutationState>())
+            {
+                observables[ATTACHED_COUNT] += 1.0;
+            }
+        }
+
+        SimulationTime::Instance()->Destroy();
+        SimulationTime::Instance()->SetStartTime(0.0);
+
+        return observables;
+    }
+
+public:
+
+    void TestEnsembleObservablesAgree() throw (Exception)
+    {
+        unsigned num_runs = 20;
+        double end_time = 40.0;
+
+        const char* const observable_names[NUM_OBSERVABLES] = {"mean attached", "attachments", "detachments"};
+        EnsembleComparison comparison(observable_names, NUM_OBSERVABLES, "coins", "events");
+        for (unsigned run = 0; run < num_runs; run++)
+        {
+            std::vector<double> coin_observables = RunAttachment(run, false, end_time);
+            std::vector<double> event_observables = RunAttachment(run, true, end_time);
+            comparison.AddRuns(coin_observables, event_observables);
+        }
+
+        cout << num_runs << " runs of " << end_time << " hours" << endl;
+        comparison.CheckAgreement();
+    }
+
+    void TestEnsembleObservablesAgreeWithDivisionAndDeath() throw (Exception)
+    {
+        unsigned num_runs = 20;
+        double end_time = 24.0;
+
+        const char* const observable_names[NUM_POPULATION_OBSERVABLES] = {"total", "attached"};
+        EnsembleComparison comparison(observable_names, NUM_POPULATION_OBSERVABLES, "coins", "events");
+        for (unsigned run = 0; run < num_runs; run++)
+        {
+            std::vector<double> coin_observables = RunDividingPopulation(run, false, end_time);
+            std::vector<double> event_observables = RunDividingPopulation(run, true, end_time);
+            comparison.AddRuns(coin_observables, event_observables);
+        }
+
+        cout << num_runs << " runs of " << end_time << " hours with division and death" << endl;
+        comparison.CheckAgreement();
+    }
+};
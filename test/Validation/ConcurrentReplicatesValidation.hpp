@@ -0,0 +1,251 @@
+/*
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+This file is part of Chaste.
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cxxtest/TestSuite.h>
+#include "CheckpointArchiveTypes.hpp"
+#include "AbstractCellBasedTestSuite.hpp"
+#include "FakePetscSetup.hpp"
+#include "SmartPointers.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "NodeBasedCellPopulation.hpp"
+#include "OffLatticeSimulationUT.hpp"
+#include "TransitCellProliferativeType.hpp"
+#include "WildTypeCellMutationState.hpp"
+#include "PlaneBoundaryCondition.hpp"
+#include "PlaneBasedCellKiller.hpp"
+#include "CellId.hpp"
+#include "OutputFileHandler.hpp"
+
+#include "GeneralisedLinearSpringForce.hpp"
+#include "GravityForce3.hpp"
+#include "BasicDiffusionForce.hpp"
+#include "CMCellCycleModel.hpp"
+#include "AttachmentModifier.hpp"
+#include "UtericBudSimulationContext.hpp"
+#include "ConcurrentReplicateRunner.hpp"
+
+/*
+ * Replicates run at the same time in worker processes give the same results as
+ * replicates run one after another.
+ *
+ * Two short uteric bud simulations, with division, diffusion, gravity and attachment,
+ * are run one after the other in the test process. They are then run again by a
+ * ConcurrentReplicateRunner with two workers, both started before the driver waits
+ * for either. Every worker writes the final cell locations to a file, and once all
+ * the workers have ended these must match the serial ones to the last digit.
+ */
+class ConcurrentReplicatesValidation : public AbstractCellBasedTestSuite
+{
+private:
+
+    /*
+     * Run one replicate and return the final ID and location of every cell, one cell per line.
+     */
+    std::vector<std::string> RunReplicate(unsigned replicateIndex, const std::string& rOutputDirectory)
+    {
+        RandomNumberGenerator::Instance()->Reseed(100 * replicateIndex);
+        CellId::ResetMaxCellId();
+        boost::shared_ptr<UtericBudSimulationContext> p_context(new UtericBudSimulationContext(100 * replicateIndex));
+
+        std::vector<Node<2>*> nodes;
+        for (unsigned index = 0; index < 20; index++)
+        {
+            double x_coord = 10.0 * RandomNumberGenerator::Instance()->ranf();
+            double y_coord = 5.0 * RandomNumberGenerator::Instance()->ranf();
+            nodes.push_back(new Node<2>(index, false, x_coord, y_coord));
+        }
+
+        NodesOnlyMesh<2> mesh;
+        mesh.ConstructNodesWithoutMesh(nodes, 1.5);
+        for (unsigned i = 0; i < nodes.size(); i++)
+        {
+            delete nodes[i];
+        }
+
+        MAKE_PTR(TransitCellProliferativeType, p_transit_type);
+        MAKE_PTR(WildTypeCellMutationState, p_state);
+        std::vector<CellPtr> cells;
+        for (unsigned i = 0; i < mesh.GetNumNodes(); i++)
+        {
+            CMCellCycleModel* p_model = new CMCellCycleModel;
+            p_model->SetDiffModel(2);
+            p_model->SetDiffModelParam(0.6);
+            p_model->SetAverageDivisionAge(5.0);
+            p_model->SetStdDivisionAge(1.0);
+            p_model->SetCritVolume(0.0);
+            p_model->SetTDYThreshold(1.0);
+            p_model->SetSimulationContext(p_context);
+
+            CellPtr p_cell(new Cell(p_state, p_model));
+            p_cell->InitialiseCellCycleModel();
+            p_cell->SetCellProliferativeType(p_transit_type);
+            p_cell->SetBirthTime(-RandomNumberGenerator::Instance()->ranf() * 5.0);
+            p_cell->GetCellData()->SetItem("AttachTime", 0);
+            p_cell->GetCellData()->SetItem("DivAge", 0);
+            p_cell->GetCellData()->SetItem("volume", 0);
+            p_cell->GetCellData()->SetItem("DivisionDelay", 0);
+            cells.push_back(p_cell);
+        }
+
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+        cell_population.SetDampingConstantMutant(100.0);
+        cell_population.SetDampingConstantNormal(0.33);
+
+        OffLatticeSimulationUT<2> simulator(cell_population);
+        simulator.SetSimulationContext(p_context);
+        simulator.SetOutputDirectory(rOutputDirectory);
+        simulator.SetSamplingTimestepMultiple(240);
+        simulator.SetDt(1.0/240.0);
+        simulator.SetEndTime(10.0);
+
+        c_vector<double, 2> bc_point = zero_vector<double>(2);
+        c_vector<double, 2> bc_normal_y = zero_vector<double>(2);
+        bc_normal_y(1) = -1.0;
+        MAKE_PTR_ARGS(PlaneBoundaryCondition<2>, p_bc_y, (&cell_population, bc_point, bc_normal_y));
+        simulator.AddCellPopulationBoundaryCondition(p_bc_y);
+
+        c_vector<double, 2> killer_point_x = zero_vector<double>(2);
+        killer_point_x(0) = 20.0;
+        c_vector<double, 2> killer_normal_x = zero_vector<double>(2);
+        killer_normal_x(0) = 1.0;
+        MAKE_PTR_ARGS(PlaneBasedCellKiller<2>, p_killer_x, (&cell_population, killer_point_x, killer_normal_x));
+        simulator.AddCellKiller(p_killer_x);
+
+        MAKE_PTR(GeneralisedLinearSpringForce<2>, p_linear_force);
+        p_linear_force->SetCutOffLength(1.5);
+        simulator.AddForce(p_linear_force);
+
+        MAKE_PTR_ARGS(GravityForce3, p_gforce, (1.0));
+        p_gforce->SetRepulsionDistance(1.5);
+        p_gforce->SetRepulsionStrength(2.5);
+        p_gforce->SetAttachmentStrength(1.5);
+        p_gforce->SetDampingConst(100.0);
+        p_gforce->SetStromaHeight(10.0);
+        simulator.AddForce(p_gforce);
+
+        // The diffusion force and attachment modifier are given the context by the simulation
+        MAKE_PTR_ARGS(BasicDiffusionForce, p_dforce, (0.3));
+        simulator.AddForce(p_dforce);
+
+        MAKE_PTR(AttachmentModifier<2>, p_attach_modifier);
+        p_attach_modifier->SetAttachmentProbability(0.5);
+        p_attach_modifier->SetDetachmentProbability(0.5);
+        p_attach_modifier->SetAttachmentHeight(1.5);
+        simulator.AddSimulationModifier(p_attach_modifier);
+
+        simulator.Solve();
+
+        std::vector<std::string> locations;
+        for (AbstractCellPopulation<2>::Iterator cell_iter = cell_population.Begin();
+             cell_iter != cell_population.End();
+             ++cell_iter)
+        {
+            c_vector<double, 2> location = cell_population.GetLocationOfCellCentre(*cell_iter);
+            std::stringstream line;
+            line << std::setprecision(17) << cell_iter->GetCellId() << " " << location[0] << " " << location[1];
+            locations.push_back(line.str());
+        }
+
+        SimulationTime::Instance()->Destroy();
+        SimulationTime::Instance()->SetStartTime(0.0);
+
+        return locations;
+    }
+
+public:
+
+    void TestConcurrentReplicatesMatchSerialReplicates() throw (Exception)
+    {
+        unsigned num_replicates = 2;
+
+        std::vector<std::vector<std::string> > serial_locations;
+        for (unsigned replicate = 0; replicate < num_replicates; replicate++)
+        {
+            std::stringstream output_directory;
+            output_directory << "ConcurrentReplicatesValidation/serial_" << replicate;
+            serial_locations.push_back(RunReplicate(replicate, output_directory.str()));
+            TS_ASSERT(!serial_locations.back().empty());
+        }
+
+        OutputFileHandler handler("ConcurrentReplicatesValidation/concurrent", true);
+        std::string results_path = handler.GetOutputDirectoryFullPath();
+
+        ConcurrentReplicateRunner runner(num_replicates);
+        for (unsigned replicate = 0; replicate < num_replicates; replicate++)
+        {
+            if (!runner.StartReplicate())
+            {
+                continue;
+            }
+
+            std::stringstream output_directory;
+            output_directory << "ConcurrentReplicatesValidation/concurrent/run_" << replicate;
+            std::vector<std::string> locations = RunReplicate(replicate, output_directory.str());
+
+            std::stringstream locations_file;
+            locations_file << results_path << "locations_" << replicate << ".dat";
+            std::ofstream file(locations_file.str().c_str());
+            for (unsigned i = 0; i < locations.size(); i++)
+            {
+                file << locations[i] << "\n";
+            }
+            file.close();
+
+            runner.FinishReplicate();
+        }
+        // The driver starts every worker before waiting for any, and only reads the results once all have ended
+        TS_ASSERT_THROWS_NOTHING(runner.WaitForReplicates());
+        TS_ASSERT_EQUALS(runner.GetPeakNumConcurrentReplicates(), num_replicates);
+
+        for (unsigned replicate = 0; replicate < num_replicates; replicate++)
+        {
+            std::stringstream locations_file;
+            locations_file << results_path << "locations_" << replicate << ".dat";
+            std::ifstream file(locations_file.str().c_str());
+            TS_ASSERT(file.is_open());
+
+            std::vector<std::string> concurrent_locations;
+            std::string line;
+            while (std::getline(file, line))
+            {
+                concurrent_locations.push_back(line);
+            }
+
+            TS_ASSERT_EQUALS(concurrent_locations.size(), serial_locations[replicate].size());
+            for (unsigned i = 0; i < std::min(concurrent_locations.size(), serial_locations[replicate].size()); i++)
+            {
+                TS_ASSERT_EQUALS(concurrent_locations[i], serial_locations[replicate][i]);
+            }
+        }
+    }
+};
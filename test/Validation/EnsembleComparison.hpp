@@ -0,0 +1,186 @@
+/*
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+This file is part of Chaste.
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef ENSEMBLECOMPARISON_HPP_
+#define ENSEMBLECOMPARISON_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/math/distributions/students_t.hpp>
+
+/*
+ * Statistical comparison of two ensembles of stochastic runs, for validation suites
+ * whose two variants use the random numbers differently, so that runs cannot be
+ * compared one by one.
+ *
+ * A suite lists its observables in an enum ending in NUM_OBSERVABLES, gives their
+ * names, and passes the observables of each pair of runs to AddRuns(). CheckAgreement()
+ * then prints the ensemble means and asserts that they agree to within three standard
+ * errors of their difference. Observables that are the same in every run, such as a
+ * count that stays at zero, must then match exactly.
+ *
+ * Failing to find a difference is not evidence that there is none, particularly with
+ * few runs, so suites that claim two variants are equivalent use CheckEquivalence()
+ * instead, which asserts that the difference is within a stated margin.
+ */
+class EnsembleComparison
+{
+private:
+
+    /* The name of each observable. */
+    std::vector<std::string> mObservableNames;
+
+    /* The names of the two variants, for the table of results. */
+    std::string mFirstLabel;
+    std::string mSecondLabel;
+
+    /* The samples of each observable from each variant, observable by observable. */
+    std::vector<std::vector<double> > mFirstSamples;
+    std::vector<std::vector<double> > mSecondSamples;
+
+public:
+
+    EnsembleComparison(const char* const observableNames[], unsigned numObservables,
+                       const std::string& rFirstLabel, const std::string& rSecondLabel)
+        : mObservableNames(observableNames, observableNames + numObservables),
+          mFirstLabel(rFirstLabel),
+          mSecondLabel(rSecondLabel),
+          mFirstSamples(numObservables),
+          mSecondSamples(numObservables)
+    {
+    }
+
+    /*
+     * Add the observables of one run of each variant.
+     */
+    void AddRuns(const std::vector<double>& rFirstObservables, const std::vector<double>& rSecondObservables)
+    {
+        TS_ASSERT_EQUALS(rFirstObservables.size(), mObservableNames.size());
+        TS_ASSERT_EQUALS(rSecondObservables.size(), mObservableNames.size());
+        for (unsigned observable = 0; observable < mObservableNames.size(); observable++)
+        {
+            mFirstSamples[observable].push_back(rFirstObservables[observable]);
+            mSecondSamples[observable].push_back(rSecondObservables[observable]);
+        }
+    }
+
+    static void GetMeanAndStandardError(const std::vector<double>& rSamples, double& rMean, double& rStandardError)
+    {
+        unsigned num_samples = rSamples.size();
+        rMean = 0.0;
+        for (unsigned i = 0; i < num_samples; i++)
+        {
+            rMean += rSamples[i];
+        }
+        rMean /= num_samples;
+
+        double variance = 0.0;
+        for (unsigned i = 0; i < num_samples; i++)
+        {
+            variance += (rSamples[i] - rMean) * (rSamples[i] - rMean);
+        }
+        variance /= (num_samples - 1);
+        rStandardError = sqrt(variance/num_samples);
+    }
+
+    /*
+     * Print the ensemble means and check that they agree.
+     */
+    void CheckAgreement()
+    {
+        std::cout << std::setw(16) << "observable" << std::setw(14) << mFirstLabel << std::setw(14) << mSecondLabel
+                  << std::setw(14) << "difference" << std::setw(14) << "std error" << std::endl;
+        for (unsigned observable = 0; observable < mObservableNames.size(); observable++)
+        {
+            double first_mean, first_error, second_mean, second_error;
+            GetMeanAndStandardError(mFirstSamples[observable], first_mean, first_error);
+            GetMeanAndStandardError(mSecondSamples[observable], second_mean, second_error);
+
+            double difference = second_mean - first_mean;
+            double standard_error = sqrt(first_error*first_error + second_error*second_error);
+            std::cout << std::setw(16) << mObservableNames[observable] << std::setw(14) << first_mean << std::setw(14) << second_mean
+                      << std::setw(14) << difference << std::setw(14) << standard_error << std::endl;
+
+            TS_ASSERT_LESS_THAN_EQUALS(fabs(difference), 3.0*standard_error + 1e-12);
+        }
+    }
+
+    /*
+     * Print the ensemble means and check that they are equivalent, by two one-sided
+     * t-tests (TOST) at the 5% level: the 90% confidence interval of the difference
+     * of the means must lie within plus or minus the margin of each observable. The
+     * margin is rRelativeMargins[i] times the magnitude of the first variant's mean,
+     * plus rAbsoluteMargins[i]. The degrees of freedom are Welch's, as the variances
+     * of the two variants need not be equal.
+     */
+    void CheckEquivalence(const std::vector<double>& rRelativeMargins, const std::vector<double>& rAbsoluteMargins)
+    {
+        TS_ASSERT_EQUALS(rRelativeMargins.size(), mObservableNames.size());
+        TS_ASSERT_EQUALS(rAbsoluteMargins.size(), mObservableNames.size());
+
+        std::cout << std::setw(16) << "observable" << std::setw(14) << mFirstLabel << std::setw(14) << mSecondLabel
+                  << std::setw(14) << "difference" << std::setw(14) << "90% bound" << std::setw(14) << "margin" << std::endl;
+        for (unsigned observable = 0; observable < mObservableNames.size(); observable++)
+        {
+            double first_mean, first_error, second_mean, second_error;
+            GetMeanAndStandardError(mFirstSamples[observable], first_mean, first_error);
+            GetMeanAndStandardError(mSecondSamples[observable], second_mean, second_error);
+
+            double difference = second_mean - first_mean;
+            double first_variance = first_error*first_error;
+            double second_variance = second_error*second_error;
+            double standard_error = sqrt(first_variance + second_variance);
+
+            // The largest difference from zero within the 90% confidence interval
+            double bound = fabs(difference);
+            if (standard_error > 0.0)
+            {
+                double degrees_of_freedom = (first_variance + second_variance)*(first_variance + second_variance)
+                    / (first_variance*first_variance/(mFirstSamples[observable].size() - 1)
+                       + second_variance*second_variance/(mSecondSamples[observable].size() - 1));
+                boost::math::students_t distribution(degrees_of_freedom);
+                bound += boost::math::quantile(boost::math::complement(distribution, 0.05))*standard_error;
+            }
+
+            double margin = rRelativeMargins[observable]*fabs(first_mean) + rAbsoluteMargins[observable];
+            std::cout << std::setw(16) << mObservableNames[observable] << std::setw(14) << first_mean << std::setw(14) << second_mean
+                      << std::setw(14) << difference << std::setw(14) << bound << std::setw(14) << margin << std::endl;
+
+            TS_ASSERT_LESS_THAN_EQUALS(bound, margin);
+        }
+    }
+};
+
+#endif /*ENSEMBLECOMPARISON_HPP_*/
@@ -0,0 +1,344 @@
+/*
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+This file is part of Chaste.
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cxxtest/TestSuite.h>
+#include "CheckpointArchiveTypes.hpp"
+#include "AbstractCellBasedTestSuite.hpp"
+#include "FakePetscSetup.hpp"
+#include "SmartPointers.hpp"
+
+#include <cmath>
+#include <sstream>
+
+#include "NodeBasedCellPopulation.hpp"
+#include "OffLatticeSimulationUT.hpp"
+#include "TransitCellProliferativeType.hpp"
+#include "WildTypeCellMutationState.hpp"
+#include "PlaneBoundaryCondition.hpp"
+#include "PlaneBasedCellKiller.hpp"
+
+#include "BasicLinearSpringForce.hpp"
+#include "GravityForce3.hpp"
+#include "BasicDiffusionForce.hpp"
+#include "CMCellCycleModel.hpp"
+#include "ChemTrackingModifier.hpp"
+#include "AttachmentModifier.hpp"
+#include "SelectivePlaneBoundaryCondition.hpp"
+#include "UtericBudCellTypesCountWriter.hpp"
+#include "UtericBudSimulationContext.hpp"
+#include "UtericBudShapeObservables.hpp"
+
+#include "BatchedSpringForceKernel.hpp"
+#include "EnsembleComparison.hpp"
+
+/*
+ * Statistical equivalence of the single precision spring kernel.
+ *
+ * An ensemble of short uteric bud simulations, with the paper parameters, is run
+ * once with the batched spring kernel in double precision and once in single
+ * precision. Trajectories diverge between the two, so the comparison is between
+ * the ensembles rather than run by run. At the end of each run the observables of
+ * the paper are measured:
+ *
+ *  - the population counts written by UtericBudCellTypesCountWriter, read from the
+ *    cell attribute cache it shares with the simulation;
+ *  - the cap height and the x-histogram slope, measured by UtericBudShapeObservables
+ *    as in MATLAB capheight.m and steadystateshape.m.
+ *
+ * The two ensembles must be equivalent by two one-sided t-tests, as checked by
+ * EnsembleComparison::CheckEquivalence(), to within these margins:
+ *
+ *  - the counts, 10% of the double precision mean plus one cell;
+ *  - the cap height, 10% plus 0.25, half a cell radius;
+ *  - the x-histogram slope, 10% plus 0.001 per unit of x, a change of 0.02 in the
+ *    probability of a bin across the domain.
+ *
+ * Forty pairs of runs are used, so that the test has the power to show this.
+ *
+ * Before that, a deterministic test checks the kernels pair by pair: for node pairs
+ * spread over the 20 by 20 domain at every separation up to the cut-off, the force
+ * of each pair in single precision must be within 1e-5 of the double precision
+ * force relative to its magnitude, plus 1e-5 absolutely so that pairs near their
+ * rest length, whose force crosses zero, are not held to an impossible relative
+ * tolerance. Both kernels are given the same locations, rounded to single precision,
+ * so the check is of the arithmetic of the kernel and not of how the locations are
+ * stored.
+ */
+class SinglePrecisionEnsembleValidation : public AbstractCellBasedTestSuite
+{
+private:
+
+    /* The observables, in the order in which they are measured. */
+    enum Observable
+    {
+        TOTAL_COUNT,
+        TRANSIT_COUNT,
+        DIFFERENTIATED_COUNT,
+        ATTACHED_COUNT,
+        RV_COUNT,
+        CAP_HEIGHT,
+        HISTOGRAM_SLOPE,
+        NUM_OBSERVABLES
+    };
+
+    void GenerateCells(unsigned numCells, std::vector<CellPtr>& rCells,
+                       boost::shared_ptr<UtericBudSimulationContext> pContext)
+    {
+        MAKE_PTR(TransitCellProliferativeType, p_transit_type);
+        MAKE_PTR(WildTypeCellMutationState, p_state);
+
+        for (unsigned i = 0; i < numCells; i++)
+        {
+            CMCellCycleModel* p_model = new CMCellCycleModel;
+            p_model->SetDiffModel(2);
+            p_model->SetDiffModelParam(0.6);
+            p_model->SetAverageDivisionAge(20.0);
+            p_model->SetStdDivisionAge(2.0);
+            p_model->SetCritVolume(0.0);
+            p_model->SetTDYThreshold(1.0);
+            p_model->SetSimulationContext(pContext);
+
+            CellPtr p_cell(new Cell(p_state, p_model));
+            p_cell->InitialiseCellCycleModel();
+            p_cell->SetCellProliferativeType(p_transit_type);
+            p_cell->SetBirthTime(-RandomNumberGenerator::Instance()->ranf() * 20.0);
+
+            p_cell->GetCellData()->SetItem("concentrationA", 1.0);
+            p_cell->GetCellData()->SetItem("concentrationB", 1.0);
+            p_cell->GetCellData()->SetItem("AttachTime", 0);
+            p_cell->GetCellData()->SetItem("DivAge", 0);
+            p_cell->GetCellData()->SetItem("volume", 0);
+            p_cell->GetCellData()->SetItem("DivisionDelay", 0);
+
+            rCells.push_back(p_cell);
+        }
+    }
+
+    /*
+     * Run one simulation of the bud and return its observables at the end time.
+     */
+    std::vector<double> RunBudSimulation(unsigned runIndex, bool useSinglePrecision, double endTime)
+    {
+        RandomNumberGenerator::Instance()->Reseed(100 * runIndex);
+        boost::shared_ptr<UtericBudSimulationContext> p_context(new UtericBudSimulationContext(100 * runIndex));
+
+        std::vector<Node<2>*> nodes;
+        for (unsigned index = 0; index < 30; index++)
+        {
+            double x_coord = 10.0 * RandomNumberGenerator::Instance()->ranf();
+            double y_coord = 5.0 * RandomNumberGenerator::Instance()->ranf();
+            nodes.push_back(new Node<2>(index, false, x_coord, y_coord));
+        }
+
+        NodesOnlyMesh<2> mesh;
+        mesh.ConstructNodesWithoutMesh(nodes, 1.5);
+
+        std::vector<CellPtr> cells;
+        GenerateCells(mesh.GetNumNodes(), cells, p_context);
+
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+        cell_population.SetDampingConstantMutant(100.0);
+        cell_population.SetDampingConstantNormal(0.33);
+
+        boost::shared_ptr<UtericBudCellTypesCountWriter<2,2> > p_cell_types_writer(new UtericBudCellTypesCountWriter<2,2>());
+        cell_population.AddCellPopulationCountWriter(p_cell_types_writer);
+
+        OffLatticeSimulationUT<2> simulator(cell_population);
+        simulator.SetSimulationContext(p_context);
+        p_cell_types_writer->SetCellAttributeCache(simulator.GetCellAttributeCache());
+        std::stringstream output_directory;
+        output_directory << "SinglePrecisionEnsembleValidation/" << (useSinglePrecision ? "float" : "double") << "/run_" << runIndex;
+        simulator.SetOutputDirectory(output_directory.str());
+        simulator.SetSamplingTimestepMultiple(240);
+        simulator.SetDt(1.0/240.0);
+        simulator.SetEndTime(endTime);
+
+        c_vector<double, 2> bc_point = zero_vector<double>(2);
+        c_vector<double, 2> bc_normal_y = zero_vector<double>(2);
+        bc_normal_y(1) = -1.0;
+        MAKE_PTR_ARGS(PlaneBoundaryCondition<2>, p_bc_y, (&cell_population, bc_point, bc_normal_y));
+        p_bc_y->SetUseJiggledNodesOnPlane(true);
+        simulator.AddCellPopulationBoundaryCondition(p_bc_y);
+
+        c_vector<double, 2> bc_normal_x = zero_vector<double>(2);
+        bc_normal_x(0) = -1.0;
+        MAKE_PTR_ARGS(PlaneBoundaryCondition<2>, p_bc_x, (&cell_population, bc_point, bc_normal_x));
+        p_bc_x->SetUseJiggledNodesOnPlane(true);
+        simulator.AddCellPopulationBoundaryCondition(p_bc_x);
+
+        c_vector<double, 2> barrier_point = zero_vector<double>(2);
+        barrier_point(0) = 18.0;
+        c_vector<double, 2> barrier_normal = zero_vector<double>(2);
+        barrier_normal(0) = 1.0;
+        MAKE_PTR_ARGS(SelectivePlaneBoundaryCondition<2>, p_barrier, (&cell_population, barrier_point, barrier_normal));
+        p_barrier->SetSimulationContext(p_context);
+        simulator.AddCellPopulationBoundaryCondition(p_barrier);
+
+        c_vector<double, 2> killer_point_x = zero_vector<double>(2);
+        killer_point_x(0) = 20.0;
+        c_vector<double, 2> killer_normal_x = zero_vector<double>(2);
+        killer_normal_x(0) = 1.0;
+        MAKE_PTR_ARGS(PlaneBasedCellKiller<2>, p_killer_x, (&cell_population, killer_point_x, killer_normal_x));
+        simulator.AddCellKiller(p_killer_x);
+
+        c_vector<double, 2> killer_point_y = zero_vector<double>(2);
+        killer_point_y(1) = 20.0;
+        c_vector<double, 2> killer_normal_y = zero_vector<double>(2);
+        killer_normal_y(1) = 1.0;
+        MAKE_PTR_ARGS(PlaneBasedCellKiller<2>, p_killer_y, (&cell_population, killer_point_y, killer_normal_y));
+        simulator.AddCellKiller(p_killer_y);
+
+        MAKE_PTR(BasicLinearSpringForce<2>, p_linear_force);
+        p_linear_force->SetCutOffLength(1.5);
+        p_linear_force->SetUseBatchedKernel(true);
+        p_linear_force->SetUseSinglePrecision(useSinglePrecision);
+        simulator.AddForce(p_linear_force);
+
+        MAKE_PTR_ARGS(GravityForce3, p_gforce, (1.0));
+        p_gforce->SetRepulsionDistance(1.5);
+        p_gforce->SetRepulsionStrength(2.5);
+        p_gforce->SetAttachmentStrength(1.5);
+        p_gforce->SetDampingConst(100.0);
+        p_gforce->SetStromaHeight(10.0);
+        simulator.AddForce(p_gforce);
+
+        MAKE_PTR_ARGS(BasicDiffusionForce, p_dforce, (0.3));
+        p_dforce->SetSimulationContext(p_context);
+        simulator.AddForce(p_dforce);
+
+        MAKE_PTR(ChemTrackingModifier<2>, p_chem_modifier);
+        simulator.AddSimulationModifier(p_chem_modifier);
+
+        MAKE_PTR(AttachmentModifier<2>, p_attach_modifier);
+        p_attach_modifier->SetAttachmentProbability(0.5);
+        p_attach_modifier->SetDetachmentProbability(0.5);
+        p_attach_modifier->SetAttachmentHeight(1.5);
+        p_attach_modifier->SetSimulationContext(p_context);
+        p_attach_modifier->SetCellAttributeCache(simulator.GetCellAttributeCache());
+        simulator.AddSimulationModifier(p_attach_modifier);
+
+        simulator.Solve();
+
+        // The counts, as UtericBudCellTypesCountWriter writes them
+        std::vector<double> observables(NUM_OBSERVABLES);
+        boost::shared_ptr<CellAttributeCache<2> > p_cache = p_cell_types_writer->GetCellAttributeCache();
+        p_cache->Rebuild(cell_population);
+        observables[TOTAL_COUNT] = cell_population.GetNumRealCells();
+        observables[TRANSIT_COUNT] = p_cache->GetNumCellsWithProliferativeType(TRANSIT_PROLIFERATIVE_TYPE);
+        observables[DIFFERENTIATED_COUNT] = p_cache->GetNumCellsWithProliferativeType(DIFFERENTIATED_PROLIFERATIVE_TYPE);
+        observables[ATTACHED_COUNT] = p_cache->GetNumCellsWithMutationState(ATTACHED_MUTATION_STATE);
+        observables[RV_COUNT] = p_cache->GetNumCellsWithMutationState(RV_MUTATION_STATE);
+
+        // The cap height and the x-histogram slope, as SteadyStateStoppingCondition measures them
+        UtericBudShapeObservables shape_observables;
+        shape_observables.Measure(cell_population);
+        observables[CAP_HEIGHT] = shape_observables.GetCapHeight();
+        observables[HISTOGRAM_SLOPE] = shape_observables.GetHistogramSlope();
+
+        SimulationTime::Instance()->Destroy();
+        SimulationTime::Instance()->SetStartTime(0.0);
+
+        return observables;
+    }
+
+public:
+
+    void TestSinglePrecisionKernelMatchesDoublePrecisionPairByPair() throw (Exception)
+    {
+        // Pairs of nodes spread over the domain, at separations from 0.05 up to 1.45
+        unsigned num_pairs = 10000;
+        unsigned num_nodes = 2*num_pairs;
+        std::vector<unsigned> first_nodes(num_pairs);
+        std::vector<unsigned> second_nodes(num_pairs);
+        std::vector<double> locations(2*num_nodes);
+        std::vector<float> single_precision_locations(2*num_nodes);
+        for (unsigned pair = 0; pair < num_pairs; pair++)
+        {
+            double x = fmod(0.7368*pair, 20.0);
+            double y = fmod(1.3331*pair, 20.0);
+            double separation = 0.05 + 1.4*pair/num_pairs;
+            double angle = 2.0*M_PI*fmod(0.6180339887*pair, 1.0);
+
+            first_nodes[pair] = 2*pair;
+            second_nodes[pair] = 2*pair + 1;
+            single_precision_locations[2*pair] = x;
+            single_precision_locations[num_nodes + 2*pair] = y;
+            single_precision_locations[2*pair + 1] = x + separation*cos(angle);
+            single_precision_locations[num_nodes + 2*pair + 1] = y + separation*sin(angle);
+        }
+        for (unsigned i = 0; i < 2*num_nodes; i++)
+        {
+            locations[i] = single_precision_locations[i];
+        }
+        std::vector<double> radii(num_nodes, 0.5);
+        std::vector<float> single_precision_radii(num_nodes, 0.5f);
+
+        BatchedSpringForceKernel<2> kernel;
+        kernel.SetParameters(15.0, 1.5, false);
+        kernel.ComputeGeometry(&first_nodes[0], &second_nodes[0], num_pairs, &locations[0], num_nodes, &radii[0]);
+        kernel.ComputeForces(NULL);
+
+        BatchedSpringForceKernel<2, float> single_precision_kernel;
+        single_precision_kernel.SetParameters(15.0, 1.5, false);
+        single_precision_kernel.ComputeGeometry(&first_nodes[0], &second_nodes[0], num_pairs,
+                                                &single_precision_locations[0], num_nodes, &single_precision_radii[0]);
+        single_precision_kernel.ComputeForces(NULL);
+
+        const std::vector<double>& r_forces = kernel.rGetForces();
+        const std::vector<float>& r_single_precision_forces = single_precision_kernel.rGetForces();
+        for (unsigned i = 0; i < 2*num_pairs; i++)
+        {
+            TS_ASSERT_LESS_THAN_EQUALS(fabs(r_single_precision_forces[i] - r_forces[i]), 1e-5*fabs(r_forces[i]) + 1e-5);
+        }
+    }
+
+    void TestEnsembleObservablesAreEquivalent() throw (Exception)
+    {
+        unsigned num_runs = 40;
+        double end_time = 40.0;
+
+        const char* const observable_names[NUM_OBSERVABLES] = {"total", "transit", "differentiated", "attached", "RV", "cap height", "x slope"};
+        EnsembleComparison comparison(observable_names, NUM_OBSERVABLES, "double", "float");
+        for (unsigned run = 0; run < num_runs; run++)
+        {
+            std::vector<double> double_observables = RunBudSimulation(run, false, end_time);
+            std::vector<double> float_observables = RunBudSimulation(run, true, end_time);
+            comparison.AddRuns(double_observables, float_observables);
+        }
+
+        // The margins of equivalence, as described above
+        std::vector<double> relative_margins(NUM_OBSERVABLES, 0.1);
+        std::vector<double> absolute_margins(NUM_OBSERVABLES, 1.0);
+        absolute_margins[CAP_HEIGHT] = 0.25;
+        absolute_margins[HISTOGRAM_SLOPE] = 0.001;
+
+        cout << num_runs << " runs of " << end_time << " hours" << endl;
+        comparison.CheckEquivalence(relative_margins, absolute_margins);
+    }
+};
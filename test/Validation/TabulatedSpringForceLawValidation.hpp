@@ -0,0 +1,177 @@
+/*
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+This file is part of Chaste.
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cxxtest/TestSuite.h>
+#include "CheckpointArchiveTypes.hpp"
+#include "AbstractCellBasedTestSuite.hpp"
+#include "FakePetscSetup.hpp"
+#include "SmartPointers.hpp"
+
+#include <iomanip>
+
+#include "NodeBasedCellPopulation.hpp"
+#include "CellsGenerator.hpp"
+#include "FixedDurationGenerationBasedCellCycleModel.hpp"
+#include "DifferentiatedCellProliferativeType.hpp"
+
+#include "BasicLinearSpringForce.hpp"
+#include "NodeBasedLinearSpringForce.hpp"
+#include "TabulatedSpringForceLaw.hpp"
+
+/*
+ * Validation of TabulatedSpringForceLaw against the analytic node-based spring law.
+ *
+ * Near zero overlap the analytic 3 log(1+x) itself loses relative accuracy, so the
+ * errors are checked relative to the exact profile plus a tiny absolute allowance.
+ */
+class TabulatedSpringForceLawValidation : public AbstractCellBasedTestSuite
+{
+public:
+
+    void TestProfileWithinTolerance() throw (Exception)
+    {
+        std::vector<double> tolerances;
+        tolerances.push_back(1e-3);
+        tolerances.push_back(1e-6);
+        tolerances.push_back(1e-9);
+
+        unsigned last_num_intervals = 0;
+        cout << std::setw(12) << "tolerance" << std::setw(16) << "intervals" << std::setw(16) << "max error" << endl;
+        for (unsigned k = 0; k < tolerances.size(); k++)
+        {
+            TabulatedSpringForceLaw force_law;
+            TS_ASSERT(!force_law.IsSetUp());
+            force_law.Setup(tolerances[k]);
+            TS_ASSERT(force_law.IsSetUp());
+            TS_ASSERT_LESS_THAN_EQUALS(force_law.GetMeasuredRelativeError(), tolerances[k]);
+
+            // Tighter tolerances need more intervals
+            unsigned num_intervals = force_law.GetNumCompressionIntervals() + force_law.GetNumTensionIntervals();
+            TS_ASSERT_LESS_THAN(last_num_intervals, num_intervals);
+            last_num_intervals = num_intervals;
+
+            // Sample densely, including outside the tables where the analytic law is used
+            double max_relative_error = 0.0;
+            unsigned num_samples = 200000;
+            for (unsigned i = 0; i <= num_samples; i++)
+            {
+                double x = -0.9 + 2.9*i/num_samples;
+                double exact = TabulatedSpringForceLaw::GetAnalyticProfile(x);
+                double error = fabs(force_law.GetProfile(x) - exact);
+                TS_ASSERT_LESS_THAN_EQUALS(error, tolerances[k]*fabs(exact) + 1e-15);
+                if (exact != 0.0)
+                {
+                    max_relative_error = std::max(max_relative_error, error/fabs(exact));
+                }
+            }
+            cout << std::setw(12) << tolerances[k] << std::setw(16) << num_intervals << std::setw(16) << max_relative_error << endl;
+
+            // The force magnitude is the profile scaled by the stiffness and rest length
+            TS_ASSERT_DELTA(force_law.GetForceMagnitude(-0.2, 0.8, 15.0),
+                            15.0*0.8*force_law.GetProfile(-0.25), 1e-12);
+            TS_ASSERT_DELTA(force_law.GetForceMagnitude(0.4, 0.8, 15.0),
+                            15.0*0.8*force_law.GetProfile(0.5), 1e-12);
+        }
+    }
+
+    void TestTabulatedSpringForces() throw (Exception)
+    {
+        RandomNumberGenerator::Instance()->Reseed(0);
+        std::vector<Node<2>*> nodes;
+        for (unsigned index = 0; index < 100; index++)
+        {
+            double x_coord = 10.0 * RandomNumberGenerator::Instance()->ranf();
+            double y_coord = 8.0 * RandomNumberGenerator::Instance()->ranf();
+            nodes.push_back(new Node<2>(index, false, x_coord, y_coord));
+        }
+
+        NodesOnlyMesh<2> mesh;
+        mesh.ConstructNodesWithoutMesh(nodes, 1.5);
+
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_diff_type);
+        std::vector<CellPtr> cells;
+        CellsGenerator<FixedDurationGenerationBasedCellCycleModel, 2> cells_generator;
+        cells_generator.GenerateBasicRandom(cells, mesh.GetNumNodes(), p_diff_type);
+
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+        cell_population.Update();
+
+        double tolerance = 1e-6;
+        BasicLinearSpringForce<2> analytic_force;
+        analytic_force.SetCutOffLength(1.5);
+        BasicLinearSpringForce<2> tabulated_force;
+        tabulated_force.SetCutOffLength(1.5);
+        tabulated_force.SetUseTabulatedForceLaw(true, tolerance);
+        TS_ASSERT(tabulated_force.GetUseTabulatedForceLaw());
+        TS_ASSERT_DELTA(tabulated_force.GetTabulatedForceLawTolerance(), tolerance, 1e-12);
+
+        // Pair by pair, the tabulated force is within the tolerance of the analytic force
+        std::vector<std::pair<Node<2>*, Node<2>*> >& r_node_pairs = cell_population.rGetNodePairs();
+        TS_ASSERT_LESS_THAN(0u, r_node_pairs.size());
+        for (unsigned pair = 0; pair < r_node_pairs.size(); pair++)
+        {
+            unsigned node_a_index = r_node_pairs[pair].first->GetIndex();
+            unsigned node_b_index = r_node_pairs[pair].second->GetIndex();
+            c_vector<double, 2> exact = analytic_force.CalculateForceBetweenNodes(node_a_index, node_b_index, cell_population);
+            c_vector<double, 2> tabulated = tabulated_force.CalculateForceBetweenNodes(node_a_index, node_b_index, cell_population);
+            TS_ASSERT_LESS_THAN_EQUALS(norm_2(tabulated - exact), tolerance*norm_2(exact) + 1e-15);
+        }
+
+        // The specialised force uses the same tables
+        NodeBasedLinearSpringForce<2> node_based_force;
+        node_based_force.SetCutOffLength(1.5);
+        node_based_force.SetUseTabulatedForceLaw(true, tolerance);
+
+        for (unsigned i = 0; i < cell_population.GetNumNodes(); i++)
+        {
+            cell_population.GetNode(i)->ClearAppliedForce();
+        }
+        tabulated_force.AddForceContribution(cell_population);
+        std::vector<c_vector<double, 2> > tabulated_forces;
+        for (unsigned i = 0; i < cell_population.GetNumNodes(); i++)
+        {
+            tabulated_forces.push_back(cell_population.GetNode(i)->rGetAppliedForce());
+            cell_population.GetNode(i)->ClearAppliedForce();
+        }
+        node_based_force.AddForceContribution(cell_population);
+        for (unsigned i = 0; i < cell_population.GetNumNodes(); i++)
+        {
+            TS_ASSERT_DELTA(norm_2(cell_population.GetNode(i)->rGetAppliedForce() - tabulated_forces[i]), 0.0, 1e-10);
+            cell_population.GetNode(i)->ClearAppliedForce();
+        }
+
+        // Sharing the pairs between threads only changes the order of summation
+        node_based_force.SetNumThreads(4);
+        node_based_force.AddForceContribution(cell_population);
+        for (unsigned i = 0; i < cell_population.GetNumNodes(); i++)
+        {
+            TS_ASSERT_DELTA(norm_2(cell_population.GetNode(i)->rGetAppliedForce() - tabulated_forces[i]), 0.0, 1e-10);
+        }
+    }
+};
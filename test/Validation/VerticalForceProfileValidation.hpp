@@ -0,0 +1,124 @@
+/*
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+This file is part of Chaste.
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cxxtest/TestSuite.h>
+#include "CheckpointArchiveTypes.hpp"
+#include "AbstractCellBasedTestSuite.hpp"
+#include "FakePetscSetup.hpp"
+
+#include <cmath>
+#include <iomanip>
+
+#include "VerticalForceProfile.hpp"
+
+/*
+ * Validation of the table of VerticalForceProfile against the analytic profile.
+ *
+ * The table meets a relative tolerance plus an absolute one, as a purely relative
+ * tolerance cannot be met where the profile crosses zero. With a negative attraction
+ * strength the profile starts positive at the repulsion distance and is pulled below
+ * zero by the stroma term, so it crosses zero inside the table.
+ */
+class VerticalForceProfileValidation : public AbstractCellBasedTestSuite
+{
+private:
+
+    /*
+     * Check the force against the analytic profile at many heights across the table
+     * and beyond it, and return the number of sign changes of the profile on the way.
+     */
+    unsigned CheckProfile(const VerticalForceProfile& rProfile, double minHeight, double maxHeight)
+    {
+        double relative_tolerance = rProfile.GetMaxRelativeError();
+        double absolute_tolerance = rProfile.GetMaxAbsoluteError();
+
+        unsigned num_samples = 100000;
+        std::vector<double> heights(num_samples + 1);
+        std::vector<double> forces(num_samples + 1);
+        for (unsigned i = 0; i <= num_samples; i++)
+        {
+            heights[i] = minHeight + (maxHeight - minHeight)*i/num_samples;
+        }
+        rProfile.GetForces(&heights[0], &forces[0], heights.size());
+
+        unsigned num_sign_changes = 0;
+        double max_error = 0.0;
+        for (unsigned i = 0; i <= num_samples; i++)
+        {
+            double exact = rProfile.GetAnalyticForce(heights[i]);
+            double error = fabs(rProfile.GetForce(heights[i]) - exact);
+            TS_ASSERT_LESS_THAN_EQUALS(error, relative_tolerance*fabs(exact) + absolute_tolerance);
+            TS_ASSERT_DELTA(forces[i], rProfile.GetForce(heights[i]), 1e-15*(1.0 + fabs(exact)));
+            max_error = std::max(max_error, error);
+
+            if (i > 0 && (exact > 0.0) != (rProfile.GetAnalyticForce(heights[i-1]) > 0.0))
+            {
+                num_sign_changes++;
+            }
+        }
+        cout << std::setw(16) << rProfile.rGetTable().GetNumIntervals() << std::setw(16) << max_error << endl;
+        return num_sign_changes;
+    }
+
+public:
+
+    void TestProfileWithinToleranceWhereItCrossesZero() throw (Exception)
+    {
+        // Repulsion distance 1.5, attraction strength -2 and the stroma term of GravityForce3 at height 10
+        VerticalForceProfile profile;
+        profile.SetParameters(1.5, 2.5, -2.0, 0.0, 4.0, 10.0);
+        TS_ASSERT(!profile.rGetTable().IsEmpty());
+        TS_ASSERT_DELTA(profile.GetMaxRelativeError(), 1e-8, 1e-20);
+        TS_ASSERT_DELTA(profile.GetMaxAbsoluteError(), 1e-10, 1e-22);
+
+        // The profile is positive at the repulsion distance and negative at the end of the table
+        TS_ASSERT_LESS_THAN(0.0, profile.GetAnalyticForce(1.5));
+        TS_ASSERT_LESS_THAN(profile.GetAnalyticForce(9.5), 0.0);
+
+        cout << std::setw(16) << "intervals" << std::setw(16) << "max error" << endl;
+        TS_ASSERT_EQUALS(CheckProfile(profile, 1.0, 9.9), 1u);
+
+        // A looser tolerance needs fewer intervals and is still met across the zero
+        unsigned num_intervals = profile.rGetTable().GetNumIntervals();
+        profile.SetMaxRelativeError(1e-5);
+        profile.SetMaxAbsoluteError(1e-7);
+        profile.SetParameters(1.5, 2.5, -2.0, 0.0, 4.0, 10.0);
+        TS_ASSERT_LESS_THAN(profile.rGetTable().GetNumIntervals(), num_intervals);
+        TS_ASSERT_EQUALS(CheckProfile(profile, 1.0, 9.9), 1u);
+    }
+
+    void TestProfileOfPaperParameters() throw (Exception)
+    {
+        // The profile of GravityForce3 with the paper parameters stays negative above the repulsion distance
+        VerticalForceProfile profile;
+        profile.SetParameters(1.5, 2.5, 2.0, 0.0, 4.0, 10.0);
+        TS_ASSERT(!profile.rGetTable().IsEmpty());
+        TS_ASSERT_EQUALS(CheckProfile(profile, 1.5, 9.9), 0u);
+    }
+};